@@ -11,6 +11,9 @@
 #include <gtk/gtk.h>
 #include "workspace.h"
 #include "file_index.h"
+#include "symbol_index.h"
+#include "ident_index.h"
+#include "trigram_index.h"
 #include "status.h"
 #include "recent_files.h"
 #include "umi_output_sink.h"
@@ -19,29 +22,59 @@
  * needs when first opening Umicom Studio. The comments below explain *every* member:
  *
  * - ws:      pointer to the Workspace model (owning the root folder path).
- * - index:   cached recursive listing of files under the workspace root.
+ * - root:    folder passed to umi_project_open() (NULL until then).
+ * - index:   cached recursive listing of files under the workspace root, with
+ *            per-file metadata; hand it to umi_editor_set_index().
+ * - symbols: definitions found in the indexed sources, for go-to-definition
+ *            and the palette's "@" mode (owned; built on the index).
+ * - idents:  identifier occurrences for "find references" (owned; same).
+ * - trigram: content index that narrows full-text searches to candidate
+ *            files (owned; same). Hand it to umi_search_panel_set_trigram()
+ *            and to umi_watch_integ_set_trigram() so edits reach it.
+ * - refresh: the running background re-index, NULL when idle.
+ * - indexed: told when a re-index replaced the indexes above (with 'user').
  * - recent:  MRU list shared with the rest of the app; adding to it keeps the
  *            welcome screen up-to-date.
  * - status:  human-readable status line where we tell the contributor what we did.
  */
-typedef struct {
-  UmiWorkspace *ws;
-  UmiFileIndex *index;
-  UmiRecent    *recent;
-  UmiStatus    *status;
-} UmiProjectManager;
+typedef struct UmiProjectManager UmiProjectManager;
+
+/* The indexes were replaced: hand the new ones to their users (search
+ * panel, watcher integration, ...). The old ones are freed on return. */
+typedef void (*UmiProjectIndexedCb)(UmiProjectManager *pm, gpointer user);
+
+struct UmiProjectManager {
+  UmiWorkspace        *ws;
+  char                *root;
+  UmiFileIndex        *index;
+  UmiSymbolIndex      *symbols;
+  UmiIdentIndex       *idents;
+  UmiTrigramIndex     *trigram;
+  GCancellable        *refresh;
+  UmiProjectIndexedCb  indexed;
+  gpointer             user;
+  UmiRecent           *recent;
+  UmiStatus           *status;
+};
 
 /* Create a new project manager by wiring the existing subsystems. */
 UmiProjectManager *umi_project_manager_new(UmiWorkspace *ws, UmiRecent *recent, UmiStatus *status);
 
 /* Open a folder as the workspace root. This *also* triggers a re-index so that
- * the file tree shows up immediately for new contributors. */
+ * the file tree shows up immediately for new contributors; it runs in the
+ * background and 'indexed' fires when it is done. */
 gboolean umi_project_open(UmiProjectManager *pm, const char *folder, GError **err);
 
-/* Refresh the file index, useful after cloning or changing branches. */
+/* Refresh the indexes, useful after cloning or changing branches. Returns at
+ * once: they are rebuilt on a worker thread (a refresh still running is
+ * dropped) and swapped in on the main loop, where 'indexed' fires. Until
+ * then the current indexes stay valid. */
 void     umi_project_refresh_index(UmiProjectManager *pm);
 
-/* Free allocated resources (index only; the shared singletons are owned elsewhere). */
+void     umi_project_set_indexed_cb(UmiProjectManager *pm, UmiProjectIndexedCb cb, gpointer user);
+
+/* Free allocated resources (root and indexes, saved first; the shared singletons
+ * are owned elsewhere). */
 void     umi_project_manager_free(UmiProjectManager *pm);
 
 #endif /* UMICOM_PROJECT_MANAGER_H */
@@ -9,12 +9,19 @@
  * Quick Start / Notes
  * - This implementation strictly follows the header:
  *
- *     typedef struct {
- *       UmiWorkspace *ws;
- *       UmiFileIndex *index;
- *       UmiRecent    *recent;
- *       UmiStatus    *status;
- *     } UmiProjectManager;
+ *     struct UmiProjectManager {
+ *       UmiWorkspace        *ws;
+ *       char                *root;
+ *       UmiFileIndex        *index;
+ *       UmiSymbolIndex      *symbols;
+ *       UmiIdentIndex       *idents;
+ *       UmiTrigramIndex     *trigram;
+ *       GCancellable        *refresh;
+ *       UmiProjectIndexedCb  indexed;
+ *       gpointer             user;
+ *       UmiRecent           *recent;
+ *       UmiStatus           *status;
+ *     };
  *
  *     UmiProjectManager *umi_project_manager_new(UmiWorkspace *ws,
  *                                                UmiRecent *recent,
@@ -23,18 +30,25 @@
  *                               const char *folder,
  *                               GError **err);
  *     void     umi_project_refresh_index(UmiProjectManager *pm);
+ *     void     umi_project_set_indexed_cb(UmiProjectManager *pm,
+ *                                         UmiProjectIndexedCb cb,
+ *                                         gpointer user);
  *     void     umi_project_manager_free(UmiProjectManager *pm);
  *
  * - We intentionally do **not** call umi_status_set(...) or any status functions.
- * - We don’t assume any concrete API for UmiWorkspace/UmiFileIndex/UmiRecent:
- *   this keeps compilation robust even if those subsystems are still evolving.
- * - On open(), we validate the folder exists (directory) and return TRUE; you
- *   can later extend this to wire the workspace root or (re)index the tree.
+ * - We don’t assume any concrete API for UmiWorkspace/UmiRecent: this keeps
+ *   compilation robust even if those subsystems are still evolving.
+ * - On open(), we validate the folder exists (directory), remember it as the
+ *   root and start (re)indexing the tree on a worker thread: the file index,
+ *   the symbol index, the identifier index and the trigram index are all
+ *   opened from their snapshots, so a warm start only re-checks what changed.
+ *   open() itself returns at once; 'indexed' fires when the set is in place.
  * - Error reporting uses GError** (if provided) for open() failures only.
  * - Everything is pure C (C17) + GLib; no GtkBuilder, no XML, no GResource.
  *---------------------------------------------------------------------------*/
 
 #include <glib.h>                 /* gboolean, gchar, GError, g_set_error, etc.  */
+#include <gio/gio.h>              /* GTask, GCancellable (background re-index)   */
 #include <string.h>               /* (not strictly needed; common safe include)  */
 
 #include "project_manager.h"      /* Must match this header’s struct + prototypes */
@@ -119,36 +133,192 @@ umi_project_open(UmiProjectManager *pm, const char *folder, GError **err)
     }
 
     /* At this stage, we do not assume any specific Workspace API.
-     * Many codebases do something like: umi_workspace_set_root(pm->ws, folder)
-     * or they rebuild the file index right away.
-     * To stay robust and compile-proof, we only log the action here.
-     *
      * If/when the Workspace exposes a clear setter, wire it here.              */
     g_message("UmiProjectManager: open → '%s'", folder);
 
-    /* Success. Caller may trigger a refresh_index() next.                      */
+    /* Remember the root and start indexing it (see the header).              */
+    g_free(pm->root);
+    pm->root = g_strdup(folder);
+    umi_project_refresh_index(pm);
     return TRUE;
 }
 
+/* Write the indexes back to their snapshots so the next open is warm. The
+ * paths follow the index's own root: after open() switched folders the set
+ * in place may still be the previous folder's until the re-index lands.   */
+static void
+umi_project_save_indexes(UmiProjectManager *pm)
+{
+    if (!pm->index) {
+        return;
+    }
+    const char *root = umi_index_root(pm->index);
+    gchar *idx_snap = umi_index_snapshot_path_for(root);
+    gchar *sym_snap = umi_symbol_index_snapshot_path_for(root);
+    gchar *ids_snap = umi_ident_index_snapshot_path_for(root);
+    gchar *tri_snap = umi_trigram_index_snapshot_path_for(root);
+    GError *e = NULL;
+    if (idx_snap && !umi_index_save(pm->index, idx_snap, &e)) {
+        g_warning("UmiProjectManager: saving the file index failed: %s", e->message);
+        g_clear_error(&e);
+    }
+    if (sym_snap && pm->symbols && !umi_symbol_index_save(pm->symbols, sym_snap, &e)) {
+        g_warning("UmiProjectManager: saving the symbol index failed: %s", e->message);
+        g_clear_error(&e);
+    }
+    if (ids_snap && pm->idents && !umi_ident_index_save(pm->idents, ids_snap, &e)) {
+        g_warning("UmiProjectManager: saving the identifier index failed: %s", e->message);
+        g_clear_error(&e);
+    }
+    if (tri_snap && pm->trigram && !umi_trigram_index_save(pm->trigram, tri_snap, &e)) {
+        g_warning("UmiProjectManager: saving the trigram index failed: %s", e->message);
+        g_clear_error(&e);
+    }
+    g_free(tri_snap);
+    g_free(ids_snap);
+    g_free(sym_snap);
+    g_free(idx_snap);
+}
+
 /*-----------------------------------------------------------------------------
- * Refresh the file index (no-op placeholder)
+ * Refresh the indexes (background)
  *
  * RATIONALE:
- *   The header documents that 'index' is owned here, but we avoid guessing
- *   the concrete API of UmiFileIndex. Later, you can fill this with the real
- *   discovery: e.g., umi_file_index_build(folder), etc., and free old index.
+ *   Opening the file index walks the whole tree and building the trigram
+ *   index reads every text file: far too slow for the main thread on a big
+ *   checkout. A worker opens a complete new set (the symbol, identifier and
+ *   trigram indexes borrow the file index, so the four travel together) and
+ *   the main loop swaps it in. The old set stays usable until then; changes
+ *   the watcher reports meanwhile only reach the old set, and are picked up
+ *   from disk by the next refresh. Symbols and identifiers are still parsed
+ *   lazily, on the first lookup; the trigram index is built here.
  *---------------------------------------------------------------------------*/
+
+/* One complete set of indexes, as the worker hands it over.                */
+typedef struct {
+    UmiFileIndex    *index;
+    UmiSymbolIndex  *symbols;
+    UmiIdentIndex   *idents;
+    UmiTrigramIndex *trigram;
+} UmiProjectIndexes;
+
+static void
+umi_project_indexes_free(gpointer data)
+{
+    UmiProjectIndexes *set = data;
+    umi_trigram_index_free(set->trigram);   /* borrowers before the index    */
+    umi_ident_index_free(set->idents);
+    umi_symbol_index_free(set->symbols);
+    umi_index_free(set->index);
+    g_free(set);
+}
+
+/* Worker thread: 'data' is the root. Touches nothing of the manager.       */
+static void
+umi_project_index_thread(GTask *task, gpointer src, gpointer data, GCancellable *cancel)
+{
+    (void)src;
+    const char *root = data;
+
+    gchar *idx_snap = umi_index_snapshot_path_for(root);
+    UmiFileIndex *index = umi_index_open(root, idx_snap);
+    g_free(idx_snap);
+    if (index == NULL) {
+        g_task_return_new_error(task, umi_project_error_quark(), 3, "Cannot index '%s'", root);
+        return;
+    }
+
+    UmiProjectIndexes *set = g_new0(UmiProjectIndexes, 1);
+    set->index = index;
+
+    gchar *sym_snap = umi_symbol_index_snapshot_path_for(root);
+    set->symbols = umi_symbol_index_open(index, sym_snap);
+    g_free(sym_snap);
+
+    gchar *ids_snap = umi_ident_index_snapshot_path_for(root);
+    set->idents = umi_ident_index_open(index, ids_snap);
+    g_free(ids_snap);
+
+    gchar *tri_snap = umi_trigram_index_snapshot_path_for(root);
+    set->trigram = umi_trigram_index_open(index, tri_snap);
+    g_free(tri_snap);
+    if (!g_cancellable_is_cancelled(cancel)) {
+        umi_trigram_index_sync(set->trigram);  /* not on the first search   */
+    }
+
+    g_task_return_pointer(task, set, umi_project_indexes_free);
+}
+
+/* Main loop: install the new set, let the users switch, free the old one. */
+static void
+umi_project_index_done(GObject *src, GAsyncResult *res, gpointer user)
+{
+    (void)src;
+    GTask *task = G_TASK(res);
+    if (g_cancellable_is_cancelled(g_task_get_cancellable(task))) {
+        return; /* dropped: 'user' may be freed; the set goes with the task  */
+    }
+
+    UmiProjectManager *pm = user;
+    g_clear_object(&pm->refresh);
+
+    GError *e = NULL;
+    UmiProjectIndexes *set = g_task_propagate_pointer(task, &e);
+    if (set == NULL) {
+        g_warning("UmiProjectManager: %s", e->message);
+        g_clear_error(&e);
+        return;
+    }
+
+    UmiProjectIndexes old = { pm->index, pm->symbols, pm->idents, pm->trigram };
+    pm->index   = set->index;
+    pm->symbols = set->symbols;
+    pm->idents  = set->idents;
+    pm->trigram = set->trigram;
+    *set = old;                               /* 'set' now holds the old one */
+
+    g_message("UmiProjectManager: refresh_index → '%s'", umi_index_root(pm->index));
+    if (pm->indexed) {
+        pm->indexed(pm, pm->user);
+    }
+    umi_project_indexes_free(set);
+}
+
+/* Drop a refresh still running; its result is freed when the worker ends.  */
+static void
+umi_project_cancel_refresh(UmiProjectManager *pm)
+{
+    if (pm->refresh) {
+        g_cancellable_cancel(pm->refresh);
+        g_clear_object(&pm->refresh);
+    }
+}
+
 void
 umi_project_refresh_index(UmiProjectManager *pm)
 {
     g_return_if_fail(pm != NULL);
 
-    /* No concrete UmiFileIndex API is assumed here.                            */
-    /* You can implement (re)indexing in a follow-up patch:                     */
-    /*   - if (pm->index) umi_file_index_free(pm->index);                       */
-    /*   - pm->index = umi_file_index_build( umi_workspace_get_root(pm->ws) );  */
+    if (pm->root == NULL) {
+        g_message("UmiProjectManager: refresh_index → no folder open");
+        return;
+    }
+
+    umi_project_cancel_refresh(pm);
+    pm->refresh = g_cancellable_new();
+
+    GTask *task = g_task_new(NULL, pm->refresh, umi_project_index_done, pm);
+    g_task_set_task_data(task, g_strdup(pm->root), g_free);
+    g_task_run_in_thread(task, umi_project_index_thread);
+    g_object_unref(task);
+}
 
-    g_message("UmiProjectManager: refresh_index (placeholder; not implemented yet)");
+void
+umi_project_set_indexed_cb(UmiProjectManager *pm, UmiProjectIndexedCb cb, gpointer user)
+{
+    g_return_if_fail(pm != NULL);
+    pm->indexed = cb;
+    pm->user    = user;
 }
 
 /*-----------------------------------------------------------------------------
@@ -161,10 +331,15 @@ umi_project_manager_free(UmiProjectManager *pm)
         return; /* tolerate NULL for convenience                                */
     }
 
-    /* If we had created an index instance, we would free it here. We won’t
-     * guess the correct free function name to keep this file build-stable.
-     * Leaving it NULL preserves safety; you can fill this in later.            */
-    pm->index = NULL;
+    /* Drop a running refresh, save, then free the borrowers before the file
+     * index itself.                                                          */
+    umi_project_cancel_refresh(pm);
+    umi_project_save_indexes(pm);
+    umi_trigram_index_free(pm->trigram);
+    umi_ident_index_free(pm->idents);
+    umi_symbol_index_free(pm->symbols);
+    umi_index_free(pm->index);
+    g_free(pm->root);
 
     g_message("UmiProjectManager: destroyed");
     g_free(pm);
@@ -0,0 +1,135 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/editor/blame_gutter.c
+ *
+ * PURPOSE:
+ *   Blame annotations for an editor buffer (see blame_gutter.h).
+ *
+ * DESIGN:
+ *   - One request at a time, tied to 'cancel'. The UmiBlame of a running
+ *     request is kept from its first callback on and grows in place, so
+ *     a lookup sees every chunk delivered so far.
+ *   - The blame cache is owned here; finished results of files visited
+ *     before come back without running git.
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <gio/gio.h>
+#include <glib.h>
+#include "blame_gutter.h"
+
+#define UMI_BLAME_GUTTER_MEM 32   /* finished results kept in memory */
+
+struct _UmiBlameGutter {
+    UmiDiffGutter *diff;        /* borrowed: buffer line -> HEAD line         */
+    UmiBlameCache *cache;
+    gboolean       enabled;
+    char          *path;
+    GCancellable  *cancel;      /* running request, or NULL                   */
+    UmiBlame      *blame;       /* ref; what lookups see                      */
+
+    UmiBlameGutterChangedCb cb;
+    gpointer                user;
+};
+
+static void notify(UmiBlameGutter *g)
+{
+    if (g->cb) g->cb(g, g->user);
+}
+
+static void on_blame(UmiBlame *b, guint first, guint n, gboolean done, gpointer user)
+{
+    (void)first;
+    UmiBlameGutter *g = user;   /* cancelling silences us, so 'g' is alive */
+    if (g->blame != b) {
+        if (g->blame) umi_blame_unref(g->blame);
+        g->blame = umi_blame_ref(b);
+    }
+    if (done) g_clear_object(&g->cancel);
+    if (n || done) notify(g);
+}
+
+/* Cancel the running request and forget the annotations. */
+static void drop(UmiBlameGutter *g)
+{
+    if (g->cancel) {
+        g_cancellable_cancel(g->cancel);
+        g_clear_object(&g->cancel);
+    }
+    if (g->blame) {
+        g_clear_pointer(&g->blame, umi_blame_unref);
+        notify(g);
+    }
+}
+
+static void request(UmiBlameGutter *g)
+{
+    drop(g);
+    if (!g->enabled || !g->path) return;
+    g->cancel = g_cancellable_new();
+    umi_blame_cache_get(g->cache, g->path, g->cancel, on_blame, g);
+}
+
+UmiBlameGutter *umi_blame_gutter_new(UmiDiffGutter *diff)
+{
+    g_return_val_if_fail(diff != NULL, NULL);
+    UmiBlameGutter *g = g_new0(UmiBlameGutter, 1);
+    g->diff  = diff;
+    g->cache = umi_blame_cache_new(NULL, UMI_BLAME_GUTTER_MEM);
+    return g;
+}
+
+void umi_blame_gutter_free(UmiBlameGutter *g)
+{
+    if (!g) return;
+    g->cb = NULL;
+    drop(g);
+    umi_blame_cache_free(g->cache);
+    g_free(g->path);
+    g_free(g);
+}
+
+void umi_blame_gutter_set_changed_cb(UmiBlameGutter *g, UmiBlameGutterChangedCb cb, gpointer user)
+{
+    if (!g) return;
+    g->cb   = cb;
+    g->user = user;
+}
+
+void umi_blame_gutter_set_enabled(UmiBlameGutter *g, gboolean on)
+{
+    if (!g || g->enabled == !!on) return;
+    g->enabled = !!on;
+    request(g);                 /* disabling just drops */
+}
+
+gboolean umi_blame_gutter_is_enabled(const UmiBlameGutter *g)
+{
+    return g && g->enabled;
+}
+
+void umi_blame_gutter_set_file(UmiBlameGutter *g, const char *path)
+{
+    if (!g) return;
+    g_free(g->path);
+    g->path = path ? g_strdup(path) : NULL;
+    request(g);
+}
+
+const UmiBlameChunk *umi_blame_gutter_line(const UmiBlameGutter *g, guint line)
+{
+    if (!g || !g->blame) return NULL;
+    if (umi_diff_gutter_mark(g->diff, line) == UMI_GUTTER_ADDED ||
+        umi_diff_gutter_mark(g->diff, line) == UMI_GUTTER_MODIFIED) return NULL;
+
+    /* Hunks are in buffer order; those above 'line' shift it. */
+    gint64 head = line;
+    for (guint i = 0, n = umi_diff_gutter_n_hunks(g->diff); i < n; ++i) {
+        const UmiDiffHunk *h = umi_diff_gutter_hunk(g->diff, i);
+        if (line < h->line_start) break;
+        if (line < h->line_start + h->line_len) return NULL;
+        head += (gint64)h->base_len - (gint64)h->line_len;
+    }
+    return head < 0 ? NULL : umi_blame_line(g->blame, (guint)head);
+}
+/*  END OF FILE */
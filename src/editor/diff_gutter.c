@@ -0,0 +1,704 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/editor/diff_gutter.c
+ *
+ * PURPOSE:
+ *   Changed-line markers against HEAD (see diff_gutter.h).
+ *
+ * DESIGN:
+ *   - Main thread state: the base (HEAD text split into hashed lines,
+ *     shared read-only with the worker), the settled hunks in buffer order,
+ *     and at most one "dirty" window: buffer lines [d_line0, d_line1) that
+ *     correspond to base lines [d_base0, d_base1) but have not been diffed
+ *     since the last edit. Settled hunks never touch the window.
+ *   - An edit folds its lines, a few context lines and every hunk it
+ *     touches into the window and shifts the hunks after it. A job copies
+ *     the window's text out of the buffer and diffs it on the worker; the
+ *     result is spliced in only if no edit happened meanwhile, otherwise
+ *     the (grown) window is simply diffed again.
+ *   - While a window waits, its lines keep the marks they had ("stale"
+ *     hunks) and freshly edited lines show as modified, so typing does not
+ *     make markers flicker.
+ *
+ * LIMITS:
+ *   - Myers gives up past UMI_GUTTER_MAX_COST edit steps per split and marks
+ *     the rest of that region as replaced (whole-file rewrites).
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <gtk/gtk.h>
+#include <gio/gio.h>
+#include <glib.h>
+#include <string.h>
+#include "diff_gutter.h"
+#include "git_index.h"        /* umi_git_find_repo() */
+
+#define UMI_GUTTER_DEBOUNCE_MS 50
+#define UMI_GUTTER_CONTEXT     3
+#define UMI_GUTTER_MAX_COST    4096
+
+/* One line of a text: byte range plus a 64-bit FNV-1a hash. */
+typedef struct {
+    guint   off, len;
+    guint64 hash;
+} Line;
+
+/* Immutable once built; shared between the gutter and its jobs. */
+typedef struct {
+    gint    ref;
+    GBytes *blob;
+    GArray *lines;              /* Line */
+} Base;
+
+struct _UmiDiffGutter {
+    GtkTextBuffer *buffer;      /* ref                                        */
+    gulong         h_insert, h_inserted, h_delete;
+    guint          insert_line; /* insert-text: line the insertion starts on  */
+
+    char          *path;        /* file whose HEAD version is the base        */
+    GCancellable  *load_cancel; /* in-flight "git cat-file"                   */
+    Base          *base;        /* NULL: no marks                             */
+    GBytes        *pending;     /* new base text waiting for the worker       */
+    guint          serial;      /* bumped whenever the base is replaced       */
+
+    GArray        *hunks;       /* UmiDiffHunk, settled, by line_start        */
+    gboolean       dirty;
+    guint          d_line0, d_line1, d_base0, d_base1;
+    GArray        *stale;       /* UmiDiffHunk: what the window shows meanwhile */
+    guint64        version;     /* bumped on every edit                       */
+
+    guint          debounce_id;
+    gboolean       busy;        /* a job is in flight                         */
+    GThreadPool   *pool;
+    GCancellable  *cancel;
+
+    UmiDiffGutterChangedCb cb;
+    gpointer               user;
+};
+
+typedef struct {
+    UmiDiffGutter *g;
+    GCancellable  *cancel;
+    guint64        version;
+    guint          serial;
+    GBytes        *blob;        /* new base to split first, or NULL           */
+    Base          *base;
+    char          *text;        /* buffer lines [line0, line1)                */
+    guint          line0, line1;
+    guint          base0, base1;   /* G_MAXUINT: to the end of a new base     */
+    GArray        *hunks;       /* result: UmiDiffHunk, absolute              */
+} DiffJob;
+
+static void schedule(UmiDiffGutter *g);
+
+/*---------------------------------------------------------------------------
+ * Lines
+ *-------------------------------------------------------------------------*/
+
+static guint64 line_hash(const char *p, guint len)
+{
+    guint64 h = 14695981039346656037ull;
+    for (guint i = 0; i < len; ++i) { h ^= (guchar)p[i]; h *= 1099511628211ull; }
+    return h;
+}
+
+/* Split the way GtkTextBuffer counts lines: "\n", "\r\n" and "\r" end a line
+ * and whatever follows the last one is a (possibly empty) last line. At
+ * most 'max' lines are returned. */
+static GArray *split_lines(const char *text, gsize len, guint max)
+{
+    GArray *lines = g_array_new(FALSE, FALSE, sizeof(Line));
+    gsize start = 0;
+    for (gsize i = 0; i <= len && lines->len < max; ) {
+        if (i < len && text[i] != '\n' && text[i] != '\r') { ++i; continue; }
+        Line l = { (guint)start, (guint)(i - start), line_hash(text + start, (guint)(i - start)) };
+        g_array_append_val(lines, l);
+        if (i == len) break;
+        i += (text[i] == '\r' && i + 1 < len && text[i + 1] == '\n') ? 2 : 1;
+        start = i;
+    }
+    return lines;
+}
+
+static Base *base_new(GBytes *blob)
+{
+    Base *b = g_new0(Base, 1);
+    b->ref  = 1;
+    b->blob = g_bytes_ref(blob);
+    gsize len = 0;
+    const char *text = g_bytes_get_data(blob, &len);
+    b->lines = split_lines(text ? text : "", len, G_MAXUINT);
+    return b;
+}
+
+static Base *base_ref(Base *b)
+{
+    if (b) g_atomic_int_inc(&b->ref);
+    return b;
+}
+
+static void base_unref(Base *b)
+{
+    if (!b || !g_atomic_int_dec_and_test(&b->ref)) return;
+    g_bytes_unref(b->blob);
+    g_array_free(b->lines, TRUE);
+    g_free(b);
+}
+
+/*---------------------------------------------------------------------------
+ * Myers diff (worker). 'a' indexes base lines, 'b' window lines.
+ *-------------------------------------------------------------------------*/
+
+typedef struct {
+    const char *at;
+    const Line *a;
+    const char *bt;
+    const Line *b;
+    GArray     *out;            /* UmiDiffHunk, b relative to the window      */
+} Myers;
+
+static inline gboolean same(const Myers *m, guint i, guint j)
+{
+    const Line *x = &m->a[i], *y = &m->b[j];
+    return x->hash == y->hash && x->len == y->len && memcmp(m->at + x->off, m->bt + y->off, x->len) == 0;
+}
+
+/* Append a hunk, merging with the previous one when they meet. */
+static void emit(Myers *m, guint a0, guint an, guint b0, guint bn)
+{
+    if (!an && !bn) return;
+    if (m->out->len) {
+        UmiDiffHunk *last = &g_array_index(m->out, UmiDiffHunk, m->out->len - 1);
+        if (last->base_start + last->base_len == a0 && last->line_start + last->line_len == b0) {
+            last->base_len += an;
+            last->line_len += bn;
+            return;
+        }
+    }
+    UmiDiffHunk h = { a0, an, b0, bn };
+    g_array_append_val(m->out, h);
+}
+
+/* Middle of an optimal edit path between a[a0,a1) and b[b0,b1), found by
+ * running forward and backward searches until they overlap. Both ranges
+ * are non-empty and differ in their first and last lines. FALSE if the
+ * cost exceeds the budget. */
+static gboolean bisect(const Myers *m, guint a0, guint a1, guint b0, guint b1, guint *sx, guint *sy)
+{
+    const gint n = (gint)(a1 - a0), mm = (gint)(b1 - b0);
+    const gint dmax = MIN((n + mm + 1) / 2, UMI_GUTTER_MAX_COST);
+    const gint off = dmax, vlen = 2 * dmax + 2;
+    gint *v1 = g_new(gint, 2 * (gsize)vlen), *v2 = v1 + vlen;
+    for (gint i = 0; i < 2 * vlen; ++i) v1[i] = -1;
+    v1[off + 1] = 0;
+    v2[off + 1] = 0;
+
+    const gint delta = n - mm;
+    const gboolean front = (delta & 1) != 0;    /* which search detects overlap */
+    gint k1start = 0, k1end = 0, k2start = 0, k2end = 0;
+    for (gint d = 0; d < dmax; ++d) {
+        for (gint k1 = -d + k1start; k1 <= d - k1end; k1 += 2) {
+            const gint k1o = off + k1;
+            gint x1 = (k1 == -d || (k1 != d && v1[k1o - 1] < v1[k1o + 1])) ? v1[k1o + 1] : v1[k1o - 1] + 1;
+            gint y1 = x1 - k1;
+            while (x1 < n && y1 < mm && same(m, a0 + (guint)x1, b0 + (guint)y1)) { ++x1; ++y1; }
+            v1[k1o] = x1;
+            if (x1 > n) {
+                k1end += 2;                     /* ran off the right edge  */
+            } else if (y1 > mm) {
+                k1start += 2;                   /* ran off the bottom      */
+            } else if (front) {
+                const gint k2o = off + delta - k1;
+                if (k2o >= 0 && k2o < vlen && v2[k2o] != -1 && x1 >= n - v2[k2o]) {
+                    *sx = a0 + (guint)x1;
+                    *sy = b0 + (guint)y1;
+                    g_free(v1);
+                    return TRUE;
+                }
+            }
+        }
+        for (gint k2 = -d + k2start; k2 <= d - k2end; k2 += 2) {
+            const gint k2o = off + k2;
+            gint x2 = (k2 == -d || (k2 != d && v2[k2o - 1] < v2[k2o + 1])) ? v2[k2o + 1] : v2[k2o - 1] + 1;
+            gint y2 = x2 - k2;
+            while (x2 < n && y2 < mm && same(m, a1 - 1 - (guint)x2, b1 - 1 - (guint)y2)) { ++x2; ++y2; }
+            v2[k2o] = x2;
+            if (x2 > n) {
+                k2end += 2;
+            } else if (y2 > mm) {
+                k2start += 2;
+            } else if (!front) {
+                const gint k1o = off + delta - k2;
+                if (k1o >= 0 && k1o < vlen && v1[k1o] != -1) {
+                    const gint x1 = v1[k1o];
+                    const gint y1 = off + x1 - k1o;
+                    if (x1 >= n - x2) {
+                        *sx = a0 + (guint)x1;
+                        *sy = b0 + (guint)y1;
+                        g_free(v1);
+                        return TRUE;
+                    }
+                }
+            }
+        }
+    }
+    g_free(v1);
+    return FALSE;
+}
+
+static void diff_range(Myers *m, guint a0, guint a1, guint b0, guint b1)
+{
+    while (a0 < a1 && b0 < b1 && same(m, a0, b0)) { ++a0; ++b0; }
+    while (a0 < a1 && b0 < b1 && same(m, a1 - 1, b1 - 1)) { --a1; --b1; }
+    guint x, y;
+    if (a0 == a1 || b0 == b1 || !bisect(m, a0, a1, b0, b1, &x, &y)) {
+        emit(m, a0, a1 - a0, b0, b1 - b0);
+        return;
+    }
+    diff_range(m, a0, x, b0, y);
+    diff_range(m, x, a1, y, b1);
+}
+
+static void run_job(DiffJob *j)
+{
+    if (j->blob) j->base = base_new(j->blob);
+    if (j->base1 == G_MAXUINT) j->base1 = j->base->lines->len;
+
+    const guint n = j->line1 - j->line0;
+    GArray *cur = split_lines(j->text, strlen(j->text), n);
+    while (cur->len < n) {                      /* cannot happen; keep counts sane */
+        Line l = { 0, 0, line_hash("", 0) };
+        g_array_append_val(cur, l);
+    }
+
+    Myers m = {
+        g_bytes_get_data(j->base->blob, NULL), (const Line *)(void *)j->base->lines->data,
+        j->text, (const Line *)(void *)cur->data,
+        g_array_new(FALSE, FALSE, sizeof(UmiDiffHunk))
+    };
+    if (!m.at) m.at = "";
+    diff_range(&m, j->base0, j->base1, 0, n);
+    for (guint i = 0; i < m.out->len; ++i) g_array_index(m.out, UmiDiffHunk, i).line_start += j->line0;
+    j->hunks = m.out;
+    g_array_free(cur, TRUE);
+}
+
+/*---------------------------------------------------------------------------
+ * Marks
+ *-------------------------------------------------------------------------*/
+
+static UmiGutterMark hunk_mark(const UmiDiffHunk *h, guint line)
+{
+    if (h->line_len) {
+        if (line < h->line_start || line >= h->line_start + h->line_len) return UMI_GUTTER_NONE;
+        return h->base_len ? UMI_GUTTER_MODIFIED : UMI_GUTTER_ADDED;
+    }
+    /* A pure deletion shows on the line above the gap. */
+    return line == (h->line_start ? h->line_start - 1 : 0) ? UMI_GUTTER_DELETED : UMI_GUTTER_NONE;
+}
+
+static UmiGutterMark lookup(const GArray *hunks, guint line)
+{
+    /* Only the last two hunks starting at or before line + 1 can apply. */
+    guint lo = 0, hi = hunks->len;
+    while (lo < hi) {
+        const guint mid = lo + (hi - lo) / 2;
+        if (g_array_index(hunks, UmiDiffHunk, mid).line_start <= line + 1) lo = mid + 1;
+        else hi = mid;
+    }
+    for (guint i = lo; i > 0 && i + 2 > lo; --i) {
+        const UmiGutterMark mk = hunk_mark(&g_array_index(hunks, UmiDiffHunk, i - 1), line);
+        if (mk) return mk;
+    }
+    return UMI_GUTTER_NONE;
+}
+
+static void emit_changed(UmiDiffGutter *g)
+{
+    if (g->cb) g->cb(g, g->user);
+}
+
+/*---------------------------------------------------------------------------
+ * Edit tracking (main thread)
+ *-------------------------------------------------------------------------*/
+
+/* Buffer lines [a, a + old) became [a, a + neu); the buffer had 'count'
+ * lines before. */
+static void note_edit(UmiDiffGutter *g, guint a, guint old, guint neu, guint count)
+{
+    g->version++;
+    if (!g->base) return;                       /* no base, or a new one is on its way */
+    const gint delta = (gint)neu - (gint)old;
+
+    /* Window in pre-edit coordinates: the edit, the previous window and
+     * some context, grown over every hunk it touches. */
+    guint r0 = a, r1 = a + old;
+    if (g->dirty) { r0 = MIN(r0, g->d_line0); r1 = MAX(r1, g->d_line1); }
+    r0 = r0 > UMI_GUTTER_CONTEXT ? r0 - UMI_GUTTER_CONTEXT : 0;
+    r1 = MIN(r1 + UMI_GUTTER_CONTEXT, count);
+
+    gint before = 0, inside = 0;                /* sum of line_len - base_len */
+    guint first = 0, last = 0;                  /* absorbed hunks [first, last) */
+    for (guint i = 0; i < g->hunks->len; ++i) {
+        const UmiDiffHunk *h = &g_array_index(g->hunks, UmiDiffHunk, i);
+        if (h->line_start + h->line_len < r0) { before += (gint)h->line_len - (gint)h->base_len; first = last = i + 1; continue; }
+        if (h->line_start > r1) break;
+        r0 = MIN(r0, h->line_start);
+        r1 = MAX(r1, h->line_start + h->line_len);
+        inside += (gint)h->line_len - (gint)h->base_len;
+        last = i + 1;
+    }
+    if (g->dirty) inside += (gint)(g->d_line1 - g->d_line0) - (gint)(g->d_base1 - g->d_base0);
+    const guint b0 = (guint)((gint)r0 - before);
+    const guint b1 = (guint)((gint)b0 + (gint)(r1 - r0) - inside);
+
+    /* Absorbed hunks keep their marks until the re-diff lands (roughly
+     * moved along with the edits). */
+    if (last > first) g_array_append_vals(g->stale, &g_array_index(g->hunks, UmiDiffHunk, first), last - first);
+    for (guint i = 0; i < g->stale->len; ++i) {
+        UmiDiffHunk *h = &g_array_index(g->stale, UmiDiffHunk, i);
+        if (h->line_start >= a + old) h->line_start = (guint)((gint)h->line_start + delta);
+        else if (h->line_start + h->line_len > a) h->line_len = (guint)MAX((gint)h->line_len + delta, 0);
+    }
+    const UmiDiffHunk edited = { 0, 1, a, neu };
+    g_array_append_val(g->stale, edited);
+    if (last > first) g_array_remove_range(g->hunks, first, last - first);
+    for (guint i = first; i < g->hunks->len; ++i)
+        g_array_index(g->hunks, UmiDiffHunk, i).line_start = (guint)((gint)g_array_index(g->hunks, UmiDiffHunk, i).line_start + delta);
+
+    g->dirty   = TRUE;
+    g->d_line0 = r0;
+    g->d_line1 = (guint)((gint)r1 + delta);
+    g->d_base0 = b0;
+    g->d_base1 = MIN(b1, g->base->lines->len);
+    schedule(g);
+}
+
+static void on_insert_text(GtkTextBuffer *buf, GtkTextIter *loc, gchar *text, gint len, gpointer user)
+{
+    (void)buf; (void)text; (void)len;
+    ((UmiDiffGutter *)user)->insert_line = (guint)gtk_text_iter_get_line(loc);
+}
+
+/* Runs after the default handler: 'loc' now sits after the new text. */
+static void on_text_inserted(GtkTextBuffer *buf, GtkTextIter *loc, gchar *text, gint len, gpointer user)
+{
+    (void)text; (void)len;
+    UmiDiffGutter *g = user;
+    const guint a   = g->insert_line;
+    const guint end = (guint)gtk_text_iter_get_line(loc);
+    note_edit(g, a, 1, end - a + 1, (guint)gtk_text_buffer_get_line_count(buf) - (end - a));
+}
+
+static void on_delete_range(GtkTextBuffer *buf, GtkTextIter *start, GtkTextIter *end, gpointer user)
+{
+    const guint a = (guint)MIN(gtk_text_iter_get_line(start), gtk_text_iter_get_line(end));
+    const guint e = (guint)MAX(gtk_text_iter_get_line(start), gtk_text_iter_get_line(end));
+    note_edit(user, a, e - a + 1, 1, (guint)gtk_text_buffer_get_line_count(buf));
+}
+
+/*---------------------------------------------------------------------------
+ * Jobs
+ *-------------------------------------------------------------------------*/
+
+static char *buffer_lines(GtkTextBuffer *buf, guint line0, guint line1)
+{
+    GtkTextIter s, e;
+    gtk_text_buffer_get_iter_at_line(buf, &s, (int)line0);
+    if (line1 >= (guint)gtk_text_buffer_get_line_count(buf)) gtk_text_buffer_get_end_iter(buf, &e);
+    else gtk_text_buffer_get_iter_at_line(buf, &e, (int)line1);
+    return gtk_text_buffer_get_text(buf, &s, &e, TRUE);
+}
+
+static DiffJob *take_job(UmiDiffGutter *g)
+{
+    if (!g->pending && !(g->dirty && g->base)) return NULL;
+    DiffJob *j = g_new0(DiffJob, 1);
+    j->g       = g;
+    j->cancel  = g_object_ref(g->cancel);
+    j->version = g->version;
+    j->serial  = g->serial;
+    if (g->pending) {
+        j->blob  = g->pending;
+        g->pending = NULL;
+        j->line0 = 0;
+        j->line1 = (guint)gtk_text_buffer_get_line_count(g->buffer);
+        j->base0 = 0;
+        j->base1 = G_MAXUINT;
+    } else {
+        j->base  = base_ref(g->base);
+        j->line0 = g->d_line0;
+        j->line1 = g->d_line1;
+        j->base0 = g->d_base0;
+        j->base1 = g->d_base1;
+    }
+    j->text = buffer_lines(g->buffer, j->line0, j->line1);
+    return j;
+}
+
+static void job_free(DiffJob *j)
+{
+    if (j->blob) g_bytes_unref(j->blob);
+    base_unref(j->base);
+    if (j->hunks) g_array_free(j->hunks, TRUE);
+    g_clear_object(&j->cancel);
+    g_free(j->text);
+    g_free(j);
+}
+
+static void apply_job(UmiDiffGutter *g, DiffJob *j)
+{
+    if (j->serial != g->serial) return;         /* the base was replaced meanwhile */
+    if (j->blob) {
+        g->base    = base_ref(j->base);
+        g->dirty   = TRUE;
+        g->d_line0 = 0;
+        g->d_line1 = (guint)gtk_text_buffer_get_line_count(g->buffer);
+        g->d_base0 = 0;
+        g->d_base1 = g->base->lines->len;
+    }
+    if (j->version != g->version) {             /* edited meanwhile: diff again */
+        schedule(g);
+        return;
+    }
+    guint at = 0;
+    while (at < g->hunks->len && g_array_index(g->hunks, UmiDiffHunk, at).line_start < j->line0) ++at;
+    g_array_insert_vals(g->hunks, at, j->hunks->data, j->hunks->len);
+    g->dirty = FALSE;
+    g_array_set_size(g->stale, 0);
+    emit_changed(g);
+}
+
+static gboolean job_done(gpointer data)
+{
+    DiffJob *j = data;
+    if (!g_cancellable_is_cancelled(j->cancel)) {   /* else the gutter is gone */
+        UmiDiffGutter *g = j->g;
+        g->busy = FALSE;
+        apply_job(g, j);
+        /* A debounce that fired while we were busy left its work here: a
+         * new base (the job was for a replaced one) or an edited window. */
+        if (g->pending || g->dirty) schedule(g);
+    }
+    job_free(j);
+    return G_SOURCE_REMOVE;
+}
+
+static void job_worker(gpointer data, gpointer user)
+{
+    (void)user;
+    DiffJob *j = data;
+    if (!g_cancellable_is_cancelled(j->cancel)) run_job(j);
+    g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, job_done, j, NULL);
+}
+
+static gboolean on_debounce(gpointer user)
+{
+    UmiDiffGutter *g = user;
+    g->debounce_id = 0;
+    if (g->busy) return G_SOURCE_REMOVE;        /* job_done reschedules */
+    DiffJob *j = take_job(g);
+    if (j) {
+        g->busy = TRUE;
+        g_thread_pool_push(g->pool, j, NULL);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static void schedule(UmiDiffGutter *g)
+{
+    if (!g->debounce_id)
+        g->debounce_id = g_timeout_add(UMI_GUTTER_DEBOUNCE_MS, on_debounce, g);
+}
+
+/*---------------------------------------------------------------------------
+ * Base
+ *-------------------------------------------------------------------------*/
+
+/* Drop the current base; 'blob' (may be NULL) becomes the next one. */
+static void replace_base(UmiDiffGutter *g, GBytes *blob)
+{
+    const gboolean had_marks = g->hunks->len || g->dirty;
+    g->serial++;
+    g_clear_pointer(&g->base, base_unref);
+    g_clear_pointer(&g->pending, g_bytes_unref);
+    g_array_set_size(g->hunks, 0);
+    g_array_set_size(g->stale, 0);
+    g->dirty = FALSE;
+    if (blob) {
+        g->pending = g_bytes_ref(blob);
+        schedule(g);
+    }
+    if (had_marks) emit_changed(g);
+}
+
+typedef struct {
+    UmiDiffGutter *g;
+    GCancellable  *cancel;
+} LoadCtx;
+
+static void on_blob_loaded(GObject *src, GAsyncResult *res, gpointer data)
+{
+    LoadCtx *l = data;
+    GBytes *out = NULL;
+    const gboolean ok = g_subprocess_communicate_finish(G_SUBPROCESS(src), res, &out, NULL, NULL)
+                        && g_subprocess_get_successful(G_SUBPROCESS(src));
+    if (!g_cancellable_is_cancelled(l->cancel)) {   /* else superseded or freed */
+        g_clear_object(&l->g->load_cancel);
+        /* Not in HEAD (new file) or not readable: no marks. */
+        if (ok && out) replace_base(l->g, out);
+    }
+    if (out) g_bytes_unref(out);
+    g_object_unref(l->cancel);
+    g_free(l);
+    g_object_unref(src);
+}
+
+static void load_head(UmiDiffGutter *g)
+{
+    if (g->load_cancel) {
+        g_cancellable_cancel(g->load_cancel);
+        g_clear_object(&g->load_cancel);
+    }
+    replace_base(g, NULL);
+    if (!g->path) return;
+
+    char *dir = g_path_get_dirname(g->path);
+    if (!umi_git_find_repo(dir, NULL, NULL)) { g_free(dir); return; }
+
+    /* "HEAD:./name" resolves against the working directory. */
+    char *name = g_path_get_basename(g->path);
+    char *spec = g_strconcat("HEAD:./", name, NULL);
+    const char *argv[] = { "git", "cat-file", "blob", spec, NULL };
+    GSubprocessLauncher *launcher = g_subprocess_launcher_new(
+        G_SUBPROCESS_FLAGS_STDOUT_PIPE | G_SUBPROCESS_FLAGS_STDERR_SILENCE);
+    g_subprocess_launcher_set_cwd(launcher, dir);
+    GSubprocess *sp = g_subprocess_launcher_spawnv(launcher, argv, NULL);
+    g_object_unref(launcher);
+    if (sp) {
+        LoadCtx *l = g_new0(LoadCtx, 1);
+        l->g      = g;
+        l->cancel = g_cancellable_new();
+        g->load_cancel = g_object_ref(l->cancel);
+        g_subprocess_communicate_async(sp, NULL, l->cancel, on_blob_loaded, l);
+    }
+    g_free(spec);
+    g_free(name);
+    g_free(dir);
+}
+
+/*---------------------------------------------------------------------------
+ * Public API
+ *-------------------------------------------------------------------------*/
+
+UmiDiffGutter *umi_diff_gutter_new(GtkTextBuffer *buffer)
+{
+    g_return_val_if_fail(GTK_IS_TEXT_BUFFER(buffer), NULL);
+    UmiDiffGutter *g = g_new0(UmiDiffGutter, 1);
+    g->buffer = g_object_ref(buffer);
+    g->hunks  = g_array_new(FALSE, FALSE, sizeof(UmiDiffHunk));
+    g->stale  = g_array_new(FALSE, FALSE, sizeof(UmiDiffHunk));
+    g->pool   = g_thread_pool_new(job_worker, NULL, 1, FALSE, NULL);
+    g->cancel = g_cancellable_new();
+    g->h_insert   = g_signal_connect(buffer, "insert-text", G_CALLBACK(on_insert_text), g);
+    g->h_inserted = g_signal_connect_after(buffer, "insert-text", G_CALLBACK(on_text_inserted), g);
+    g->h_delete   = g_signal_connect(buffer, "delete-range", G_CALLBACK(on_delete_range), g);
+    return g;
+}
+
+void umi_diff_gutter_free(UmiDiffGutter *g)
+{
+    if (!g) return;
+    g_cancellable_cancel(g->cancel);            /* a pending job_done frees its job */
+    if (g->load_cancel) { g_cancellable_cancel(g->load_cancel); g_object_unref(g->load_cancel); }
+    if (g->debounce_id) g_source_remove(g->debounce_id);
+    g_signal_handler_disconnect(g->buffer, g->h_insert);
+    g_signal_handler_disconnect(g->buffer, g->h_inserted);
+    g_signal_handler_disconnect(g->buffer, g->h_delete);
+    g_thread_pool_free(g->pool, FALSE, TRUE);
+    g_object_unref(g->cancel);
+    base_unref(g->base);
+    if (g->pending) g_bytes_unref(g->pending);
+    g_array_free(g->hunks, TRUE);
+    g_array_free(g->stale, TRUE);
+    g_object_unref(g->buffer);
+    g_free(g->path);
+    g_free(g);
+}
+
+void umi_diff_gutter_set_changed_cb(UmiDiffGutter *g, UmiDiffGutterChangedCb cb, gpointer user)
+{
+    if (!g) return;
+    g->cb   = cb;
+    g->user = user;
+}
+
+void umi_diff_gutter_set_file(UmiDiffGutter *g, const char *path)
+{
+    if (!g) return;
+    g_free(g->path);
+    g->path = path ? g_strdup(path) : NULL;
+    load_head(g);
+}
+
+void umi_diff_gutter_reload(UmiDiffGutter *g)
+{
+    if (g) load_head(g);
+}
+
+void umi_diff_gutter_set_base(UmiDiffGutter *g, const char *text, gssize len)
+{
+    if (!g) return;
+    if (g->load_cancel) {
+        g_cancellable_cancel(g->load_cancel);
+        g_clear_object(&g->load_cancel);
+    }
+    GBytes *blob = text ? g_bytes_new(text, len < 0 ? strlen(text) : (gsize)len) : NULL;
+    replace_base(g, blob);
+    if (blob) g_bytes_unref(blob);
+}
+
+gboolean umi_diff_gutter_flush(UmiDiffGutter *g)
+{
+    if (!g || g->busy) return FALSE;
+    if (g->debounce_id) { g_source_remove(g->debounce_id); g->debounce_id = 0; }
+    DiffJob *j;
+    while ((j = take_job(g))) {                 /* a new base is followed by its diff */
+        run_job(j);
+        apply_job(g, j);
+        job_free(j);
+        if (g->debounce_id) { g_source_remove(g->debounce_id); g->debounce_id = 0; }
+    }
+    return TRUE;
+}
+
+UmiGutterMark umi_diff_gutter_mark(const UmiDiffGutter *g, guint line)
+{
+    if (!g || !g->base) return UMI_GUTTER_NONE;
+    if (g->dirty && line >= g->d_line0 && line < g->d_line1) {
+        for (guint i = g->stale->len; i > 0; --i) {     /* newest first */
+            const UmiGutterMark mk = hunk_mark(&g_array_index(g->stale, UmiDiffHunk, i - 1), line);
+            if (mk) return mk;
+        }
+        return UMI_GUTTER_NONE;
+    }
+    return lookup(g->hunks, line);
+}
+
+void umi_diff_gutter_marks(const UmiDiffGutter *g, guint first, guint n, UmiGutterMark *out)
+{
+    if (!out) return;
+    for (guint i = 0; i < n; ++i) out[i] = umi_diff_gutter_mark(g, first + i);
+}
+
+guint umi_diff_gutter_n_hunks(const UmiDiffGutter *g)
+{
+    return (g && g->base) ? g->hunks->len : 0;
+}
+
+const UmiDiffHunk *umi_diff_gutter_hunk(const UmiDiffGutter *g, guint i)
+{
+    if (!g || !g->base || i >= g->hunks->len) return NULL;
+    return &g_array_index(g->hunks, UmiDiffHunk, i);
+}
+/*  END OF FILE */
@@ -22,6 +22,8 @@
 #include "problem_list.h"    /* umi_problem_list_* API               */
 #include "output_pane.h"     /* UmiOutputPane + widget accessor      */
 #include "status.h"          /* shim → forwards to status_util.h     */
+#include "diff_gutter.h"     /* changed-line marks against HEAD      */
+#include "blame_gutter.h"    /* blame annotations (off by default)   */
 
 static void on_problem_activate(gpointer user, const char *file, int line, int col)
 {
@@ -42,6 +44,8 @@ UmiEditor *umi_editor_new(void)
 
   /* Minimal text buffer so file operations compile even without a view yet. */
   ed->buffer = gtk_text_buffer_new(NULL);
+  ed->gutter = umi_diff_gutter_new(ed->buffer);
+  ed->blame  = umi_blame_gutter_new(ed->gutter);
 
   /* Root vertical box */
   ed->root = GTK_WIDGET(gtk_box_new(GTK_ORIENTATION_VERTICAL, 0));
@@ -86,6 +90,8 @@ void umi_editor_free(UmiEditor *ed)
 {
   if (!ed) return;
   g_clear_pointer(&ed->current_file, g_free);
+  g_clear_pointer(&ed->blame, umi_blame_gutter_free);   /* cancels a running blame */
+  g_clear_pointer(&ed->gutter, umi_diff_gutter_free);
   if (ed->buffer) g_object_unref(ed->buffer);
   if (ed->root)   g_object_unref(ed->root); /* children destroyed with root */
   g_free(ed);
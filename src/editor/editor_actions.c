@@ -21,6 +21,10 @@
 #include <gtk/gtk.h>
 #include <glib.h>
 #include "editor_actions.h"   /* public prototypes */
+#include "diff_gutter.h"      /* umi_diff_gutter_set_file() */
+#include "blame_gutter.h"     /* umi_blame_gutter_set_file() */
+#include "symbol_index.h"     /* umi_symbol_index_lookup()  */
+#include "file_meta.h"        /* umi_file_meta_stat/kind()  */
 
 static GtkTextBuffer* ensure_buffer(UmiEditor *ed)
 {
@@ -29,6 +33,35 @@ static GtkTextBuffer* ensure_buffer(UmiEditor *ed)
     return ed->buffer;
 }
 
+void umi_editor_set_index(UmiEditor *ed, UmiFileIndex *idx)
+{
+    if (ed) ed->index = idx;
+}
+
+/* Refuse files the index knows to be binary or too large, before reading
+ * them; the walk already stat()ed them and the kind is read once per
+ * file version. */
+static gboolean check_indexed(UmiEditor *ed, const char *path, GError **err)
+{
+    if (!ed->index) return TRUE;
+    const guint32 id = umi_index_lookup(ed->index, path);
+    if (id == UMI_INDEX_NO_FILE) return TRUE;
+
+    UmiFileMeta *meta = umi_index_meta(ed->index);
+    UmiFileStat  st;
+    if (umi_file_meta_stat(meta, id, &st) && st.size > (gint64)UMI_EDITOR_MAX_OPEN) {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_NO_SPACE,
+                    "'%s' is too large to open (%" G_GINT64_FORMAT " bytes)", path, st.size);
+        return FALSE;
+    }
+    if (umi_file_meta_kind(meta, id) == UMI_FILE_KIND_BINARY) {
+        g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                    "'%s' is a binary file", path);
+        return FALSE;
+    }
+    return TRUE;
+}
+
 gboolean umi_editor_open_file(UmiEditor *ed, const char *path, GError **err)
 {
     if (!ed || !path || !*path) {
@@ -36,6 +69,7 @@ gboolean umi_editor_open_file(UmiEditor *ed, const char *path, GError **err)
                              "umi_editor_open_file: invalid editor or path");
         return FALSE;
     }
+    if (!check_indexed(ed, path, err)) return FALSE;
 
     gchar *txt = NULL;
     gsize len = 0;
@@ -50,6 +84,8 @@ gboolean umi_editor_open_file(UmiEditor *ed, const char *path, GError **err)
 
     g_free(ed->current_file);
     ed->current_file = g_strdup(path);
+    umi_diff_gutter_set_file(ed->gutter, path);
+    umi_blame_gutter_set_file(ed->blame, path);
 
     g_message("Editor: opened '%s' (%" G_GSIZE_FORMAT " bytes)", path, len);
     g_free(txt);
@@ -104,6 +140,8 @@ gboolean umi_editor_save_as_path(UmiEditor *ed, const char *path, GError **err)
     if (ok) {
         g_free(ed->current_file);
         ed->current_file = g_strdup(path);
+        umi_diff_gutter_set_file(ed->gutter, path);
+        umi_blame_gutter_set_file(ed->blame, path);
         g_message("Editor: saved-as '%s'", path);
     }
     g_free(txt);
@@ -125,5 +163,100 @@ void umi_editor_new_file(UmiEditor *ed)
 
     gtk_text_buffer_set_text(buf, "", -1);
     g_clear_pointer(&ed->current_file, g_free);
+    umi_diff_gutter_set_file(ed->gutter, NULL);
+    umi_blame_gutter_set_file(ed->blame, NULL);
     g_message("Editor: new file");
 }
+
+static gboolean is_word_char(gunichar c)
+{
+    return c == '_' || (c < 0x80 && g_ascii_isalnum((gchar)c));
+}
+
+char *umi_editor_word_at_cursor(UmiEditor *ed)
+{
+    if (!ed || !ed->buffer) return NULL;
+
+    GtkTextIter start, end;
+    gtk_text_buffer_get_iter_at_mark(ed->buffer, &start, gtk_text_buffer_get_insert(ed->buffer));
+    end = start;
+    while (!gtk_text_iter_is_start(&start)) {          /* back to the word start */
+        GtkTextIter prev = start;
+        gtk_text_iter_backward_char(&prev);
+        if (!is_word_char(gtk_text_iter_get_char(&prev))) break;
+        start = prev;
+    }
+    while (!gtk_text_iter_is_end(&end) && is_word_char(gtk_text_iter_get_char(&end)))
+        gtk_text_iter_forward_char(&end);
+    if (gtk_text_iter_equal(&start, &end) || g_unichar_isdigit(gtk_text_iter_get_char(&start)))
+        return NULL;
+    return gtk_text_buffer_get_text(ed->buffer, &start, &end, FALSE);
+}
+
+gboolean umi_editor_open_at(UmiEditor *ed, const char *path, guint line, guint column, GError **err)
+{
+    if (!ed || !path || !*path) {
+        if (err) g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                             "umi_editor_open_at: invalid editor or path");
+        return FALSE;
+    }
+    if (!ed->current_file || g_strcmp0(ed->current_file, path) != 0) {
+        if (!umi_editor_open_file(ed, path, err)) return FALSE;
+    }
+
+    /* Clamp to the buffer: the index may be a little behind the disk. */
+    GtkTextIter it;
+    const gint n_lines = gtk_text_buffer_get_line_count(ed->buffer);
+    gtk_text_buffer_get_iter_at_line(ed->buffer, &it, MIN((gint)MAX(line, 1u), n_lines) - 1);
+    const gint bytes = gtk_text_iter_get_bytes_in_line(&it);
+    if (column > 1) gtk_text_iter_set_line_index(&it, MIN((gint)column - 1, MAX(bytes - 1, 0)));
+    gtk_text_buffer_place_cursor(ed->buffer, &it);
+    return TRUE;
+}
+
+gboolean umi_editor_goto_definition(UmiEditor *ed, UmiSymbolIndex *symbols, const char *root,
+                                    GError **err)
+{
+    if (!ed || !symbols || !root) {
+        if (err) g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                             "umi_editor_goto_definition: invalid arguments");
+        return FALSE;
+    }
+    char *name = umi_editor_word_at_cursor(ed);
+    if (!name) {
+        if (err) g_set_error(err, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "No identifier at the cursor");
+        return FALSE;
+    }
+
+    GArray *defs = g_array_new(FALSE, FALSE, sizeof(UmiSymbol));
+    umi_symbol_index_lookup(symbols, name, defs);
+
+    /* Prefer a definition in this file, but not the one already under the
+     * cursor: asking again from a definition moves on to the next. */
+    GtkTextIter cur;
+    gtk_text_buffer_get_iter_at_mark(ed->buffer, &cur, gtk_text_buffer_get_insert(ed->buffer));
+    const guint cur_line = (guint)gtk_text_iter_get_line(&cur) + 1;
+    gint best = -1, best_rank = G_MAXINT;
+    for (guint i = 0; i < defs->len; ++i) {
+        const UmiSymbol *sym = &g_array_index(defs, UmiSymbol, i);
+        char *full = g_build_filename(root, sym->path, NULL);
+        const gboolean here = ed->current_file && g_strcmp0(full, ed->current_file) == 0;
+        g_free(full);
+        const gint rank = here && sym->line == cur_line ? 2 : (here ? 0 : 1);
+        if (rank < best_rank) { best = (gint)i; best_rank = rank; }
+    }
+
+    gboolean ok = FALSE;
+    if (best < 0) {
+        if (err) g_set_error(err, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "No definition of '%s'", name);
+    } else {
+        const UmiSymbol *sym = &g_array_index(defs, UmiSymbol, best);
+        char *full = g_build_filename(root, sym->path, NULL);   /* before the index moves */
+        const guint line = sym->line, column = sym->column;
+        ok = umi_editor_open_at(ed, full, line, column, err);
+        g_free(full);
+    }
+    g_array_free(defs, TRUE);
+    g_free(name);
+    return ok;
+}
@@ -0,0 +1,68 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/editor/include/blame_gutter.h
+ *
+ * PURPOSE:
+ *   Blame annotations (commit, author, date) for the lines of an editor
+ *   buffer. A gutter renderer asks for the annotation of the visible lines
+ *   and repaints when told that more arrived.
+ *
+ * DESIGN:
+ *   - Annotations come from git_blame.h for the current file's HEAD
+ *     version. They stream in: the first chunks are shown while blame of
+ *     a large file is still running.
+ *   - Buffer lines are mapped to HEAD lines through the diff gutter's
+ *     hunks; lines added or modified in the buffer have no annotation.
+ *   - Blame is costly, so nothing runs until annotations are enabled.
+ *     Switching to another file, closing it or disabling the annotations
+ *     cancels the running request (git is killed).
+ *
+ * API:
+ *   UmiBlameGutter       *umi_blame_gutter_new(UmiDiffGutter *diff);
+ *   void                  umi_blame_gutter_free(UmiBlameGutter *g);
+ *   void                  umi_blame_gutter_set_enabled(UmiBlameGutter *g, gboolean on);
+ *   void                  umi_blame_gutter_set_file(UmiBlameGutter *g, const char *path);
+ *   const UmiBlameChunk  *umi_blame_gutter_line(const UmiBlameGutter *g, guint line);
+ *
+ * THREADING:
+ *   - Main thread only.
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_BLAME_GUTTER_H
+#define UMICOM_BLAME_GUTTER_H
+
+#include <glib.h>
+#include "diff_gutter.h"
+#include "git_blame.h"
+
+G_BEGIN_DECLS
+
+typedef struct _UmiBlameGutter UmiBlameGutter;
+
+/* Runs on the main loop when annotations arrived or were dropped. */
+typedef void (*UmiBlameGutterChangedCb)(UmiBlameGutter *g, gpointer user);
+
+/* Annotate the buffer 'diff' tracks ('diff' is borrowed and must outlive
+ * the gutter). Disabled until umi_blame_gutter_set_enabled(). */
+UmiBlameGutter      *umi_blame_gutter_new(UmiDiffGutter *diff);
+void                 umi_blame_gutter_free(UmiBlameGutter *g);
+
+void                 umi_blame_gutter_set_changed_cb(UmiBlameGutter *g, UmiBlameGutterChangedCb cb,
+                                                     gpointer user);
+
+/* Show annotations (starts blame of the current file) or hide them. */
+void                 umi_blame_gutter_set_enabled(UmiBlameGutter *g, gboolean on);
+gboolean             umi_blame_gutter_is_enabled(const UmiBlameGutter *g);
+
+/* The buffer shows 'path' (NULL: closed). A running blame is cancelled. */
+void                 umi_blame_gutter_set_file(UmiBlameGutter *g, const char *path);
+
+/* Annotation of buffer line 'line' (0-based), or NULL: disabled, not
+ * known yet, or the line differs from HEAD. Valid until the next call
+ * into the gutter. */
+const UmiBlameChunk *umi_blame_gutter_line(const UmiBlameGutter *g, guint line);
+
+G_END_DECLS
+
+#endif /* UMICOM_BLAME_GUTTER_H */
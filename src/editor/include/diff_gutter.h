@@ -0,0 +1,93 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/editor/include/diff_gutter.h
+ *
+ * PURPOSE:
+ *   Changed-line markers for an editor buffer: which lines are added or
+ *   modified relative to the file in HEAD, and where HEAD lines were
+ *   deleted. A gutter renderer asks for the marks of the visible lines.
+ *
+ * DESIGN:
+ *   - The HEAD blob is fetched once per file ("git cat-file", async) and
+ *     kept, split into hashed lines, until the file or HEAD changes.
+ *   - Lines are compared by hash (confirmed byte-wise) with Myers' O(ND)
+ *     diff in linear space.
+ *   - Edits are taken from the buffer's insert-text / delete-range signals
+ *     as line ranges. Hunks away from an edit are only shifted; the window
+ *     around it (a few lines of context plus any hunk it touches) is
+ *     re-diffed on a worker thread after a short debounce.
+ *   - The first diff after a base is loaded covers the whole file and runs
+ *     on the worker as well: the main thread never diffs.
+ *
+ * API:
+ *   UmiDiffGutter *umi_diff_gutter_new(GtkTextBuffer *buffer);
+ *   void           umi_diff_gutter_free(UmiDiffGutter *g);
+ *   void           umi_diff_gutter_set_file(UmiDiffGutter *g, const char *path);
+ *   void           umi_diff_gutter_reload(UmiDiffGutter *g);
+ *   void           umi_diff_gutter_set_base(UmiDiffGutter *g, const char *text, gssize len);
+ *   UmiGutterMark  umi_diff_gutter_mark(const UmiDiffGutter *g, guint line);
+ *
+ * THREADING:
+ *   - Main thread only (the diff itself runs on an internal worker).
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_DIFF_GUTTER_H
+#define UMICOM_DIFF_GUTTER_H
+
+#include <gtk/gtk.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+    UMI_GUTTER_NONE = 0,
+    UMI_GUTTER_ADDED,      /* not in HEAD                                     */
+    UMI_GUTTER_MODIFIED,   /* replaces HEAD lines                             */
+    UMI_GUTTER_DELETED     /* HEAD lines removed just below (above line 0)    */
+} UmiGutterMark;
+
+/* One difference: base lines [base_start, +base_len) became buffer lines
+ * [line_start, +line_len). Either length may be 0. */
+typedef struct {
+    guint base_start, base_len;
+    guint line_start, line_len;
+} UmiDiffHunk;
+
+typedef struct _UmiDiffGutter UmiDiffGutter;
+
+/* Runs on the main loop when marks changed. */
+typedef void (*UmiDiffGutterChangedCb)(UmiDiffGutter *g, gpointer user);
+
+/* Track 'buffer' (a reference is kept). No marks until a base is set. */
+UmiDiffGutter *umi_diff_gutter_new(GtkTextBuffer *buffer);
+void           umi_diff_gutter_free(UmiDiffGutter *g);
+
+void           umi_diff_gutter_set_changed_cb(UmiDiffGutter *g, UmiDiffGutterChangedCb cb, gpointer user);
+
+/* The buffer shows 'path': compare with its HEAD version, loaded in the
+ * background. Files outside git or not in HEAD get no marks; NULL clears. */
+void           umi_diff_gutter_set_file(UmiDiffGutter *g, const char *path);
+
+/* Fetch HEAD again (after a commit, checkout, ...). */
+void           umi_diff_gutter_reload(UmiDiffGutter *g);
+
+/* Compare with 'text' instead (len -1: NUL-terminated); NULL clears. */
+void           umi_diff_gutter_set_base(UmiDiffGutter *g, const char *text, gssize len);
+
+/* Run pending diff work now, synchronously. For tools and tests without a
+ * main loop; FALSE while the worker is busy. */
+gboolean       umi_diff_gutter_flush(UmiDiffGutter *g);
+
+/* Mark of buffer line 'line' (0-based), or of 'n' lines from 'first'. */
+UmiGutterMark  umi_diff_gutter_mark(const UmiDiffGutter *g, guint line);
+void           umi_diff_gutter_marks(const UmiDiffGutter *g, guint first, guint n, UmiGutterMark *out);
+
+/* Settled hunks in buffer order (a region still waiting for its re-diff
+ * is left out), e.g. for next/previous change navigation. */
+guint              umi_diff_gutter_n_hunks(const UmiDiffGutter *g);
+const UmiDiffHunk *umi_diff_gutter_hunk(const UmiDiffGutter *g, guint i);
+
+G_END_DECLS
+
+#endif /* UMICOM_DIFF_GUTTER_H */
@@ -10,6 +10,11 @@
  * DESIGN:
  *   - Header kept lightweight with forward declarations.
  *   - Avoids deep/relative include paths; names only.
+ *   - The buffer carries a diff gutter (diff_gutter.h) that follows the
+ *     current file's HEAD version, and blame annotations (blame_gutter.h)
+ *     mapped through it once enabled.
+ *   - Opening a file the project index knows asks its metadata cache
+ *     (file_meta.h) whether it is binary or too large before reading it.
  *
  * API:
  *   UmiEditor *umi_editor_new(void);
@@ -33,6 +38,9 @@ G_BEGIN_DECLS  /* allow clean inclusion from C++ units if needed */
 typedef struct _UmiOutputPane  UmiOutputPane;
 typedef struct _UmiProblemList UmiProblemList;
 typedef struct _UmiStatus      UmiStatus;
+typedef struct _UmiDiffGutter  UmiDiffGutter;
+typedef struct _UmiBlameGutter UmiBlameGutter;
+typedef struct _UmiFileIndex   UmiFileIndex;
 
 /* Public editor state used across the app. */
 typedef struct _UmiEditor {
@@ -43,6 +51,9 @@ typedef struct _UmiEditor {
   GtkTextBuffer  *buffer;       /* detached text buffer (no view yet)            */
   char           *current_file; /* full path of current file (or NULL)           */
   UmiStatus      *status;       /* optional status object                         */
+  UmiDiffGutter  *gutter;       /* changed-line marks of 'buffer' against HEAD    */
+  UmiBlameGutter *blame;        /* blame of the current file; follows 'gutter'    */
+  UmiFileIndex   *index;        /* borrowed: project files, for their metadata    */
 } UmiEditor;
 
 UmiEditor *umi_editor_new(void);
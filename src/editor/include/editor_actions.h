@@ -16,6 +16,10 @@
  *   gboolean umi_editor_save_as  (UmiEditor *ed, GError **err);
  *   gboolean umi_editor_save_as_path(UmiEditor *ed, const char *path, GError **err);
  *   void     umi_editor_new_file (UmiEditor *ed);
+ *   void     umi_editor_set_index(UmiEditor *ed, UmiFileIndex *idx);
+ *   char    *umi_editor_word_at_cursor(UmiEditor *ed);
+ *   gboolean umi_editor_open_at(UmiEditor *ed, const char *path, guint line, guint column, GError **err);
+ *   gboolean umi_editor_goto_definition(UmiEditor *ed, UmiSymbolIndex *symbols, const char *root, GError **err);
  *
  * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
  *---------------------------------------------------------------------------*/
@@ -24,10 +28,36 @@
 
 #include "editor.h"  /* UmiEditor, GtkTextBuffer */
 
+typedef struct _UmiSymbolIndex UmiSymbolIndex;
+
 gboolean umi_editor_open_file   (UmiEditor *ed, const char *path, GError **err);
 gboolean umi_editor_save        (UmiEditor *ed, GError **err);
 gboolean umi_editor_save_as     (UmiEditor *ed, GError **err);
 gboolean umi_editor_save_as_path(UmiEditor *ed, const char *path, GError **err);
 void     umi_editor_new_file    (UmiEditor *ed);
 
+/* Project index (borrowed; NULL to drop it). Opening one of its files is
+ * refused without reading it when the index's metadata says it is binary
+ * (G_IO_ERROR_INVALID_DATA) or larger than UMI_EDITOR_MAX_OPEN
+ * (G_IO_ERROR_NO_SPACE). Other files open unchecked. */
+#define UMI_EDITOR_MAX_OPEN (64u << 20)
+void     umi_editor_set_index   (UmiEditor *ed, UmiFileIndex *idx);
+
+/* Identifier ([A-Za-z0-9_]) at or just before the cursor, e.g. for "find
+ * references"; NULL when there is none. Free with g_free(). */
+char    *umi_editor_word_at_cursor(UmiEditor *ed);
+
+/* Open 'path' (unless it is the current file) and put the cursor on
+ * 'line':'column' (1-based, byte column), e.g. for a palette "@symbol"
+ * pick or a search result. */
+gboolean umi_editor_open_at     (UmiEditor *ed, const char *path, guint line, guint column,
+                                 GError **err);
+
+/* Go to the definition of the identifier at the cursor, looked up in
+ * 'symbols' (paths relative to 'root'). A definition in the current file
+ * wins; from a definition, the next one is taken. G_IO_ERROR_NOT_FOUND
+ * when there is none. */
+gboolean umi_editor_goto_definition(UmiEditor *ed, UmiSymbolIndex *symbols, const char *root,
+                                    GError **err);
+
 #endif /* UMICOM_EDITOR_ACTIONS_H */
@@ -17,6 +17,7 @@
  *   GtkWidget    *umi_status_bar_widget(UmiStatusBar *sb);   // pack this
  *   void          umi_status_bar_set  (UmiStatusBar *sb, const char *text);
  *   void          umi_status_bar_flash(UmiStatusBar *sb, const char *text, guint ms);
+ *   void          umi_status_bar_set_git(UmiStatusBar *sb, UmiGitStatusEngine *git);
  *   void          umi_status_bar_free (UmiStatusBar *sb);
  *
  * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
@@ -30,11 +31,15 @@
 G_BEGIN_DECLS
 
 typedef struct _UmiStatusBar UmiStatusBar;
+typedef struct _UmiGitStatusEngine UmiGitStatusEngine;  /* git_status.h */
 
 UmiStatusBar *umi_status_bar_new(void);
 GtkWidget    *umi_status_bar_widget(UmiStatusBar *sb);
 void          umi_status_bar_set  (UmiStatusBar *sb, const char *text);
 void          umi_status_bar_flash(UmiStatusBar *sb, const char *text, guint ms);
+/* Show branch and change counts from 'git' at the right edge, following its
+ * updates (NULL hides them). Borrowed: detach before freeing 'git'. */
+void          umi_status_bar_set_git(UmiStatusBar *sb, UmiGitStatusEngine *git);
 void          umi_status_bar_free (UmiStatusBar *sb);
 
 G_END_DECLS
@@ -8,6 +8,8 @@
  * DESIGN:
  *   - Root is a vertical box: [ GtkSeparator ] + [ horizontal content box ].
  *   - Spacing/margins in code; no gtk_widget_add_css_class calls.
+ *   - Optional git segment at the right edge: branch plus counts of changed
+ *     files, re-rendered when the attached status engine reports changes.
  *
  * SECURITY/ROBUSTNESS:
  *   - All pointers guarded; flash timeout id cleared on cancel.
@@ -18,12 +20,16 @@
 #include <gtk/gtk.h>
 #include <glib.h>
 #include "status_bar.h"
+#include "git_status.h"
 
 struct _UmiStatusBar {
     GtkWidget *root;     /* vertical box: separator + content row              */
     GtkWidget *row;      /* horizontal row containing the text label           */
     GtkWidget *label;    /* shows the current status text                      */
     guint      flash_id; /* timeout source id for flash(); 0 when inactive     */
+    GtkWidget *git_label;/* branch + change counts; empty without git          */
+    UmiGitStatusEngine *git; /* borrowed                                       */
+    guint      git_listener;
 };
 
 static gboolean flash_clear_cb(gpointer data)
@@ -54,7 +60,11 @@ UmiStatusBar *umi_status_bar_new(void)
     gtk_label_set_xalign(GTK_LABEL(sb->label), 0.0f);
     gtk_widget_set_hexpand(sb->label, TRUE);
 
+    sb->git_label = gtk_label_new("");
+    gtk_label_set_xalign(GTK_LABEL(sb->git_label), 1.0f);
+
     gtk_box_append(GTK_BOX(sb->row), sb->label);
+    gtk_box_append(GTK_BOX(sb->row), sb->git_label);
     gtk_box_append(GTK_BOX(sb->root), sb->row);
 
     return sb;
@@ -81,9 +91,38 @@ void umi_status_bar_flash(UmiStatusBar *sb, const char *text, guint ms)
     sb->flash_id = g_timeout_add(ms, flash_clear_cb, sb);
 }
 
+/* "main  3M 1D 2?" : branch, then only the non-zero counts. */
+static void git_changed_cb(UmiGitStatusEngine *git, gpointer data)
+{
+    UmiStatusBar *sb = (UmiStatusBar *)data;
+    if (!git) { gtk_label_set_text(GTK_LABEL(sb->git_label), ""); return; }
+
+    static const UmiGitFileStatus order[] = {
+        UMI_GIT_CONFLICTED, UMI_GIT_MODIFIED, UMI_GIT_DELETED, UMI_GIT_ADDED, UMI_GIT_UNTRACKED
+    };
+    const char *branch = umi_git_status_branch(git);
+    GString *s = g_string_new(branch ? branch : "");
+    for (guint i = 0; i < G_N_ELEMENTS(order); ++i) {
+        const guint n = umi_git_status_count(git, order[i]);
+        if (n) g_string_append_printf(s, "%s%u%c", s->len ? "  " : "", n, umi_git_status_letter(order[i]));
+    }
+    gtk_label_set_text(GTK_LABEL(sb->git_label), s->str);
+    g_string_free(s, TRUE);
+}
+
+void umi_status_bar_set_git(UmiStatusBar *sb, UmiGitStatusEngine *git)
+{
+    if (!sb || sb->git == git) return;
+    if (sb->git) umi_git_status_remove_listener(sb->git, sb->git_listener);
+    sb->git = git;
+    sb->git_listener = git ? umi_git_status_add_listener(git, git_changed_cb, sb) : 0;
+    git_changed_cb(git, sb);
+}
+
 void umi_status_bar_free(UmiStatusBar *sb)
 {
     if (!sb) return;
+    if (sb->git) umi_git_status_remove_listener(sb->git, sb->git_listener);
     if (sb->flash_id) { g_source_remove(sb->flash_id); sb->flash_id = 0; }
     gtk_widget_destroy(sb->root);
     g_free(sb);
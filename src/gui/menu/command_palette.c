@@ -11,11 +11,20 @@
 #include <ctype.h>
 
 #include "command_palette.h"
+#include "symbol_index.h"
+
+#define PALETTE_MAX_SYMBOLS 50
 
 /* Opaque state (defined only in .c) */
 struct _UmiPalette {
-  const UmiCommand *table;
-  gpointer          user;
+  const UmiCommand   *table;
+  gpointer            user;
+
+  /* "@name" queries list symbols instead of commands (optional). */
+  UmiSymbolIndex     *symbols;
+  UmiPaletteSymbolFn  on_symbol;
+  gpointer            symbol_user;
+  GArray             *hits;      /* UmiSymbol of the current list */
 
   GtkWindow *win;
   GtkWidget *content;
@@ -68,11 +77,42 @@ static void on_command_clicked(GtkButton *btn, gpointer user)
   gtk_window_close(p->win);
 }
 
+static void on_symbol_clicked(GtkButton *btn, gpointer user)
+{
+  struct _UmiPalette *p = (struct _UmiPalette*)user;
+  const guint idx = (guint)(uintptr_t)g_object_get_data(G_OBJECT(btn), "idx");
+  if (!p || idx >= p->hits->len) return;
+
+  const UmiSymbol *sym = &g_array_index(p->hits, UmiSymbol, idx);
+  if (p->on_symbol) p->on_symbol(sym->path, sym->line, sym->column, p->symbol_user);
+  gtk_window_close(p->win);
+}
+
+static void populate_symbols(struct _UmiPalette *p, const char *q)
+{
+  umi_symbol_index_query(p->symbols, q, PALETTE_MAX_SYMBOLS, p->hits);
+  for (guint i = 0; i < p->hits->len; ++i) {
+    const UmiSymbol *sym = &g_array_index(p->hits, UmiSymbol, i);
+    char *label = g_strdup_printf("%s%s%s  (%s)  %s:%u", sym->scope, *sym->scope ? "::" : "",
+                                  sym->name, umi_symbol_kind_name(sym->kind), sym->path, sym->line);
+    GtkWidget *btn = gtk_button_new_with_label(label);
+    g_free(label);
+
+    g_object_set_data(G_OBJECT(btn), "idx", (gpointer)(uintptr_t)i);
+    g_signal_connect(btn, "clicked", G_CALLBACK(on_symbol_clicked), p);
+    gtk_box_append(GTK_BOX(p->list), btn);
+  }
+}
+
 static void populate(struct _UmiPalette *p, const char *q)
 {
   if (!p || !p->list || !p->table) return;
 
   clear_list(p->list);
+  if (q && q[0] == '@' && p->symbols) {
+    populate_symbols(p, q);
+    return;
+  }
 
   for (guint i = 0; p->table[i].name; ++i) {
     const char *name = p->table[i].name;
@@ -105,6 +145,7 @@ UmiPalette *umi_palette_new(const UmiCommand *table, gpointer user)
   struct _UmiPalette *p = g_new0(struct _UmiPalette, 1);
   p->table = table;
   p->user  = user;
+  p->hits  = g_array_new(FALSE, FALSE, sizeof(UmiSymbol));
 
   p->win = GTK_WINDOW(gtk_window_new());
   gtk_window_set_title(p->win, "Command Palette");
@@ -130,6 +171,16 @@ UmiPalette *umi_palette_new(const UmiCommand *table, gpointer user)
   return (UmiPalette*)p;
 }
 
+void umi_palette_set_symbols(UmiPalette *pp, UmiSymbolIndex *symbols,
+                             UmiPaletteSymbolFn on_symbol, gpointer user)
+{
+  struct _UmiPalette *p = (struct _UmiPalette*)pp;
+  if (!p) return;
+  p->symbols     = symbols;
+  p->on_symbol   = on_symbol;
+  p->symbol_user = user;
+}
+
 void umi_palette_open(UmiPalette *pp, GtkWindow *parent)
 {
   struct _UmiPalette *p = (struct _UmiPalette*)pp;
@@ -143,5 +194,6 @@ void umi_palette_free(UmiPalette *pp)
   struct _UmiPalette *p = (struct _UmiPalette*)pp;
   if (!p) return;
   gtk_window_destroy(p->win);
+  g_array_free(p->hits, TRUE);
   g_free(p);
 }
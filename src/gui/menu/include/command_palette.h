@@ -8,6 +8,7 @@
 #define UMICOM_COMMAND_PALETTE_H
 
 #include <gtk/gtk.h>
+#include "symbol_index.h"
 
 G_BEGIN_DECLS
 
@@ -21,7 +22,13 @@ typedef struct {
 
 typedef struct _UmiPalette UmiPalette;
 
+/* A symbol was picked: open 'path' (relative to the project root) there. */
+typedef void (*UmiPaletteSymbolFn)(const char *path, guint line, guint column, gpointer user);
+
 UmiPalette *umi_palette_new (const UmiCommand *table, gpointer user);
+/* Answer "@name" queries from 'symbols' (borrowed; NULL turns them off). */
+void        umi_palette_set_symbols(UmiPalette *p, UmiSymbolIndex *symbols,
+                                    UmiPaletteSymbolFn on_symbol, gpointer user);
 void        umi_palette_open(UmiPalette *p, GtkWindow *parent);
 void        umi_palette_free(UmiPalette *p);
 
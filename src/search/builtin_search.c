@@ -0,0 +1,283 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/builtin_search.c
+ * PURPOSE: In-process text search, the fallback when ripgrep is missing
+ *
+ * DESIGN:
+ *   - The file loop, reading, batching and cancellation are the shared
+ *     search stream's (search_stream.h); this file plans the pattern and
+ *     scans one file.
+ *   - Planning compiles the pattern and picks its longest required
+ *     literal, the "needle" (umi_trigram_literal_runs).
+ *   - Scanning looks for the needle with memmem (case-sensitive) or
+ *     memchr on one byte of it (caseless), and only runs GRegex on the
+ *     line around each hit. A plain pattern never touches GRegex: the
+ *     needle hits are the matches. A regex without any usable literal is
+ *     run on every line. Long files poll the stream's stop flag every few
+ *     thousand lines.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#define _GNU_SOURCE                   /* memmem */
+#include <string.h>
+#include "builtin_search.h"
+#include "search_stream.h"
+#include "trigram_index.h"
+
+#define BS_POLL_LINES    4096u        /* lines between checks of 'stop'      */
+
+typedef struct {
+  GArray       *spans;              /* UmiSearchSpan of the current line     */
+  const guchar *fend;               /* end of the file being searched        */
+  const guchar *memo[2];            /* next anchor byte per case, or 'fend'  */
+} BsWorker;
+
+typedef struct {
+  GRegex           *re;             /* NULL: the needle is the pattern       */
+  guchar           *needle;         /* NULL: every line is a candidate       */
+  gsize             nlen;
+  gsize             anchor;         /* needle byte memchr looks for          */
+  guchar            anchor_cases[2];
+  gboolean          caseless;
+  BsWorker         *workers;
+  guint             n_workers;
+} BsSearch;
+
+/*---------------------------------------------------------------------------
+ * Finding the needle
+ *---------------------------------------------------------------------------*/
+static const guchar *find_bytes(const guchar *h, gsize hl, const guchar *n, gsize nl) {
+#if defined(__GLIBC__) || defined(__APPLE__) || defined(__FreeBSD__)
+  return memmem(h, hl, n, nl);                     /* vectorized in glibc    */
+#else
+  if (hl < nl) return NULL;
+  const guchar *end = h + hl - nl + 1;
+  for (const guchar *p = h; p < end; ++p) {
+    p = memchr(p, n[0], (gsize)(end - p));
+    if (!p) return NULL;
+    if (memcmp(p, n, nl) == 0) return p;
+  }
+  return NULL;
+#endif
+}
+
+static gboolean fold_equal(const guchar *a, const guchar *b, gsize n) {
+  for (gsize i = 0; i < n; ++i)
+    if (g_ascii_tolower(a[i]) != g_ascii_tolower(b[i])) return FALSE;
+  return TRUE;
+}
+
+/* Next 'c' at or after 'p' in the file, or w->fend. The answer is kept in
+ * '*memo', so a byte that is rare in the file is not rescanned to the end
+ * for every candidate of the other case. */
+static const guchar *next_byte(BsWorker *w, const guchar **memo, guchar c, const guchar *p) {
+  if (*memo && *memo >= p) return *memo;
+  const guchar *q = p < w->fend ? memchr(p, c, (gsize)(w->fend - p)) : NULL;
+  return *memo = q ? q : w->fend;
+}
+
+/* First needle in [p, end), or NULL. Caseless: find the anchor byte in
+ * either case, then compare the whole needle ASCII-folded. */
+static const guchar *needle_find(const BsSearch *s, BsWorker *w,
+                                 const guchar *p, const guchar *end) {
+  if (p >= end || (gsize)(end - p) < s->nlen) return NULL;
+  if (!s->caseless) return find_bytes(p, (gsize)(end - p), s->needle, s->nlen);
+
+  const gsize tail = s->nlen - s->anchor;
+  for (const guchar *from = p + s->anchor; ; ) {
+    const guchar *q = next_byte(w, &w->memo[0], s->anchor_cases[0], from);
+    if (s->anchor_cases[1] != s->anchor_cases[0])
+      q = MIN(q, next_byte(w, &w->memo[1], s->anchor_cases[1], from));
+    if (q >= end || (gsize)(end - q) < tail) return NULL;
+    if (fold_equal(q - s->anchor, s->needle, s->nlen)) return q - s->anchor;
+    from = q + 1;
+  }
+}
+
+/*---------------------------------------------------------------------------
+ * Scanning (worker threads)
+ *---------------------------------------------------------------------------*/
+/* Collect the matches on the line [ls, le); 'hit' is the first needle in
+ * it (NULL without a needle). Spans starting well past the first one are
+ * never shown (the store keeps a window of UMI_SEARCH_PREVIEW_MAX bytes
+ * from a little before it), so they end the scan, and only that much of a
+ * long line is copied. */
+static void match_line(UmiSearchStream *ss, BsSearch *s, guint worker, guint32 file,
+                       guint32 line, const guchar *ls, const guchar *le, const guchar *hit) {
+  BsWorker *w = &s->workers[worker];
+  const gsize n = (gsize)(le - ls);
+  gsize limit = n;
+  g_array_set_size(w->spans, 0);
+
+  if (!s->re) {
+    for (const guchar *q = hit; q; q = needle_find(s, w, q + s->nlen, le)) {
+      UmiSearchSpan sp = { (guint32)(q - ls), (guint32)(q - ls + s->nlen) };
+      if (!w->spans->len) limit = MIN(n, (gsize)sp.start + UMI_SEARCH_PREVIEW_MAX);
+      else if (sp.start > limit) break;
+      g_array_append_val(w->spans, sp);
+    }
+  } else {
+    GMatchInfo *mi = NULL;
+    g_regex_match_full(s->re, (const char *)ls, (gssize)n, 0, 0, &mi, NULL);
+    while (g_match_info_matches(mi)) {
+      gint a = -1, b = -1;
+      if (g_match_info_fetch_pos(mi, 0, &a, &b) && a >= 0) {
+        UmiSearchSpan sp = { (guint32)a, (guint32)b };
+        if (!w->spans->len) limit = MIN(n, (gsize)sp.start + UMI_SEARCH_PREVIEW_MAX);
+        else if (sp.start > limit) break;
+        g_array_append_val(w->spans, sp);
+      }
+      if (!g_match_info_next(mi, NULL)) break;
+    }
+    g_match_info_free(mi);
+  }
+  if (w->spans->len)
+    umi_search_stream_row(ss, worker, 0, file, line, ls, limit,
+                          (const UmiSearchSpan *)(const void *)w->spans->data, w->spans->len);
+}
+
+/* Lines are numbered lazily: newlines are only counted (memchr) up to the
+ * next needle hit, never looked at one by one. */
+static void search_buffer(UmiSearchStream *ss, guint worker, guint32 file,
+                          const guchar *data, gsize len, gpointer engine) {
+  BsSearch *s = engine;
+  BsWorker *w = &s->workers[worker];
+  const guchar *end = data + len;
+  const guchar *bol = data;        /* start of line 'line'; searched from   */
+  guint32 line = 1;
+  guint   polls = 0;
+  w->fend = end;
+  w->memo[0] = w->memo[1] = NULL;
+
+  while (bol < end) {
+    const guchar *hit = NULL;
+    if (s->needle) {
+      hit = needle_find(s, w, bol, end);
+      if (!hit) break;
+      for (const guchar *q; (q = memchr(bol, '\n', (gsize)(hit - bol))); bol = q + 1) ++line;
+    }
+    const guchar *from = hit ? hit : bol;
+    const guchar *nl   = memchr(from, '\n', (gsize)(end - from));
+    match_line(ss, s, worker, file, line, bol, nl ? nl : end, hit);
+    if (!nl) break;
+    bol = nl + 1;
+    ++line;
+    if (++polls % BS_POLL_LINES == 0 && umi_search_stream_stopped(ss)) break;
+  }
+}
+
+/*---------------------------------------------------------------------------
+ * Planning (main loop)
+ *---------------------------------------------------------------------------*/
+static void search_free(gpointer data) {
+  BsSearch *s = data;
+  for (guint i = 0; i < s->n_workers; ++i) g_array_free(s->workers[i].spans, TRUE);
+  g_free(s->workers);
+  if (s->re) g_regex_unref(s->re);
+  g_free(s->needle);
+  g_free(s);
+}
+
+/* How common a byte is in source text, roughly: whitespace, frequent
+ * letters (caseless, a letter also costs a second memchr), the rest. */
+static guint byte_rank(guchar c) {
+  if (c == ' ' || c == '\t') return 4;
+  if (g_ascii_isalpha(c)) return strchr("etaoinsrlcdu", g_ascii_tolower(c)) ? 3 : 2;
+  if (c && strchr("_();,.*=-/>", c)) return 2;
+  return 1;
+}
+
+/* Longest run, and for caseless matching its rarest byte as the one
+ * memchr looks for. */
+static void pick_needle(BsSearch *s, GPtrArray *runs) {
+  const char *best = NULL;
+  gsize blen = 0;
+  for (guint i = 0; i < runs->len; ++i) {
+    const gsize n = strlen(runs->pdata[i]);
+    if (n > blen) { best = runs->pdata[i]; blen = n; }
+  }
+  if (!best) return;
+  s->needle = (guchar *)g_strndup(best, blen);
+  s->nlen   = blen;
+  s->anchor = 0;
+  for (gsize i = 1; i < blen; ++i)
+    if (byte_rank(s->needle[i]) < byte_rank(s->needle[s->anchor])) s->anchor = i;
+  const guchar a = s->needle[s->anchor];
+  s->anchor_cases[0] = s->caseless ? (guchar)g_ascii_tolower(a) : a;
+  s->anchor_cases[1] = s->caseless ? (guchar)g_ascii_toupper(a) : a;
+}
+
+/* A stream for 'pattern', or NULL when it does not compile (then on_done
+ * is already scheduled). The caller adds the files and runs it. */
+static UmiSearchStream *search_new(const char *pattern, UmiBuiltinSearchFlags flags,
+                                   UmiSearchResults *out, guint max_results,
+                                   GCancellable *cancel, UmiSearchBatchCb on_batch,
+                                   UmiSearchDoneCb on_done, gpointer user) {
+  BsSearch *s = g_new0(BsSearch, 1);
+  s->caseless = (flags & UMI_BUILTIN_SEARCH_CASELESS) != 0;
+  UmiSearchStream *ss = umi_search_stream_new(0, search_buffer, NULL, s, search_free, out,
+                                              max_results, cancel, on_batch, on_done, user);
+  s->n_workers = umi_search_stream_n_workers(ss);
+  s->workers   = g_new0(BsWorker, s->n_workers);
+  for (guint i = 0; i < s->n_workers; ++i)
+    s->workers[i].spans = g_array_new(FALSE, FALSE, sizeof(UmiSearchSpan));
+
+  /* A plain pattern needs no regex; anything else is compiled (escaped
+   * when LITERAL is asked for an empty pattern, which matches every line). */
+  const gboolean plain = *pattern && ((flags & UMI_BUILTIN_SEARCH_LITERAL) ||
+                                      !strpbrk(pattern, ".^$|()[]{}*+?\\"));
+  if (!plain) {
+    GError *e = NULL;
+    GRegexCompileFlags cf = G_REGEX_RAW | G_REGEX_OPTIMIZE;
+    if (s->caseless) cf |= G_REGEX_CASELESS;
+    char *src = (flags & UMI_BUILTIN_SEARCH_LITERAL) ? g_regex_escape_string(pattern, -1)
+                                                     : g_strdup(pattern);
+    s->re = g_regex_new(src, cf, 0, &e);
+    g_free(src);
+    if (!s->re) {
+      umi_search_stream_fail(ss, e->message);
+      g_error_free(e);
+      return NULL;
+    }
+  }
+  GPtrArray *runs = g_ptr_array_new_with_free_func(g_free);
+  umi_trigram_literal_runs(pattern, plain ? 0 : UMI_TRIGRAM_REGEX, runs);
+  pick_needle(s, runs);
+  g_ptr_array_free(runs, TRUE);
+  return ss;
+}
+
+/*---------------------------------------------------------------------------
+ * umi_builtin_search_start:
+ *   Plan the pattern, snapshot the file list, search on a thread; see
+ *   builtin_search.h.
+ *---------------------------------------------------------------------------*/
+void umi_builtin_search_start(UmiFileIndex *idx, const char *pattern,
+                              UmiBuiltinSearchFlags flags, UmiSearchResults *out,
+                              guint max_results, GCancellable *cancel,
+                              UmiSearchBatchCb on_batch, UmiSearchDoneCb on_done,
+                              gpointer user) {
+  g_return_if_fail(idx != NULL && pattern != NULL && out != NULL && on_batch != NULL);
+  UmiSearchStream *ss = search_new(pattern, flags, out, max_results, cancel, on_batch, on_done, user);
+  if (!ss) return;
+  umi_search_stream_add_index(ss, idx, NULL);
+  umi_search_stream_run(ss);
+}
+
+/*---------------------------------------------------------------------------
+ * umi_builtin_search_files_start:
+ *   Same search over a list of files; see builtin_search.h.
+ *---------------------------------------------------------------------------*/
+void umi_builtin_search_files_start(const char *root, const char * const *files,
+                                    const char *pattern, UmiBuiltinSearchFlags flags,
+                                    UmiSearchResults *out, guint max_results,
+                                    GCancellable *cancel, UmiSearchBatchCb on_batch,
+                                    UmiSearchDoneCb on_done, gpointer user) {
+  g_return_if_fail(root != NULL && files != NULL && pattern != NULL && out != NULL &&
+                   on_batch != NULL);
+  UmiSearchStream *ss = search_new(pattern, flags, out, max_results, cancel, on_batch, on_done, user);
+  if (!ss) return;
+  umi_search_stream_add_files(ss, root, files);
+  umi_search_stream_run(ss);
+}
+/*---------------------------------------------------------------------------*/
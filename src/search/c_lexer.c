@@ -0,0 +1,257 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/c_lexer.c
+ * PURPOSE: Small C / C++ tokenizer shared by the code indexes
+ *
+ * DESIGN:
+ *   - One pass, no allocation. The only state carried between tokens is
+ *     the line bookkeeping, "inside a directive" and "at line start".
+ *   - A newline ends a directive unless a backslash splices it; splices
+ *     are otherwise treated as whitespace.
+ *   - "#if 0" skipping counts nested conditionals line by line; it stops
+ *     at the matching #else (resuming after it), #elif (resuming on it)
+ *     or #endif.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include "c_lexer.h"
+
+void umi_c_lexer_init(UmiCLexer *lx, const char *src, gsize len, UmiCLexFlags flags) {
+  g_return_if_fail(lx != NULL);
+  memset(lx, 0, sizeof *lx);
+  lx->src   = src ? src : "";
+  lx->len   = src ? len : 0;
+  lx->line  = 1;
+  lx->flags = flags;
+  lx->bol   = TRUE;
+}
+
+static inline void newline(UmiCLexer *lx, gsize nl) {
+  lx->line++;
+  lx->line_start = nl + 1;
+}
+
+/* Backslash + line break at 'p'? Returns the bytes it spans (0: none). */
+static inline gsize splice_at(const UmiCLexer *lx, gsize p) {
+  if (lx->src[p] != '\\' || p + 1 >= lx->len) return 0;
+  if (lx->src[p + 1] == '\n') return 2;
+  if (lx->src[p + 1] == '\r' && p + 2 < lx->len && lx->src[p + 2] == '\n') return 3;
+  return 0;
+}
+
+/* Move to the line break ending the current line (splices continue it). */
+static void skip_line(UmiCLexer *lx) {
+  while (lx->pos < lx->len && lx->src[lx->pos] != '\n') {
+    const gsize sp = splice_at(lx, lx->pos);
+    if (sp) {
+      lx->pos += sp;
+      newline(lx, lx->pos - 1);
+    } else {
+      lx->pos++;
+    }
+  }
+}
+
+static void skip_block_comment(UmiCLexer *lx) {
+  lx->pos += 2;
+  while (lx->pos < lx->len) {
+    const char c = lx->src[lx->pos];
+    if (c == '*' && lx->pos + 1 < lx->len && lx->src[lx->pos + 1] == '/') {
+      lx->pos += 2;
+      return;
+    }
+    if (c == '\n') newline(lx, lx->pos);
+    lx->pos++;
+  }
+}
+
+/* The directive word after the '#' at 'p' ("if", "endif", ...), or none. */
+static gsize directive_word(const UmiCLexer *lx, gsize p, gsize *word) {
+  ++p;
+  while (p < lx->len && (lx->src[p] == ' ' || lx->src[p] == '\t')) ++p;
+  *word = p;
+  gsize n = 0;
+  while (p + n < lx->len && g_ascii_isalpha(lx->src[p + n])) ++n;
+  return n;
+}
+
+static gboolean word_is(const UmiCLexer *lx, gsize at, gsize n, const char *w) {
+  return strlen(w) == n && !memcmp(lx->src + at, w, n);
+}
+
+/* At the '#' of "#if 0"? */
+static gboolean is_if0(const UmiCLexer *lx) {
+  gsize w;
+  const gsize n = directive_word(lx, lx->pos, &w);
+  if (!word_is(lx, w, n, "if")) return FALSE;
+  gsize p = w + n;
+  if (p >= lx->len || (lx->src[p] != ' ' && lx->src[p] != '\t')) return FALSE;
+  while (p < lx->len && (lx->src[p] == ' ' || lx->src[p] == '\t')) ++p;
+  return p < lx->len && lx->src[p] == '0' && (p + 1 >= lx->len || !umi_c_ident_char((guchar)lx->src[p + 1]));
+}
+
+/* Skip from the "#if 0" at pos to where live code resumes. */
+static void skip_if0(UmiCLexer *lx) {
+  guint depth = 0;
+  skip_line(lx);
+  while (lx->pos < lx->len) {
+    newline(lx, lx->pos);                             /* at a '\n' */
+    const gsize bol = ++lx->pos;
+    gsize p = bol;
+    while (p < lx->len && (lx->src[p] == ' ' || lx->src[p] == '\t')) ++p;
+    if (p < lx->len && lx->src[p] == '#') {
+      gsize w;
+      const gsize n = directive_word(lx, p, &w);
+      if (word_is(lx, w, n, "if") || word_is(lx, w, n, "ifdef") || word_is(lx, w, n, "ifndef")) {
+        ++depth;
+      } else if (word_is(lx, w, n, "endif") || word_is(lx, w, n, "else")) {
+        if (!depth) {                                 /* resume after this line */
+          lx->pos = p;
+          skip_line(lx);
+          return;
+        }
+        if (word_is(lx, w, n, "endif")) --depth;
+      } else if (word_is(lx, w, n, "elif") && !depth) {
+        lx->pos = bol;                                /* lexed as a directive */
+        lx->bol = TRUE;
+        lx->in_pp = FALSE;
+        return;
+      }
+    }
+    lx->pos = p;
+    skip_line(lx);
+  }
+}
+
+/* Past a quoted literal whose opening quote is at 'p'. */
+static gsize skip_quoted(UmiCLexer *lx, gsize p) {
+  const char q = lx->src[p++];
+  while (p < lx->len && lx->src[p] != q && lx->src[p] != '\n') {
+    if (lx->src[p] == '\\' && p + 1 < lx->len) {
+      if (lx->src[p + 1] == '\n') newline(lx, p + 1);
+      ++p;
+    }
+    ++p;
+  }
+  return p < lx->len && lx->src[p] == q ? p + 1 : p;
+}
+
+/* Past a raw string R"delim( ... )delim" whose quote is at 'p'. */
+static gsize skip_raw(UmiCLexer *lx, gsize p) {
+  gsize d = p + 1;
+  while (d < lx->len && d - p - 1 < 16 && lx->src[d] != '(' && lx->src[d] != '"' &&
+         lx->src[d] != ' ' && lx->src[d] != '\n')
+    ++d;
+  if (d >= lx->len || lx->src[d] != '(') return skip_quoted(lx, p);    /* not raw after all */
+  const char *delim = lx->src + p + 1;
+  const gsize dn = d - p - 1;
+  for (gsize i = d + 1; i < lx->len; ++i) {
+    if (lx->src[i] == '\n') newline(lx, i);
+    else if (lx->src[i] == ')' && i + 1 + dn < lx->len &&
+             !memcmp(lx->src + i + 1, delim, dn) && lx->src[i + 1 + dn] == '"')
+      return i + dn + 2;
+  }
+  return lx->len;
+}
+
+static const char *const punct3[] = { "<<=", ">>=", "...", "->*", "<=>", NULL };
+static const char *const punct2[] = { "->", "++", "--", "<<", ">>", "<=", ">=", "==", "!=", "&&",
+                                      "||", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "::",
+                                      "##", ".*", NULL };
+
+static gsize punct_len(const UmiCLexer *lx, gsize p) {
+  const gsize left = lx->len - p;
+  if (left < 2 || !strchr("-+<>=!&|*/%^:#.", lx->src[p])) return 1;
+  if (left >= 3)
+    for (guint i = 0; punct3[i]; ++i)
+      if (!memcmp(lx->src + p, punct3[i], 3)) return 3;
+  if (left >= 2)
+    for (guint i = 0; punct2[i]; ++i)
+      if (!memcmp(lx->src + p, punct2[i], 2)) return 2;
+  return 1;
+}
+
+/* String prefixes: L u U u8, each optionally followed by R. */
+static gboolean string_prefix(const char *s, gsize n, gboolean *raw) {
+  *raw = n && s[n - 1] == 'R';
+  if (*raw) --n;
+  return n == 0 || (n == 1 && (s[0] == 'L' || s[0] == 'u' || s[0] == 'U')) ||
+         (n == 2 && s[0] == 'u' && s[1] == '8');
+}
+
+gboolean umi_c_lexer_next(UmiCLexer *lx, UmiCToken *t) {
+  g_return_val_if_fail(lx != NULL && t != NULL, FALSE);
+  const char *s = lx->src;
+  for (;;) {
+    if (lx->pos >= lx->len) {
+      memset(t, 0, sizeof *t);
+      t->off  = (guint32)lx->len;
+      t->line = lx->line;
+      return FALSE;
+    }
+    const char c = s[lx->pos];
+    if (c == '\n') {
+      newline(lx, lx->pos++);
+      lx->in_pp = FALSE;
+      lx->bol   = TRUE;
+      continue;
+    }
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') { lx->pos++; continue; }
+    const gsize sp = splice_at(lx, lx->pos);
+    if (sp) {
+      lx->pos += sp;
+      newline(lx, lx->pos - 1);
+      continue;
+    }
+    if (c == '/' && lx->pos + 1 < lx->len && s[lx->pos + 1] == '/') { skip_line(lx); continue; }
+    if (c == '/' && lx->pos + 1 < lx->len && s[lx->pos + 1] == '*') { skip_block_comment(lx); continue; }
+    if (c == '#' && lx->bol && !lx->in_pp && (lx->flags & UMI_CLEX_SKIP_IF0) && is_if0(lx)) {
+      skip_if0(lx);
+      continue;
+    }
+    break;
+  }
+
+  const gsize start = lx->pos;
+  const guchar c = (guchar)s[start];
+  t->off    = (guint32)start;
+  t->line   = lx->line;
+  t->column = (guint32)(start - lx->line_start + 1);
+  t->flags  = (lx->bol ? UMI_CTOK_BOL : 0);
+  if (c == '#' && lx->bol) lx->in_pp = TRUE;
+  if (lx->in_pp) t->flags |= UMI_CTOK_PP;
+  lx->bol = FALSE;
+
+  gsize p = start;
+  if (umi_c_ident_char(c) && !g_ascii_isdigit(c)) {
+    while (p < lx->len && umi_c_ident_char((guchar)s[p])) ++p;
+    gboolean raw;
+    if (p < lx->len && (s[p] == '"' || s[p] == '\'') && string_prefix(s + start, p - start, &raw)) {
+      t->kind = s[p] == '"' ? UMI_CTOK_STRING : UMI_CTOK_CHAR;
+      p = (raw && s[p] == '"') ? skip_raw(lx, p) : skip_quoted(lx, p);
+    } else {
+      t->kind = UMI_CTOK_IDENT;
+    }
+  } else if (g_ascii_isdigit(c) || (c == '.' && start + 1 < lx->len && g_ascii_isdigit(s[start + 1]))) {
+    t->kind = UMI_CTOK_NUMBER;
+    for (++p; p < lx->len; ++p) {
+      const char d = s[p];
+      if ((d == '+' || d == '-') && strchr("eEpP", s[p - 1])) continue;
+      if (d == '\'' && p + 1 < lx->len && g_ascii_isalnum(s[p + 1])) continue;   /* 1'000 */
+      if (!umi_c_ident_char((guchar)d) && d != '.') break;
+    }
+  } else if (c == '"') {
+    t->kind = UMI_CTOK_STRING;
+    p = skip_quoted(lx, p);
+  } else if (c == '\'') {
+    t->kind = UMI_CTOK_CHAR;
+    p = skip_quoted(lx, p);
+  } else {
+    t->kind = UMI_CTOK_PUNCT;
+    p += punct_len(lx, p);
+  }
+  t->len  = (guint32)(p - start);
+  lx->pos = p;
+  return TRUE;
+}
+/*---------------------------------------------------------------------------*/
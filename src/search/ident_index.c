@@ -0,0 +1,812 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/ident_index.c
+ * PURPOSE: Identifier occurrence index for "find references"
+ *
+ * DESIGN:
+ *   - Documents, tombstones, sync and snapshot follow trigram_index.c; only
+ *     C and C++ files (umi_symbol_index_is_source) become documents.
+ *   - Posting list of an identifier = one block per document, in document
+ *     order: varint(document delta; the first one absolute), varint(count),
+ *     then per occurrence varint(line delta) and varint(column), the column
+ *     itself a delta when the line did not change. Blocks are appended
+ *     whole, so a list is decoded front to back only.
+ *   - Workers tokenize a file, sort its identifier tokens by name and
+ *     position and encode every identifier's block; the calling thread
+ *     only appends ready bytes to the lists, in document order.
+ *   - Keywords are left out (a binary search over a sorted table); so are
+ *     the words of #include, #pragma, #error and #line directives and the
+ *     "defined" of #if.
+ *
+ * SNAPSHOT (native endianness, local cache):
+ *   IdHeader, IdSnapDoc[n_docs], IdSnapPost[n_posts], posting bytes,
+ *   strings (relative paths, identifiers, then the canonical root). Saved
+ *   compacted, so document numbers are dense.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <string.h>
+#include <glib/gstdio.h>
+#include "ident_index.h"
+#include "symbol_index.h"
+#include "c_lexer.h"
+#include "file_meta.h"
+#include "file_io.h"
+#include "parallel_for.h"
+
+#define ID_MAX_FILE   (8u << 20)  /* larger files are not tokenized          */
+#define ID_CHUNK      1024u       /* files extracted per parallel round      */
+#define ID_NO_DOC     G_MAXUINT32
+#define ID_MAGIC      "UMID"
+#define ID_VERSION    1u
+
+enum {
+  DOC_DEAD = 1 << 0               /* tombstone                               */
+};
+
+typedef struct IdDoc {
+  guint32 file_id;                /* UMI_INDEX_NO_FILE until resolved        */
+  guint32 flags;
+  gint64  size;
+  gint64  mtime_us;
+  char   *rel;                    /* root-relative path (owned)              */
+} IdDoc;
+
+typedef struct IdPost {
+  GByteArray *data;               /* blocks, see DESIGN                      */
+  guint32     n;                  /* blocks (documents)                      */
+  guint32     last;               /* document of the last block              */
+} IdPost;
+
+struct _UmiIdentIndex {
+  UmiFileIndex *idx;
+  GArray       *docs;             /* IdDoc by document number                */
+  GHashTable   *by_path;          /* rel (doc->rel) -> doc + 1, live only    */
+  GHashTable   *posts;            /* identifier (owned) -> IdPost*           */
+  GHashTable   *dirty;            /* canonical absolute paths                */
+  guint         n_live;
+  guint         n_dead;
+  guint64       synced_gen;       /* 0: resolve every document again         */
+  gboolean      verify;           /* loaded: stat-check documents on sync    */
+};
+
+#define DOC_AT(x, d) (&g_array_index((x)->docs, IdDoc, (d)))
+
+/*---------------------------------------------------------------------------
+ * Varints and posting lists
+ *---------------------------------------------------------------------------*/
+static void put_varint(GByteArray *b, guint32 v) {
+  guint8 tmp[5];
+  guint  n = 0;
+  while (v >= 0x80) { tmp[n++] = (guint8)(v | 0x80); v >>= 7; }
+  tmp[n++] = (guint8)v;
+  g_byte_array_append(b, tmp, n);
+}
+
+static inline const guint8 *get_varint(const guint8 *p, const guint8 *end, guint32 *out) {
+  guint32 v = 0;
+  for (guint shift = 0; p < end && shift < 35; shift += 7) {
+    const guint8 c = *p++;
+    v |= (guint32)(c & 0x7f) << shift;
+    if (!(c & 0x80)) { *out = v; return p; }
+  }
+  return NULL;                                        /* truncated/corrupt */
+}
+
+static void post_free(gpointer p) {
+  IdPost *pl = p;
+  g_byte_array_free(pl->data, TRUE);
+  g_free(pl);
+}
+
+/* Walk the blocks of 'pl'; 'each' gets the document and the block's
+ * occurrence bytes (count included). Stops early on corrupt data. */
+typedef void (*IdBlockFn)(guint32 doc, const guint8 *block, gsize len, gpointer user);
+
+static void post_blocks(const IdPost *pl, IdBlockFn each, gpointer user) {
+  const guint8 *p = pl->data->data, *end = p + pl->data->len;
+  guint32 doc = 0;
+  for (guint32 b = 0; b < pl->n; ++b) {
+    guint32 d, count, v;
+    if (!(p = get_varint(p, end, &d))) return;
+    doc = b ? doc + d : d;
+    const guint8 *block = p;
+    if (!(p = get_varint(p, end, &count))) return;
+    for (guint32 k = 0; k < 2 * count; ++k)
+      if (!(p = get_varint(p, end, &v))) return;
+    each(doc, block, (gsize)(p - block), user);
+  }
+}
+
+static void post_append(IdPost *pl, guint32 doc, const guint8 *block, gsize len) {
+  put_varint(pl->data, pl->n ? doc - pl->last : doc);
+  g_byte_array_append(pl->data, block, (guint)len);
+  pl->last = doc;
+  pl->n++;
+}
+
+/*---------------------------------------------------------------------------
+ * Tokens
+ *---------------------------------------------------------------------------*/
+static const char *const keywords[] = {            /* sorted (strcmp) */
+  "_Alignas", "_Alignof", "_Atomic", "_Bool", "_Complex", "_Generic", "_Imaginary",
+  "_Noreturn", "_Static_assert", "_Thread_local", "alignas", "alignof", "and", "and_eq",
+  "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch", "char", "char16_t",
+  "char32_t", "char8_t", "class", "co_await", "co_return", "co_yield", "compl", "concept",
+  "const", "const_cast", "consteval", "constexpr", "constinit", "continue", "decltype",
+  "default", "delete", "do", "double", "dynamic_cast", "else", "enum", "explicit",
+  "export", "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int",
+  "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq", "nullptr",
+  "operator", "or", "or_eq", "private", "protected", "public", "register",
+  "reinterpret_cast", "requires", "restrict", "return", "short", "signed", "sizeof",
+  "static", "static_assert", "static_cast", "struct", "switch", "template", "this",
+  "thread_local", "throw", "true", "try", "typedef", "typeid", "typename", "union",
+  "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while", "xor", "xor_eq"
+};
+
+static gint cmp_word(const char *s, gsize n, const char *kw) {
+  const gsize kn = strlen(kw);
+  const gint  r  = memcmp(s, kw, MIN(n, kn));
+  return r ? r : (n < kn ? -1 : (n > kn ? 1 : 0));
+}
+
+static gboolean is_keyword(const char *s, gsize n) {
+  guint lo = 0, hi = G_N_ELEMENTS(keywords);
+  while (lo < hi) {
+    const guint mid = (lo + hi) / 2;
+    const gint  r   = cmp_word(s, n, keywords[mid]);
+    if (!r) return TRUE;
+    if (r < 0) hi = mid;
+    else lo = mid + 1;
+  }
+  return FALSE;
+}
+
+/* Directives whose words are not identifiers. */
+static gboolean is_text_directive(const char *s, gsize n) {
+  static const char *const words[] = {
+    "include", "include_next", "import", "pragma", "error", "warning", "line", "ident", NULL
+  };
+  for (guint i = 0; words[i]; ++i)
+    if (!cmp_word(s, n, words[i])) return TRUE;
+  return FALSE;
+}
+
+/*---------------------------------------------------------------------------
+ * Documents
+ *---------------------------------------------------------------------------*/
+static void kill_doc(UmiIdentIndex *x, guint32 d) {
+  IdDoc *doc = DOC_AT(x, d);
+  if (doc->flags & DOC_DEAD) return;
+  g_hash_table_remove(x->by_path, doc->rel);
+  doc->flags |= DOC_DEAD;
+  x->n_dead++;
+  x->n_live--;
+}
+
+static guint32 doc_for(const UmiIdentIndex *x, const char *rel) {
+  const gpointer v = g_hash_table_lookup(x->by_path, rel);
+  return v ? GPOINTER_TO_UINT(v) - 1 : ID_NO_DOC;
+}
+
+static guint32 add_doc(UmiIdentIndex *x, guint32 file_id, char *rel, gint64 size, gint64 mtime_us) {
+  IdDoc doc = { file_id, 0, size, mtime_us, rel };
+  g_array_append_val(x->docs, doc);
+  const guint32 d = x->docs->len - 1;
+  g_hash_table_insert(x->by_path, rel, GUINT_TO_POINTER(d + 1));
+  x->n_live++;
+  return d;
+}
+
+static const char *rel_of(const UmiIdentIndex *x, const char *abs) {
+  const char *root = umi_index_root(x->idx);
+  const gsize rl = strlen(root);
+  if (strncmp(abs, root, rl) != 0 || abs[rl] != G_DIR_SEPARATOR) return NULL;
+  return abs + rl + 1;
+}
+
+/*---------------------------------------------------------------------------
+ * Extraction (parallel)
+ *---------------------------------------------------------------------------*/
+typedef struct IdOcc {
+  guint32 off, len;
+  guint32 line, column;
+} IdOcc;
+
+typedef struct IdExtract {
+  guint32  file_id;
+  gint64   size;
+  gint64   mtime_us;
+  char    *rel;                   /* NULL: file vanished, skip               */
+  guint8  *enc;                   /* per identifier: name NUL, varint(len),  */
+  gsize    enc_len;               /*   block                                 */
+} IdExtract;
+
+typedef struct IdWorker {
+  GArray     *occ;                /* IdOcc scratch                           */
+  GByteArray *enc;
+  GByteArray *block;
+} IdWorker;
+
+typedef struct IdExtractRun {
+  UmiIdentIndex *x;
+  const guint32 *ids;
+  IdExtract     *out;
+  IdWorker      *workers;
+} IdExtractRun;
+
+static gint cmp_occ(gconstpointer a, gconstpointer b, gpointer user) {
+  const char  *src = user;
+  const IdOcc *p = a, *q = b;
+  gint r = memcmp(src + p->off, src + q->off, MIN(p->len, q->len));
+  if (!r) r = p->len < q->len ? -1 : (p->len > q->len ? 1 : 0);
+  if (!r) r = p->line < q->line ? -1 : (p->line > q->line ? 1 : 0);
+  if (!r) r = p->column < q->column ? -1 : (p->column > q->column ? 1 : 0);
+  return r;
+}
+
+/* Identifier tokens of 'src' into w->occ. */
+static void scan(IdWorker *w, const char *src, gsize len) {
+  UmiCLexer lx;
+  UmiCToken t;
+  gboolean  word = FALSE, skip = FALSE;               /* directive state */
+  g_array_set_size(w->occ, 0);
+  umi_c_lexer_init(&lx, src, len, UMI_CLEX_SKIP_IF0);
+  while (umi_c_lexer_next(&lx, &t)) {
+    if (t.flags & UMI_CTOK_PP) {
+      if (t.flags & UMI_CTOK_BOL) { word = TRUE; skip = FALSE; continue; }    /* '#' */
+      if (word) {
+        word = FALSE;
+        skip = is_text_directive(src + t.off, t.len);
+        continue;
+      }
+      if (skip || (t.len == 7 && !memcmp(src + t.off, "defined", 7))) continue;
+    }
+    if (t.kind != UMI_CTOK_IDENT || is_keyword(src + t.off, t.len)) continue;
+    IdOcc o = { t.off, t.len, t.line, t.column };
+    g_array_append_val(w->occ, o);
+  }
+}
+
+/* Sorted occurrences -> per identifier: name NUL, varint(len), block. */
+static void encode(IdWorker *w, const char *src) {
+  g_byte_array_set_size(w->enc, 0);
+  const IdOcc *o = (const IdOcc *)(const void *)w->occ->data;
+  for (guint i = 0; i < w->occ->len; ) {
+    guint j = i + 1;
+    while (j < w->occ->len && o[j].len == o[i].len && !memcmp(src + o[j].off, src + o[i].off, o[i].len)) ++j;
+    g_byte_array_set_size(w->block, 0);
+    put_varint(w->block, j - i);
+    guint32 line = 0, col = 0;
+    for (guint k = i; k < j; ++k) {
+      put_varint(w->block, o[k].line - line);
+      put_varint(w->block, o[k].line != line ? o[k].column : o[k].column - col);
+      line = o[k].line;
+      col  = o[k].column;
+    }
+    g_byte_array_append(w->enc, (const guint8 *)src + o[i].off, o[i].len);
+    g_byte_array_append(w->enc, (const guint8 *)"", 1);
+    put_varint(w->enc, w->block->len);
+    g_byte_array_append(w->enc, w->block->data, w->block->len);
+    i = j;
+  }
+}
+
+static void extract_one(UmiIdentIndex *x, IdWorker *w, guint32 file_id, IdExtract *ex) {
+  ex->file_id = file_id;
+  UmiFileStat st;
+  char *path = umi_index_file_path(x->idx, file_id);
+  if (!path || !umi_file_meta_stat(umi_index_meta(x->idx), file_id, &st)) {
+    g_free(path);
+    return;
+  }
+  const char *rel = rel_of(x, path);
+  if (!rel) { g_free(path); return; }
+  ex->rel      = g_strdup(rel);
+  ex->size     = st.size;
+  ex->mtime_us = st.mtime_us;
+
+  if (st.kind != UMI_FILE_KIND_BINARY && st.size <= (gint64)ID_MAX_FILE) {
+    GMappedFile *mf = g_mapped_file_new(path, FALSE, NULL);
+    const char *src = mf ? g_mapped_file_get_contents(mf) : NULL;
+    const gsize n   = mf ? g_mapped_file_get_length(mf) : 0;
+    if (n && !memchr(src, '\0', MIN(n, (gsize)8000))) {
+      scan(w, src, n);
+      g_array_sort_with_data(w->occ, cmp_occ, (gpointer)src);
+      encode(w, src);
+      ex->enc_len = w->enc->len;
+      ex->enc     = g_memdup2(w->enc->data, w->enc->len);
+    }
+    if (mf) g_mapped_file_unref(mf);
+  }
+  g_free(path);
+}
+
+static void extract_range(guint b, guint e, guint worker, gpointer user) {
+  IdExtractRun *r = user;
+  IdWorker     *w = &r->workers[worker];
+  if (!w->occ) {
+    w->occ   = g_array_sized_new(FALSE, FALSE, sizeof(IdOcc), 1 << 14);
+    w->enc   = g_byte_array_new();
+    w->block = g_byte_array_new();
+  }
+  for (guint i = b; i < e; ++i) extract_one(r->x, w, r->ids[i], &r->out[i]);
+}
+
+/* Index the files in 'ids' as new documents. */
+static void add_files(UmiIdentIndex *x, const GArray *ids) {
+  if (ids->len == 0) return;
+  const guint nw = umi_parallel_workers();
+  IdWorker *workers = g_new0(IdWorker, nw);
+
+  for (guint base = 0; base < ids->len; base += ID_CHUNK) {
+    const guint n = MIN(ID_CHUNK, ids->len - base);
+    IdExtract *ex = g_new0(IdExtract, n);
+    IdExtractRun run = { x, (const guint32 *)(const void *)ids->data + base, ex, workers };
+    umi_parallel_for(n, 4, extract_range, &run);
+
+    for (guint i = 0; i < n; ++i) {
+      if (!ex[i].rel) continue;
+      const guint32 old = doc_for(x, ex[i].rel);
+      if (old != ID_NO_DOC) kill_doc(x, old);
+      const guint32 d = add_doc(x, ex[i].file_id, ex[i].rel, ex[i].size, ex[i].mtime_us);
+      const guint8 *p = ex[i].enc, *end = p + ex[i].enc_len;
+      while (p && p < end) {
+        const char *name = (const char *)p;
+        p += strlen(name) + 1;
+        guint32 blen;
+        if (!(p = get_varint(p, end, &blen)) || blen > (gsize)(end - p)) break;
+        IdPost *pl = g_hash_table_lookup(x->posts, name);
+        if (!pl) {
+          pl = g_new0(IdPost, 1);
+          pl->data = g_byte_array_new();
+          g_hash_table_insert(x->posts, g_strdup(name), pl);
+        }
+        post_append(pl, d, p, blen);
+        p += blen;
+      }
+      g_free(ex[i].enc);
+    }
+    g_free(ex);
+  }
+
+  for (guint i = 0; i < nw; ++i) {
+    if (!workers[i].occ) continue;
+    g_array_free(workers[i].occ, TRUE);
+    g_byte_array_free(workers[i].enc, TRUE);
+    g_byte_array_free(workers[i].block, TRUE);
+  }
+  g_free(workers);
+}
+
+/*---------------------------------------------------------------------------
+ * Compaction: drop tombstones, renumber densely (order is preserved, so
+ * every list stays ascending).
+ *---------------------------------------------------------------------------*/
+typedef struct IdRewrite {
+  const guint32 *remap;
+  IdPost        *out;
+} IdRewrite;
+
+static void rewrite_block(guint32 doc, const guint8 *block, gsize len, gpointer user) {
+  IdRewrite *rw = user;
+  if (rw->remap[doc] != ID_NO_DOC) post_append(rw->out, rw->remap[doc], block, len);
+}
+
+static void compact(UmiIdentIndex *x) {
+  if (x->n_dead == 0) return;
+  guint32 *remap = g_new(guint32, MAX(x->docs->len, 1u));
+  GArray  *docs  = g_array_sized_new(FALSE, FALSE, sizeof(IdDoc), x->n_live);
+  for (guint d = 0; d < x->docs->len; ++d) {
+    IdDoc *doc = DOC_AT(x, d);
+    if (doc->flags & DOC_DEAD) {
+      remap[d] = ID_NO_DOC;
+      g_free(doc->rel);
+      continue;
+    }
+    remap[d] = docs->len;
+    g_array_append_val(docs, *doc);
+  }
+  g_array_free(x->docs, TRUE);
+  x->docs = docs;
+  g_hash_table_remove_all(x->by_path);
+  for (guint d = 0; d < docs->len; ++d)
+    g_hash_table_insert(x->by_path, DOC_AT(x, d)->rel, GUINT_TO_POINTER(d + 1));
+
+  GHashTableIter it;
+  gpointer key, val;
+  g_hash_table_iter_init(&it, x->posts);
+  while (g_hash_table_iter_next(&it, &key, &val)) {
+    IdPost *pl = val;
+    IdPost  fresh = { g_byte_array_sized_new(pl->data->len), 0, 0 };
+    IdRewrite rw = { remap, &fresh };
+    post_blocks(pl, rewrite_block, &rw);
+    g_byte_array_free(pl->data, TRUE);
+    *pl = fresh;
+    if (pl->n == 0) g_hash_table_iter_remove(&it);
+  }
+  g_free(remap);
+  x->n_dead = 0;
+}
+
+static void maybe_compact(UmiIdentIndex *x) {
+  if (x->n_dead > 1024 && x->n_dead * 4 > x->docs->len) compact(x);
+}
+
+/*---------------------------------------------------------------------------
+ * Lifecycle
+ *---------------------------------------------------------------------------*/
+UmiIdentIndex *umi_ident_index_new(UmiFileIndex *idx) {
+  g_return_val_if_fail(idx != NULL, NULL);
+  UmiIdentIndex *x = g_new0(UmiIdentIndex, 1);
+  x->idx     = idx;
+  x->docs    = g_array_new(FALSE, FALSE, sizeof(IdDoc));
+  x->by_path = g_hash_table_new(g_str_hash, g_str_equal);
+  x->posts   = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, post_free);
+  x->dirty   = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  return x;
+}
+
+void umi_ident_index_free(UmiIdentIndex *x) {
+  if (!x) return;
+  for (guint d = 0; d < x->docs->len; ++d) g_free(DOC_AT(x, d)->rel);
+  g_array_free(x->docs, TRUE);
+  g_hash_table_destroy(x->by_path);
+  g_hash_table_destroy(x->posts);
+  g_hash_table_destroy(x->dirty);
+  g_free(x);
+}
+
+void umi_ident_index_mark_dirty(UmiIdentIndex *x, const char *path) {
+  if (!x || !path || !*path) return;
+  g_hash_table_add(x->dirty, g_canonicalize_filename(path, NULL));
+}
+
+static gint cmp_u32(gconstpointer a, gconstpointer b) {
+  const guint32 p = *(const guint32 *)a, q = *(const guint32 *)b;
+  return p < q ? -1 : (p > q ? 1 : 0);
+}
+
+guint umi_ident_index_sync(UmiIdentIndex *x) {
+  g_return_val_if_fail(x != NULL, 0);
+  const guint64 gen = umi_index_generation(x->idx);
+  if (gen == x->synced_gen && g_hash_table_size(x->dirty) == 0) return 0;
+
+  GArray *todo = g_array_new(FALSE, FALSE, sizeof(guint32));
+  UmiFileMeta *meta = umi_index_meta(x->idx);
+
+  /* File set moved (or ids were renumbered): match documents by path. */
+  if (gen != x->synced_gen) {
+    guint8 *seen = g_new0(guint8, MAX(x->docs->len, 1u));
+    UmiIndexIter it;
+    umi_index_iter_init(&it, x->idx);
+    while (umi_index_iter_next(&it)) {
+      const char *path = umi_index_iter_path(&it);
+      if (!umi_symbol_index_is_source(path)) continue;
+      const char   *rel = rel_of(x, path);
+      const guint32 d   = rel ? doc_for(x, rel) : ID_NO_DOC;
+      if (d == ID_NO_DOC) {
+        g_array_append_val(todo, it.id);
+        continue;
+      }
+      IdDoc *doc = DOC_AT(x, d);
+      doc->file_id = it.id;
+      seen[d] = 1;
+      if (x->verify) {                                 /* changed while closed? */
+        UmiFileStat st;
+        if (!umi_file_meta_stat(meta, it.id, &st) ||
+            st.size != doc->size || st.mtime_us != doc->mtime_us)
+          g_array_append_val(todo, it.id);
+      }
+    }
+    umi_index_iter_clear(&it);
+    for (guint d = 0; d < x->docs->len; ++d)
+      if (!seen[d] && !(DOC_AT(x, d)->flags & DOC_DEAD)) kill_doc(x, d);
+    g_free(seen);
+    x->synced_gen = gen;
+    x->verify     = FALSE;
+  }
+
+  /* Content changes reported by the watcher. */
+  GHashTableIter hi;
+  gpointer key;
+  g_hash_table_iter_init(&hi, x->dirty);
+  while (g_hash_table_iter_next(&hi, &key, NULL)) {
+    const char *rel = rel_of(x, key);
+    if (!rel || !umi_symbol_index_is_source(rel)) continue;
+    const guint32 d = doc_for(x, rel);
+    if (d != ID_NO_DOC) kill_doc(x, d);
+    const guint32 id = umi_index_lookup(x->idx, key);
+    if (id != UMI_INDEX_NO_FILE) g_array_append_val(todo, id);
+  }
+  g_hash_table_remove_all(x->dirty);
+
+  g_array_sort(todo, cmp_u32);
+  guint n = 0;
+  for (guint i = 0; i < todo->len; ++i)                /* dedup */
+    if (n == 0 || g_array_index(todo, guint32, n - 1) != g_array_index(todo, guint32, i))
+      g_array_index(todo, guint32, n++) = g_array_index(todo, guint32, i);
+  g_array_set_size(todo, n);
+
+  add_files(x, todo);
+  maybe_compact(x);
+  g_array_free(todo, TRUE);
+  return n;
+}
+
+guint umi_ident_index_n_files(const UmiIdentIndex *x) {
+  return x ? x->n_live : 0;
+}
+
+guint umi_ident_index_n_idents(const UmiIdentIndex *x) {
+  return x ? g_hash_table_size(x->posts) : 0;
+}
+
+/*---------------------------------------------------------------------------
+ * Lookup
+ *---------------------------------------------------------------------------*/
+typedef struct IdBlock {
+  guint32       doc;
+  guint32       count;
+  const guint8 *occ;              /* first occurrence varint                 */
+  const guint8 *end;
+} IdBlock;
+
+typedef struct IdCollect {
+  const UmiIdentIndex *x;
+  GArray              *blocks;    /* IdBlock of live documents               */
+  guint                total;
+} IdCollect;
+
+static void collect_block(guint32 doc, const guint8 *block, gsize len, gpointer user) {
+  IdCollect *c = user;
+  if (doc >= c->x->docs->len || (DOC_AT(c->x, doc)->flags & DOC_DEAD)) return;
+  IdBlock b = { doc, 0, NULL, block + len };
+  if (!(b.occ = get_varint(block, b.end, &b.count))) return;
+  c->total += b.count;
+  g_array_append_val(c->blocks, b);
+}
+
+static gint cmp_blocks(gconstpointer a, gconstpointer b, gpointer user) {
+  const UmiIdentIndex *x = user;
+  return strcmp(DOC_AT(x, ((const IdBlock *)a)->doc)->rel, DOC_AT(x, ((const IdBlock *)b)->doc)->rel);
+}
+
+guint umi_ident_index_find(UmiIdentIndex *x, const char *name, guint max, GArray *out) {
+  g_return_val_if_fail(x != NULL && out != NULL, 0);
+  g_array_set_size(out, 0);
+  umi_ident_index_sync(x);
+  const IdPost *pl = name ? g_hash_table_lookup(x->posts, name) : NULL;
+  if (!pl) return 0;
+
+  /* Blocks are already in line order; only documents need ordering, and
+   * occurrences past 'max' are counted, never decoded. */
+  IdCollect c = { x, g_array_sized_new(FALSE, FALSE, sizeof(IdBlock), pl->n), 0 };
+  post_blocks(pl, collect_block, &c);
+  g_array_sort_with_data(c.blocks, cmp_blocks, x);
+  for (guint i = 0; i < c.blocks->len && out->len < max; ++i) {
+    const IdBlock *b   = &g_array_index(c.blocks, IdBlock, i);
+    const IdDoc   *doc = DOC_AT(x, b->doc);
+    const guint8  *p   = b->occ;
+    guint32 line = 0, col = 0;
+    for (guint32 k = 0; k < b->count && out->len < max; ++k) {
+      guint32 dl, dc;
+      if (!(p = get_varint(p, b->end, &dl)) || !(p = get_varint(p, b->end, &dc))) break;
+      col   = dl ? dc : col + dc;
+      line += dl;
+      UmiIdentRef r = { doc->rel, doc->file_id, line, col };
+      g_array_append_val(out, r);
+    }
+  }
+  const guint total = c.total;
+  g_array_free(c.blocks, TRUE);
+  return total;
+}
+
+/* Append rows for refs[b, e) (one file, ascending lines) read from disk. */
+static void add_rows(UmiIdentIndex *x, UmiSearchResults *res, const UmiIdentRef *refs,
+                     guint b, guint e, gsize name_len, const char *name, GArray *spans) {
+  char *abs = g_build_filename(umi_index_root(x->idx), refs[b].path, NULL);
+  GMappedFile *mf = g_mapped_file_new(abs, FALSE, NULL);
+  g_free(abs);
+  if (!mf) return;
+  const char *s = g_mapped_file_get_contents(mf), *end = s + g_mapped_file_get_length(mf);
+  const guint32 fid = umi_search_results_add_file(res, refs[b].path);
+  const char *ls = s;
+  guint32 line = 1;
+  for (guint i = b; i < e && ls && ls < end; ) {
+    while (line < refs[i].line && ls) {               /* to the start of the line */
+      ls = memchr(ls, '\n', (gsize)(end - ls));
+      if (ls) { ++ls; ++line; }
+    }
+    if (!ls || ls >= end) break;
+    const char *nl = memchr(ls, '\n', (gsize)(end - ls));
+    const gsize len = (gsize)((nl ? nl : end) - ls);
+    g_array_set_size(spans, 0);
+    for (; i < e && refs[i].line == line; ++i) {
+      const gsize at = refs[i].column - 1;
+      if (at + name_len > len || memcmp(ls + at, name, name_len) != 0) continue;   /* file moved on */
+      UmiSearchSpan sp = { (guint32)at, (guint32)(at + name_len) };
+      g_array_append_val(spans, sp);
+    }
+    if (spans->len)
+      umi_search_results_add(res, fid, line, ls, (gssize)len,
+                             (const UmiSearchSpan *)(const void *)spans->data, spans->len);
+  }
+  g_mapped_file_unref(mf);
+}
+
+UmiSearchResults *umi_ident_index_results(UmiIdentIndex *x, const char *name, guint max,
+                                          gboolean *truncated) {
+  g_return_val_if_fail(x != NULL, NULL);
+  GArray *refs = g_array_new(FALSE, FALSE, sizeof(UmiIdentRef));
+  const guint total = umi_ident_index_find(x, name, max, refs);
+  if (truncated) *truncated = total > refs->len;
+
+  UmiSearchResults *res = umi_search_results_new();
+  GArray *spans = g_array_new(FALSE, FALSE, sizeof(UmiSearchSpan));
+  const UmiIdentRef *r = (const UmiIdentRef *)(const void *)refs->data;
+  const gsize name_len = name ? strlen(name) : 0;
+  for (guint b = 0; b < refs->len; ) {
+    guint e = b + 1;
+    while (e < refs->len && r[e].path == r[b].path) ++e;
+    add_rows(x, res, r, b, e, name_len, name, spans);
+    b = e;
+  }
+  g_array_free(spans, TRUE);
+  g_array_free(refs, TRUE);
+  return res;
+}
+
+/*---------------------------------------------------------------------------
+ * Snapshot
+ *---------------------------------------------------------------------------*/
+typedef struct IdHeader {
+  char    magic[4];
+  guint32 version;
+  guint32 n_docs;
+  guint32 n_posts;
+  guint64 bytes_len;
+  guint32 strings_len;
+  guint32 root_off;
+} IdHeader;
+
+typedef struct IdSnapDoc {
+  gint64  size;
+  gint64  mtime_us;
+  guint32 path_off;
+  guint32 flags;
+} IdSnapDoc;
+
+typedef struct IdSnapPost {
+  guint32 name_off;
+  guint32 n;
+  guint32 last;
+  guint32 len;
+  guint64 off;
+} IdSnapPost;
+
+gboolean umi_ident_index_save(UmiIdentIndex *x, const char *snapshot_path, GError **err) {
+  g_return_val_if_fail(x != NULL && snapshot_path != NULL, FALSE);
+  compact(x);
+
+  GByteArray *strings = g_byte_array_new();
+  GByteArray *bytes   = g_byte_array_new();
+  GArray     *sdocs   = g_array_sized_new(FALSE, FALSE, sizeof(IdSnapDoc), x->docs->len);
+  GArray     *sposts  = g_array_sized_new(FALSE, FALSE, sizeof(IdSnapPost), g_hash_table_size(x->posts));
+
+  for (guint d = 0; d < x->docs->len; ++d) {
+    const IdDoc *doc = DOC_AT(x, d);
+    IdSnapDoc sd = { doc->size, doc->mtime_us, strings->len, doc->flags };
+    g_byte_array_append(strings, (const guint8 *)doc->rel, (guint)strlen(doc->rel) + 1);
+    g_array_append_val(sdocs, sd);
+  }
+  GHashTableIter it;
+  gpointer key, val;
+  g_hash_table_iter_init(&it, x->posts);
+  while (g_hash_table_iter_next(&it, &key, &val)) {
+    const IdPost *pl = val;
+    IdSnapPost sp = { strings->len, pl->n, pl->last, pl->data->len, bytes->len };
+    g_byte_array_append(strings, key, (guint)strlen(key) + 1);
+    g_byte_array_append(bytes, pl->data->data, pl->data->len);
+    g_array_append_val(sposts, sp);
+  }
+  const char *root = umi_index_root(x->idx);
+  const guint32 root_off = strings->len;
+  g_byte_array_append(strings, (const guint8 *)root, (guint)strlen(root) + 1);
+
+  IdHeader h;
+  memset(&h, 0, sizeof h);
+  memcpy(h.magic, ID_MAGIC, 4);
+  h.version     = ID_VERSION;
+  h.n_docs      = sdocs->len;
+  h.n_posts     = sposts->len;
+  h.bytes_len   = bytes->len;
+  h.strings_len = strings->len;
+  h.root_off    = root_off;
+
+  GByteArray *out = g_byte_array_new();
+  g_byte_array_append(out, (const guint8 *)&h, sizeof h);
+  g_byte_array_append(out, (const guint8 *)sdocs->data, sdocs->len * (guint)sizeof(IdSnapDoc));
+  g_byte_array_append(out, (const guint8 *)sposts->data, sposts->len * (guint)sizeof(IdSnapPost));
+  g_byte_array_append(out, bytes->data, bytes->len);
+  g_byte_array_append(out, strings->data, strings->len);
+
+  char *parent = g_path_get_dirname(snapshot_path);
+  g_mkdir_with_parents(parent, 0755);
+  g_free(parent);
+  const gboolean ok = umi_file_save_atomic(snapshot_path, (const char *)out->data, out->len, err);
+
+  g_byte_array_free(out, TRUE);
+  g_byte_array_free(strings, TRUE);
+  g_byte_array_free(bytes, TRUE);
+  g_array_free(sdocs, TRUE);
+  g_array_free(sposts, TRUE);
+  return ok;
+}
+
+static gboolean load(UmiIdentIndex *x, const char *data, gsize len) {
+  IdHeader h;
+  if (len < sizeof h) return FALSE;
+  memcpy(&h, data, sizeof h);
+  if (memcmp(h.magic, ID_MAGIC, 4) != 0 || h.version != ID_VERSION) return FALSE;
+  const guint64 need = sizeof h + (guint64)h.n_docs * sizeof(IdSnapDoc) +
+                       (guint64)h.n_posts * sizeof(IdSnapPost) + h.bytes_len + h.strings_len;
+  if (need != len || h.strings_len == 0 || h.root_off >= h.strings_len) return FALSE;
+
+  const IdSnapDoc  *sdocs   = (const IdSnapDoc *)(const void *)(data + sizeof h);
+  const IdSnapPost *sposts  = (const IdSnapPost *)(const void *)(sdocs + h.n_docs);
+  const guint8     *bytes   = (const guint8 *)(sposts + h.n_posts);
+  const char       *strings = (const char *)(bytes + h.bytes_len);
+  if (strings[h.strings_len - 1] != '\0') return FALSE;
+  if (h.root_off > 0 && strings[h.root_off - 1] != '\0') return FALSE;
+  if (g_strcmp0(strings + h.root_off, umi_index_root(x->idx)) != 0) return FALSE;
+  for (guint32 i = 0; i < h.n_docs; ++i)
+    if (sdocs[i].path_off >= h.root_off || (sdocs[i].flags & DOC_DEAD)) return FALSE;
+  for (guint32 i = 0; i < h.n_posts; ++i)
+    if (sposts[i].off + sposts[i].len > h.bytes_len || sposts[i].last >= h.n_docs ||
+        sposts[i].name_off >= h.root_off)
+      return FALSE;
+
+  for (guint32 i = 0; i < h.n_docs; ++i)
+    add_doc(x, UMI_INDEX_NO_FILE, g_strdup(strings + sdocs[i].path_off),
+            sdocs[i].size, sdocs[i].mtime_us);
+  for (guint32 i = 0; i < h.n_posts; ++i) {
+    IdPost *pl = g_new0(IdPost, 1);
+    pl->data = g_byte_array_sized_new(sposts[i].len);
+    g_byte_array_append(pl->data, bytes + sposts[i].off, sposts[i].len);
+    pl->n    = sposts[i].n;
+    pl->last = sposts[i].last;
+    g_hash_table_replace(x->posts, g_strdup(strings + sposts[i].name_off), pl);
+  }
+  return TRUE;
+}
+
+UmiIdentIndex *umi_ident_index_open(UmiFileIndex *idx, const char *snapshot_path) {
+  UmiIdentIndex *x = umi_ident_index_new(idx);
+  if (!x || !snapshot_path) return x;
+  GMappedFile *mf = g_mapped_file_new(snapshot_path, FALSE, NULL);
+  if (!mf) return x;
+  if (load(x, g_mapped_file_get_contents(mf), g_mapped_file_get_length(mf))) {
+    x->synced_gen = 0;
+    x->verify     = TRUE;
+  } else {                                             /* stale or foreign  */
+    umi_ident_index_free(x);
+    x = umi_ident_index_new(idx);
+  }
+  g_mapped_file_unref(mf);
+  return x;
+}
+
+char *umi_ident_index_snapshot_path_for(const char *root) {
+  if (!root || !*root) return NULL;
+  char *canon = g_canonicalize_filename(root, NULL);
+  char *key   = g_compute_checksum_for_string(G_CHECKSUM_SHA1, canon, -1);
+  char *leaf  = g_strconcat(key, ".ids", NULL);
+  char *path  = g_build_filename(g_get_user_cache_dir(), "umicom-studio-ide", "index", leaf, NULL);
+  g_free(leaf);
+  g_free(key);
+  g_free(canon);
+  return path;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,67 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/include/builtin_search.h
+ * PURPOSE: In-process text search, the fallback when ripgrep is missing
+ *
+ * OVERVIEW:
+ *   Searches the text files of a UmiFileIndex without any external tool and
+ *   streams its matches into a UmiSearchResults store through the same
+ *   callbacks as umi_rg_search_start(), so a view cannot tell the engines
+ *   apart. Each file is memory-mapped and scanned for a literal every
+ *   match must contain (memmem / memchr); only the lines holding it are
+ *   handed to GRegex. Files are spread over the cores (umi_parallel_for).
+ *
+ *   Semantics follow rg's defaults where they can: matches never span
+ *   lines, binary files (a NUL in the first 8000 bytes) are skipped, and
+ *   hidden or ignored files are not searched because the index leaves them
+ *   out. Patterns are matched bytewise (G_REGEX_RAW): '.' is one byte and
+ *   case folding is ASCII only.
+ *
+ * THREADING:
+ *   - Start, callbacks and cancellation happen on the main loop. The index
+ *     is read only inside umi_builtin_search_start() (the file list is
+ *     copied), so watcher events may be applied while a search runs.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_BUILTIN_SEARCH_H
+#define UMICOM_BUILTIN_SEARCH_H
+
+#include <glib.h>
+#include <gio/gio.h>
+#include "file_index.h"
+#include "search_results.h"
+
+G_BEGIN_DECLS
+
+typedef enum {
+  UMI_BUILTIN_SEARCH_CASELESS = 1 << 0,   /* ASCII case-insensitive          */
+  UMI_BUILTIN_SEARCH_LITERAL  = 1 << 1    /* pattern is plain text, no regex */
+} UmiBuiltinSearchFlags;
+
+/* Search the files of 'idx' for 'pattern' (a regex unless LITERAL) and
+ * append matching lines to 'out' (a reference is held until on_done).
+ * Paths in 'out' are relative to umi_index_root(idx). The contract is the
+ * one of umi_rg_search_start(): at most 'max_results' rows (0: no cap),
+ * batches of a few hundred rows, no batch after 'cancel' fires, and
+ * on_done exactly once, from the main loop. An invalid pattern ends the
+ * search with 'spawned' FALSE and the compile error. 'exit_status' is what
+ * rg would return: 0 matches, 1 none, 2 some file could not be read, -1
+ * stopped early. */
+void umi_builtin_search_start(UmiFileIndex *idx, const char *pattern,
+                              UmiBuiltinSearchFlags flags, UmiSearchResults *out,
+                              guint max_results, GCancellable *cancel,
+                              UmiSearchBatchCb on_batch, UmiSearchDoneCb on_done,
+                              gpointer user);
+
+/* Like umi_builtin_search_start(), over 'files' (NULL-terminated paths
+ * relative to 'root', as rows will name them) instead of an index. Used to
+ * re-search the few files that changed since a result was cached. */
+void umi_builtin_search_files_start(const char *root, const char * const *files,
+                                    const char *pattern, UmiBuiltinSearchFlags flags,
+                                    UmiSearchResults *out, guint max_results,
+                                    GCancellable *cancel, UmiSearchBatchCb on_batch,
+                                    UmiSearchDoneCb on_done, gpointer user);
+
+G_END_DECLS
+#endif /* UMICOM_BUILTIN_SEARCH_H */
@@ -0,0 +1,84 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/include/c_lexer.h
+ * PURPOSE: Small C / C++ tokenizer shared by the code indexes
+ *
+ * OVERVIEW:
+ *   Turns a source buffer into tokens without building anything: comments
+ *   and whitespace are skipped, string and character literals (prefixes
+ *   and C++ raw strings included) come out as single tokens, punctuators
+ *   are taken longest first ("->", "<<=", "::"). Tokens of a preprocessor
+ *   directive carry UMI_CTOK_PP, so a caller can read a #define and pass
+ *   over #include lines. With UMI_CLEX_SKIP_IF0, "#if 0" blocks are dropped
+ *   as if they were comments.
+ *
+ *   It is a lexer for indexing, not a compiler: no trigraphs, no macro
+ *   expansion, and a line splice inside a token ends the token. Every
+ *   byte sequence is accepted; bytes >= 0x80 are identifier characters.
+ *
+ * THREADING:
+ *   - A UmiCLexer is plain state on the caller's stack; any number of them
+ *     may run at once.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_C_LEXER_H
+#define UMICOM_C_LEXER_H
+
+#include <string.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+  UMI_CTOK_EOF = 0,
+  UMI_CTOK_IDENT,                  /* identifiers and keywords alike          */
+  UMI_CTOK_NUMBER,
+  UMI_CTOK_STRING,                 /* with prefix and quotes: u8"x", R"(x)"   */
+  UMI_CTOK_CHAR,
+  UMI_CTOK_PUNCT
+} UmiCTokenKind;
+
+enum {
+  UMI_CTOK_PP  = 1 << 0,           /* part of a preprocessor directive        */
+  UMI_CTOK_BOL = 1 << 1            /* first token on its line                 */
+};
+
+typedef struct {
+  UmiCTokenKind kind;
+  guint32       off, len;          /* bytes of the source                     */
+  guint32       line;              /* 1-based                                 */
+  guint32       column;            /* 1-based byte column                     */
+  guint32       flags;             /* UMI_CTOK_*                              */
+} UmiCToken;
+
+typedef enum {
+  UMI_CLEX_SKIP_IF0 = 1 << 0       /* drop "#if 0" ... "#else"/"#endif"       */
+} UmiCLexFlags;
+
+typedef struct {
+  /*< private >*/
+  const char *src;
+  gsize       len, pos, line_start;
+  guint32     line;
+  guint32     flags;
+  gboolean    in_pp, bol;
+} UmiCLexer;
+
+void     umi_c_lexer_init(UmiCLexer *lx, const char *src, gsize len, UmiCLexFlags flags);
+
+/* Next token into 'out'; FALSE (and an EOF token) at the end. */
+gboolean umi_c_lexer_next(UmiCLexer *lx, UmiCToken *out);
+
+/* Does token 't' of 'src' spell 'text'? */
+static inline gboolean umi_ctok_is(const char *src, const UmiCToken *t, const char *text) {
+  return strlen(text) == t->len && !memcmp(src + t->off, text, t->len);
+}
+
+/* Is 'c' a byte of an identifier (letters, digits, '_', '$', >= 0x80)? */
+static inline gboolean umi_c_ident_char(guchar c) {
+  return g_ascii_isalnum(c) || c == '_' || c == '$' || c >= 0x80;
+}
+
+G_END_DECLS
+#endif /* UMICOM_C_LEXER_H */
@@ -0,0 +1,87 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/include/ident_index.h
+ * PURPOSE: Identifier occurrence index for "find references"
+ *
+ * OVERVIEW:
+ *   Every C or C++ file of a UmiFileIndex is tokenized (c_lexer.h) and each
+ *   identifier token is recorded: identifier -> (file, line, column). Words
+ *   in comments, string literals, "#if 0" blocks and #include lines are not
+ *   identifiers, and neither are keywords, so a lookup lists real uses
+ *   only, token-exact ("len" never matches inside "strlen").
+ *   - Posting lists are appended per document (one version of one file):
+ *     document delta, count, then line delta and column per occurrence,
+ *     all LEB128 varints. A typical occurrence costs about two bytes.
+ *   - Changes are incremental as in trigram_index.h: a changed file's old
+ *     document is tombstoned and its new occurrences appended; tombstones
+ *     are squeezed out once they make up a quarter of the index.
+ *   - Files are tokenized in parallel (umi_parallel_for). The index
+ *     persists next to the file index snapshot; reopening it re-reads only
+ *     files whose size or mtime moved.
+ *
+ * THREADING:
+ *   - Same rules as trigram_index.h: one thread at a time, the file index
+ *     left alone meanwhile, umi_ident_index_mark_dirty() cheap enough for
+ *     watcher callbacks.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_IDENT_INDEX_H
+#define UMICOM_IDENT_INDEX_H
+
+#include <glib.h>
+#include "file_index.h"
+#include "search_results.h"
+
+G_BEGIN_DECLS
+
+typedef struct _UmiIdentIndex UmiIdentIndex;
+
+/* One occurrence. 'path' is borrowed: valid until the next sync or free. */
+typedef struct {
+  const char *path;                /* root-relative                        */
+  guint32     file_id;             /* resolve with umi_index_file_path()   */
+  guint32     line;                /* 1-based                              */
+  guint32     column;              /* 1-based byte column                  */
+} UmiIdentRef;
+
+/* Empty index over 'idx' (borrowed; must outlive it). */
+UmiIdentIndex *umi_ident_index_new(UmiFileIndex *idx);
+
+/* Like _new(), then load 'snapshot_path' when it matches the index root;
+ * files are re-verified on the first sync. NULL path: same as _new(). */
+UmiIdentIndex *umi_ident_index_open(UmiFileIndex *idx, const char *snapshot_path);
+
+void           umi_ident_index_free(UmiIdentIndex *x);
+
+/* Write the index atomically (tombstones are dropped first). */
+gboolean       umi_ident_index_save(UmiIdentIndex *x, const char *snapshot_path, GError **err);
+
+/* <user cache dir>/umicom-studio-ide/index/<sha1 of canonical root>.ids */
+char          *umi_ident_index_snapshot_path_for(const char *root);
+
+/* The contents of 'path' changed (or it was replaced). */
+void           umi_ident_index_mark_dirty(UmiIdentIndex *x, const char *path);
+
+/* Bring the index up to date with the file index and the dirty files.
+ * RETURNS: number of files (re-)read. */
+guint          umi_ident_index_sync(UmiIdentIndex *x);
+
+/* Sync, then replace the contents of 'out' (GArray of UmiIdentRef) with the
+ * first 'max' occurrences of identifier 'name' (case-sensitive), by path,
+ * line and column. RETURNS: total number of occurrences (may exceed max). */
+guint          umi_ident_index_find(UmiIdentIndex *x, const char *name, guint max, GArray *out);
+
+/* umi_ident_index_find() as search results a results view can show: one
+ * row per line, spans on the identifier, paths relative to the root.
+ * Lines are read from disk. '*truncated' (may be NULL) is set when more
+ * than 'max' occurrences exist. */
+UmiSearchResults *umi_ident_index_results(UmiIdentIndex *x, const char *name, guint max,
+                                          gboolean *truncated);
+
+/* Number of live documents and of distinct identifiers. */
+guint          umi_ident_index_n_files(const UmiIdentIndex *x);
+guint          umi_ident_index_n_idents(const UmiIdentIndex *x);
+
+G_END_DECLS
+#endif /* UMICOM_IDENT_INDEX_H */
@@ -0,0 +1,82 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/include/multi_search.h
+ * PURPOSE: Many literal patterns at once (Aho-Corasick), grouped by pattern
+ *
+ * OVERVIEW:
+ *   For audits such as "every use of these 300 deprecated calls": the
+ *   patterns are compiled once into an Aho-Corasick automaton and each
+ *   file is read once, however many patterns there are, instead of one rg
+ *   run per pattern or one huge regex alternation.
+ *   - A UmiMultiPattern holds the automaton. It is immutable and
+ *     reference-counted, so a search may outlive the caller's reference
+ *     and several searches may share it.
+ *   - umi_multi_search_start() scans the text files of a UmiFileIndex in
+ *     parallel (umi_parallel_for) and fills a UmiSearchResults store with
+ *     one group per pattern that matched (search_results.h), in pattern
+ *     order, rows by path and line inside a group. Overlapping matches of
+ *     different patterns are all reported, each in its own group.
+ *
+ * THREADING:
+ *   - As builtin_search.h: start, callbacks and cancellation on the main
+ *     loop; the index is only read inside umi_multi_search_start().
+ *   - umi_multi_pattern_scan() is reentrant.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_MULTI_SEARCH_H
+#define UMICOM_MULTI_SEARCH_H
+
+#include <glib.h>
+#include <gio/gio.h>
+#include "file_index.h"
+#include "search_results.h"
+
+G_BEGIN_DECLS
+
+typedef struct _UmiMultiPattern UmiMultiPattern;
+
+typedef enum {
+  UMI_MULTI_PATTERN_CASELESS = 1 << 0,    /* ASCII case-insensitive              */
+  UMI_MULTI_PATTERN_WORD     = 1 << 1     /* whole words: no [A-Za-z0-9_] around */
+} UmiMultiPatternFlags;
+
+/* Compile the 'n' literal patterns (empty ones and repeats are dropped).
+ * NULL when none is left. */
+UmiMultiPattern *umi_multi_pattern_new(const char * const *patterns, guint n,
+                                       UmiMultiPatternFlags flags);
+
+/* One pattern per line of 'text' (a trailing '\r' is dropped). */
+UmiMultiPattern *umi_multi_pattern_new_from_text(const char *text, UmiMultiPatternFlags flags);
+
+/* Patterns from a file, one per line. NULL with 'err' set when it cannot
+ * be read or holds no pattern. */
+UmiMultiPattern *umi_multi_pattern_new_from_file(const char *path, UmiMultiPatternFlags flags,
+                                                 GError **err);
+
+UmiMultiPattern *umi_multi_pattern_ref(UmiMultiPattern *mp);
+void             umi_multi_pattern_unref(UmiMultiPattern *mp);
+
+guint            umi_multi_pattern_count(const UmiMultiPattern *mp);
+const char      *umi_multi_pattern_get(const UmiMultiPattern *mp, guint i);
+
+/* Every match in data[0, len): 'fn' gets the pattern index and the byte
+ * range, in order of the match end. Return FALSE from 'fn' to stop. */
+typedef gboolean (*UmiMultiMatchFn)(guint pattern, gsize start, gsize end, gpointer user);
+void             umi_multi_pattern_scan(const UmiMultiPattern *mp, const char *data, gsize len,
+                                        UmiMultiMatchFn fn, gpointer user);
+
+/* Search the files of 'idx' for all patterns of 'mp' (a reference is
+ * held until on_done) and append the matching lines to 'out', grouped by
+ * pattern; the group label is the pattern. Same contract as
+ * umi_builtin_search_start(): at most 'max_results' rows (0: no cap), rows
+ * in batches, none after 'cancel' fires, on_done once from the main loop.
+ * Rows only arrive once every file was scanned, as grouping needs them
+ * all. */
+void             umi_multi_search_start(UmiFileIndex *idx, UmiMultiPattern *mp,
+                                        UmiSearchResults *out, guint max_results,
+                                        GCancellable *cancel, UmiSearchBatchCb on_batch,
+                                        UmiSearchDoneCb on_done, gpointer user);
+
+G_END_DECLS
+#endif /* UMICOM_MULTI_SEARCH_H */
@@ -0,0 +1,63 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/include/quick_open.h
+ * PURPOSE: Fuzzy "Quick Open" file matcher over a UmiFileIndex
+ *
+ * OVERVIEW:
+ *   Matches a short query ("fidx", "fs/walk.c", "TaskRun") against every
+ *   root-relative path in the index and returns the best few, best first.
+ *   - Scoring is subsequence based: every query character must appear in
+ *     order. Matches right after a separator ('/', '_', '-', '.'), on a
+ *     camelCase hump, in runs, and inside the file name score higher; gaps
+ *     cost a little.
+ *   - A 64-bit character-class mask per path rejects most candidates before
+ *     any scoring (SSE2, two paths per compare, scalar fallback elsewhere).
+ *   - Candidates are split across cores (umi_parallel_for); every worker
+ *     keeps its own top-k heap, merged at the end.
+ *   - When the new query extends the previous one, only the previous
+ *     matches are re-examined (typing narrows, it never widens).
+ *
+ * THREADING:
+ *   - A UmiQuickOpen is used from one thread at a time (typically the UI
+ *     thread, which calls query on each keystroke). Workers are internal.
+ *   - The index must not be modified during a query. Index changes are
+ *     picked up on the next query through umi_index_generation().
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_QUICK_OPEN_H
+#define UMICOM_QUICK_OPEN_H
+
+#include <glib.h>
+#include "file_index.h"
+
+G_BEGIN_DECLS
+
+typedef struct _UmiQuickOpen UmiQuickOpen;
+
+/* One result: resolve the path with umi_index_file_path(idx, file_id). */
+typedef struct {
+  guint32 file_id;
+  gint    score;
+} UmiQuickOpenHit;
+
+#define UMI_QUICK_OPEN_NO_MATCH G_MININT
+
+/* Create a matcher over 'idx' (borrowed; must outlive the matcher). */
+UmiQuickOpen *umi_quick_open_new(const UmiFileIndex *idx);
+void          umi_quick_open_free(UmiQuickOpen *qo);
+
+/* Replace the contents of 'out_hits' (GArray of UmiQuickOpenHit) with up to
+ * 'max_results' best matches for 'query', best first. Spaces in the query
+ * are ignored, matching is ASCII case-insensitive, '/' and '\' are
+ * interchangeable. An empty query returns the first files in index order.
+ * RETURNS: total number of matching files (may exceed max_results). */
+guint         umi_quick_open_query(UmiQuickOpen *qo, const char *query,
+                                   guint max_results, GArray *out_hits);
+
+/* Score one root-relative path, or UMI_QUICK_OPEN_NO_MATCH. Same rules as
+ * the matcher; handy for highlighting code and ad-hoc lists. */
+gint          umi_quick_open_score(const char *query, const char *rel_path);
+
+G_END_DECLS
+#endif /* UMICOM_QUICK_OPEN_H */
@@ -0,0 +1,106 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/include/replace_engine.h
+ * PURPOSE: Project-wide search and replace: preview first, then write
+ *
+ * OVERVIEW:
+ *   A replace runs in two steps over the files a search found:
+ *   1. Prepare: every file is mapped and matched on the worker threads
+ *      (umi_parallel_for); the edits are recorded, nothing is written.
+ *      The preview lists every changed line, before and after, as two
+ *      UmiSearchResults stores a results list can show.
+ *   2. Apply: each file is checked against what was previewed, rewritten
+ *      and staged next to itself (umi_file_stage) in parallel. Only when
+ *      every file staged are they renamed into place, one rename each, so
+ *      a failure leaves no file half-written and, before the renames, no
+ *      file changed at all.
+ *
+ *   Files open in an editor with unsaved changes are replaced in their
+ *   buffer text instead (umi_replace_plan_set_buffer): the new text goes
+ *   back to the editor, the file on disk is left alone.
+ *
+ *   Matching follows the search: line by line, bytewise (G_REGEX_RAW), a
+ *   trailing '\r' is not part of the line, and binary files are skipped.
+ *   Replacements may refer to groups as GRegex does (\0, \1, \g<name>).
+ *
+ * THREADING:
+ *   - Main thread API; prepare and apply block while the workers run.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_REPLACE_ENGINE_H
+#define UMICOM_REPLACE_ENGINE_H
+
+#include <glib.h>
+#include "search_results.h"
+
+G_BEGIN_DECLS
+
+typedef enum {
+  UMI_REPLACE_CASELESS = 1 << 0,   /* ASCII case-insensitive                      */
+  UMI_REPLACE_LITERAL  = 1 << 1    /* pattern and replacement are plain text      */
+} UmiReplaceFlags;
+
+typedef struct _UmiReplacePlan UmiReplacePlan;
+
+typedef struct {
+  const char *path;                /* as the search named it                     */
+  guint       n_edits;
+  gboolean    in_buffer;           /* replaced in unsaved editor text             */
+  gboolean    excluded;
+  const char *error;               /* why the file cannot be replaced, or NULL   */
+} UmiReplaceFileInfo;
+
+typedef struct {
+  guint files_written;
+  guint buffers_updated;
+  guint edits;
+} UmiReplaceStats;
+
+/* An editor buffer received its replaced text: put 'text' into the buffer
+ * of 'path' (absolute), as one undoable edit. */
+typedef void (*UmiReplaceBufferCb)(const char *path, const char *text, gsize len, gpointer user);
+
+/* A plan to replace 'pattern' (a regex unless LITERAL) with 'replacement'
+ * in the files of 'matches', whose paths are relative to 'root'. NULL with
+ * 'err' set if the pattern or the replacement does not compile. */
+UmiReplacePlan *umi_replace_plan_new(const char *root, const UmiSearchResults *matches,
+                                     const char *pattern, const char *replacement,
+                                     UmiReplaceFlags flags, GError **err);
+void            umi_replace_plan_free(UmiReplacePlan *p);
+
+/* 'path' (absolute) is open with unsaved 'text' (len -1: NUL-terminated,
+ * copied): replace in that text and hand the result to the editor rather
+ * than writing the file. The file joins the plan if the search (which read
+ * the disk) did not list it. Call before umi_replace_plan_prepare(). */
+void            umi_replace_plan_set_buffer(UmiReplacePlan *p, const char *path,
+                                            const char *text, gssize len);
+
+/* Match every file and build the preview. Files that cannot be read keep
+ * their error and are left out. */
+void            umi_replace_plan_prepare(UmiReplacePlan *p);
+
+guint           umi_replace_plan_n_files(const UmiReplacePlan *p);
+gboolean        umi_replace_plan_file(const UmiReplacePlan *p, guint i, UmiReplaceFileInfo *out);
+/* Leave file 'i' out of the apply step (the user unticked it). */
+void            umi_replace_plan_set_excluded(UmiReplacePlan *p, guint i, gboolean excluded);
+/* Edits over all files, excluded ones included. */
+guint           umi_replace_plan_n_edits(const UmiReplacePlan *p);
+
+/* Changed lines as they are ('after' FALSE) or will be, with spans on the
+ * matches or on their replacements. Borrowed; valid until the plan is
+ * prepared again or freed. Rows of both stores correspond one to one. */
+UmiSearchResults *umi_replace_plan_preview(const UmiReplacePlan *p, gboolean after);
+
+/* Write the prepared edits of the files not excluded. Each file is read
+ * again and the edits are spliced into what is there now, so a change
+ * elsewhere in it survives; a file whose size or changed lines differ from
+ * the preview, or that cannot be staged, aborts the whole apply before any
+ * file is touched: FALSE, 'err' names them, prepare again. A rename
+ * failing afterwards is reported the same way; the other files are still
+ * committed. */
+gboolean        umi_replace_plan_apply(UmiReplacePlan *p, UmiReplaceBufferCb on_buffer,
+                                       gpointer user, UmiReplaceStats *out, GError **err);
+
+G_END_DECLS
+#endif /* UMICOM_REPLACE_ENGINE_H */
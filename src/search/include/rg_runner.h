@@ -2,20 +2,45 @@
  * Umicom Studio IDE
  * File: src/search/include/rg_runner.h
  * PURPOSE: Thin wrapper to run ripgrep with our argument builder
+ *
+ * STREAMING:
+ *   umi_rg_search_start() spawns "rg --json" and returns at once. Its
+ *   stdout is read on the main loop as it arrives; every "match" message
+ *   becomes a row of a UmiSearchResults store (path, line, submatch byte
+ *   ranges, preview) and rows reach the caller in batches, so the first
+ *   hits show while rg is still walking the tree. A result cap kills rg
+ *   once enough rows arrived, which keeps memory bounded, and the
+ *   GCancellable kills it whenever the caller loses interest.
+ *
  * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-01 | MIT
  *---------------------------------------------------------------------------*/
 #ifndef UMICOM_RG_RUNNER_H
 #define UMICOM_RG_RUNNER_H
 
 #include <glib.h>
+#include <gio/gio.h>
+#include "search_results.h"
 
 G_BEGIN_DECLS
 
 /* Execute ripgrep with the provided argv vector (NULL-terminated).
  * Captures stdout and stderr into GString buffers (which must be pre-
  * allocated by the caller). Returns TRUE on successful spawn; the exit
- * code from ripgrep is written into *exit_status when non-NULL. */
+ * code from ripgrep is written into *exit_status when non-NULL.
+ * Blocks until rg exits: for tools and tests, the UI uses
+ * umi_rg_search_start(). */
 gboolean umi_rg_run(char **argvv, GString *out, GString *err, int *exit_status);
 
+/* Start rg with 'argvv' (umi_rg_args_make_json()) in 'cwd' (NULL: ours)
+ * and append its matches to 'out' (a reference is held until on_done).
+ * At most 'max_results' rows are added (0: no cap); batches hold at most
+ * a few hundred rows so the main loop stays responsive. Cancelling
+ * 'cancel' kills rg: no batch follows, then on_done runs with 'cancelled'
+ * set. If rg cannot be spawned, on_done runs from an idle. */
+void umi_rg_search_start(char **argvv, const char *cwd, UmiSearchResults *out,
+                         guint max_results, GCancellable *cancel,
+                         UmiSearchBatchCb on_batch, UmiSearchDoneCb on_done,
+                         gpointer user);
+
 G_END_DECLS
 #endif /* UMICOM_RG_RUNNER_H */
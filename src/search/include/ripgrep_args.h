@@ -15,6 +15,20 @@
  *---------------------------------------------------------------------------*/
 char **umi_rg_args_make_simple(const char *pattern, const char *path);
 
+/*---------------------------------------------------------------------------
+ * umi_rg_args_make_json:
+ *   Same search, with rg's JSON Lines output (match byte ranges, non-UTF-8
+ *   paths) as read by umi_rg_search_start(). Free with umi_rg_args_free().
+ *---------------------------------------------------------------------------*/
+char **umi_rg_args_make_json(const char *pattern, const char *path);
+
+/*---------------------------------------------------------------------------
+ * umi_rg_args_make_json_files:
+ *   The JSON search over a NULL-terminated list of paths instead of one.
+ *   The list must not be empty: rg would search the working directory.
+ *---------------------------------------------------------------------------*/
+char **umi_rg_args_make_json_files(const char *pattern, const char * const *paths);
+
 /*---------------------------------------------------------------------------
  * umi_rg_args_free:
  *   Frees an argv vector previously created by umi_rg_args_make_simple().
@@ -0,0 +1,85 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/include/search_cache.h
+ * PURPOSE: Cache of finished text searches, revalidated file by file
+ *
+ * OVERVIEW:
+ *   Completed result stores are kept per (pattern, flags, scope) in an LRU
+ *   bounded by bytes (umi_search_results_memory). Watcher events are
+ *   appended to one change log; an entry remembers the log position it is
+ *   valid at. A lookup then has three outcomes:
+ *   - hit: nothing under the scope changed; the cached store is returned
+ *     as is and can be shown without searching.
+ *   - partial: a few files (or directories) changed. The caller gets a
+ *     copy of the store without their rows plus the list of changed
+ *     paths, re-searches only those, appends, and puts the store back.
+ *   - miss: no entry, too many changes to be worth patching, or the file
+ *     set moved without any event explaining it (the index generation
+ *     changed, e.g. after a refresh).
+ *
+ * THREADING:
+ *   - Main loop only, like the stores it holds. Cached stores are never
+ *     appended to again; a partial hit always works on a copy.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_SEARCH_CACHE_H
+#define UMICOM_SEARCH_CACHE_H
+
+#include <glib.h>
+#include "search_results.h"
+
+G_BEGIN_DECLS
+
+#define UMI_SEARCH_CACHE_MAX_STALE  256u   /* more changed paths: search again */
+
+typedef struct _UmiSearchCache UmiSearchCache;
+
+/* What a search was. Searches differing in any field never share results. */
+typedef struct {
+  const char *pattern;
+  guint       flags;        /* engine and options; opaque to the cache         */
+  const char *scope;        /* absolute directory; row paths are relative to it */
+  guint64     generation;   /* umi_index_generation() of the scope, 0: none    */
+} UmiSearchKey;
+
+typedef struct {
+  guint hits, partial, misses;
+  guint entries;
+  gsize bytes;
+} UmiSearchCacheStats;
+
+/* A cache holding at most 'max_bytes' of results (0: a default of 64 MiB). */
+UmiSearchCache   *umi_search_cache_new(gsize max_bytes);
+void              umi_search_cache_free(UmiSearchCache *c);
+
+/* Drop every entry, e.g. when the index behind the scopes was rebuilt. */
+void              umi_search_cache_clear(UmiSearchCache *c);
+
+/* Watcher hook: the file or directory at absolute 'path' was created,
+ * changed, deleted or renamed (report both names). A changed .gitignore
+ * or .ignore stands for its whole directory. */
+void              umi_search_cache_file_changed(UmiSearchCache *c, const char *path);
+
+/* Current position in the change log. Take it when a search starts and
+ * hand it to _put(): changes after it make the entry stale again. */
+guint64           umi_search_cache_stamp(const UmiSearchCache *c);
+
+/* NULL on a miss. On a hit, the cached store (new reference) and '*stale'
+ * set to NULL. On a partial hit, a new store without the rows of the
+ * changed paths and '*stale' a NULL-terminated list of those paths,
+ * relative to the scope (g_strfreev). Directories are listed as such:
+ * everything below them is stale. */
+UmiSearchResults *umi_search_cache_get(UmiSearchCache *c, const UmiSearchKey *key,
+                                       char ***stale);
+
+/* Remember the complete results 'r' of 'key' as of 'stamp' (takes a
+ * reference; 'r' must not be appended to afterwards). Stores larger than
+ * the budget, or stamps older than the change log reaches, are ignored. */
+void              umi_search_cache_put(UmiSearchCache *c, const UmiSearchKey *key,
+                                       guint64 stamp, UmiSearchResults *r);
+
+void              umi_search_cache_stats(const UmiSearchCache *c, UmiSearchCacheStats *out);
+
+G_END_DECLS
+#endif /* UMICOM_SEARCH_CACHE_H */
@@ -2,32 +2,122 @@
  * Umicom Studio IDE
  * File: src/search/include/search_panel.h
  * PURPOSE: Public API for the Search Panel widget (GTK)
+ *
+ * OVERVIEW:
+ *   A search entry over a GtkListView of results. The list is virtualized:
+ *   its model is a view of a UmiSearchResults store and row objects are
+ *   made on demand for the rows on screen, so hundreds of thousands of
+ *   results cost no widgets and scroll like a short list. Results stream
+ *   in from ripgrep (rg_runner.h) while it runs, or from the built-in
+ *   engine (builtin_search.h) on machines without rg. With a file index,
+ *   finished searches are cached (search_cache.h): a repeated query is
+ *   answered at once, and after edits only the changed files are searched.
+ *
  * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-01 | MIT
  *---------------------------------------------------------------------------*/
 #pragma once
 
 #include <gtk/gtk.h>
+#include "builtin_search.h"
+#include "ident_index.h"
+#include "multi_search.h"
+#include "struct_search.h"
+#include "trigram_index.h"
 #include "rg_runner.h"
 #include "rg_discovery.h"
 #include "ripgrep_args.h"
+#include "search_cache.h"
+#include "search_results.h"
 #include "status_util.h"  /* from src/util/log/include */
 
 /*---------------------------------------------------------------------------
  * UmiSearchPanel:
- *   Opaque type representing the panel state. For now this is a trivial
- *   wrapper around a GtkWidget, but it may evolve to keep settings/state.
+ *   Opaque panel state: widgets, the current search and its results.
  *---------------------------------------------------------------------------*/
-typedef struct UmiSearchPanel {
-  GtkWidget *widget;  /* owned by the panel; packed into the main UI */
-} UmiSearchPanel;
+typedef struct UmiSearchPanel UmiSearchPanel;
 
-/* Construct a new panel instance. Ownership: caller must later destroy it. */
+/* A result was activated: open 'path' at 'line' / 'column' (1-based; the
+ * column is a byte column). */
+typedef void (*UmiSearchOpenCb)(gpointer user, const char *path, guint line, guint column);
+
+/* Construct a new panel instance. Ownership: caller must later destroy it
+ * with umi_search_panel_free(). */
 UmiSearchPanel *umi_search_panel_new(void);
+void            umi_search_panel_free(UmiSearchPanel *sp);
 
 /* Return the root widget to pack into UI containers. Non-owning pointer. */
 GtkWidget *umi_search_panel_widget(UmiSearchPanel *sp);
 
-/* Execute a sample search (placeholder). Will emit results to the UI when
- * fully implemented. */
+/* Directory searched (NULL: the working directory); paths in the list are
+ * shown relative to it. */
+void umi_search_panel_set_root(UmiSearchPanel *sp, const char *dir);
+void umi_search_panel_set_open_cb(UmiSearchPanel *sp, UmiSearchOpenCb cb, gpointer user);
+
+/* Files the built-in engine searches when rg is missing (borrowed; must
+ * outlive the panel). Its root should be the panel's root. Unset, the
+ * panel indexes the root itself on the first search that needs it. */
+void umi_search_panel_set_index(UmiSearchPanel *sp, UmiFileIndex *idx);
+
+/* Trigram index over that same index (borrowed; NULL: none). A full search
+ * then only reads the files it names as candidates: always for the
+ * built-in engine, for rg when the pattern is a literal. It is synced on
+ * the main thread before each such search, so build it elsewhere first. */
+void umi_search_panel_set_trigram(UmiSearchPanel *sp, UmiTrigramIndex *t);
+
+/* Watcher hook: 'path' (absolute) was created, changed, deleted or renamed
+ * (report both names). Call it after umi_index_apply() so the index
+ * already knows the new file set. Cached results are revalidated lazily,
+ * on the next search for the same query. */
+void umi_search_panel_file_changed(UmiSearchPanel *sp, const char *path);
+
+/* Hit, partial-hit and miss counts of the result cache, and its size. */
+void umi_search_panel_cache_stats(UmiSearchPanel *sp, UmiSearchCacheStats *out);
+
+/* Search for 'pattern' (a regex, as rg takes it), replacing the current
+ * results; a search still running is cancelled (its rg is killed). A
+ * literal that contains the previous, complete literal query is answered
+ * by filtering the shown results instead. Empty: clear. */
+void umi_search_panel_search(UmiSearchPanel *sp, const char *pattern);
+
+/* Search the indexed files for every pattern of 'mp' at once (see
+ * multi_search.h), replacing the current results: one group per pattern
+ * that matched, each under a header. NULL: clear. */
+void umi_search_panel_search_patterns(UmiSearchPanel *sp, UmiMultiPattern *mp);
+
+/* Search the C / C++ files for structural 'query' (struct_search.h: tokens
+ * with $x / $$x holes, layout ignored), replacing the current results. A
+ * query that does not compile is reported in the status line. Empty: clear. */
+void umi_search_panel_search_structural(UmiSearchPanel *sp, const char *query);
+
+/* Search for the text currently in the entry, as typing does once it
+ * pauses (edits are debounced; Enter searches at once). Does nothing when
+ * that query is already shown or running. */
 void umi_search_panel_run_example(UmiSearchPanel *sp);
-/*---------------------------------------------------------------------------*/
\ No newline at end of file
+
+/* The results shown (borrowed, NULL when empty), e.g. the matches a
+ * replace (replace_engine.h) works on. Paths are relative to the root. */
+UmiSearchResults *umi_search_panel_results(UmiSearchPanel *sp);
+
+/* Show 'res' (a reference is taken) instead of search results, with
+ * 'status' under the entry; a running search is cancelled. Used for the
+ * before / after preview of a replace. */
+void umi_search_panel_show(UmiSearchPanel *sp, UmiSearchResults *res, const char *status);
+
+/* Show the uses of identifier 'name' from 'ids' (ident_index.h) the same
+ * way: token-exact, one row per line, comments and strings left out. */
+void umi_search_panel_show_references(UmiSearchPanel *sp, UmiIdentIndex *ids, const char *name);
+
+/* What search-as-you-type did and what it threw away. */
+typedef struct {
+  guint   edits;         /* entry changes seen                              */
+  guint   debounced;     /* edits that restarted a pending debounce         */
+  guint   started;       /* engine runs (rg spawns or built-in searches)    */
+  guint   superseded;    /* runs cancelled by a newer query                 */
+  guint   narrowed;      /* queries answered by filtering the shown results */
+  guint   cached;        /* queries answered from the result cache          */
+  guint64 wasted_rows;   /* rows found by superseded runs                   */
+  gint64  wasted_usec;   /* time superseded runs ran before being cancelled */
+} UmiSearchLiveStats;
+
+void umi_search_panel_live_stats(UmiSearchPanel *sp, UmiSearchLiveStats *out);
+/*---------------------------------------------------------------------------*/
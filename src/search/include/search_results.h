@@ -0,0 +1,117 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/include/search_results.h
+ * PURPOSE: Compact store for text search results, shared by every engine
+ *
+ * OVERVIEW:
+ *   A result row is one matching line: file id, line number, a preview of
+ *   the line and the byte spans of the matches in it. Rows are stored
+ *   column by column (one array per field) and previews are packed into a
+ *   single text arena, so 200k rows cost a few tens of MB and no per-row
+ *   allocation. A preview is at most UMI_SEARCH_PREVIEW_MAX bytes: long
+ *   lines keep a window starting a little before their first match, and
+ *   leading indentation is dropped.
+ *
+ *   Search engines append rows and report them with UmiSearchBatchCb;
+ *   views read rows by index with umi_search_results_row().
+ *
+ * THREADING:
+ *   - Not thread-safe; engines append from the main loop.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_SEARCH_RESULTS_H
+#define UMICOM_SEARCH_RESULTS_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define UMI_SEARCH_PREVIEW_MAX  512u   /* bytes of line text kept per row   */
+
+typedef struct _UmiSearchResults UmiSearchResults;
+
+/* A match inside a row, as byte offsets into its preview. */
+typedef struct {
+  guint32 start, end;
+} UmiSearchSpan;
+
+/* A row as returned by umi_search_results_row(); pointers are borrowed
+ * and stay valid until the store is cleared or freed. 'preview' is not
+ * NUL-terminated. */
+typedef struct {
+  guint32              file_id;
+  guint32              line;       /* 1-based                               */
+  guint32              column;     /* byte offset of the preview in the line */
+  const char          *preview;
+  guint                preview_len;
+  const UmiSearchSpan *spans;
+  guint                n_spans;
+} UmiSearchRow;
+
+/* How a search ended. */
+typedef struct {
+  gboolean    spawned;     /* FALSE: the search could not start ('error') */
+  gboolean    cancelled;   /* the caller cancelled                        */
+  gboolean    truncated;   /* stopped at the result cap                   */
+  int         exit_status; /* rg's exit code (1: no match); -1 if killed  */
+  guint       n_rows;      /* rows added by this search                   */
+  const char *error;       /* diagnostics (rg's stderr), may be empty     */
+} UmiSearchSummary;
+
+/* Rows [first, first + n) were appended to 'r' (n is never 0). */
+typedef void (*UmiSearchBatchCb)(UmiSearchResults *r, guint first, guint n, gpointer user);
+/* Called exactly once per search, last, also after cancellation. */
+typedef void (*UmiSearchDoneCb)(const UmiSearchSummary *s, gpointer user);
+
+UmiSearchResults *umi_search_results_new(void);
+UmiSearchResults *umi_search_results_ref(UmiSearchResults *r);
+void              umi_search_results_unref(UmiSearchResults *r);
+void              umi_search_results_clear(UmiSearchResults *r);
+
+/* Id of 'path', added on first use. */
+guint32           umi_search_results_add_file(UmiSearchResults *r, const char *path);
+const char       *umi_search_results_file(const UmiSearchResults *r, guint32 file_id);
+guint             umi_search_results_n_files(const UmiSearchResults *r);
+
+/* Append a row for 'line' of 'file_id'. 'text' is the whole line (len -1:
+ * NUL-terminated; a line break ends it) and 'spans' the matches in it as
+ * byte offsets into 'text'; both are copied. Returns the row index. */
+guint             umi_search_results_add(UmiSearchResults *r, guint32 file_id, guint32 line,
+                                         const char *text, gssize len,
+                                         const UmiSearchSpan *spans, guint n_spans);
+
+guint             umi_search_results_n_rows(const UmiSearchResults *r);
+gboolean          umi_search_results_row(const UmiSearchResults *r, guint i, UmiSearchRow *out);
+
+/* Groups: rows appended after _begin_group() belong to a group labelled
+ * 'label' (copied) until the next one starts, e.g. one group per pattern
+ * of a multi-pattern search. Stores without groups are the norm; filter
+ * and narrow do not carry groups over. */
+guint             umi_search_results_begin_group(UmiSearchResults *r, const char *label);
+guint             umi_search_results_n_groups(const UmiSearchResults *r);
+/* Group of row 'row', or -1 when it is in none. */
+gint              umi_search_results_row_group(const UmiSearchResults *r, guint row);
+/* Label of 'group' (NULL when out of range) and its rows [first, first + n_rows). */
+const char       *umi_search_results_group(const UmiSearchResults *r, guint group,
+                                           guint *first, guint *n_rows);
+
+/* A new store holding the rows of the files 'keep' returns TRUE for, in
+ * their order (file ids are renumbered). */
+typedef gboolean (*UmiSearchFileFilter)(const char *path, gpointer user);
+UmiSearchResults *umi_search_results_filter(const UmiSearchResults *r, UmiSearchFileFilter keep,
+                                            gpointer user);
+
+/* A new store holding the rows whose preview contains 'literal', with
+ * spans on its occurrences. For narrowing the complete results of a
+ * pattern that 'literal' contains (typing on after a literal query): a
+ * line matching 'literal' has a row in 'r', and its match lies in the
+ * preview window unless the line was cut. NULL when some cut preview
+ * leaves a row undecided; search again then. */
+UmiSearchResults *umi_search_results_narrow(const UmiSearchResults *r, const char *literal);
+
+/* Bytes held by the store (arrays, arena, file names). */
+gsize             umi_search_results_memory(const UmiSearchResults *r);
+
+G_END_DECLS
+#endif /* UMICOM_SEARCH_RESULTS_H */
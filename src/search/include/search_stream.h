@@ -0,0 +1,97 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/include/search_stream.h
+ * PURPOSE: Shared file loop of the in-process search engines
+ *
+ * OVERVIEW:
+ *   The built-in, multi-pattern and structural searches differ only in how
+ *   they look at one file. Everything around that lives here: the file
+ *   list snapshot, reading (small files copied into a reused buffer, large
+ *   ones mapped), the binary probe, spreading files over the cores
+ *   (umi_parallel_for), collecting rows, moving them into the
+ *   UmiSearchResults store in batches, the result cap, cancellation and
+ *   the summary.
+ *   - An engine supplies a scan function. It runs on worker threads, once
+ *     per readable text file, and reports rows with umi_search_stream_row().
+ *   - Rows stream into the store as workers hand them over, or, with
+ *     UMI_SEARCH_STREAM_GROUPED, only once every file was scanned, sorted
+ *     by group, file and line, with a store group (search_results.h) per
+ *     group number.
+ *
+ * THREADING:
+ *   - Created, started and finished on the main loop; the callbacks of
+ *     UmiSearchResults run there. Only the scan function, row reporting
+ *     and umi_search_stream_stopped() are called from workers.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_SEARCH_STREAM_H
+#define UMICOM_SEARCH_STREAM_H
+
+#include <glib.h>
+#include <gio/gio.h>
+#include "file_index.h"
+#include "search_results.h"
+
+G_BEGIN_DECLS
+
+typedef struct _UmiSearchStream UmiSearchStream;
+
+typedef enum {
+  UMI_SEARCH_STREAM_GROUPED = 1 << 0      /* rows sorted into groups at the end */
+} UmiSearchStreamFlags;
+
+/* Look at data[0, len) of file 'file' (an index into the stream's list)
+ * on worker 'worker' (0 .. umi_search_stream_n_workers() - 1); 'engine'
+ * is the pointer given to umi_search_stream_new(). 'data' is only valid
+ * during the call. */
+typedef void (*UmiSearchStreamScanFn)(UmiSearchStream *ss, guint worker, guint32 file,
+                                      const guchar *data, gsize len, gpointer engine);
+
+/* Label of group 'group' (GROUPED streams), called on the main loop. */
+typedef const char *(*UmiSearchStreamGroupFn)(guint32 group, gpointer engine);
+
+/* A stream that fills 'out' (a reference is held) under the contract of
+ * umi_builtin_search_start(): at most 'max_results' rows (0: no cap),
+ * batches, no batch after 'cancel' fires, on_done exactly once from the
+ * main loop. 'engine' is freed with 'engine_free' after on_done. */
+UmiSearchStream *umi_search_stream_new(UmiSearchStreamFlags flags,
+                                       UmiSearchStreamScanFn scan,
+                                       UmiSearchStreamGroupFn group_label,
+                                       gpointer engine, GDestroyNotify engine_free,
+                                       UmiSearchResults *out, guint max_results,
+                                       GCancellable *cancel, UmiSearchBatchCb on_batch,
+                                       UmiSearchDoneCb on_done, gpointer user);
+
+/* Files to search: the files of 'idx' that 'keep' accepts (NULL: all),
+ * binary files the metadata cache knows about left out; rows are named
+ * relative to the index root. */
+void  umi_search_stream_add_index(UmiSearchStream *ss, UmiFileIndex *idx,
+                                  gboolean (*keep)(const char *path));
+
+/* Or 'files', NULL-terminated paths relative to 'root'. */
+void  umi_search_stream_add_files(UmiSearchStream *ss, const char *root,
+                                  const char * const *files);
+
+guint umi_search_stream_n_workers(const UmiSearchStream *ss);
+
+/* Search on a thread; the stream frees itself after on_done. */
+void  umi_search_stream_run(UmiSearchStream *ss);
+
+/* Instead of running: end with 'spawned' FALSE and 'error' as the
+ * summary's error (a pattern that does not compile); on_done comes from
+ * an idle. */
+void  umi_search_stream_fail(UmiSearchStream *ss, const char *error);
+
+/* From the scan function: a row for 'line' of 'file', 'text' the start
+ * of the line (copied), 'spans' relative to it. 'group' is only used by
+ * GROUPED streams. */
+void  umi_search_stream_row(UmiSearchStream *ss, guint worker, guint32 group, guint32 file,
+                            guint32 line, const guchar *text, gsize text_len,
+                            const UmiSearchSpan *spans, guint n_spans);
+
+/* TRUE once the search was cancelled or capped; long scans poll it. */
+gboolean umi_search_stream_stopped(const UmiSearchStream *ss);
+
+G_END_DECLS
+#endif /* UMICOM_SEARCH_STREAM_H */
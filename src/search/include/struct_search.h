@@ -0,0 +1,71 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/include/struct_search.h
+ * PURPOSE: Structural (token-level) code search with wildcard holes
+ *
+ * OVERVIEW:
+ *   The query and the files are both tokenized by the shared C-family
+ *   lexer (c_lexer.h) and compared token by token, so layout does not
+ *   matter: "foo ( a , b )" finds "foo(a,\n    b)", and nothing inside a
+ *   comment, a string literal or an "#if 0" block is found by accident.
+ *   Holes stand for code:
+ *     $x    one token, or one bracketed group "( ... )", "[ ... ]", "{ ... }"
+ *     $$x   any run of tokens with balanced brackets, possibly empty; the
+ *           shortest run that lets the rest of the query match is taken
+ *   A name used twice must match the same tokens both times ("$a = $a");
+ *   "$_" and "$$" (no name) match anything each time. A query needs at
+ *   least one token that is not a hole, and balanced brackets.
+ *   - Files are checked for the longest literal tokens of the query
+ *     (memmem) before they are tokenized; most files stop there.
+ *   - Only C and C++ files are searched (umi_symbol_index_is_source).
+ *
+ * THREADING:
+ *   - As builtin_search.h: start, callbacks and cancellation on the main
+ *     loop; the index is only read inside umi_struct_search_start().
+ *   - A UmiStructQuery is immutable; umi_struct_query_match() is reentrant.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_STRUCT_SEARCH_H
+#define UMICOM_STRUCT_SEARCH_H
+
+#include <glib.h>
+#include <gio/gio.h>
+#include "file_index.h"
+#include "search_results.h"
+
+G_BEGIN_DECLS
+
+typedef struct _UmiStructQuery UmiStructQuery;
+
+/* One match: bytes [start, end) of the source, starting at line:column
+ * (1-based, byte column). */
+typedef struct {
+  guint32 start, end;
+  guint32 line, column;
+} UmiStructMatch;
+
+/* Compile 'text'. NULL with 'err' set (G_IO_ERROR_INVALID_ARGUMENT) when
+ * it is empty, only holes, its brackets do not balance, or it names more
+ * than 32 different holes. */
+UmiStructQuery *umi_struct_query_new(const char *text, GError **err);
+UmiStructQuery *umi_struct_query_ref(UmiStructQuery *q);
+void            umi_struct_query_unref(UmiStructQuery *q);
+
+/* Replace the contents of 'out' (GArray of UmiStructMatch) with the
+ * matches in src[0, len), left to right, not overlapping. "#if 0" blocks
+ * are skipped. RETURNS: out->len. */
+guint           umi_struct_query_match(const UmiStructQuery *q, const char *src, gsize len,
+                                       GArray *out);
+
+/* Search the C / C++ files of 'idx' for 'q' (a reference is held until
+ * on_done) and append a row per matching line to 'out', spans on the
+ * matches (a match running over several lines is marked on its first).
+ * Same contract as umi_builtin_search_start(). */
+void            umi_struct_search_start(UmiFileIndex *idx, UmiStructQuery *q,
+                                        UmiSearchResults *out, guint max_results,
+                                        GCancellable *cancel, UmiSearchBatchCb on_batch,
+                                        UmiSearchDoneCb on_done, gpointer user);
+
+G_END_DECLS
+#endif /* UMICOM_STRUCT_SEARCH_H */
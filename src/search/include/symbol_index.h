@@ -0,0 +1,111 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/include/symbol_index.h
+ * PURPOSE: ctags-style C / C++ definition index (go-to-definition, "@symbol")
+ *
+ * OVERVIEW:
+ *   Every C or C++ source and header of a UmiFileIndex is tokenized
+ *   (c_lexer.h; comments, strings and "#if 0" blocks never reach the
+ *   parser) and scanned for definitions: functions with a body, structs,
+ *   unions, classes, enums and their enumerators, typedefs / using-aliases
+ *   and #define macros. Declarations without a body (prototypes, "struct
+ *   x;") are not definitions and are left out.
+ *   - The scan is heuristic, like ctags: braces are tracked, names are
+ *     found by shape, and only the first branch of an #if/#else is read,
+ *     so a conditional does not unbalance the braces.
+ *   - All symbols sit in one table sorted by name (ASCII case-folded
+ *     first), so an exact or prefix lookup is a binary search.
+ *   - Files are tokenized in parallel (umi_parallel_for). A changed file's
+ *     symbols are replaced without touching the rest: its new symbols are
+ *     sorted on their own and merged into the table.
+ *   - The index persists next to the file index snapshot, table order
+ *     included; reopening it re-reads only files whose size or mtime moved.
+ *
+ * THREADING:
+ *   - Same rules as trigram_index.h: one thread at a time, the file index
+ *     left alone meanwhile, umi_symbol_index_mark_dirty() cheap enough for
+ *     watcher callbacks.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_SYMBOL_INDEX_H
+#define UMICOM_SYMBOL_INDEX_H
+
+#include <glib.h>
+#include "file_index.h"
+
+G_BEGIN_DECLS
+
+typedef struct _UmiSymbolIndex UmiSymbolIndex;
+
+typedef enum {
+  UMI_SYMBOL_FUNCTION = 0,
+  UMI_SYMBOL_STRUCT,
+  UMI_SYMBOL_UNION,
+  UMI_SYMBOL_CLASS,
+  UMI_SYMBOL_ENUM,
+  UMI_SYMBOL_ENUMERATOR,
+  UMI_SYMBOL_TYPEDEF,
+  UMI_SYMBOL_MACRO
+} UmiSymbolKind;
+
+/* One definition. Strings are borrowed from the index: valid until the
+ * next sync, lookup, save or free. */
+typedef struct {
+  const char    *name;             /* "bar", "~Foo", "operator=="          */
+  const char    *scope;            /* "ns::Foo" for members; "" if none    */
+  const char    *path;             /* root-relative                        */
+  guint32        file_id;          /* resolve with umi_index_file_path()   */
+  guint32        line;             /* 1-based                              */
+  guint32        column;           /* 1-based byte column of the name      */
+  UmiSymbolKind  kind;
+} UmiSymbol;
+
+/* Empty index over 'idx' (borrowed; must outlive it). */
+UmiSymbolIndex *umi_symbol_index_new(UmiFileIndex *idx);
+
+/* Like _new(), then load 'snapshot_path' when it matches the index root;
+ * files are re-verified on the first sync. NULL path: same as _new(). */
+UmiSymbolIndex *umi_symbol_index_open(UmiFileIndex *idx, const char *snapshot_path);
+
+void            umi_symbol_index_free(UmiSymbolIndex *s);
+
+/* Write the index atomically (dropped files are squeezed out first). */
+gboolean        umi_symbol_index_save(UmiSymbolIndex *s, const char *snapshot_path,
+                                      GError **err);
+
+/* <user cache dir>/umicom-studio-ide/index/<sha1 of canonical root>.sym */
+char           *umi_symbol_index_snapshot_path_for(const char *root);
+
+/* The contents of 'path' changed (or it was replaced). */
+void            umi_symbol_index_mark_dirty(UmiSymbolIndex *s, const char *path);
+
+/* Bring the index up to date with the file index and the dirty files.
+ * RETURNS: number of files (re-)read. */
+guint           umi_symbol_index_sync(UmiSymbolIndex *s);
+
+/* Sync, then replace the contents of 'out' (GArray of UmiSymbol) with the
+ * definitions named exactly 'name' (case-sensitive), by path and line.
+ * RETURNS: out->len. */
+guint           umi_symbol_index_lookup(UmiSymbolIndex *s, const char *name, GArray *out);
+
+/* Palette query: sync, then up to 'max' symbols for 'query' (a leading
+ * '@' is ignored), best first. Names starting with the query (ASCII
+ * case-insensitive) come first, exact and shorter names ahead; when they
+ * do not fill 'max', fuzzy matches (umi_quick_open_score rules) follow.
+ * RETURNS: out->len. */
+guint           umi_symbol_index_query(UmiSymbolIndex *s, const char *query, guint max,
+                                       GArray *out);
+
+/* "function", "struct", ... */
+const char     *umi_symbol_kind_name(UmiSymbolKind kind);
+
+/* Number of indexed files and of symbols. */
+guint           umi_symbol_index_n_files(const UmiSymbolIndex *s);
+guint           umi_symbol_index_n_symbols(const UmiSymbolIndex *s);
+
+/* Is 'path' a C or C++ source or header (by extension)? */
+gboolean        umi_symbol_index_is_source(const char *path);
+
+G_END_DECLS
+#endif /* UMICOM_SYMBOL_INDEX_H */
@@ -0,0 +1,111 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/include/trigram_index.h
+ * PURPOSE: Trigram content index for in-process full-text search
+ *
+ * OVERVIEW:
+ *   Every text file of a UmiFileIndex is broken into its distinct 3-byte
+ *   sequences (ASCII case-folded); each trigram keeps a posting list of the
+ *   documents containing it. A query is planned from the literal runs its
+ *   matches must contain: the posting lists of their trigrams are
+ *   intersected and only the surviving files are opened and searched.
+ *   - Building fans out over the cores (umi_parallel_for); so does the
+ *     verification pass of a query.
+ *   - Changes are incremental: a changed file's old document is tombstoned
+ *     and a new one appended, so posting lists only ever grow at the end.
+ *     Tombstones are squeezed out once they make up a quarter of the index.
+ *   - Binary files (umi_file_meta_kind) are neither indexed nor searched.
+ *     Files above 8 MiB are not indexed but always searched.
+ *   - The index persists next to the file index snapshot; reopening it
+ *     re-reads only files whose size or mtime moved.
+ *
+ * THREADING:
+ *   - Used from one thread at a time; the file index must not be modified
+ *     meanwhile (same rule as quick_open.h). Large builds belong off the UI
+ *     thread. umi_trigram_index_mark_dirty() is cheap enough for watcher
+ *     callbacks: the file is re-read on the next sync or search.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_TRIGRAM_INDEX_H
+#define UMICOM_TRIGRAM_INDEX_H
+
+#include <glib.h>
+#include "file_index.h"
+
+G_BEGIN_DECLS
+
+typedef struct _UmiTrigramIndex UmiTrigramIndex;
+
+typedef enum {
+  UMI_TRIGRAM_CASELESS = 1 << 0,   /* ASCII case-insensitive               */
+  UMI_TRIGRAM_REGEX    = 1 << 1    /* pattern is a GRegex (PCRE) pattern   */
+} UmiTrigramFlags;
+
+/* One match. 'text' is the whole line (newline stripped, capped at 1 KiB). */
+typedef struct {
+  guint32 file_id;                 /* resolve with umi_index_file_path()   */
+  guint32 line;                    /* 1-based                              */
+  guint32 column;                  /* 1-based byte column of the match     */
+  guint32 length;                  /* match length in bytes                */
+  char   *text;
+} UmiTrigramHit;
+
+/* Empty index over 'idx' (borrowed; must outlive it). Nothing is read until
+ * the first sync/search. */
+UmiTrigramIndex *umi_trigram_index_new(UmiFileIndex *idx);
+
+/* Like _new(), then load 'snapshot_path' when it matches the index root;
+ * files are re-verified on the first sync. NULL path: same as _new(). */
+UmiTrigramIndex *umi_trigram_index_open(UmiFileIndex *idx, const char *snapshot_path);
+
+void             umi_trigram_index_free(UmiTrigramIndex *t);
+
+/* Write the index atomically (tombstones are dropped first). */
+gboolean         umi_trigram_index_save(UmiTrigramIndex *t, const char *snapshot_path,
+                                        GError **err);
+
+/* <user cache dir>/umicom-studio-ide/index/<sha1 of canonical root>.tri */
+char            *umi_trigram_index_snapshot_path_for(const char *root);
+
+/* The contents of 'path' changed (or it was replaced). */
+void             umi_trigram_index_mark_dirty(UmiTrigramIndex *t, const char *path);
+
+/* Bring the index up to date with the file index (files added/removed
+ * since the last sync, dirty files, files changed while closed).
+ * RETURNS: number of files (re-)read. */
+guint            umi_trigram_index_sync(UmiTrigramIndex *t);
+
+/* Array for umi_trigram_index_search(); frees each hit's text. */
+GArray          *umi_trigram_hits_new(void);
+
+/* Sync, then replace the contents of 'out_hits' with the first 'max_hits'
+ * matches of 'pattern' (files in path order, then line and column).
+ * RETURNS: total number of matches (may exceed max_hits); 0 and 'err' set
+ * for an invalid regex. */
+guint            umi_trigram_index_search(UmiTrigramIndex *t, const char *pattern,
+                                          UmiTrigramFlags flags, guint max_hits,
+                                          GArray *out_hits, GError **err);
+
+/* Sync, then append to 'out_rel' (char*, g_free) the files, relative to
+ * the index root and in path order, that may hold a match of 'pattern':
+ * the planning step of umi_trigram_index_search(), for engines that stream
+ * their own verification. RETURNS: FALSE, with nothing appended, when the
+ * pattern has no trigram to narrow by (every file is a candidate). */
+gboolean         umi_trigram_index_candidates(UmiTrigramIndex *t, const char *pattern,
+                                              UmiTrigramFlags flags, GPtrArray *out_rel);
+
+/* Append to 'runs' (char*, g_free) literal strings every match of
+ * 'pattern' contains. A plain pattern is its own run; for REGEX the runs
+ * (3+ bytes each) are found conservatively and there may be none. Other
+ * engines use them to skip text that cannot match. */
+void             umi_trigram_literal_runs(const char *pattern, UmiTrigramFlags flags,
+                                          GPtrArray *runs);
+
+/* Number of live documents (binary files included: they are tracked so
+ * they are not re-read, never searched) and of distinct trigrams. */
+guint            umi_trigram_index_n_docs(const UmiTrigramIndex *t);
+guint            umi_trigram_index_n_trigrams(const UmiTrigramIndex *t);
+
+G_END_DECLS
+#endif /* UMICOM_TRIGRAM_INDEX_H */
@@ -0,0 +1,377 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/multi_search.c
+ * PURPOSE: Many literal patterns at once (Aho-Corasick), grouped by pattern
+ *
+ * DESIGN:
+ *   - The automaton is a dense DFA over byte classes: every byte that
+ *     occurs in some pattern gets a class (both cases share one when
+ *     caseless), all other bytes share class 0. Failure links are folded
+ *     into the table while it is built (breadth first), so scanning is one
+ *     table load per input byte. States where a pattern ends are numbered
+ *     last, so "any match here?" is one compare; 'dict' chains the other
+ *     patterns ending there.
+ *   - A search runs on the shared search stream (search_stream.h) in its
+ *     grouped mode. The scan collects a file's matches, numbers their
+ *     lines in one forward sweep and reports one row per pattern and line,
+ *     spans on that pattern only, with the pattern as the row's group; the
+ *     stream sorts the rows by pattern, file and line once every file is
+ *     done and starts a store group whenever the pattern changes.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <string.h>
+#include "multi_search.h"
+#include "search_stream.h"
+
+#define MS_NONE          G_MAXUINT32
+
+struct _UmiMultiPattern {
+  gint        ref;
+  guint       flags;
+  GPtrArray  *patterns;             /* char*, as given                       */
+  guint32    *plen;                 /* byte length per pattern               */
+  guint16     cls[256];             /* byte -> class                         */
+  guint       n_classes;
+  guint32    *delta;                /* [row + class] -> row of the next      */
+                                    /*   state (row = state * n_classes)     */
+  guint32    *out;                  /* pattern ending in state, or MS_NONE   */
+  guint32    *dict;                 /* next state on the failure chain with  */
+                                    /*   a pattern, or MS_NONE               */
+  guint32     emit_row;             /* states from here on have a match      */
+  guint       n_states;
+};
+
+/*---------------------------------------------------------------------------
+ * Automaton
+ *---------------------------------------------------------------------------*/
+static inline gboolean word_byte(guchar c) {
+  return c == '_' || g_ascii_isalnum(c);
+}
+
+static void build(UmiMultiPattern *mp) {
+  const gboolean caseless = (mp->flags & UMI_MULTI_PATTERN_CASELESS) != 0;
+  const guint np = mp->patterns->len;
+
+  /* Byte classes. */
+  mp->n_classes = 1;
+  for (guint i = 0; i < np; ++i)
+    for (const guchar *p = g_ptr_array_index(mp->patterns, i); *p; ++p) {
+      const guchar c = caseless ? (guchar)g_ascii_tolower(*p) : *p;
+      if (mp->cls[c]) continue;
+      mp->cls[c] = (guint16)mp->n_classes++;
+      if (caseless) mp->cls[(guchar)g_ascii_toupper(c)] = mp->cls[c];
+    }
+
+  /* Trie; missing edges are MS_NONE until the breadth-first pass. */
+  guint cap = 1;
+  for (guint i = 0; i < np; ++i) cap += mp->plen[i];
+  const guint nc = mp->n_classes;
+  mp->delta = g_new(guint32, (gsize)cap * nc);
+  mp->out   = g_new(guint32, cap);
+  mp->dict  = g_new(guint32, cap);
+  memset(mp->delta, 0xff, (gsize)cap * nc * sizeof(guint32));
+  mp->out[0]  = MS_NONE;
+  mp->n_states = 1;
+  for (guint i = 0; i < np; ++i) {
+    guint32 st = 0;
+    for (const guchar *p = g_ptr_array_index(mp->patterns, i); *p; ++p) {
+      guint32 *edge = &mp->delta[(gsize)st * nc + mp->cls[*p]];
+      if (*edge == MS_NONE) {
+        *edge = mp->n_states;
+        mp->out[mp->n_states++] = MS_NONE;
+      }
+      st = *edge;
+    }
+    mp->out[st] = i;
+  }
+
+  /* Failure links, folded into the table; 'fail' is only needed here. */
+  guint32 *fail  = g_new(guint32, mp->n_states);
+  guint32 *queue = g_new(guint32, mp->n_states);
+  guint head = 0, tail = 0;
+  fail[0] = 0;
+  mp->dict[0] = MS_NONE;
+  for (guint c = 0; c < nc; ++c) {
+    guint32 *edge = &mp->delta[c];
+    if (*edge == MS_NONE) { *edge = 0; continue; }
+    fail[*edge] = 0;
+    mp->dict[*edge] = MS_NONE;
+    queue[tail++] = *edge;
+  }
+  while (head < tail) {
+    const guint32 s = queue[head++];
+    for (guint c = 0; c < nc; ++c) {
+      guint32 *edge = &mp->delta[(gsize)s * nc + c];
+      const guint32 via = mp->delta[(gsize)fail[s] * nc + c];
+      if (*edge == MS_NONE) { *edge = via; continue; }
+      const guint32 t = *edge;
+      fail[t] = via;
+      mp->dict[t] = mp->out[via] != MS_NONE ? via : mp->dict[via];
+      queue[tail++] = t;
+    }
+  }
+  g_free(queue);
+  g_free(fail);
+
+  /* Renumber: states where a match ends go last (the root never does), so
+   * the scan tests for one with a compare; edges become row offsets. */
+  guint32 *id   = g_new(guint32, mp->n_states);
+  guint    next = 0;
+  for (int pass = 0; pass < 2; ++pass)
+    for (guint s = 0; s < mp->n_states; ++s)
+      if ((mp->out[s] != MS_NONE || mp->dict[s] != MS_NONE) == pass) id[s] = next++;
+  mp->emit_row = MS_NONE;
+  for (guint s = 0; s < mp->n_states; ++s)
+    if (mp->out[s] != MS_NONE || mp->dict[s] != MS_NONE) mp->emit_row = MIN(mp->emit_row, id[s] * nc);
+  guint32 *delta = g_new(guint32, (gsize)mp->n_states * nc);
+  guint32 *out   = g_new(guint32, mp->n_states);
+  guint32 *dict  = g_new(guint32, mp->n_states);
+  for (guint s = 0; s < mp->n_states; ++s) {
+    for (guint c = 0; c < nc; ++c)
+      delta[(gsize)id[s] * nc + c] = id[mp->delta[(gsize)s * nc + c]] * nc;
+    out[id[s]]  = mp->out[s];
+    dict[id[s]] = mp->dict[s] == MS_NONE ? MS_NONE : id[mp->dict[s]];
+  }
+  g_free(mp->delta);
+  g_free(mp->out);
+  g_free(mp->dict);
+  g_free(id);
+  mp->delta = delta;
+  mp->out   = out;
+  mp->dict  = dict;
+}
+
+UmiMultiPattern *umi_multi_pattern_new(const char * const *patterns, guint n,
+                                       UmiMultiPatternFlags flags) {
+  g_return_val_if_fail(patterns != NULL || n == 0, NULL);
+  UmiMultiPattern *mp = g_new0(UmiMultiPattern, 1);
+  mp->ref      = 1;
+  mp->flags    = flags;
+  mp->patterns = g_ptr_array_new_with_free_func(g_free);
+
+  /* Caseless repeats differ in case only; compare them folded. */
+  GHashTable *seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  for (guint i = 0; i < n; ++i) {
+    if (!patterns[i] || !*patterns[i]) continue;
+    char *key = (flags & UMI_MULTI_PATTERN_CASELESS) ? g_ascii_strdown(patterns[i], -1)
+                                                     : g_strdup(patterns[i]);
+    if (!g_hash_table_add(seen, key)) continue;
+    g_ptr_array_add(mp->patterns, g_strdup(patterns[i]));
+  }
+  g_hash_table_destroy(seen);
+  if (!mp->patterns->len) {
+    umi_multi_pattern_unref(mp);
+    return NULL;
+  }
+  mp->plen = g_new(guint32, mp->patterns->len);
+  for (guint i = 0; i < mp->patterns->len; ++i)
+    mp->plen[i] = (guint32)strlen(g_ptr_array_index(mp->patterns, i));
+  build(mp);
+  return mp;
+}
+
+UmiMultiPattern *umi_multi_pattern_new_from_text(const char *text, UmiMultiPatternFlags flags) {
+  if (!text) return NULL;
+  gchar **lines = g_strsplit(text, "\n", -1);
+  const guint n = g_strv_length(lines);
+  for (guint i = 0; i < n; ++i) {
+    const gsize len = strlen(lines[i]);
+    if (len && lines[i][len - 1] == '\r') lines[i][len - 1] = '\0';
+  }
+  UmiMultiPattern *mp = umi_multi_pattern_new((const char * const *)lines, n, flags);
+  g_strfreev(lines);
+  return mp;
+}
+
+UmiMultiPattern *umi_multi_pattern_new_from_file(const char *path, UmiMultiPatternFlags flags,
+                                                 GError **err) {
+  g_return_val_if_fail(path != NULL, NULL);
+  gchar *text = NULL;
+  if (!g_file_get_contents(path, &text, NULL, err)) return NULL;
+  UmiMultiPattern *mp = umi_multi_pattern_new_from_text(text, flags);
+  g_free(text);
+  if (!mp) g_set_error(err, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s: no patterns", path);
+  return mp;
+}
+
+UmiMultiPattern *umi_multi_pattern_ref(UmiMultiPattern *mp) {
+  if (mp) g_atomic_int_inc(&mp->ref);
+  return mp;
+}
+
+void umi_multi_pattern_unref(UmiMultiPattern *mp) {
+  if (!mp || !g_atomic_int_dec_and_test(&mp->ref)) return;
+  g_ptr_array_free(mp->patterns, TRUE);
+  g_free(mp->plen);
+  g_free(mp->delta);
+  g_free(mp->out);
+  g_free(mp->dict);
+  g_free(mp);
+}
+
+guint umi_multi_pattern_count(const UmiMultiPattern *mp) {
+  return mp ? mp->patterns->len : 0;
+}
+
+const char *umi_multi_pattern_get(const UmiMultiPattern *mp, guint i) {
+  return (mp && i < mp->patterns->len) ? g_ptr_array_index(mp->patterns, i) : NULL;
+}
+
+/* Whole-word check, only at pattern edges that are word bytes themselves. */
+static gboolean at_word_edges(const UmiMultiPattern *mp, guint pat, const guchar *data,
+                              gsize len, gsize start, gsize end) {
+  const guchar *p = g_ptr_array_index(mp->patterns, pat);
+  if (start > 0 && word_byte(p[0]) && word_byte(data[start - 1])) return FALSE;
+  if (end < len && word_byte(p[mp->plen[pat] - 1]) && word_byte(data[end])) return FALSE;
+  return TRUE;
+}
+
+void umi_multi_pattern_scan(const UmiMultiPattern *mp, const char *data, gsize len,
+                            UmiMultiMatchFn fn, gpointer user) {
+  g_return_if_fail(mp != NULL && fn != NULL);
+  const guchar   *d     = (const guchar *)data;
+  const guint32  *delta = mp->delta;
+  const guint16  *cls   = mp->cls;
+  const guint32   emit  = mp->emit_row;
+  const gboolean  word  = (mp->flags & UMI_MULTI_PATTERN_WORD) != 0;
+  guint32 row = 0;
+  for (gsize i = 0; i < len; ++i) {
+    row = delta[row + cls[d[i]]];
+    if (G_LIKELY(row < emit)) continue;
+    const guint32 st = row / mp->n_classes;
+    for (guint32 q = mp->out[st] != MS_NONE ? st : mp->dict[st]; q != MS_NONE; q = mp->dict[q]) {
+      const guint  pat   = mp->out[q];
+      const gsize  end   = i + 1;
+      const gsize  start = end - mp->plen[pat];
+      if (word && !at_word_edges(mp, pat, d, len, start, end)) continue;
+      if (!fn(pat, start, end, user)) return;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------
+ * Search state
+ *---------------------------------------------------------------------------*/
+typedef struct {
+  guint32 pattern;
+  guint32 start, end;               /* file offsets                          */
+  guint32 line;
+  guint32 bol;                      /* offset of the line start              */
+} MsHit;
+
+typedef struct {
+  GArray *hits;                     /* MsHit of the current file             */
+  GArray *spans;                    /* UmiSearchSpan of the current row      */
+} MsWorker;
+
+typedef struct {
+  UmiMultiPattern *mp;
+  MsWorker        *workers;
+  guint            n_workers;
+} MsSearch;
+
+/*---------------------------------------------------------------------------
+ * Scanning (worker threads)
+ *---------------------------------------------------------------------------*/
+static gboolean on_match(guint pattern, gsize start, gsize end, gpointer user) {
+  MsHit h = { pattern, (guint32)start, (guint32)end, 0, 0 };
+  g_array_append_val((GArray *)user, h);
+  return TRUE;
+}
+
+static gint cmp_hit_start(gconstpointer a, gconstpointer b) {
+  const MsHit *p = a, *q = b;
+  return p->start < q->start ? -1 : (p->start > q->start ? 1 : 0);
+}
+
+static gint cmp_hit_pattern(gconstpointer a, gconstpointer b) {
+  const MsHit *p = a, *q = b;
+  if (p->pattern != q->pattern) return p->pattern < q->pattern ? -1 : 1;
+  return cmp_hit_start(a, b);
+}
+
+/* Hits of one file -> rows (one per pattern and line, the pattern being
+ * the row's group). Spans starting past the preview window of the first
+ * one are dropped, as the built-in engine does, and only that much of a
+ * long line is copied. */
+static void scan_file(UmiSearchStream *ss, guint worker, guint32 file,
+                      const guchar *data, gsize len, gpointer engine) {
+  MsSearch *s = engine;
+  MsWorker *w = &s->workers[worker];
+  if (len >= G_MAXUINT32) return;
+  GArray *hits = w->hits;
+  g_array_set_size(hits, 0);
+  umi_multi_pattern_scan(s->mp, (const char *)data, len, on_match, hits);
+  if (!hits->len) return;
+
+  g_array_sort(hits, cmp_hit_start);
+  guint32 line = 1;
+  const guchar *bol = data;
+  for (guint i = 0; i < hits->len; ++i) {                /* one forward sweep */
+    MsHit *h = &g_array_index(hits, MsHit, i);
+    for (const guchar *q; (q = memchr(bol, '\n', (gsize)(data + h->start - bol))); bol = q + 1) ++line;
+    h->line = line;
+    h->bol  = (guint32)(bol - data);
+  }
+  g_array_sort(hits, cmp_hit_pattern);
+
+  for (guint i = 0; i < hits->len; ) {
+    const MsHit *h0 = &g_array_index(hits, MsHit, i);
+    const guchar *ls = data + h0->bol;
+    const guchar *nl = memchr(data + h0->start, '\n', len - h0->start);
+    const gsize   n  = (gsize)((nl ? nl : data + len) - ls);
+    const gsize   limit = MIN(n, (gsize)(h0->start - h0->bol) + UMI_SEARCH_PREVIEW_MAX);
+    const guint32 pattern = h0->pattern, at = h0->line;
+    g_array_set_size(w->spans, 0);
+    for (; i < hits->len; ++i) {
+      const MsHit *h = &g_array_index(hits, MsHit, i);
+      if (h->pattern != pattern || h->line != at) break;
+      if (h->start - h->bol > limit) continue;
+      UmiSearchSpan sp = { h->start - h->bol, MIN(h->end - h->bol, (guint32)limit) };
+      g_array_append_val(w->spans, sp);
+    }
+    umi_search_stream_row(ss, worker, pattern, file, at, ls, limit,
+                          (const UmiSearchSpan *)(const void *)w->spans->data, w->spans->len);
+  }
+}
+
+static const char *group_label(guint32 group, gpointer engine) {
+  return umi_multi_pattern_get(((MsSearch *)engine)->mp, group);
+}
+
+static void search_free(gpointer data) {
+  MsSearch *s = data;
+  for (guint i = 0; i < s->n_workers; ++i) {
+    g_array_free(s->workers[i].hits, TRUE);
+    g_array_free(s->workers[i].spans, TRUE);
+  }
+  g_free(s->workers);
+  umi_multi_pattern_unref(s->mp);
+  g_free(s);
+}
+
+/*---------------------------------------------------------------------------
+ * umi_multi_search_start:
+ *   Snapshot the file list, scan on a thread; see multi_search.h.
+ *---------------------------------------------------------------------------*/
+void umi_multi_search_start(UmiFileIndex *idx, UmiMultiPattern *mp,
+                            UmiSearchResults *out, guint max_results,
+                            GCancellable *cancel, UmiSearchBatchCb on_batch,
+                            UmiSearchDoneCb on_done, gpointer user) {
+  g_return_if_fail(idx != NULL && mp != NULL && out != NULL && on_batch != NULL);
+  MsSearch *s = g_new0(MsSearch, 1);
+  s->mp = umi_multi_pattern_ref(mp);
+  UmiSearchStream *ss = umi_search_stream_new(UMI_SEARCH_STREAM_GROUPED, scan_file, group_label,
+                                              s, search_free, out, max_results, cancel,
+                                              on_batch, on_done, user);
+  s->n_workers = umi_search_stream_n_workers(ss);
+  s->workers   = g_new0(MsWorker, s->n_workers);
+  for (guint i = 0; i < s->n_workers; ++i) {
+    s->workers[i].hits  = g_array_new(FALSE, FALSE, sizeof(MsHit));
+    s->workers[i].spans = g_array_new(FALSE, FALSE, sizeof(UmiSearchSpan));
+  }
+  umi_search_stream_add_index(ss, idx, NULL);
+  umi_search_stream_run(ss);
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,451 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/quick_open.c
+ * PURPOSE: Fuzzy "Quick Open" file matcher over a UmiFileIndex
+ *
+ * DESIGN:
+ *   - Tables are built once per index generation, as parallel arrays
+ *     indexed by candidate position (index order):
+ *       masks[] : character classes present in the relative path (64 bits)
+ *       ids[]   : file id, dirs[]: slot in dir_paths, names[]: leaf name
+ *     Directory paths are stored once per directory, not once per file.
+ *   - A query runs in three steps per candidate: mask test (SIMD), fzf-v1
+ *     style window search (leftmost end, then the shortest window ending
+ *     there), and window scoring. The file name alone is scored as a second
+ *     window so "fidx" prefers file_index.c over letters scattered across
+ *     directory names.
+ *   - Every matching position is remembered; the next query reuses that list
+ *     when it extends the current one.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <string.h>
+#include "quick_open.h"
+#include "parallel_for.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QO_HAVE_SSE2 1
+#endif
+
+/*---------------------------------------------------------------------------
+ * Scoring constants (per matched character unless noted).
+ *---------------------------------------------------------------------------*/
+enum {
+  SCORE_MATCH       = 16,
+  BONUS_BOUNDARY    = 10,  /* start of a path component                   */
+  BONUS_SEPARATOR   = 8,   /* after '_', '-', '.', ' '                    */
+  BONUS_CAMEL       = 7,   /* aB, a1                                      */
+  BONUS_CONSECUTIVE = 6,   /* directly after the previous match           */
+  BONUS_BASENAME    = 4,   /* inside the file name                        */
+  PENALTY_GAP_START = -3,  /* per gap                                     */
+  PENALTY_GAP_EXT   = -1,  /* per skipped character inside a gap          */
+  QO_GRAIN          = 4096 /* candidates per parallel chunk               */
+};
+
+#define QO_MAX_QUERY 256
+
+typedef struct QoHit {
+  gint    score;
+  guint32 len;             /* relative path length (tie-break: shorter)   */
+  guint32 pos;             /* candidate position                          */
+} QoHit;
+
+typedef struct QoWorker {
+  QoHit   *heap;           /* min-heap of the k best (worst at [0])       */
+  guint    heap_len;
+  GArray  *matched;        /* guint32 candidate positions                 */
+  GArray  *pass;           /* guint32 scratch: positions past the mask    */
+  GString *text;           /* scratch: relative path being scored         */
+} QoWorker;
+
+struct _UmiQuickOpen {
+  const UmiFileIndex *idx;
+  guint64      gen;        /* index generation the tables reflect         */
+  guint        n;
+  guint64     *masks;
+  guint32     *ids;
+  guint32     *dirs;
+  const char **names;      /* point into the index (valid for 'gen')      */
+  GPtrArray   *dir_paths;  /* char*: relative dir + separator, "" = root  */
+
+  char        *last_query; /* normalized query of the previous call       */
+  GArray      *last_cands; /* guint32 positions that matched it           */
+
+  QoWorker    *workers;
+  guint        n_workers;
+};
+
+/*---------------------------------------------------------------------------
+ * Character classes
+ *---------------------------------------------------------------------------*/
+static inline guint64 char_bit(guchar c) {
+  c = (guchar)g_ascii_tolower((gchar)c);
+  if (c >= 'a' && c <= 'z') return G_GUINT64_CONSTANT(1) << (c - 'a');
+  if (c >= '0' && c <= '9') return G_GUINT64_CONSTANT(1) << (26 + c - '0');
+  switch (c) {
+    case '.':  return G_GUINT64_CONSTANT(1) << 36;
+    case '_':  return G_GUINT64_CONSTANT(1) << 37;
+    case '-':  return G_GUINT64_CONSTANT(1) << 38;
+    case '/':
+    case '\\': return G_GUINT64_CONSTANT(1) << 39;
+    case ' ':  return G_GUINT64_CONSTANT(1) << 40;
+    default: break;
+  }
+  if (c >= 0x80) return G_GUINT64_CONSTANT(1) << 63;
+  return G_GUINT64_CONSTANT(1) << (41 + c % 22);      /* other punctuation */
+}
+
+static guint64 mask_of(const char *s) {
+  guint64 m = 0;
+  for (const guchar *p = (const guchar *)s; *p; ++p) m |= char_bit(*p);
+  return m;
+}
+
+/*---------------------------------------------------------------------------
+ * Scoring
+ *---------------------------------------------------------------------------*/
+static inline gboolean is_sep(char c) { return c == '/' || c == '\\'; }
+
+static inline char fold(char c) {
+  return is_sep(c) ? G_DIR_SEPARATOR : g_ascii_tolower(c);
+}
+
+static gint bonus_at(const char *t, gint i) {
+  if (i == 0) return BONUS_BOUNDARY;
+  const char p = t[i - 1], c = t[i];
+  if (is_sep(p)) return BONUS_BOUNDARY;
+  if (p == '_' || p == '-' || p == '.' || p == ' ') return BONUS_SEPARATOR;
+  if (g_ascii_islower(p) && g_ascii_isupper(c)) return BONUS_CAMEL;
+  if (!g_ascii_isdigit(p) && g_ascii_isdigit(c)) return BONUS_CAMEL;
+  return 0;
+}
+
+/* Best window for 'q' inside t[from, len): leftmost end, then the latest
+ * start that still matches (shortest window). Scores it, or NO_MATCH. */
+static gint score_window(const char *t, gint from, gint len, gint base,
+                         const char *q, gint qlen) {
+  gint j = 0, end = -1;
+  for (gint i = from; i < len; ++i) {
+    if (fold(t[i]) == q[j] && ++j == qlen) { end = i; break; }
+  }
+  if (end < 0) return UMI_QUICK_OPEN_NO_MATCH;
+
+  gint start = end;
+  j = qlen - 1;
+  for (gint i = end; i >= from; --i) {
+    if (fold(t[i]) == q[j] && --j < 0) { start = i; break; }
+  }
+
+  gint score = 0;
+  gboolean prev = FALSE, gap = FALSE;
+  j = 0;
+  for (gint i = start; i <= end && j < qlen; ++i) {
+    if (fold(t[i]) == q[j]) {
+      const gint b = bonus_at(t, i);
+      score += SCORE_MATCH + (j == 0 ? 2 * b : b);
+      if (prev) score += BONUS_CONSECUTIVE;
+      if (i >= base) score += BONUS_BASENAME;
+      prev = TRUE; gap = FALSE; ++j;
+    } else {
+      score += gap ? PENALTY_GAP_EXT : PENALTY_GAP_START;
+      prev = FALSE; gap = TRUE;
+    }
+  }
+  return score;
+}
+
+/* Whole path vs. file name alone; the better of the two. */
+static gint score_path(const char *t, gint len, gint base, const char *q, gint qlen) {
+  const gint whole = score_window(t, 0, len, base, q, qlen);
+  if (whole == UMI_QUICK_OPEN_NO_MATCH || base == 0) return whole;
+  const gint name = score_window(t, base, len, base, q, qlen);
+  return MAX(whole, name);
+}
+
+/* Lowercase, drop spaces, unify separators. Returns length, -1 if too long. */
+static gint normalize_query(const char *in, char *out) {
+  gint n = 0;
+  for (const char *p = in ? in : ""; *p; ++p) {
+    if (*p == ' ' || *p == '\t') continue;
+    if (n >= QO_MAX_QUERY) return -1;
+    out[n++] = fold(*p);
+  }
+  out[n] = '\0';
+  return n;
+}
+
+gint umi_quick_open_score(const char *query, const char *rel_path) {
+  char q[QO_MAX_QUERY + 1];
+  const gint qlen = normalize_query(query, q);
+  if (qlen < 0 || !rel_path) return UMI_QUICK_OPEN_NO_MATCH;
+  if (qlen == 0) return 0;
+  const char *slash = strrchr(rel_path, G_DIR_SEPARATOR);
+#ifdef G_OS_WIN32
+  const char *alt = strrchr(rel_path, '/');
+  if (alt && (!slash || alt > slash)) slash = alt;
+#endif
+  const gint base = slash ? (gint)(slash - rel_path) + 1 : 0;
+  return score_path(rel_path, (gint)strlen(rel_path), base, q, qlen);
+}
+
+/*---------------------------------------------------------------------------
+ * Per-worker top-k heap ("better" = higher score, then shorter, then first)
+ *---------------------------------------------------------------------------*/
+static inline gboolean hit_better(const QoHit *a, const QoHit *b) {
+  if (a->score != b->score) return a->score > b->score;
+  if (a->len != b->len)     return a->len < b->len;
+  return a->pos < b->pos;
+}
+
+static void heap_sift_down(QoHit *h, guint n, guint i) {
+  for (;;) {
+    guint w = i, l = 2 * i + 1, r = l + 1;
+    if (l < n && hit_better(&h[w], &h[l])) w = l;
+    if (r < n && hit_better(&h[w], &h[r])) w = r;
+    if (w == i) return;
+    QoHit t = h[i]; h[i] = h[w]; h[w] = t;
+    i = w;
+  }
+}
+
+static void heap_offer(QoWorker *w, guint k, const QoHit *hit) {
+  if (k == 0) return;
+  if (w->heap_len < k) {
+    guint i = w->heap_len++;
+    w->heap[i] = *hit;
+    while (i > 0) {                        /* sift up: worst stays on top */
+      guint p = (i - 1) / 2;
+      if (!hit_better(&w->heap[p], &w->heap[i])) break;
+      QoHit t = w->heap[i]; w->heap[i] = w->heap[p]; w->heap[p] = t;
+      i = p;
+    }
+  } else if (hit_better(hit, &w->heap[0])) {
+    w->heap[0] = *hit;
+    heap_sift_down(w->heap, w->heap_len, 0);
+  }
+}
+
+static gint cmp_hits(gconstpointer a, gconstpointer b) {
+  const QoHit *x = a, *y = b;
+  return hit_better(x, y) ? -1 : (hit_better(y, x) ? 1 : 0);
+}
+
+static gint cmp_u32(gconstpointer a, gconstpointer b) {
+  const guint32 x = *(const guint32 *)a, y = *(const guint32 *)b;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/*---------------------------------------------------------------------------
+ * Mask prefilter: append positions in [b, e) whose mask covers 'q'.
+ *---------------------------------------------------------------------------*/
+static void prefilter(const guint64 *masks, guint b, guint e, guint64 q, GArray *out) {
+  guint i = b;
+#ifdef QO_HAVE_SSE2
+  const __m128i qv   = _mm_set_epi32((int)(q >> 32), (int)(guint32)q,
+                                     (int)(q >> 32), (int)(guint32)q);
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 2 <= e; i += 2) {
+    const __m128i m    = _mm_loadu_si128((const __m128i *)(const void *)(masks + i));
+    const __m128i miss = _mm_andnot_si128(m, qv);          /* q & ~mask  */
+    const int     ok   = _mm_movemask_epi8(_mm_cmpeq_epi32(miss, zero));
+    if (ok == 0) continue;                                 /* both fail  */
+    if ((ok & 0x00FF) == 0x00FF) { guint32 p = i;     g_array_append_val(out, p); }
+    if ((ok & 0xFF00) == 0xFF00) { guint32 p = i + 1; g_array_append_val(out, p); }
+  }
+#endif
+  for (; i < e; ++i) {
+    if ((q & ~masks[i]) == 0) { guint32 p = i; g_array_append_val(out, p); }
+  }
+}
+
+/*---------------------------------------------------------------------------
+ * Parallel query body
+ *---------------------------------------------------------------------------*/
+typedef struct QoRun {
+  UmiQuickOpen  *qo;
+  const char    *q;
+  gint           qlen;
+  guint64        qmask;
+  const guint32 *list;     /* narrowed candidates, or NULL for all        */
+  guint          k;
+} QoRun;
+
+static void score_candidate(const QoRun *r, QoWorker *w, guint32 pos) {
+  const UmiQuickOpen *qo  = r->qo;
+  const char         *dir = g_ptr_array_index(qo->dir_paths, qo->dirs[pos]);
+  g_string_assign(w->text, dir);
+  const gint base = (gint)w->text->len;
+  g_string_append(w->text, qo->names[pos]);
+
+  const gint s = score_path(w->text->str, (gint)w->text->len, base, r->q, r->qlen);
+  if (s == UMI_QUICK_OPEN_NO_MATCH) return;
+  g_array_append_val(w->matched, pos);
+  QoHit hit = { s, (guint32)w->text->len, pos };
+  heap_offer(w, r->k, &hit);
+}
+
+static void query_range(guint b, guint e, guint worker, gpointer user) {
+  const QoRun *r = user;
+  QoWorker    *w = &r->qo->workers[worker];
+
+  if (r->list) {
+    for (guint i = b; i < e; ++i) {
+      const guint32 pos = r->list[i];
+      if ((r->qmask & ~r->qo->masks[pos]) == 0) score_candidate(r, w, pos);
+    }
+    return;
+  }
+  g_array_set_size(w->pass, 0);
+  prefilter(r->qo->masks, b, e, r->qmask, w->pass);
+  for (guint i = 0; i < w->pass->len; ++i)
+    score_candidate(r, w, g_array_index(w->pass, guint32, i));
+}
+
+/*---------------------------------------------------------------------------
+ * Tables
+ *---------------------------------------------------------------------------*/
+static void tables_clear(UmiQuickOpen *qo) {
+  g_clear_pointer(&qo->masks, g_free);
+  g_clear_pointer(&qo->ids, g_free);
+  g_clear_pointer(&qo->dirs, g_free);
+  g_clear_pointer(&qo->names, g_free);
+  g_ptr_array_set_size(qo->dir_paths, 0);
+  g_clear_pointer(&qo->last_query, g_free);
+  g_array_set_size(qo->last_cands, 0);
+  qo->n = 0;
+}
+
+static void tables_build(UmiQuickOpen *qo) {
+  tables_clear(qo);
+  const guint n = umi_index_count(qo->idx);
+  qo->masks = g_new(guint64, MAX(n, 1u));
+  qo->ids   = g_new(guint32, MAX(n, 1u));
+  qo->dirs  = g_new(guint32, MAX(n, 1u));
+  qo->names = g_new(const char *, MAX(n, 1u));
+
+  const gsize root_len = strlen(umi_index_root(qo->idx)) + 1; /* + separator */
+  guint32 cur_dir = G_MAXUINT32;
+  guint64 dir_mask = 0;
+
+  UmiIndexIter it;
+  umi_index_iter_init(&it, qo->idx);
+  guint i = 0;
+  while (umi_index_iter_next(&it) && i < n) {
+    if (it.dir != cur_dir) {                 /* files arrive grouped by dir */
+      const char *full = umi_index_iter_path(&it);
+      const gsize nl   = strlen(it.name);
+      const gsize fl   = strlen(full);
+      char *rel = (fl > root_len + nl) ? g_strndup(full + root_len, fl - root_len - nl)
+                                       : g_strdup("");
+      dir_mask = mask_of(rel);
+      g_ptr_array_add(qo->dir_paths, rel);
+      cur_dir = it.dir;
+    }
+    qo->masks[i] = dir_mask | mask_of(it.name);
+    qo->ids[i]   = it.id;
+    qo->dirs[i]  = qo->dir_paths->len - 1;
+    qo->names[i] = it.name;
+    ++i;
+  }
+  umi_index_iter_clear(&it);
+  qo->n   = i;
+  qo->gen = umi_index_generation(qo->idx);
+}
+
+/*---------------------------------------------------------------------------
+ * Public API
+ *---------------------------------------------------------------------------*/
+UmiQuickOpen *umi_quick_open_new(const UmiFileIndex *idx) {
+  g_return_val_if_fail(idx != NULL, NULL);
+  UmiQuickOpen *qo = g_new0(UmiQuickOpen, 1);
+  qo->idx        = idx;
+  qo->dir_paths  = g_ptr_array_new_with_free_func(g_free);
+  qo->last_cands = g_array_new(FALSE, FALSE, sizeof(guint32));
+  qo->n_workers  = umi_parallel_workers();
+  qo->workers    = g_new0(QoWorker, qo->n_workers);
+  for (guint i = 0; i < qo->n_workers; ++i) {
+    qo->workers[i].matched = g_array_new(FALSE, FALSE, sizeof(guint32));
+    qo->workers[i].pass    = g_array_sized_new(FALSE, FALSE, sizeof(guint32), QO_GRAIN);
+    qo->workers[i].text    = g_string_sized_new(256);
+  }
+  return qo;
+}
+
+void umi_quick_open_free(UmiQuickOpen *qo) {
+  if (!qo) return;
+  tables_clear(qo);
+  g_ptr_array_free(qo->dir_paths, TRUE);
+  g_array_free(qo->last_cands, TRUE);
+  for (guint i = 0; i < qo->n_workers; ++i) {
+    g_free(qo->workers[i].heap);
+    g_array_free(qo->workers[i].matched, TRUE);
+    g_array_free(qo->workers[i].pass, TRUE);
+    g_string_free(qo->workers[i].text, TRUE);
+  }
+  g_free(qo->workers);
+  g_free(qo);
+}
+
+guint umi_quick_open_query(UmiQuickOpen *qo, const char *query,
+                           guint max_results, GArray *out_hits) {
+  g_return_val_if_fail(qo != NULL && out_hits != NULL, 0);
+  g_array_set_size(out_hits, 0);
+
+  if (qo->gen != umi_index_generation(qo->idx) || !qo->masks) tables_build(qo);
+
+  char q[QO_MAX_QUERY + 1];
+  const gint qlen = normalize_query(query, q);
+  if (qlen < 0) return 0;
+
+  if (qlen == 0) {                            /* nothing typed: index order */
+    for (guint i = 0; i < qo->n && i < max_results; ++i) {
+      UmiQuickOpenHit h = { qo->ids[i], 0 };
+      g_array_append_val(out_hits, h);
+    }
+    g_clear_pointer(&qo->last_query, g_free);
+    return qo->n;
+  }
+
+  /* Narrow: the previous matches are a superset of this query's matches. */
+  const gboolean narrow = qo->last_query && g_str_has_prefix(q, qo->last_query);
+  GArray *prev = NULL;
+  if (narrow) {
+    prev = qo->last_cands;
+    qo->last_cands = g_array_new(FALSE, FALSE, sizeof(guint32));
+  }
+
+  QoRun run = { qo, q, qlen, mask_of(q), narrow ? (const guint32 *)(void *)prev->data : NULL,
+                max_results };
+  for (guint i = 0; i < qo->n_workers; ++i) {
+    QoWorker *w = &qo->workers[i];
+    w->heap     = g_renew(QoHit, w->heap, MAX(max_results, 1u));
+    w->heap_len = 0;
+    g_array_set_size(w->matched, 0);
+  }
+
+  umi_parallel_for(narrow ? prev->len : qo->n, QO_GRAIN, query_range, &run);
+
+  /* Merge: all matches (for the next narrowing step), then the k best. */
+  GArray *all = g_array_new(FALSE, FALSE, sizeof(QoHit));
+  g_array_set_size(qo->last_cands, 0);
+  for (guint i = 0; i < qo->n_workers; ++i) {
+    QoWorker *w = &qo->workers[i];
+    g_array_append_vals(qo->last_cands, w->matched->data, w->matched->len);
+    g_array_append_vals(all, w->heap, w->heap_len);
+  }
+  g_array_sort(qo->last_cands, cmp_u32);
+  g_array_sort(all, cmp_hits);
+  for (guint i = 0; i < all->len && i < max_results; ++i) {
+    const QoHit *h = &g_array_index(all, QoHit, i);
+    UmiQuickOpenHit out = { qo->ids[h->pos], h->score };
+    g_array_append_val(out_hits, out);
+  }
+  g_array_free(all, TRUE);
+  if (prev) g_array_free(prev, TRUE);
+
+  g_free(qo->last_query);
+  qo->last_query = g_strdup(q);
+  return qo->last_cands->len;
+}
+/*---------------------------------------------------------------------------*/
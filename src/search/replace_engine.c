@@ -0,0 +1,471 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/replace_engine.c
+ * PURPOSE: Project-wide search and replace: preview first, then write
+ *
+ * DESIGN:
+ *   - A file keeps its edits (offset, length, replacement) and, per changed
+ *     line, the line as it was and as it will be, all in one text arena.
+ *     The old lines are what apply compares the file against: the edits
+ *     are only valid on exactly the bytes they were computed on.
+ *   - Lines with a match are found by running the pattern over the whole
+ *     file; each such line is then matched on its own, as the search
+ *     engines do, so ^, $ and lookarounds see one line.
+ *   - Workers only touch their own file; the preview stores are filled
+ *     afterwards on the calling thread, in file order.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <string.h>
+#include <glib/gstdio.h>
+#include "replace_engine.h"
+#include "file_io.h"
+#include "parallel_for.h"
+
+#define RP_GRAIN         4
+#define RP_BINARY_PROBE  8000u   /* a NUL in this many leading bytes: binary */
+#define RP_ERR_NAMES     5u      /* files named in an error message          */
+
+typedef struct {
+  gsize   off;                   /* in the file                              */
+  guint32 len;                   /* bytes matched                            */
+  guint32 repl, repl_len;        /* replacement in 'text'                    */
+} RpEdit;
+
+typedef struct {
+  guint32 line;                  /* 1-based                                  */
+  gsize   start;                 /* file offset of the line                  */
+  guint32 old_off, old_len;      /* the line now, in 'text' (no '\n')        */
+  guint32 new_off, new_len;      /* the line replaced                        */
+  guint   first, n;              /* its edits                                */
+} RpLine;
+
+typedef struct {
+  char     *path;                /* as the search named it                   */
+  char     *abs;
+  char     *buffer;              /* unsaved editor text, NULL: the disk      */
+  gsize     buffer_len;
+  gsize     size;                /* bytes the edits were computed on         */
+  GArray   *edits;               /* RpEdit                                   */
+  GArray   *lines;               /* RpLine                                   */
+  GString  *text;
+  gboolean  excluded;
+  GError   *error;
+  char     *tmp;                 /* staged by apply                          */
+  GString  *staged;              /* buffer text with the edits, by apply     */
+} RpFile;
+
+struct _UmiReplacePlan {
+  char             *root;
+  GRegex           *re;
+  char             *replacement;
+  gboolean          literal;
+  GPtrArray        *files;       /* RpFile*                                  */
+  GHashTable       *by_abs;      /* abs path -> index + 1                    */
+  UmiSearchResults *before, *after;
+  guint             n_edits;
+};
+
+static void file_free(gpointer data) {
+  RpFile *f = data;
+  if (f->tmp) (void)g_remove(f->tmp);
+  g_free(f->tmp);
+  if (f->staged) g_string_free(f->staged, TRUE);
+  g_free(f->path);
+  g_free(f->abs);
+  g_free(f->buffer);
+  if (f->edits) g_array_free(f->edits, TRUE);
+  if (f->lines) g_array_free(f->lines, TRUE);
+  if (f->text) g_string_free(f->text, TRUE);
+  g_clear_error(&f->error);
+  g_free(f);
+}
+
+static RpFile *add_file(UmiReplacePlan *p, const char *path) {
+  const char *rel = (path[0] == '.' && G_IS_DIR_SEPARATOR(path[1])) ? path + 2 : path;
+  char *abs = g_canonicalize_filename(rel, p->root);
+  const guint at = GPOINTER_TO_UINT(g_hash_table_lookup(p->by_abs, abs));
+  if (at) {
+    g_free(abs);
+    return g_ptr_array_index(p->files, at - 1);
+  }
+  RpFile *f = g_new0(RpFile, 1);
+  f->path = g_strdup(path);
+  f->abs  = abs;
+  g_ptr_array_add(p->files, f);
+  g_hash_table_insert(p->by_abs, f->abs, GUINT_TO_POINTER(p->files->len));
+  return f;
+}
+
+UmiReplacePlan *umi_replace_plan_new(const char *root, const UmiSearchResults *matches,
+                                     const char *pattern, const char *replacement,
+                                     UmiReplaceFlags flags, GError **err) {
+  g_return_val_if_fail(pattern != NULL && replacement != NULL, NULL);
+  const gboolean literal = (flags & UMI_REPLACE_LITERAL) != 0;
+  char *src = literal ? g_regex_escape_string(pattern, -1) : g_strdup(pattern);
+  GRegexCompileFlags cf = G_REGEX_RAW | G_REGEX_OPTIMIZE;
+  if (flags & UMI_REPLACE_CASELESS) cf |= G_REGEX_CASELESS;
+  /* Multiline and CRLF-aware for the whole-file pass; lines have no breaks. */
+  GRegex *re = g_regex_new(src, cf | G_REGEX_MULTILINE | G_REGEX_NEWLINE_ANYCRLF, 0, err);
+  g_free(src);
+  if (!re) return NULL;
+  if (!literal && !g_regex_check_replacement(replacement, NULL, err)) {
+    g_regex_unref(re);
+    return NULL;
+  }
+
+  UmiReplacePlan *p = g_new0(UmiReplacePlan, 1);
+  p->root        = g_canonicalize_filename(root ? root : ".", NULL);
+  p->re          = re;
+  p->replacement = g_strdup(replacement);
+  p->literal     = literal;
+  p->files       = g_ptr_array_new_with_free_func(file_free);
+  p->by_abs      = g_hash_table_new(g_str_hash, g_str_equal);
+  for (guint i = 0, n = umi_search_results_n_files(matches); i < n; ++i)
+    add_file(p, umi_search_results_file(matches, i));
+  return p;
+}
+
+void umi_replace_plan_free(UmiReplacePlan *p) {
+  if (!p) return;
+  g_hash_table_destroy(p->by_abs);
+  g_ptr_array_free(p->files, TRUE);
+  umi_search_results_unref(p->before);
+  umi_search_results_unref(p->after);
+  g_regex_unref(p->re);
+  g_free(p->replacement);
+  g_free(p->root);
+  g_free(p);
+}
+
+void umi_replace_plan_set_buffer(UmiReplacePlan *p, const char *path, const char *text, gssize len) {
+  g_return_if_fail(p != NULL && path != NULL && text != NULL);
+  char *abs = g_canonicalize_filename(path, p->root);
+  const guint at = GPOINTER_TO_UINT(g_hash_table_lookup(p->by_abs, abs));
+  RpFile *f;
+  if (at) {
+    f = g_ptr_array_index(p->files, at - 1);
+  } else {                                    /* shown relative when under the root */
+    const gsize rl = strlen(p->root);
+    const gboolean under = !strncmp(abs, p->root, rl) && G_IS_DIR_SEPARATOR(abs[rl]);
+    f = add_file(p, under ? abs + rl + 1 : abs);
+  }
+  g_free(abs);
+  g_free(f->buffer);
+  f->buffer_len = len < 0 ? strlen(text) : (gsize)len;
+  f->buffer     = g_malloc(f->buffer_len + 1);
+  memcpy(f->buffer, text, f->buffer_len);
+  f->buffer[f->buffer_len] = '\0';
+}
+
+/*---------------------------------------------------------------------------
+ * Prepare (worker threads)
+ *---------------------------------------------------------------------------*/
+/* Match the line [ls, le) of 'data' on its own; record its edits. */
+static void match_line(const UmiReplacePlan *p, RpFile *f, const char *data,
+                       gsize ls, gsize le, guint32 line) {
+  gsize n = le - ls;
+  if (n && data[le - 1] == '\r') --n;
+  if (n > G_MAXINT) return;
+  const guint first = f->edits->len;
+  GMatchInfo *mi = NULL;
+  g_regex_match_full(p->re, data + ls, (gssize)n, 0, 0, &mi, NULL);
+  while (g_match_info_matches(mi)) {
+    gint s, e;
+    g_match_info_fetch_pos(mi, 0, &s, &e);
+    char *repl = p->literal ? NULL : g_match_info_expand_references(mi, p->replacement, NULL);
+    const char *r = p->literal ? p->replacement : (repl ? repl : "");
+    const gsize rlen = strlen(r);
+    /* A replacement equal to what it replaces is no edit. */
+    if (rlen != (gsize)(e - s) || memcmp(r, data + ls + s, rlen)) {
+      const RpEdit ed = { ls + (gsize)s, (guint32)(e - s), (guint32)f->text->len, (guint32)rlen };
+      g_string_append_len(f->text, r, (gssize)rlen);
+      g_array_append_val(f->edits, ed);
+    }
+    g_free(repl);
+    if (!g_match_info_next(mi, NULL)) break;
+  }
+  g_match_info_free(mi);
+  if (f->edits->len == first) return;
+
+  RpLine l = { line, ls, (guint32)f->text->len, (guint32)(le - ls), 0, 0, first, f->edits->len - first };
+  g_string_append_len(f->text, data + ls, (gssize)(le - ls));
+  /* The new line goes through 'scratch': replacements are read from 'text'. */
+  GString *scratch = g_string_sized_new(le - ls + 64);
+  gsize at = ls;
+  for (guint k = l.first; k < l.first + l.n; ++k) {
+    const RpEdit *ed = &g_array_index(f->edits, RpEdit, k);
+    g_string_append_len(scratch, data + at, (gssize)(ed->off - at));
+    g_string_append_len(scratch, f->text->str + ed->repl, ed->repl_len);
+    at = ed->off + ed->len;
+  }
+  g_string_append_len(scratch, data + at, (gssize)(le - at));
+  l.new_off = (guint32)f->text->len;
+  l.new_len = (guint32)scratch->len;
+  g_string_append_len(f->text, scratch->str, (gssize)scratch->len);
+  g_string_free(scratch, TRUE);
+  g_array_append_val(f->lines, l);
+}
+
+static void prepare_file(const UmiReplacePlan *p, RpFile *f) {
+  g_clear_error(&f->error);
+  f->edits = g_array_new(FALSE, FALSE, sizeof(RpEdit));
+  f->lines = g_array_new(FALSE, FALSE, sizeof(RpLine));
+  f->text  = g_string_new(NULL);
+  GMappedFile *mf = NULL;
+  const char  *data;
+  gsize        n;
+  if (f->buffer) {
+    data = f->buffer;
+    n    = f->buffer_len;
+  } else {
+    mf = g_mapped_file_new(f->abs, FALSE, &f->error);
+    if (!mf) return;
+    data = g_mapped_file_get_contents(mf);
+    n    = g_mapped_file_get_length(mf);
+  }
+  f->size = n;
+  if (!n || n > G_MAXINT || memchr(data, '\0', MIN(n, RP_BINARY_PROBE))) goto out;
+
+  /* Find lines with a match anywhere in them, then match those alone. */
+  gsize pos = 0, counted = 0;
+  guint32 line = 1;
+  GMatchInfo *mi = NULL;
+  while (pos < n && g_regex_match_full(p->re, data, (gssize)n, (gint)pos, 0, &mi, NULL)) {
+    gint s, e;
+    g_match_info_fetch_pos(mi, 0, &s, &e);
+    g_match_info_free(mi);
+    mi = NULL;
+    gsize ls = (gsize)s;
+    while (ls > pos && data[ls - 1] != '\n') --ls;
+    const char *nl = memchr(data + s, '\n', n - (gsize)s);
+    const gsize le = nl ? (gsize)(nl - data) : n;
+    for (const char *c = data + counted; (c = memchr(c, '\n', (gsize)(data + ls - c))); ++c) ++line;
+    counted = ls;
+    match_line(p, f, data, ls, le, line);
+    pos = le + 1;
+  }
+  g_match_info_free(mi);
+out:
+  if (mf) g_mapped_file_unref(mf);
+}
+
+static void prepare_range(guint begin, guint end, guint worker, gpointer user) {
+  (void)worker;
+  UmiReplacePlan *p = user;
+  for (guint i = begin; i < end; ++i) prepare_file(p, g_ptr_array_index(p->files, i));
+}
+
+void umi_replace_plan_prepare(UmiReplacePlan *p) {
+  g_return_if_fail(p != NULL);
+  for (guint i = 0; i < p->files->len; ++i) {      /* prepare may run again */
+    RpFile *f = g_ptr_array_index(p->files, i);
+    if (f->edits) g_array_free(f->edits, TRUE);
+    if (f->lines) g_array_free(f->lines, TRUE);
+    if (f->text) g_string_free(f->text, TRUE);
+    f->edits = f->lines = NULL;
+    f->text  = NULL;
+  }
+  umi_parallel_for(p->files->len, RP_GRAIN, prepare_range, p);
+
+  /* Preview stores, in file order. */
+  umi_search_results_unref(p->before);
+  umi_search_results_unref(p->after);
+  p->before  = umi_search_results_new();
+  p->after   = umi_search_results_new();
+  p->n_edits = 0;
+  GArray *olds = g_array_new(FALSE, FALSE, sizeof(UmiSearchSpan));
+  GArray *news = g_array_new(FALSE, FALSE, sizeof(UmiSearchSpan));
+  for (guint i = 0; i < p->files->len; ++i) {
+    const RpFile *f = g_ptr_array_index(p->files, i);
+    if (!f->lines->len) continue;
+    const guint32 fb = umi_search_results_add_file(p->before, f->path);
+    const guint32 fa = umi_search_results_add_file(p->after, f->path);
+    for (guint j = 0; j < f->lines->len; ++j) {
+      const RpLine *l = &g_array_index(f->lines, RpLine, j);
+      g_array_set_size(olds, 0);
+      g_array_set_size(news, 0);
+      gssize shift = 0;                           /* new minus old, so far */
+      for (guint k = l->first; k < l->first + l->n; ++k) {
+        const RpEdit *ed = &g_array_index(f->edits, RpEdit, k);
+        const guint32 at = (guint32)(ed->off - l->start);
+        const UmiSearchSpan so = { at, at + ed->len };
+        const UmiSearchSpan sn = { (guint32)(at + shift), (guint32)(at + shift) + ed->repl_len };
+        g_array_append_val(olds, so);
+        g_array_append_val(news, sn);
+        shift += (gssize)ed->repl_len - (gssize)ed->len;
+      }
+      umi_search_results_add(p->before, fb, l->line, f->text->str + l->old_off, l->old_len,
+                             (const UmiSearchSpan *)olds->data, olds->len);
+      umi_search_results_add(p->after, fa, l->line, f->text->str + l->new_off, l->new_len,
+                             (const UmiSearchSpan *)news->data, news->len);
+    }
+    p->n_edits += f->edits->len;
+  }
+  g_array_free(olds, TRUE);
+  g_array_free(news, TRUE);
+}
+
+/*---------------------------------------------------------------------------
+ * Preview
+ *---------------------------------------------------------------------------*/
+guint umi_replace_plan_n_files(const UmiReplacePlan *p) {
+  return p ? p->files->len : 0;
+}
+
+gboolean umi_replace_plan_file(const UmiReplacePlan *p, guint i, UmiReplaceFileInfo *out) {
+  g_return_val_if_fail(out != NULL, FALSE);
+  if (!p || i >= p->files->len) return FALSE;
+  const RpFile *f = g_ptr_array_index(p->files, i);
+  out->path      = f->path;
+  out->n_edits   = f->edits ? f->edits->len : 0;
+  out->in_buffer = f->buffer != NULL;
+  out->excluded  = f->excluded;
+  out->error     = f->error ? f->error->message : NULL;
+  return TRUE;
+}
+
+void umi_replace_plan_set_excluded(UmiReplacePlan *p, guint i, gboolean excluded) {
+  g_return_if_fail(p != NULL && i < p->files->len);
+  ((RpFile *)g_ptr_array_index(p->files, i))->excluded = excluded;
+}
+
+guint umi_replace_plan_n_edits(const UmiReplacePlan *p) {
+  return p ? p->n_edits : 0;
+}
+
+UmiSearchResults *umi_replace_plan_preview(const UmiReplacePlan *p, gboolean after) {
+  g_return_val_if_fail(p != NULL, NULL);
+  return after ? p->after : p->before;
+}
+
+/*---------------------------------------------------------------------------
+ * Apply
+ *---------------------------------------------------------------------------*/
+static gboolean wanted(const RpFile *f) {
+  return !f->excluded && !f->error && f->edits && f->edits->len;
+}
+
+/* 'data' with the edits applied, or NULL when it is not what they were
+ * computed on. */
+static GString *rewrite(const RpFile *f, const char *data, gsize n) {
+  if (n != f->size) return NULL;
+  for (guint j = 0; j < f->lines->len; ++j) {
+    const RpLine *l = &g_array_index(f->lines, RpLine, j);
+    if (memcmp(data + l->start, f->text->str + l->old_off, l->old_len)) return NULL;
+  }
+  gssize grow = 0;
+  for (guint k = 0; k < f->edits->len; ++k) {
+    const RpEdit *ed = &g_array_index(f->edits, RpEdit, k);
+    grow += (gssize)ed->repl_len - (gssize)ed->len;
+  }
+  GString *out = g_string_sized_new((gsize)((gssize)n + grow) + 1);
+  gsize at = 0;
+  for (guint k = 0; k < f->edits->len; ++k) {
+    const RpEdit *ed = &g_array_index(f->edits, RpEdit, k);
+    g_string_append_len(out, data + at, (gssize)(ed->off - at));
+    g_string_append_len(out, f->text->str + ed->repl, ed->repl_len);
+    at = ed->off + ed->len;
+  }
+  g_string_append_len(out, data + at, (gssize)(n - at));
+  return out;
+}
+
+static void stage_range(guint begin, guint end, guint worker, gpointer user) {
+  (void)worker;
+  UmiReplacePlan *p = user;
+  for (guint i = begin; i < end; ++i) {
+    RpFile *f = g_ptr_array_index(p->files, i);
+    if (!wanted(f)) continue;
+    if (f->buffer) {                                   /* kept until phase 3 */
+      f->staged = rewrite(f, f->buffer, f->buffer_len);
+      if (!f->staged)
+        g_set_error(&f->error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "%s changed since the preview", f->path);
+      continue;
+    }
+    GMappedFile *mf = g_mapped_file_new(f->abs, FALSE, &f->error);
+    if (!mf) continue;
+    GString *out = rewrite(f, g_mapped_file_get_contents(mf), g_mapped_file_get_length(mf));
+    g_mapped_file_unref(mf);
+    if (!out) {
+      g_set_error(&f->error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "%s changed since the preview", f->path);
+      continue;
+    }
+    f->tmp = umi_file_stage(f->abs, out->str, (gssize)out->len, &f->error);
+    g_string_free(out, TRUE);
+  }
+}
+
+/* One error naming the first few files that have one. */
+static void collect_errors(const UmiReplacePlan *p, guint n_bad, GError **err) {
+  GString *msg = g_string_new(NULL);
+  g_string_printf(msg, "%u %s could not be replaced", n_bad, n_bad == 1 ? "file" : "files");
+  guint named = 0;
+  for (guint i = 0; i < p->files->len && named < RP_ERR_NAMES; ++i) {
+    const RpFile *f = g_ptr_array_index(p->files, i);
+    if (f->excluded || !f->error || !f->edits || !f->edits->len) continue;
+    g_string_append_printf(msg, "%s %s", named++ ? ";" : ":", f->error->message);
+  }
+  if (n_bad > named) g_string_append(msg, "; …");
+  g_set_error_literal(err, G_FILE_ERROR, G_FILE_ERROR_FAILED, msg->str);
+  g_string_free(msg, TRUE);
+}
+
+gboolean umi_replace_plan_apply(UmiReplacePlan *p, UmiReplaceBufferCb on_buffer,
+                                gpointer user, UmiReplaceStats *out, GError **err) {
+  g_return_val_if_fail(p != NULL, FALSE);
+  UmiReplaceStats st = { 0, 0, 0 };
+  if (out) *out = st;
+
+  /* Phase 1: stage every file and buffer; any failure (a buffer edited since
+   * the preview too) drops all temps, writes nothing. */
+  umi_parallel_for(p->files->len, RP_GRAIN, stage_range, p);
+  guint n_bad = 0;
+  for (guint i = 0; i < p->files->len; ++i) {
+    const RpFile *f = g_ptr_array_index(p->files, i);
+    if (!f->excluded && f->error && f->edits && f->edits->len) ++n_bad;
+  }
+  if (n_bad) {
+    collect_errors(p, n_bad, err);
+    for (guint i = 0; i < p->files->len; ++i) {
+      RpFile *f = g_ptr_array_index(p->files, i);
+      if (f->tmp) (void)g_remove(f->tmp);
+      g_clear_pointer(&f->tmp, g_free);
+      if (f->staged) g_string_free(f->staged, TRUE);
+      f->staged = NULL;
+    }
+    return FALSE;
+  }
+
+  /* Phase 2: one rename per file. */
+  for (guint i = 0; i < p->files->len; ++i) {
+    RpFile *f = g_ptr_array_index(p->files, i);
+    if (!f->tmp) continue;
+    if (umi_file_commit(f->tmp, f->abs, &f->error)) {
+      st.files_written++;
+      st.edits += f->edits->len;
+    } else {
+      ++n_bad;
+    }
+    g_clear_pointer(&f->tmp, g_free);
+  }
+
+  /* Unsaved buffers get their text back; the disk is theirs to write. */
+  for (guint i = 0; i < p->files->len; ++i) {
+    RpFile *f = g_ptr_array_index(p->files, i);
+    if (!f->staged) continue;
+    if (on_buffer) on_buffer(f->abs, f->staged->str, f->staged->len, user);
+    g_string_free(f->staged, TRUE);
+    f->staged = NULL;
+    st.buffers_updated++;
+    st.edits += f->edits->len;
+  }
+
+  if (out) *out = st;
+  if (n_bad) {
+    collect_errors(p, n_bad, err);
+    return FALSE;
+  }
+  return TRUE;
+}
+/*---------------------------------------------------------------------------*/
@@ -2,56 +2,469 @@
  * Umicom Studio IDE
  * File: src/search/rg_runner.c
  * PURPOSE: Spawn ripgrep and collect its output
+ *
+ * DESIGN (umi_rg_search_start):
+ *   - rg runs as a GSubprocess; stdout and stderr are read with async GIO
+ *     on the main loop, 64 KiB at a time. A search finishes when three
+ *     legs have: stdout drained, stderr drained, process reaped.
+ *   - rg --json prints one JSON object per line. Lines are parsed by a
+ *     small scanner that knows the shape of rg's messages: only "match"
+ *     messages are decoded, everything else is skipped at the "type" key.
+ *     A general JSON tree per line (json-glib) costs several times more
+ *     for a few hundred thousand matches and is not needed.
+ *   - Non-UTF-8 paths and lines come as {"bytes": base64}; they are
+ *     decoded so submatch offsets stay valid.
+ *   - The read buffer only holds one partial line. A message longer than
+ *     RG_HOLD_MAX (a huge minified line) is skipped whole.
+ *   - Our own GCancellable stops all reads; it is cancelled by the caller's
+ *     cancellable and by the result cap. Either also kills rg.
+ *
  * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-01 | MIT
  *---------------------------------------------------------------------------*/
 #include <glib.h>
+#include <string.h>
 #include "rg_runner.h"
 
+#define RG_READ_SIZE  (64 * 1024)
+#define RG_BATCH      256u            /* rows per callback                   */
+#define RG_HOLD_MAX   (16u << 20)     /* longest JSON message we buffer      */
+#define RG_ERR_MAX    (64 * 1024)
+
+typedef struct {
+  GSubprocess      *sp;
+  GInputStream     *out, *errs;
+  GCancellable     *cancel;        /* ours: all reads use it                 */
+  GCancellable     *user_cancel;
+  gulong            user_handler;
+  guint             max_results;
+  GString          *buf;           /* unparsed stdout                        */
+  gboolean          skip_line;     /* dropping an over-long message          */
+  UmiSearchResults *res;
+  guint             pending;       /* rows added, not yet reported           */
+  /* Scratch for the message being parsed. */
+  GString          *path, *text, *str;
+  GArray           *spans;         /* UmiSearchSpan                          */
+  GString          *err;
+  UmiSearchSummary  sum;
+  int               legs;          /* stdout, stderr, exit still running     */
+  UmiSearchBatchCb  on_batch;
+  UmiSearchDoneCb   on_done;
+  gpointer          user;
+} RgSearch;
+
 /*---------------------------------------------------------------------------
  * umi_rg_run:
  *   Spawns the process described by argvv and captures stdout / stderr.
  *   The argvv array must be NULL-terminated. Output is appended to the
  *   provided GString buffers (they may be empty). Returns TRUE if the
- *   process was started; the process exit status is returned via
+ *   process was started and its output read; the process exit status is returned via
  *   *exit_status when supplied.
  *---------------------------------------------------------------------------*/
 gboolean umi_rg_run(char **argvv, GString *out, GString *err, int *exit_status) {
   g_return_val_if_fail(argvv != NULL && argvv[0] != NULL, FALSE);
   g_return_val_if_fail(out != NULL && err != NULL, FALSE);
 
-  gchar *stdout_str = NULL;
-  gchar *stderr_str = NULL;
   GError *spawn_err = NULL;
-  gint    status = 0;
-
-  if (!g_spawn_sync(NULL,              /* working dir */
-                    argvv,             /* argv */
-                    NULL,              /* envp */
-                    G_SPAWN_SEARCH_PATH,
-                    NULL, NULL,        /* no child-setup */
-                    &stdout_str,       /* capture stdout */
-                    &stderr_str,       /* capture stderr */
-                    &status,           /* exit status */
-                    &spawn_err)) {
-    if (spawn_err) {
-      g_string_append(err, spawn_err->message);
-      g_error_free(spawn_err);
-    }
-    g_free(stdout_str);
-    g_free(stderr_str);
+  GSubprocess *sp = g_subprocess_newv((const gchar * const *)argvv,
+                                      G_SUBPROCESS_FLAGS_STDOUT_PIPE |
+                                      G_SUBPROCESS_FLAGS_STDERR_PIPE, &spawn_err);
+  if (!sp) {
+    g_string_append(err, spawn_err->message);
+    g_error_free(spawn_err);
     return FALSE;
   }
 
-  if (stdout_str) {
-    g_string_append(out, stdout_str);
-    g_free(stdout_str);
+  GBytes *o = NULL, *e = NULL;
+  if (!g_subprocess_communicate(sp, NULL, NULL, &o, &e, &spawn_err)) {
+    g_string_append(err, spawn_err->message);
+    g_error_free(spawn_err);
+    g_object_unref(sp);
+    return FALSE;
   }
-  if (stderr_str) {
-    g_string_append(err, stderr_str);
-    g_free(stderr_str);
+  gsize n = 0;
+  const char *p;
+  if (o && (p = g_bytes_get_data(o, &n)) && n) g_string_append_len(out, p, (gssize)n);
+  if (e && (p = g_bytes_get_data(e, &n)) && n) g_string_append_len(err, p, (gssize)n);
+  if (o) g_bytes_unref(o);
+  if (e) g_bytes_unref(e);
+
+  if (exit_status)
+    *exit_status = g_subprocess_get_if_exited(sp) ? g_subprocess_get_exit_status(sp) : -1;
+  g_object_unref(sp);
+  return TRUE;
+}
+
+/*---------------------------------------------------------------------------
+ * rg --json messages
+ *
+ *   {"type":"match","data":{"path":{"text":"src/a.c"},
+ *    "lines":{"text":"int x;\n"},"line_number":3,"absolute_offset":40,
+ *    "submatches":[{"match":{"text":"x"},"start":4,"end":5}]}}
+ *---------------------------------------------------------------------------*/
+typedef struct {
+  const char *p, *end;
+} Js;
+
+static void js_ws(Js *j) {
+  while (j->p < j->end && (*j->p == ' ' || *j->p == '\t' || *j->p == '\n' || *j->p == '\r')) ++j->p;
+}
+
+static gboolean js_char(Js *j, char c) {
+  js_ws(j);
+  if (j->p >= j->end || *j->p != c) return FALSE;
+  ++j->p;
+  return TRUE;
+}
+
+static gint js_hex4(const char *p) {
+  gint v = 0;
+  for (int i = 0; i < 4; ++i) {
+    const gint d = g_ascii_xdigit_value(p[i]);
+    if (d < 0) return -1;
+    v = v * 16 + d;
+  }
+  return v;
+}
+
+/* A string, decoded into 'out' (NULL: skipped). */
+static gboolean js_string(Js *j, GString *out) {
+  if (!js_char(j, '"')) return FALSE;
+  if (out) g_string_truncate(out, 0);
+  while (j->p < j->end) {
+    const char *q = j->p;
+    while (q < j->end && *q != '"' && *q != '\\') ++q;
+    if (out && q > j->p) g_string_append_len(out, j->p, q - j->p);
+    j->p = q;
+    if (q >= j->end) return FALSE;
+    if (*q == '"') { ++j->p; return TRUE; }
+    if (j->end - q < 2) return FALSE;
+    j->p = q + 2;
+    char c = q[1];
+    switch (c) {
+      case 'n': c = '\n'; break;
+      case 't': c = '\t'; break;
+      case 'r': c = '\r'; break;
+      case 'b': c = '\b'; break;
+      case 'f': c = '\f'; break;
+      case 'u': {
+        if (j->end - j->p < 4) return FALSE;
+        gint u = js_hex4(j->p);
+        j->p += 4;
+        if (u >= 0xD800 && u < 0xDC00 && j->end - j->p >= 6 && j->p[0] == '\\' && j->p[1] == 'u') {
+          const gint lo = js_hex4(j->p + 2);
+          if (lo >= 0xDC00 && lo < 0xE000) {
+            u = 0x10000 + ((u - 0xD800) << 10) + (lo - 0xDC00);
+            j->p += 6;
+          }
+        }
+        if (u < 0) return FALSE;
+        if (out) g_string_append_unichar(out, (gunichar)u);
+        continue;
+      }
+      default: break;                              /* '"', '\\', '/' */
+    }
+    if (out) g_string_append_c(out, c);
   }
+  return FALSE;
+}
 
-  if (exit_status) *exit_status = status;
+/* Any value. */
+static gboolean js_skip(Js *j) {
+  js_ws(j);
+  if (j->p >= j->end) return FALSE;
+  if (*j->p == '"') return js_string(j, NULL);
+  if (*j->p != '{' && *j->p != '[') {              /* number, true, null */
+    while (j->p < j->end && *j->p != ',' && *j->p != '}' && *j->p != ']') ++j->p;
+    return TRUE;
+  }
+  int depth = 0;
+  while (j->p < j->end) {
+    const char c = *j->p;
+    if (c == '"') {
+      if (!js_string(j, NULL)) return FALSE;
+      continue;
+    }
+    ++j->p;
+    if (c == '{' || c == '[') ++depth;
+    else if ((c == '}' || c == ']') && --depth == 0) return TRUE;
+  }
+  return FALSE;
+}
+
+static gint64 js_int(Js *j) {
+  js_ws(j);
+  char *e = NULL;
+  const gint64 v = g_ascii_strtoll(j->p, &e, 10);
+  if (!e || e == j->p) { js_skip(j); return -1; } /* null */
+  j->p = e;
+  return v;
+}
+
+/* Walk the members of an object: 'key' gets each name. FALSE at the end,
+ * with the closing brace left for the caller. */
+static gboolean js_member(Js *j, GString *key, gboolean first) {
+  if (first ? !js_char(j, '{') : !js_char(j, ',')) return FALSE;
+  return js_string(j, key) && js_char(j, ':');
+}
+
+/* {"text": "..."} or {"bytes": "<base64>"} */
+static gboolean js_data(Js *j, GString *out, GString *key) {
+  gboolean ok = FALSE;
+  for (gboolean first = TRUE; js_member(j, key, first); first = FALSE) {
+    if (!strcmp(key->str, "text")) {
+      ok = js_string(j, out);
+    } else if (!strcmp(key->str, "bytes") && js_string(j, out)) {
+      gsize n = out->len;
+      g_base64_decode_inplace(out->str, &n);
+      g_string_truncate(out, n);
+      ok = TRUE;
+    } else if (!js_skip(j)) {
+      return FALSE;
+    }
+  }
+  return ok;
+}
+
+static gboolean js_submatches(Js *j, RgSearch *s) {
+  if (!js_char(j, '[')) return FALSE;
+  if (js_char(j, ']')) return TRUE;
+  do {
+    gint64 start = -1, end = -1;
+    for (gboolean first = TRUE; js_member(j, s->str, first); first = FALSE) {
+      if (!strcmp(s->str->str, "start")) start = js_int(j);
+      else if (!strcmp(s->str->str, "end")) end = js_int(j);
+      else if (!js_skip(j)) return FALSE;
+    }
+    if (!js_char(j, '}')) return FALSE;
+    if (start >= 0 && end >= start && end <= G_MAXUINT32) {
+      const UmiSearchSpan sp = { (guint32)start, (guint32)end };
+      g_array_append_val(s->spans, sp);
+    }
+  } while (js_char(j, ','));
+  return js_char(j, ']');
+}
+
+static gboolean parse_match_data(Js *j, RgSearch *s, gint64 *line) {
+  GString *key = g_string_new(NULL);
+  gboolean have_path = FALSE, have_text = FALSE, ok = TRUE;
+  for (gboolean first = TRUE; ok && js_member(j, key, first); first = FALSE) {
+    if (!strcmp(key->str, "path"))              ok = have_path = js_data(j, s->path, s->str) && js_char(j, '}');
+    else if (!strcmp(key->str, "lines"))        ok = have_text = js_data(j, s->text, s->str) && js_char(j, '}');
+    else if (!strcmp(key->str, "line_number"))  *line = js_int(j);
+    else if (!strcmp(key->str, "submatches"))   ok = js_submatches(j, s);
+    else                                        ok = js_skip(j);
+  }
+  g_string_free(key, TRUE);
+  return ok && have_path && have_text && js_char(j, '}');
+}
+
+/* One line of output: is it a match message? Its row is added if 'add'. */
+static gboolean parse_message(RgSearch *s, const char *line, gsize len, gboolean add) {
+  Js j = { line, line + len };
+  gboolean is_match = FALSE, have_data = FALSE;
+  gint64 lineno = 0;
+  g_array_set_size(s->spans, 0);
+  for (gboolean first = TRUE; js_member(&j, s->str, first); first = FALSE) {
+    if (!strcmp(s->str->str, "type")) {
+      if (!js_string(&j, s->str) || strcmp(s->str->str, "match")) return FALSE;
+      is_match = TRUE;
+    } else if (!strcmp(s->str->str, "data")) {
+      if (!(have_data = parse_match_data(&j, s, &lineno))) return FALSE;
+    } else if (!js_skip(&j)) {
+      return FALSE;
+    }
+  }
+  if (!is_match || !have_data) return FALSE;
+  if (!add) return TRUE;
+  const guint32 file = umi_search_results_add_file(s->res, s->path->str);
+  umi_search_results_add(s->res, file, (guint32)CLAMP(lineno, 0, G_MAXUINT32),
+                         s->text->str, (gssize)s->text->len,
+                         (const UmiSearchSpan *)(void *)s->spans->data, s->spans->len);
+  s->pending++;
   return TRUE;
 }
+
+/*---------------------------------------------------------------------------
+ * Streaming search
+ *---------------------------------------------------------------------------*/
+
+static void search_free(RgSearch *s) {
+  if (s->user_cancel) {
+    g_cancellable_disconnect(s->user_cancel, s->user_handler);
+    g_object_unref(s->user_cancel);
+  }
+  g_clear_object(&s->out);
+  g_clear_object(&s->errs);
+  g_clear_object(&s->sp);
+  g_object_unref(s->cancel);
+  umi_search_results_unref(s->res);
+  g_string_free(s->buf, TRUE);
+  g_string_free(s->path, TRUE);
+  g_string_free(s->text, TRUE);
+  g_string_free(s->str, TRUE);
+  g_array_free(s->spans, TRUE);
+  g_string_free(s->err, TRUE);
+  g_free(s);
+}
+
+static void finish(RgSearch *s) {
+  s->sum.cancelled = s->user_cancel && g_cancellable_is_cancelled(s->user_cancel);
+  s->sum.error     = s->err->str;
+  if (s->on_done) s->on_done(&s->sum, s->user);
+  search_free(s);
+}
+
+static void leg_done(RgSearch *s) {
+  if (--s->legs == 0) finish(s);
+}
+
+static void stop(RgSearch *s) {
+  g_cancellable_cancel(s->cancel);
+  if (s->sp) g_subprocess_force_exit(s->sp);      /* no-op once rg exited */
+}
+
+static void on_user_cancel(GCancellable *c, gpointer data) {
+  (void)c;
+  stop(data);
+}
+
+static void flush_batch(RgSearch *s) {
+  if (!s->pending) return;
+  const guint first = umi_search_results_n_rows(s->res) - s->pending;
+  const guint n = s->pending;
+  s->pending = 0;
+  s->sum.n_rows += n;
+  s->on_batch(s->res, first, n, s->user);
+}
+
+/* Parse every complete line of 'buf'. FALSE once a row past the cap shows
+ * up: exactly 'max_results' rows is not a truncation. */
+static gboolean parse_buffer(RgSearch *s) {
+  char *p = s->buf->str, *end = p + s->buf->len;
+  gboolean more = TRUE;
+  while (more && p < end && !g_cancellable_is_cancelled(s->cancel)) {
+    char *nl = memchr(p, '\n', (gsize)(end - p));
+    if (!nl) {
+      if ((gsize)(end - p) > RG_HOLD_MAX) s->skip_line = TRUE;
+      break;
+    }
+    const gboolean full = s->max_results && s->sum.n_rows + s->pending >= s->max_results;
+    if (!s->skip_line && parse_message(s, p, (gsize)(nl - p), !full) && full) {
+      s->sum.truncated = TRUE;
+      more = FALSE;
+    }
+    s->skip_line = FALSE;
+    p = nl + 1;
+    if (s->pending >= RG_BATCH) flush_batch(s);
+  }
+  if (!g_cancellable_is_cancelled(s->cancel)) flush_batch(s);
+  if (s->skip_line) p = end;                       /* drop what we have of it */
+  g_string_erase(s->buf, 0, p - s->buf->str);
+  return more;
+}
+
+static void on_out_read(GObject *src, GAsyncResult *res, gpointer data) {
+  RgSearch *s = data;
+  GBytes *bytes = g_input_stream_read_bytes_finish(G_INPUT_STREAM(src), res, NULL);
+  gsize n = 0;
+  const char *p = bytes ? g_bytes_get_data(bytes, &n) : NULL;
+  if (!n || g_cancellable_is_cancelled(s->cancel)) {   /* EOF, error, cancel */
+    if (bytes) g_bytes_unref(bytes);
+    if (s->buf->len && !s->skip_line && !g_cancellable_is_cancelled(s->cancel)) {
+      g_string_append_c(s->buf, '\n');             /* unterminated last line */
+      parse_buffer(s);
+    }
+    leg_done(s);
+    return;
+  }
+  g_string_append_len(s->buf, p, (gssize)n);
+  g_bytes_unref(bytes);
+  if (!parse_buffer(s)) {
+    stop(s);                                       /* result cap */
+    leg_done(s);
+    return;
+  }
+  g_input_stream_read_bytes_async(s->out, RG_READ_SIZE, G_PRIORITY_DEFAULT, s->cancel,
+                                  on_out_read, s);
+}
+static void on_err_read(GObject *src, GAsyncResult *res, gpointer data) {
+  RgSearch *s = data;
+  GBytes *bytes = g_input_stream_read_bytes_finish(G_INPUT_STREAM(src), res, NULL);
+  gsize n = 0;
+  const char *p = bytes ? g_bytes_get_data(bytes, &n) : NULL;
+  if (n && s->err->len < RG_ERR_MAX)
+    g_string_append_len(s->err, p, (gssize)MIN(n, RG_ERR_MAX - s->err->len));
+  if (bytes) g_bytes_unref(bytes);
+  if (!n || g_cancellable_is_cancelled(s->cancel)) {
+    leg_done(s);
+    return;
+  }
+  g_input_stream_read_bytes_async(s->errs, RG_READ_SIZE, G_PRIORITY_DEFAULT, s->cancel,
+                                  on_err_read, s);
+}
+
+static void on_rg_exit(GObject *src, GAsyncResult *res, gpointer data) {
+  RgSearch *s = data;
+  GSubprocess *sp = G_SUBPROCESS(src);
+  s->sum.exit_status = (g_subprocess_wait_finish(sp, res, NULL) && g_subprocess_get_if_exited(sp))
+                       ? g_subprocess_get_exit_status(sp) : -1;
+  leg_done(s);
+}
+
+static gboolean spawn_failed_idle(gpointer data) {
+  finish(data);
+  return G_SOURCE_REMOVE;
+}
+
+/*---------------------------------------------------------------------------
+ * umi_rg_search_start:
+ *   Spawn rg and stream its matches; see rg_runner.h.
+ *---------------------------------------------------------------------------*/
+void umi_rg_search_start(char **argvv, const char *cwd, UmiSearchResults *out,
+                         guint max_results, GCancellable *cancel,
+                         UmiSearchBatchCb on_batch, UmiSearchDoneCb on_done,
+                         gpointer user) {
+  g_return_if_fail(argvv != NULL && argvv[0] != NULL && out != NULL && on_batch != NULL);
+
+  RgSearch *s = g_new0(RgSearch, 1);
+  s->cancel      = g_cancellable_new();
+  s->max_results = max_results;
+  s->buf         = g_string_sized_new(RG_READ_SIZE);
+  s->res         = umi_search_results_ref(out);
+  s->path        = g_string_new(NULL);
+  s->text        = g_string_new(NULL);
+  s->str         = g_string_new(NULL);
+  s->spans       = g_array_new(FALSE, FALSE, sizeof(UmiSearchSpan));
+  s->err         = g_string_new(NULL);
+  s->on_batch    = on_batch;
+  s->on_done     = on_done;
+  s->user        = user;
+  s->sum.exit_status = -1;
+  if (cancel) s->user_cancel = g_object_ref(cancel);
+
+  GError *e = NULL;
+  GSubprocessLauncher *l = g_subprocess_launcher_new(G_SUBPROCESS_FLAGS_STDOUT_PIPE |
+                                                     G_SUBPROCESS_FLAGS_STDERR_PIPE);
+  if (cwd) g_subprocess_launcher_set_cwd(l, cwd);
+  if (!cancel || !g_cancellable_is_cancelled(cancel))
+    s->sp = g_subprocess_launcher_spawnv(l, (const gchar * const *)argvv, &e);
+  g_object_unref(l);
+  if (!s->sp) {
+    if (e) g_string_assign(s->err, e->message);
+    g_clear_error(&e);
+    g_idle_add(spawn_failed_idle, s);
+    return;
+  }
+
+  s->sum.spawned = TRUE;
+  s->out  = g_object_ref(g_subprocess_get_stdout_pipe(s->sp));
+  s->errs = g_object_ref(g_subprocess_get_stderr_pipe(s->sp));
+  s->legs = 3;
+  g_input_stream_read_bytes_async(s->out, RG_READ_SIZE, G_PRIORITY_DEFAULT, s->cancel,
+                                  on_out_read, s);
+  g_input_stream_read_bytes_async(s->errs, RG_READ_SIZE, G_PRIORITY_DEFAULT, s->cancel,
+                                  on_err_read, s);
+  g_subprocess_wait_async(s->sp, NULL, on_rg_exit, s);          /* always reaps */
+  if (cancel) s->user_handler = g_cancellable_connect(cancel, G_CALLBACK(on_user_cancel), s, NULL);
+}
 /*---------------------------------------------------------------------------*/
@@ -20,7 +20,7 @@
  * umi_rg_args_make_simple:
  *   Build a NULL-terminated argv suitable for glib's g_spawn* APIs:
  *
- *     rg -n --no-heading --color=never <pattern> <path>
+ *     rg -n --with-filename --no-heading --color=never <pattern> <path>
  *
  *   Ownership:
  *     - Returns a newly-allocated, NULL-terminated array of newly-allocated
@@ -38,6 +38,7 @@ char **umi_rg_args_make_simple(const char *pattern, const char *path)
   GPtrArray *a = g_ptr_array_new_with_free_func(g_free);
   g_ptr_array_add(a, g_strdup("rg"));
   g_ptr_array_add(a, g_strdup("-n"));              /* print line numbers */
+  g_ptr_array_add(a, g_strdup("--with-filename")); /* even for one file */
   g_ptr_array_add(a, g_strdup("--no-heading"));    /* no file headers */
   g_ptr_array_add(a, g_strdup("--color=never"));   /* machine-friendly */
   g_ptr_array_add(a, g_strdup(safe_pattern));
@@ -48,6 +49,50 @@ char **umi_rg_args_make_simple(const char *pattern, const char *path)
   return (char**)g_ptr_array_free(a, FALSE);
 }
 
+/*-----------------------------------------------------------------------------
+ * umi_rg_args_make_json:
+ *
+ *     rg --json -e <pattern> -- <path>
+ *
+ *   '-e' and '--' keep a pattern or path starting with '-' from being read
+ *   as an option. Same ownership and defaults as umi_rg_args_make_simple().
+ *---------------------------------------------------------------------------*/
+char **umi_rg_args_make_json(const char *pattern, const char *path)
+{
+  const char *safe_pattern = pattern ? pattern : "";
+  const char *safe_path    = (path && *path) ? path : ".";
+
+  GPtrArray *a = g_ptr_array_new_with_free_func(g_free);
+  g_ptr_array_add(a, g_strdup("rg"));
+  g_ptr_array_add(a, g_strdup("--json"));          /* one JSON object per line */
+  g_ptr_array_add(a, g_strdup("-e"));
+  g_ptr_array_add(a, g_strdup(safe_pattern));
+  g_ptr_array_add(a, g_strdup("--"));
+  g_ptr_array_add(a, g_strdup(safe_path));
+  g_ptr_array_add(a, NULL);
+  return (char**)g_ptr_array_free(a, FALSE);
+}
+
+/*-----------------------------------------------------------------------------
+ * umi_rg_args_make_json_files:
+ *
+ *     rg --json -e <pattern> -- <path> <path> ...
+ *
+ *   For re-searching a handful of known files. Same ownership as above.
+ *---------------------------------------------------------------------------*/
+char **umi_rg_args_make_json_files(const char *pattern, const char * const *paths)
+{
+  GPtrArray *a = g_ptr_array_new_with_free_func(g_free);
+  g_ptr_array_add(a, g_strdup("rg"));
+  g_ptr_array_add(a, g_strdup("--json"));
+  g_ptr_array_add(a, g_strdup("-e"));
+  g_ptr_array_add(a, g_strdup(pattern ? pattern : ""));
+  g_ptr_array_add(a, g_strdup("--"));
+  for (const char * const *p = paths; p && *p; p++) g_ptr_array_add(a, g_strdup(*p));
+  g_ptr_array_add(a, NULL);
+  return (char**)g_ptr_array_free(a, FALSE);
+}
+
 /*-----------------------------------------------------------------------------
  * umi_rg_args_free:
  *   Frees an argv vector previously created by umi_rg_args_make_simple().
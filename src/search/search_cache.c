@@ -0,0 +1,244 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/search_cache.c
+ * PURPOSE: Cache of finished text searches, revalidated file by file
+ *
+ * DESIGN:
+ *   - Entries live in a hash table (key string -> entry) and in a GQueue
+ *     ordered by use; the queue link is embedded in the entry, so touching
+ *     and evicting are O(1).
+ *   - The change log is a GPtrArray of absolute paths; a stamp is a log
+ *     position counted from the start of the cache ('log_base' is the
+ *     stamp of element 0). The log is trimmed to what the oldest entry
+ *     still needs; entries so far behind that they could only miss are
+ *     dropped first.
+ *   - Row paths may carry rg's "./"; they are compared without it.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <string.h>
+#include "search_cache.h"
+#include "ignore_rules.h"
+
+#define SC_DEFAULT_BYTES  (64u << 20)
+#define SC_LOG_SLACK      4u          /* trim once the log is this many times MAX_STALE */
+
+typedef struct {
+  GList             link;             /* in 'lru'; data points back here     */
+  char             *key;
+  char             *scope;
+  guint64           generation;
+  guint64           stamp;
+  UmiSearchResults *res;
+  gsize             bytes;
+} ScEntry;
+
+struct _UmiSearchCache {
+  GHashTable          *entries;       /* key -> ScEntry (owned)              */
+  GQueue               lru;           /* most recently used first            */
+  gsize                bytes, max_bytes;
+  GPtrArray           *log;           /* char*: absolute paths               */
+  guint64              log_base;
+  UmiSearchCacheStats  stats;
+};
+
+static char *key_string(const UmiSearchKey *k) {
+  return g_strdup_printf("%s%c%u%c%s", k->scope, '\x1f', k->flags, '\x1f', k->pattern);
+}
+
+static void entry_free(gpointer p) {
+  ScEntry *e = p;
+  umi_search_results_unref(e->res);
+  g_free(e->key);
+  g_free(e->scope);
+  g_free(e);
+}
+
+static void entry_remove(UmiSearchCache *c, ScEntry *e) {
+  g_queue_unlink(&c->lru, &e->link);
+  c->bytes -= e->bytes;
+  g_hash_table_remove(c->entries, e->key);             /* frees 'e' */
+}
+
+UmiSearchCache *umi_search_cache_new(gsize max_bytes) {
+  UmiSearchCache *c = g_new0(UmiSearchCache, 1);
+  c->entries   = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, entry_free);
+  c->max_bytes = max_bytes ? max_bytes : SC_DEFAULT_BYTES;
+  c->log       = g_ptr_array_new_with_free_func(g_free);
+  g_queue_init(&c->lru);
+  return c;
+}
+
+void umi_search_cache_free(UmiSearchCache *c) {
+  if (!c) return;
+  g_hash_table_destroy(c->entries);
+  g_ptr_array_free(c->log, TRUE);
+  g_free(c);
+}
+
+void umi_search_cache_clear(UmiSearchCache *c) {
+  g_return_if_fail(c != NULL);
+  g_queue_init(&c->lru);
+  g_hash_table_remove_all(c->entries);
+  c->bytes     = 0;
+  c->log_base += c->log->len;
+  g_ptr_array_set_size(c->log, 0);
+}
+
+guint64 umi_search_cache_stamp(const UmiSearchCache *c) {
+  return c ? c->log_base + c->log->len : 0;
+}
+
+/*---------------------------------------------------------------------------
+ * Change log
+ *---------------------------------------------------------------------------*/
+/* Drop entries that fell more than MAX_STALE changes behind, then the part
+ * of the log no remaining entry needs. */
+static void log_trim(UmiSearchCache *c) {
+  const guint64 now = umi_search_cache_stamp(c);
+  guint64 keep_from = now;
+  for (GList *l = c->lru.head; l; ) {
+    ScEntry *e = l->data;
+    l = l->next;
+    if (now - e->stamp > UMI_SEARCH_CACHE_MAX_STALE) entry_remove(c, e);
+    else keep_from = MIN(keep_from, e->stamp);
+  }
+  const guint drop = (guint)(keep_from - c->log_base);
+  if (drop) {
+    g_ptr_array_remove_range(c->log, 0, drop);
+    c->log_base = keep_from;
+  }
+}
+
+void umi_search_cache_file_changed(UmiSearchCache *c, const char *path) {
+  g_return_if_fail(c != NULL && path != NULL);
+  if (strstr(path, G_DIR_SEPARATOR_S ".git" G_DIR_SEPARATOR_S)) return;   /* git's own churn */
+  char *base = g_path_get_basename(path);
+  char *p = umi_ignore_is_rule_file(base) ? g_path_get_dirname(path) : g_strdup(path);
+  g_free(base);
+  if (c->log->len && !strcmp(g_ptr_array_index(c->log, c->log->len - 1), p)) {
+    g_free(p);                                        /* saved twice in a row */
+    return;
+  }
+  g_ptr_array_add(c->log, p);
+  if (c->log->len > SC_LOG_SLACK * UMI_SEARCH_CACHE_MAX_STALE) log_trim(c);
+}
+
+/*---------------------------------------------------------------------------
+ * Lookup
+ *---------------------------------------------------------------------------*/
+static const char *strip_dot(const char *path) {
+  return (path[0] == '.' && G_IS_DIR_SEPARATOR(path[1])) ? path + 2 : path;
+}
+
+/* Is 'path' or one of its parent directories in the stale set? */
+static gboolean keep_fresh(const char *path, gpointer user) {
+  GHashTable *stale = user;
+  const char *rel = strip_dot(path);
+  if (g_hash_table_contains(stale, rel)) return FALSE;
+  char *buf = g_strdup(rel);
+  gboolean fresh = TRUE;
+  for (char *s = strrchr(buf, G_DIR_SEPARATOR); s && fresh; s = strrchr(buf, G_DIR_SEPARATOR)) {
+    *s = '\0';
+    fresh = !g_hash_table_contains(stale, buf);
+  }
+  g_free(buf);
+  return fresh;
+}
+
+static void touch(UmiSearchCache *c, ScEntry *e) {
+  g_queue_unlink(&c->lru, &e->link);
+  g_queue_push_head_link(&c->lru, &e->link);
+}
+
+UmiSearchResults *umi_search_cache_get(UmiSearchCache *c, const UmiSearchKey *key,
+                                       char ***stale) {
+  g_return_val_if_fail(c != NULL && key != NULL && stale != NULL, NULL);
+  *stale = NULL;
+  char *k = key_string(key);
+  ScEntry *e = g_hash_table_lookup(c->entries, k);
+  g_free(k);
+  const guint64 now = umi_search_cache_stamp(c);
+  if (!e || e->stamp < c->log_base || now - e->stamp > UMI_SEARCH_CACHE_MAX_STALE) {
+    if (e) entry_remove(c, e);
+    c->stats.misses++;
+    return NULL;
+  }
+
+  /* Changed paths under the scope, relative to it. */
+  GHashTable *set = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  const gsize slen = strlen(e->scope);
+  for (guint64 i = e->stamp - c->log_base; i < c->log->len; ++i) {
+    const char *p = g_ptr_array_index(c->log, i);
+    if (!strncmp(p, e->scope, slen) && G_IS_DIR_SEPARATOR(p[slen]) && p[slen + 1])
+      g_hash_table_add(set, g_strdup(p + slen + 1));
+    else if (!strcmp(p, e->scope))
+      g_hash_table_add(set, g_strdup("."));           /* the scope itself */
+  }
+
+  /* The file set moved with nothing to show for it: no way to patch. */
+  if ((!g_hash_table_size(set) && e->generation != key->generation) ||
+      g_hash_table_contains(set, ".")) {
+    g_hash_table_destroy(set);
+    entry_remove(c, e);
+    c->stats.misses++;
+    return NULL;
+  }
+  touch(c, e);
+  if (!g_hash_table_size(set)) {                      /* changes were elsewhere */
+    e->stamp      = now;
+    e->generation = key->generation;
+    g_hash_table_destroy(set);
+    c->stats.hits++;
+    return umi_search_results_ref(e->res);
+  }
+
+  UmiSearchResults *r = umi_search_results_filter(e->res, keep_fresh, set);
+  GPtrArray *list = g_ptr_array_new();
+  GHashTableIter it;
+  gpointer p;
+  g_hash_table_iter_init(&it, set);
+  while (g_hash_table_iter_next(&it, &p, NULL)) {
+    g_ptr_array_add(list, p);
+    g_hash_table_iter_steal(&it);
+  }
+  g_ptr_array_add(list, NULL);
+  *stale = (char **)g_ptr_array_free(list, FALSE);
+  g_hash_table_destroy(set);
+  c->stats.partial++;
+  return r;
+}
+
+void umi_search_cache_put(UmiSearchCache *c, const UmiSearchKey *key,
+                          guint64 stamp, UmiSearchResults *r) {
+  g_return_if_fail(c != NULL && key != NULL && r != NULL);
+  char *k = key_string(key);
+  ScEntry *old = g_hash_table_lookup(c->entries, k);
+  if (old) entry_remove(c, old);
+  const gsize bytes = umi_search_results_memory(r) + 2 * strlen(k) + sizeof(ScEntry);
+  if (stamp < c->log_base || stamp > umi_search_cache_stamp(c) || bytes > c->max_bytes) {
+    g_free(k);
+    return;
+  }
+
+  ScEntry *e = g_new0(ScEntry, 1);
+  e->link.data  = e;
+  e->key        = k;
+  e->scope      = g_strdup(key->scope);
+  e->generation = key->generation;
+  e->stamp      = stamp;
+  e->res        = umi_search_results_ref(r);
+  e->bytes      = bytes;
+  g_hash_table_insert(c->entries, e->key, e);
+  g_queue_push_head_link(&c->lru, &e->link);
+  c->bytes += bytes;
+  while (c->bytes > c->max_bytes) entry_remove(c, c->lru.tail->data);
+}
+
+void umi_search_cache_stats(const UmiSearchCache *c, UmiSearchCacheStats *out) {
+  g_return_if_fail(c != NULL && out != NULL);
+  *out         = c->stats;
+  out->entries = g_hash_table_size(c->entries);
+  out->bytes   = c->bytes;
+}
+/*---------------------------------------------------------------------------*/
@@ -1,33 +1,418 @@
 /*-----------------------------------------------------------------------------
  * Umicom Studio IDE
  * File: src/search/search_panel.c
- * PURPOSE: Minimal Search Panel wiring (placeholder for full UI)
+ * PURPOSE: Search Panel: entry, streaming ripgrep search, virtualized list
+ *
+ * DESIGN:
+ *   - UmiSearchModel implements GListModel over a UmiSearchResults store.
+ *     get_item() makes a tiny UmiSearchHit (just the row index) for the
+ *     rows GtkListView asks for; nothing is kept per row on our side.
+ *   - The runner appends rows in batches; the model publishes them with a
+ *     single items-changed per main loop iteration (idle), however many
+ *     batches arrived in between.
+ *   - Each search gets its own store and GCancellable. Starting another
+ *     search cancels the previous one, which kills its rg.
+ *   - Without rg on PATH the built-in engine (builtin_search.h) searches
+ *     the files of the panel's index instead; both fill the same store.
+ *   - With a trigram index (trigram_index.h), a full search reads only
+ *     the files its posting lists name as candidates.
+ *   - With an index, finished searches go to a UmiSearchCache. Repeating a
+ *     query shows the cached store at once; after edits only the files the
+ *     watcher reported are searched again, appended to the rest.
+ *   - Typing searches as you go: edits are debounced, and a query that
+ *     only adds to the literal before it filters the shown results in
+ *     memory (umi_search_results_narrow) instead of searching again. What
+ *     superseded searches cost is counted in UmiSearchLiveStats.
+ *   - A pattern list (multi_search.h) is one Aho-Corasick pass over the
+ *     index; its store has a group per pattern and the first row of each
+ *     group carries a header.
+ *   - "Find references" does not search at all: the rows come from an
+ *     identifier index (ident_index.h) and are shown like a replace preview.
+ *   - A structural query (struct_search.h) matches tokens, not text, over
+ *     the C / C++ files; like a pattern list it is never cached or narrowed.
+ *
  * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-01 | MIT
  *---------------------------------------------------------------------------*/
 #include <gtk/gtk.h>
 #include <glib.h>
+#include <string.h>
 #include "search_panel.h"
 
-/*---------------------------------------------------------------------------
- * on_clicked:
- *   Temporary stub callback used during early UI wiring. Marked G_GNUC_UNUSED
- *   to avoid -Wunused-function warnings until connected in the .ui file.
- *---------------------------------------------------------------------------*/
-static void on_clicked(void) G_GNUC_UNUSED;
-static void on_clicked(void) {
-  g_message("SearchPanel: click handler stub");
+#define SP_MAX_RESULTS  250000u   /* rows kept per search */
+#define SP_CACHE_BYTES  (64u << 20)
+#define SP_TYPE_DELAY   150u      /* ms of quiet typing before a live search */
+#define SP_TYPE_MIN     2u        /* shorter live queries wait for Enter     */
+#define SP_RG_MAX_FILES 2048u     /* longer candidate lists: rg walks instead */
+
+/* Engine part of a cache key: the two engines' results are not mixed. */
+enum { SP_ENGINE_RG = 1, SP_ENGINE_BUILTIN = 2 };
+
+/*------------------------------ List items ----------------------------------*/
+#define UMI_TYPE_SEARCH_HIT (umi_search_hit_get_type())
+G_DECLARE_FINAL_TYPE(UmiSearchHit, umi_search_hit, UMI, SEARCH_HIT, GObject)
+
+struct _UmiSearchHit {
+  GObject parent_instance;
+  guint   row;                       /* index into the model's store            */
+};
+
+G_DEFINE_TYPE(UmiSearchHit, umi_search_hit, G_TYPE_OBJECT)
+
+static void umi_search_hit_class_init(UmiSearchHitClass *klass){ (void)klass; }
+static void umi_search_hit_init(UmiSearchHit *h){ (void)h; }
+
+/*------------------------------ List model ----------------------------------*/
+#define UMI_TYPE_SEARCH_MODEL (umi_search_model_get_type())
+G_DECLARE_FINAL_TYPE(UmiSearchModel, umi_search_model, UMI, SEARCH_MODEL, GObject)
+
+struct _UmiSearchModel {
+  GObject           parent_instance;
+  UmiSearchResults *res;             /* NULL: empty                             */
+  guint             n;               /* rows published to the view              */
+  guint             publish_source;  /* pending idle, 0 if none                 */
+};
+
+static GType model_get_item_type(GListModel *m){ (void)m; return UMI_TYPE_SEARCH_HIT; }
+
+static guint model_get_n_items(GListModel *m){ return UMI_SEARCH_MODEL(m)->n; }
+
+static gpointer model_get_item(GListModel *m, guint pos){
+  if(pos >= UMI_SEARCH_MODEL(m)->n) return NULL;
+  UmiSearchHit *h = g_object_new(UMI_TYPE_SEARCH_HIT, NULL);
+  h->row = pos;
+  return h;
+}
+
+static void model_iface_init(GListModelInterface *iface){
+  iface->get_item_type = model_get_item_type;
+  iface->get_n_items   = model_get_n_items;
+  iface->get_item      = model_get_item;
+}
+
+G_DEFINE_TYPE_WITH_CODE(UmiSearchModel, umi_search_model, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(G_TYPE_LIST_MODEL, model_iface_init))
+
+static void umi_search_model_finalize(GObject *o){
+  UmiSearchModel *m = UMI_SEARCH_MODEL(o);
+  if(m->publish_source) g_source_remove(m->publish_source);
+  umi_search_results_unref(m->res);
+  G_OBJECT_CLASS(umi_search_model_parent_class)->finalize(o);
+}
+
+static void umi_search_model_class_init(UmiSearchModelClass *klass){
+  G_OBJECT_CLASS(klass)->finalize = umi_search_model_finalize;
+}
+
+static void umi_search_model_init(UmiSearchModel *m){ (void)m; }
+
+/* Show rows appended to the store since the last publish. */
+static void model_publish(UmiSearchModel *m){
+  if(m->publish_source){ g_source_remove(m->publish_source); m->publish_source = 0; }
+  const guint old = m->n;
+  m->n = umi_search_results_n_rows(m->res);
+  if(m->n > old) g_list_model_items_changed(G_LIST_MODEL(m), old, 0, m->n - old);
+}
+
+static gboolean model_publish_idle(gpointer data){
+  UmiSearchModel *m = UMI_SEARCH_MODEL(data);
+  m->publish_source = 0;
+  model_publish(m);
+  return G_SOURCE_REMOVE;
+}
+
+static void model_schedule_publish(UmiSearchModel *m){
+  if(!m->publish_source) m->publish_source = g_idle_add(model_publish_idle, m);
+}
+
+/* Swap in another store (NULL: empty). */
+static void model_reset(UmiSearchModel *m, UmiSearchResults *res){
+  if(m->publish_source){ g_source_remove(m->publish_source); m->publish_source = 0; }
+  const guint old = m->n;
+  umi_search_results_unref(m->res);
+  m->res = res ? umi_search_results_ref(res) : NULL;
+  m->n = umi_search_results_n_rows(m->res);
+  if(old || m->n) g_list_model_items_changed(G_LIST_MODEL(m), 0, old, m->n);
+}
+
+/*------------------------------ Panel state ---------------------------------*/
+struct UmiSearchPanel {
+  GtkWidget        *widget;          /* root box (owned ref)                    */
+  GtkWidget        *entry;
+  GtkWidget        *status;
+  GtkListView      *view;
+  UmiSearchModel   *model;           /* our ref; the selection holds another    */
+  GCancellable     *cancel;          /* current search, NULL when idle          */
+  char             *root;
+  UmiRgProbe       *rg;              /* looked up on the first search           */
+  gboolean          rg_probed;
+  UmiFileIndex     *index;           /* for the built-in engine, borrowed       */
+  UmiFileIndex     *own_index;       /* built by us when none was set           */
+  UmiTrigramIndex  *trigram;         /* over 'index', borrowed; may be NULL     */
+  UmiSearchCache   *cache;
+  char             *query;           /* pattern of the shown / running search   */
+  gboolean          complete;        /* the store holds every match of 'query'  */
+  gboolean          cacheable;       /* an index was there when it started      */
+  guint             engine;          /* the query's key: engine, generation and */
+  guint64           generation;      /* change log stamp when it started        */
+  guint64           stamp;
+  guint             run_base;        /* rows the store had before the engine ran */
+  gint64            run_start;       /* monotonic usec                          */
+  guint             type_source;     /* pending debounce, 0 if none             */
+  UmiSearchLiveStats live;
+  UmiSearchOpenCb   on_open;
+  gpointer          user;
+};
+
+/* Shown path: relative to the root, without rg's "./". */
+static const char *display_path(const char *path){
+  return (path[0] == '.' && path[1] == G_DIR_SEPARATOR) ? path + 2 : path;
+}
+
+static void set_status(UmiSearchPanel *sp, const char *text){
+  gtk_label_set_text(GTK_LABEL(sp->status), text);
+}
+
+static UmiFileIndex *panel_index(UmiSearchPanel *sp){
+  return sp->index ? sp->index : sp->own_index;
+}
+
+static void show_count(UmiSearchPanel *sp, gboolean truncated, const char *note){
+  const guint rows  = umi_search_results_n_rows(sp->model->res);
+  const guint files = umi_search_results_n_files(sp->model->res);
+  const guint groups = umi_search_results_n_groups(sp->model->res);
+  gchar *by = groups ? g_strdup_printf(", %u %s", groups, groups == 1 ? "pattern" : "patterns")
+                     : g_strdup("");
+  gchar *msg = g_strdup_printf("%u %s in %u %s%s%s%s", rows, rows == 1 ? "match" : "matches",
+                               files, files == 1 ? "file" : "files", by,
+                               truncated ? " (more not shown)" : "", note);
+  g_free(by);
+  set_status(sp, msg);
+  g_free(msg);
+}
+
+/* The shown store is complete for 'query': hand it to the cache under the
+ * key the search started with. */
+static void cache_current(UmiSearchPanel *sp){
+  UmiFileIndex *idx = panel_index(sp);
+  sp->complete = TRUE;
+  if(sp->cacheable && idx && sp->model->res){
+    const UmiSearchKey key = { sp->query, sp->engine, umi_index_root(idx), sp->generation };
+    umi_search_cache_put(sp->cache, &key, sp->stamp, sp->model->res);
+  }
+}
+
+/* Stop the running search, if any; its rg is killed. */
+static void cancel_run(UmiSearchPanel *sp){
+  if(!sp->cancel) return;
+  g_cancellable_cancel(sp->cancel);
+  g_clear_object(&sp->cancel);
+  sp->live.superseded++;
+  sp->live.wasted_rows += umi_search_results_n_rows(sp->model->res) - sp->run_base;
+  sp->live.wasted_usec += g_get_monotonic_time() - sp->run_start;
+}
+
+static void on_batch(UmiSearchResults *r, guint first, guint n, gpointer user){
+  (void)r; (void)first; (void)n;
+  UmiSearchPanel *sp = (UmiSearchPanel*)user;
+  model_schedule_publish(sp->model);
+}
+
+static void on_done(const UmiSearchSummary *s, gpointer user){
+  UmiSearchPanel *sp = (UmiSearchPanel*)user;
+  if(s->cancelled) return;                 /* a newer search owns the panel */
+  g_clear_object(&sp->cancel);
+  model_publish(sp->model);
+
+  /* Only complete answers are worth repeating or narrowing. */
+  if(s->spawned && !s->truncated && (s->exit_status == 0 || s->exit_status == 1)) cache_current(sp);
+
+  if(!s->spawned){
+    gchar *msg = g_strdup_printf("Search failed: %s", s->error);
+    set_status(sp, msg);
+    g_free(msg);
+    return;
+  }
+  if(s->exit_status == 2 && !umi_search_results_n_rows(sp->model->res)){   /* error, nothing found */
+    set_status(sp, (s->error && *s->error) ? s->error : "Search failed");
+    return;
+  }
+  show_count(sp, s->truncated, "");
+}
+
+/*------------------------------ Rows ----------------------------------------*/
+/* Row widgets: vbox > [ group header | box > [ location label | preview label ] ].
+ * The header is only shown on the first row of a group. */
+static void on_setup(GtkSignalListItemFactory *f, GtkListItem *li, gpointer user){
+  (void)f; (void)user;
+  GtkWidget *head = gtk_label_new(NULL);
+  gtk_label_set_xalign(GTK_LABEL(head), 0.0f);
+  gtk_widget_add_css_class(head, "heading");
+  gtk_widget_set_visible(head, FALSE);
+  GtkWidget *loc = gtk_label_new(NULL);
+  gtk_label_set_xalign(GTK_LABEL(loc), 0.0f);
+  gtk_widget_add_css_class(loc, "dim-label");
+  GtkWidget *text = gtk_label_new(NULL);
+  gtk_label_set_xalign(GTK_LABEL(text), 0.0f);
+  gtk_label_set_ellipsize(GTK_LABEL(text), PANGO_ELLIPSIZE_END);
+  gtk_label_set_single_line_mode(GTK_LABEL(text), TRUE);
+  gtk_widget_set_hexpand(text, TRUE);
+  GtkWidget *box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
+  gtk_box_append(GTK_BOX(box), loc);
+  gtk_box_append(GTK_BOX(box), text);
+  GtkWidget *outer = gtk_box_new(GTK_ORIENTATION_VERTICAL, 2);
+  gtk_box_append(GTK_BOX(outer), head);
+  gtk_box_append(GTK_BOX(outer), box);
+  gtk_list_item_set_child(li, outer);
+}
+
+static void on_bind(GtkSignalListItemFactory *f, GtkListItem *li, gpointer user){
+  (void)f;
+  UmiSearchPanel *sp  = (UmiSearchPanel*)user;
+  UmiSearchHit   *hit = UMI_SEARCH_HIT(gtk_list_item_get_item(li));
+  GtkWidget      *head = gtk_widget_get_first_child(gtk_list_item_get_child(li));
+  GtkWidget      *box = gtk_widget_get_last_child(gtk_list_item_get_child(li));
+  GtkWidget      *loc = gtk_widget_get_first_child(box);
+  GtkWidget      *txt = gtk_widget_get_last_child(box);
+  UmiSearchRow row;
+  if(!hit || !umi_search_results_row(sp->model->res, hit->row, &row)) return;
+
+  const gint group = umi_search_results_row_group(sp->model->res, hit->row);
+  guint first = 0, n = 0;
+  const char *label = group >= 0 ? umi_search_results_group(sp->model->res, (guint)group, &first, &n) : NULL;
+  gtk_widget_set_visible(head, label && first == hit->row);
+  if(label && first == hit->row){
+    gchar *title = g_strdup_printf("%s (%u %s)", label, n, n == 1 ? "line" : "lines");
+    gtk_label_set_text(GTK_LABEL(head), title);
+    g_free(title);
+  }
+
+  gchar *where = g_strdup_printf("%s:%u", display_path(umi_search_results_file(sp->model->res, row.file_id)),
+                                 row.line);
+  gtk_label_set_text(GTK_LABEL(loc), where);
+  g_free(where);
+
+  /* Highlight the matches; a preview that is not UTF-8 is shown repaired,
+   * without highlights (its byte offsets no longer line up). */
+  PangoAttrList *attrs = pango_attr_list_new();
+  if(g_utf8_validate(row.preview, row.preview_len, NULL)){
+    gchar *text = g_strndup(row.preview, row.preview_len);
+    gtk_label_set_text(GTK_LABEL(txt), text);
+    g_free(text);
+    for(guint i = 0; i < row.n_spans; i++){
+      PangoAttribute *a = pango_attr_weight_new(PANGO_WEIGHT_BOLD);
+      a->start_index = row.spans[i].start;
+      a->end_index   = row.spans[i].end;
+      pango_attr_list_insert(attrs, a);
+      a = pango_attr_underline_new(PANGO_UNDERLINE_SINGLE);
+      a->start_index = row.spans[i].start;
+      a->end_index   = row.spans[i].end;
+      pango_attr_list_insert(attrs, a);
+    }
+  } else {
+    gchar *text = g_utf8_make_valid(row.preview, row.preview_len);
+    gtk_label_set_text(GTK_LABEL(txt), text);
+    g_free(text);
+  }
+  gtk_label_set_attributes(GTK_LABEL(txt), attrs);
+  pango_attr_list_unref(attrs);
+}
+
+/* Enter or double-click: open the file at the first match of the row. */
+static void on_activate_row(GtkListView *v, guint pos, gpointer user){
+  (void)v;
+  UmiSearchPanel *sp = (UmiSearchPanel*)user;
+  UmiSearchRow row;
+  if(!sp->on_open || !umi_search_results_row(sp->model->res, pos, &row)) return;
+  const char *rel = display_path(umi_search_results_file(sp->model->res, row.file_id));
+  gchar *path = g_path_is_absolute(rel) || !sp->root ? g_strdup(rel) : g_build_filename(sp->root, rel, NULL);
+  const guint col = row.column + (row.n_spans ? row.spans[0].start : 0) + 1;
+  sp->on_open(sp->user, path, row.line, col);
+  g_free(path);
+}
+
+static void on_entry_activate(GtkSearchEntry *e, gpointer user){
+  UmiSearchPanel *sp = (UmiSearchPanel*)user;
+  if(sp->type_source){ g_source_remove(sp->type_source); sp->type_source = 0; }
+  umi_search_panel_search(sp, gtk_editable_get_text(GTK_EDITABLE(e)));
+}
+
+static gboolean type_idle(gpointer user){
+  UmiSearchPanel *sp = (UmiSearchPanel*)user;
+  sp->type_source = 0;
+  umi_search_panel_run_example(sp);
+  return G_SOURCE_REMOVE;
+}
+
+/* Every edit restarts the debounce; only a pause in typing searches. */
+static void on_entry_changed(GtkEditable *e, gpointer user){
+  (void)e;
+  UmiSearchPanel *sp = (UmiSearchPanel*)user;
+  sp->live.edits++;
+  if(sp->type_source){
+    g_source_remove(sp->type_source);
+    sp->live.debounced++;
+  }
+  sp->type_source = g_timeout_add(SP_TYPE_DELAY, type_idle, sp);
 }
 
 /*---------------------------------------------------------------------------
  * umi_search_panel_new:
- *   Create a trivial panel instance that wraps a plain GtkBox for now.
+ *   Entry on top, status line, then the result list in a scroller (the view
+ *   only virtualizes inside a scrollable parent).
  *---------------------------------------------------------------------------*/
 UmiSearchPanel *umi_search_panel_new(void) {
   UmiSearchPanel *sp = g_new0(UmiSearchPanel, 1);
+  sp->model = g_object_new(UMI_TYPE_SEARCH_MODEL, NULL);
+  sp->cache = umi_search_cache_new(SP_CACHE_BYTES);
+
+  sp->entry = gtk_search_entry_new();
+  g_signal_connect(sp->entry, "activate", G_CALLBACK(on_entry_activate), sp);
+  g_signal_connect(sp->entry, "changed",  G_CALLBACK(on_entry_changed), sp);
+
+  sp->status = gtk_label_new(NULL);
+  gtk_label_set_xalign(GTK_LABEL(sp->status), 0.0f);
+  gtk_label_set_ellipsize(GTK_LABEL(sp->status), PANGO_ELLIPSIZE_END);
+
+  GtkListItemFactory *factory = gtk_signal_list_item_factory_new();
+  g_signal_connect(factory, "setup", G_CALLBACK(on_setup), sp);
+  g_signal_connect(factory, "bind",  G_CALLBACK(on_bind),  sp);
+  GtkSingleSelection *sel = gtk_single_selection_new(G_LIST_MODEL(g_object_ref(sp->model)));
+  sp->view = GTK_LIST_VIEW(gtk_list_view_new(GTK_SELECTION_MODEL(sel), factory));
+  g_signal_connect(sp->view, "activate", G_CALLBACK(on_activate_row), sp);
+
+  GtkWidget *scroller = gtk_scrolled_window_new();
+  gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(scroller), GTK_WIDGET(sp->view));
+  gtk_widget_set_vexpand(scroller, TRUE);
+
   sp->widget = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+  gtk_box_append(GTK_BOX(sp->widget), sp->entry);
+  gtk_box_append(GTK_BOX(sp->widget), sp->status);
+  gtk_box_append(GTK_BOX(sp->widget), scroller);
+  g_object_ref_sink(sp->widget);
   return sp;
 }
 
+void umi_search_panel_free(UmiSearchPanel *sp) {
+  if (!sp) return;
+  if (sp->cancel) {                  /* its on_done sees 'cancelled' and returns */
+    g_cancellable_cancel(sp->cancel);
+    g_object_unref(sp->cancel);
+  }
+  if (sp->type_source) g_source_remove(sp->type_source);
+  g_signal_handlers_disconnect_by_data(sp->entry, sp);
+  g_signal_handlers_disconnect_by_data(sp->view, sp);
+  gtk_list_view_set_model(sp->view, NULL);
+  g_object_unref(sp->widget);
+  model_reset(sp->model, NULL);
+  g_object_unref(sp->model);
+  umi_rg_probe_free(sp->rg);
+  if (sp->own_index) umi_index_free(sp->own_index);
+  umi_search_cache_free(sp->cache);
+  g_free(sp->query);
+  g_free(sp->root);
+  g_free(sp);
+}
+
 /*---------------------------------------------------------------------------
  * umi_search_panel_widget:
  *   Accessor for the root widget of the panel.
@@ -37,13 +422,359 @@ GtkWidget *umi_search_panel_widget(UmiSearchPanel *sp) {
   return sp->widget;
 }
 
+void umi_search_panel_set_root(UmiSearchPanel *sp, const char *dir) {
+  g_return_if_fail(sp != NULL);
+  g_free(sp->root);
+  sp->root = dir ? g_strdup(dir) : NULL;
+  if (sp->own_index) {               /* indexed the old root */
+    umi_index_free(sp->own_index);
+    sp->own_index = NULL;
+  }
+  umi_search_cache_clear(sp->cache);
+}
+
+void umi_search_panel_set_index(UmiSearchPanel *sp, UmiFileIndex *idx) {
+  g_return_if_fail(sp != NULL);
+  sp->index = idx;
+  umi_search_cache_clear(sp->cache);
+}
+
+void umi_search_panel_set_trigram(UmiSearchPanel *sp, UmiTrigramIndex *t) {
+  g_return_if_fail(sp != NULL);
+  sp->trigram = t;
+}
+
+void umi_search_panel_file_changed(UmiSearchPanel *sp, const char *path) {
+  g_return_if_fail(sp != NULL && path != NULL);
+  umi_search_cache_file_changed(sp->cache, path);
+}
+
+void umi_search_panel_cache_stats(UmiSearchPanel *sp, UmiSearchCacheStats *out) {
+  g_return_if_fail(sp != NULL && out != NULL);
+  umi_search_cache_stats(sp->cache, out);
+}
+
+void umi_search_panel_set_open_cb(UmiSearchPanel *sp, UmiSearchOpenCb cb, gpointer user) {
+  g_return_if_fail(sp != NULL);
+  sp->on_open = cb;
+  sp->user    = user;
+}
+
+/* Indexed files at the 'stale' paths of a partial cache hit (relative to
+ * the index root, as rows name them): a path that is still indexed, or
+ * every indexed file below a directory. Deleted and ignored paths give
+ * nothing, as they would in a full search. NULL-terminated, g_strfreev. */
+static char **stale_files(const UmiFileIndex *idx, char **stale){
+  const char *root = umi_index_root(idx);
+  GPtrArray  *out  = g_ptr_array_new();
+  GPtrArray  *dirs = g_ptr_array_new_with_free_func(g_free);
+  GHashTable *seen = g_hash_table_new(g_str_hash, g_str_equal);
+  for(char **p = stale; *p; p++){
+    char *abs = g_build_filename(root, *p, NULL);
+    if(umi_index_lookup(idx, abs) != UMI_INDEX_NO_FILE){
+      g_ptr_array_add(out, g_strdup(*p));
+      g_hash_table_add(seen, g_ptr_array_index(out, out->len - 1));
+    } else if(g_file_test(abs, G_FILE_TEST_IS_DIR)){
+      g_ptr_array_add(dirs, g_strconcat(*p, G_DIR_SEPARATOR_S, NULL));
+    }
+    g_free(abs);
+  }
+  if(dirs->len){                           /* a new or re-ruled directory */
+    const gsize rlen = strlen(root);
+    UmiIndexIter it;
+    umi_index_iter_init(&it, idx);
+    while(umi_index_iter_next(&it)){
+      const char *rel = umi_index_iter_path(&it) + rlen;
+      if(G_IS_DIR_SEPARATOR(*rel)) rel++;
+      for(guint i = 0; i < dirs->len; i++){
+        if(g_str_has_prefix(rel, g_ptr_array_index(dirs, i)) && !g_hash_table_contains(seen, rel)){
+          g_ptr_array_add(out, g_strdup(rel));
+          g_hash_table_add(seen, g_ptr_array_index(out, out->len - 1));
+          break;
+        }
+      }
+    }
+    umi_index_iter_clear(&it);
+  }
+  g_hash_table_destroy(seen);
+  g_ptr_array_free(dirs, TRUE);
+  g_ptr_array_add(out, NULL);
+  return (char**)g_ptr_array_free(out, FALSE);
+}
+
+/* Does 'p' match only itself as a regex? */
+static gboolean is_literal(const char *p){
+  return p[strcspn(p, "\\.^$|?*+()[]{}")] == '\0';
+}
+
+/* Files that may match 'pattern' per the trigram index (NULL-terminated,
+ * relative to the root, g_strfreev), or NULL: no index, or the pattern
+ * does not narrow the search. rg's regex dialect is not the PCRE the
+ * literals are extracted for, so it only gets lists for plain literals,
+ * and only lists short enough for a command line. */
+static char **candidate_files(UmiSearchPanel *sp, const char *pattern){
+  if (!sp->trigram || !sp->index || (sp->rg && !is_literal(pattern))) return NULL;
+  GPtrArray *cands = g_ptr_array_new_with_free_func(g_free);
+  const UmiTrigramFlags flags = is_literal(pattern) ? 0 : UMI_TRIGRAM_REGEX;
+  if (!umi_trigram_index_candidates(sp->trigram, pattern, flags, cands) ||
+      (sp->rg && cands->len > SP_RG_MAX_FILES)) {
+    g_ptr_array_free(cands, TRUE);
+    return NULL;
+  }
+  g_ptr_array_set_free_func(cands, NULL);
+  g_ptr_array_add(cands, NULL);
+  return (char**)g_ptr_array_free(cands, FALSE);
+}
+
+/* Answer 'pattern' from the shown results when it only adds to their
+ * literal query: every line matching it is already a row, so rows are
+ * dropped and spans moved, and no engine runs. Only while those results
+ * are complete and nothing changed on disk since they were found. */
+static gboolean try_narrow(UmiSearchPanel *sp, const char *pattern){
+  if (!sp->complete || !sp->query || !strcmp(pattern, sp->query) || !strstr(pattern, sp->query) ||
+      !is_literal(sp->query) || !is_literal(pattern) ||
+      umi_search_cache_stamp(sp->cache) != sp->stamp ||
+      umi_index_generation(panel_index(sp)) != sp->generation)
+    return FALSE;
+  UmiSearchResults *res = umi_search_results_narrow(sp->model->res, pattern);
+  if (!res) return FALSE;
+  g_free(sp->query);
+  sp->query = g_strdup(pattern);
+  model_reset(sp->model, res);
+  umi_search_results_unref(res);
+  cache_current(sp);
+  sp->live.narrowed++;
+  show_count(sp, FALSE, "");
+  return TRUE;
+}
+
+/*---------------------------------------------------------------------------
+ * umi_search_panel_search:
+ *   Cancel the running search, then answer from the cache or stream a new
+ *   search into a fresh store. A partially stale cached result is shown
+ *   at once and only the changed files are searched, appending to it.
+ *---------------------------------------------------------------------------*/
+void umi_search_panel_search(UmiSearchPanel *sp, const char *pattern) {
+  g_return_if_fail(sp != NULL);
+  cancel_run(sp);
+  if (pattern && *pattern && try_narrow(sp, pattern)) return;
+  g_clear_pointer(&sp->query, g_free);
+  sp->complete = FALSE;
+  model_reset(sp->model, NULL);
+  if (!pattern || !*pattern) {
+    set_status(sp, "");
+    return;
+  }
+
+  if (!sp->rg_probed) {
+    sp->rg = umi_rg_discover();
+    sp->rg_probed = TRUE;
+  }
+  /* No rg: search in-process. An index the panel has to build itself
+   * costs one walk of the root, on the first such search only. */
+  if (!sp->rg && !sp->index && !sp->own_index) sp->own_index = umi_index_build(sp->root ? sp->root : ".");
+
+  /* Without an index there is no way to tell which files a change hit,
+   * so results are only cached when there is one. */
+  UmiFileIndex     *idx   = panel_index(sp);
+  UmiSearchResults *res   = NULL;
+  char            **files = NULL;
+  sp->query      = g_strdup(pattern);
+  sp->engine     = sp->rg ? SP_ENGINE_RG : SP_ENGINE_BUILTIN;
+  sp->generation = umi_index_generation(idx);
+  sp->stamp      = umi_search_cache_stamp(sp->cache);
+  sp->cacheable  = idx != NULL;
+  if (idx) {
+    const UmiSearchKey key = { pattern, sp->engine, umi_index_root(idx), sp->generation };
+    char **stale = NULL;
+    res = umi_search_cache_get(sp->cache, &key, &stale);
+    if (stale) {
+      files = stale_files(idx, stale);
+      g_strfreev(stale);
+    }
+    if (res && (!files || !files[0])) {    /* nothing left to search */
+      model_reset(sp->model, res);
+      if (files) cache_current(sp);
+      sp->complete = TRUE;
+      sp->live.cached++;
+      show_count(sp, FALSE, " (cached)");
+      umi_search_results_unref(res);
+      g_strfreev(files);
+      return;
+    }
+    if (res && umi_search_results_n_rows(res) >= SP_MAX_RESULTS) {   /* no room: start over */
+      g_clear_pointer(&res, umi_search_results_unref);
+      g_clear_pointer(&files, g_strfreev);
+    }
+  }
+
+  /* A full search: the trigram index may rule most files out. */
+  char **cands = res ? NULL : candidate_files(sp, pattern);
+
+  const guint have = res ? umi_search_results_n_rows(res) : 0;
+  if (!res) res = umi_search_results_new();
+  model_reset(sp->model, res);
+  sp->cancel    = g_cancellable_new();
+  sp->run_base  = have;
+  sp->run_start = g_get_monotonic_time();
+  sp->live.started++;
+  char **named = files ? files : cands;
+  gchar *msg = named ? g_strdup_printf("Searching %u %s %s%s…", g_strv_length(named),
+                                       files ? "changed" : "candidate",
+                                       g_strv_length(named) == 1 ? "file" : "files",
+                                       sp->rg ? "" : " (built-in)")
+                     : g_strdup(sp->rg ? "Searching…" : "Searching (built-in, ripgrep not found)…");
+  set_status(sp, msg);
+  g_free(msg);
+  if (cands) files = cands;                /* replaces the walk of the root */
+  if (sp->rg && files && !files[0]) {      /* no file can match; rg would search "." */
+    umi_builtin_search_files_start(umi_index_root(idx), (const char * const *)files, pattern, 0, res,
+                                   SP_MAX_RESULTS, sp->cancel, on_batch, on_done, sp);
+  } else if (sp->rg) {
+    char **argvv;
+    if (files) {                           /* named like rg names them under "." */
+      const guint n = g_strv_length(files);
+      char **paths = g_new0(char*, n + 1);
+      for (guint i = 0; i < n; i++) paths[i] = g_strconcat("." G_DIR_SEPARATOR_S, files[i], NULL);
+      argvv = umi_rg_args_make_json_files(pattern, (const char * const *)paths);
+      g_strfreev(paths);
+    } else {
+      argvv = umi_rg_args_make_json(pattern, ".");
+    }
+    g_free(argvv[0]);
+    argvv[0] = g_strdup(sp->rg->path);
+    umi_rg_search_start(argvv, sp->root, res, SP_MAX_RESULTS - have, sp->cancel, on_batch, on_done, sp);
+    umi_rg_args_free(argvv);
+  } else if (files) {
+    umi_builtin_search_files_start(umi_index_root(idx), (const char * const *)files, pattern, 0, res,
+                                   SP_MAX_RESULTS - have, sp->cancel, on_batch, on_done, sp);
+  } else {
+    umi_builtin_search_start(idx, pattern, 0, res, SP_MAX_RESULTS, sp->cancel, on_batch, on_done, sp);
+  }
+  g_strfreev(files);
+  umi_search_results_unref(res);
+}
+
+/* Reset the panel for a search that is not a single query (nothing is
+ * cached or narrowed) and return its new store; the caller starts it. */
+static UmiSearchResults *begin_other_run(UmiSearchPanel *sp, const char *status) {
+  if (!sp->index && !sp->own_index) sp->own_index = umi_index_build(sp->root ? sp->root : ".");
+  UmiSearchResults *res = umi_search_results_new();
+  model_reset(sp->model, res);
+  sp->cancel    = g_cancellable_new();
+  sp->run_base  = 0;
+  sp->run_start = g_get_monotonic_time();
+  sp->live.started++;
+  set_status(sp, status);
+  return res;
+}
+
+static void clear_query(UmiSearchPanel *sp) {
+  cancel_run(sp);
+  g_clear_pointer(&sp->query, g_free);
+  sp->complete  = FALSE;
+  sp->cacheable = FALSE;
+  model_reset(sp->model, NULL);
+}
+
+/*---------------------------------------------------------------------------
+ * umi_search_panel_search_patterns:
+ *   Cancel the running search, then scan the index for every pattern of
+ *   'mp' in one pass. Not a single query, so nothing is cached or narrowed.
+ *---------------------------------------------------------------------------*/
+void umi_search_panel_search_patterns(UmiSearchPanel *sp, UmiMultiPattern *mp) {
+  g_return_if_fail(sp != NULL);
+  clear_query(sp);
+  if (!mp) {
+    set_status(sp, "");
+    return;
+  }
+  const guint n = umi_multi_pattern_count(mp);
+  gchar *msg = g_strdup_printf("Searching for %u %s…", n, n == 1 ? "pattern" : "patterns");
+  UmiSearchResults *res = begin_other_run(sp, msg);
+  g_free(msg);
+  umi_multi_search_start(panel_index(sp), mp, res, SP_MAX_RESULTS, sp->cancel, on_batch, on_done, sp);
+  umi_search_results_unref(res);
+}
+
+/*---------------------------------------------------------------------------
+ * umi_search_panel_search_structural:
+ *   Cancel the running search, compile 'query' (struct_search.h) and run
+ *   it over the C / C++ files of the index. A query that does not compile
+ *   only sets the status.
+ *---------------------------------------------------------------------------*/
+void umi_search_panel_search_structural(UmiSearchPanel *sp, const char *query) {
+  g_return_if_fail(sp != NULL);
+  clear_query(sp);
+  if (!query || !*query) {
+    set_status(sp, "");
+    return;
+  }
+  GError *err = NULL;
+  UmiStructQuery *q = umi_struct_query_new(query, &err);
+  if (!q) {
+    gchar *msg = g_strdup_printf("Invalid structural query: %s", err->message);
+    set_status(sp, msg);
+    g_free(msg);
+    g_error_free(err);
+    return;
+  }
+  UmiSearchResults *res = begin_other_run(sp, "Searching code structure…");
+  umi_struct_search_start(panel_index(sp), q, res, SP_MAX_RESULTS, sp->cancel, on_batch, on_done, sp);
+  umi_struct_query_unref(q);
+  umi_search_results_unref(res);
+}
+
 /*---------------------------------------------------------------------------
  * umi_search_panel_run_example:
- *   Placeholder demonstrating how the panel might kick off a search.
- *   Currently just logs to the console to prove basic wiring works.
+ *   The live search step, run once typing pauses: search the entry's text
+ *   now. Queries shorter than SP_TYPE_MIN characters would match nearly
+ *   every line, so they only clear the list and wait for Enter.
  *---------------------------------------------------------------------------*/
 void umi_search_panel_run_example(UmiSearchPanel *sp) {
   g_return_if_fail(sp != NULL);
-  g_message("SearchPanel: run_example() called (stub)");
+  if (sp->type_source) {
+    g_source_remove(sp->type_source);
+    sp->type_source = 0;
+  }
+  const char *text = gtk_editable_get_text(GTK_EDITABLE(sp->entry));
+  if (*text && g_utf8_strlen(text, -1) < (glong)SP_TYPE_MIN) {
+    umi_search_panel_search(sp, NULL);
+    set_status(sp, "Press Enter to search");
+    return;
+  }
+  if (sp->query && !strcmp(text, sp->query) && (sp->cancel || sp->complete)) return;   /* no change */
+  umi_search_panel_search(sp, text);
+}
+
+UmiSearchResults *umi_search_panel_results(UmiSearchPanel *sp) {
+  g_return_val_if_fail(sp != NULL, NULL);
+  return sp->model->res;
+}
+
+void umi_search_panel_show(UmiSearchPanel *sp, UmiSearchResults *res, const char *status) {
+  g_return_if_fail(sp != NULL);
+  cancel_run(sp);
+  g_clear_pointer(&sp->query, g_free);    /* not a query: nothing to narrow */
+  sp->complete = FALSE;
+  model_reset(sp->model, res);
+  set_status(sp, status ? status : "");
+}
+
+void umi_search_panel_show_references(UmiSearchPanel *sp, UmiIdentIndex *ids, const char *name) {
+  g_return_if_fail(sp != NULL && ids != NULL);
+  if (!name || !*name) { umi_search_panel_show(sp, NULL, ""); return; }
+  gboolean truncated = FALSE;
+  UmiSearchResults *res = umi_ident_index_results(ids, name, SP_MAX_RESULTS, &truncated);
+  umi_search_panel_show(sp, res, NULL);
+  umi_search_results_unref(res);
+  gchar *note = g_strdup_printf(" (references to %s)", name);
+  show_count(sp, truncated, note);
+  g_free(note);
+}
+
+void umi_search_panel_live_stats(UmiSearchPanel *sp, UmiSearchLiveStats *out) {
+  g_return_if_fail(sp != NULL && out != NULL);
+  *out = sp->live;
 }
-/*---------------------------------------------------------------------------*/
\ No newline at end of file
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,347 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/search_results.c
+ * PURPOSE: Compact store for text search results, shared by every engine
+ *
+ * DESIGN:
+ *   - One GArray per row field; a row is an index into all of them. The
+ *     narrow fields (preview length, span count) are 16-bit.
+ *   - Previews live back to back in one GByteArray ('arena'), spans in one
+ *     GArray; a row holds offsets into both.
+ *   - File paths are interned once (GPtrArray + hash). Engines report the
+ *     matches of a file together, so the last id is checked first.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <string.h>
+#include "search_results.h"
+
+#define SR_CONTEXT  48u   /* bytes kept before the first match of a long line */
+#define SR_CUT_LEFT 0x8000u /* text_len flag: window starts past the indentation */
+
+struct _UmiSearchResults {
+  gint        ref;
+  /* Row columns. */
+  GArray     *file;       /* guint32 */
+  GArray     *line;       /* guint32 */
+  GArray     *column;     /* guint32: preview start in the line */
+  GArray     *text_off;   /* guint32: preview in 'arena'        */
+  GArray     *text_len;   /* guint16, | SR_CUT_LEFT             */
+  GArray     *span_off;   /* guint32: first span in 'spans'     */
+  GArray     *n_spans;    /* guint16                            */
+  GByteArray *arena;
+  GArray     *spans;      /* UmiSearchSpan, preview-relative    */
+  /* Files. */
+  GPtrArray  *files;      /* char*, by id                       */
+  GHashTable *file_ids;   /* path (borrowed) -> id + 1          */
+  gsize       file_bytes;
+  guint32     last_file;
+  /* Groups (optional): labelled runs of consecutive rows. */
+  GArray     *group_first; /* guint32: first row of each group  */
+  GPtrArray  *groups;      /* char* label, by group             */
+};
+
+static GArray *column_new(guint elem) {
+  return g_array_sized_new(FALSE, FALSE, elem, 1024);
+}
+
+UmiSearchResults *umi_search_results_new(void) {
+  UmiSearchResults *r = g_new0(UmiSearchResults, 1);
+  r->ref      = 1;
+  r->file     = column_new(sizeof(guint32));
+  r->line     = column_new(sizeof(guint32));
+  r->column   = column_new(sizeof(guint32));
+  r->text_off = column_new(sizeof(guint32));
+  r->text_len = column_new(sizeof(guint16));
+  r->span_off = column_new(sizeof(guint32));
+  r->n_spans  = column_new(sizeof(guint16));
+  r->arena    = g_byte_array_sized_new(64 * 1024);
+  r->spans    = column_new(sizeof(UmiSearchSpan));
+  r->files    = g_ptr_array_new_with_free_func(g_free);
+  r->file_ids = g_hash_table_new(g_str_hash, g_str_equal);
+  r->last_file = G_MAXUINT32;
+  r->group_first = g_array_new(FALSE, FALSE, sizeof(guint32));
+  r->groups      = g_ptr_array_new_with_free_func(g_free);
+  return r;
+}
+
+UmiSearchResults *umi_search_results_ref(UmiSearchResults *r) {
+  if (r) r->ref++;
+  return r;
+}
+
+void umi_search_results_unref(UmiSearchResults *r) {
+  if (!r || --r->ref > 0) return;
+  g_array_free(r->file, TRUE);
+  g_array_free(r->line, TRUE);
+  g_array_free(r->column, TRUE);
+  g_array_free(r->text_off, TRUE);
+  g_array_free(r->text_len, TRUE);
+  g_array_free(r->span_off, TRUE);
+  g_array_free(r->n_spans, TRUE);
+  g_byte_array_free(r->arena, TRUE);
+  g_array_free(r->spans, TRUE);
+  g_hash_table_destroy(r->file_ids);
+  g_ptr_array_free(r->files, TRUE);
+  g_array_free(r->group_first, TRUE);
+  g_ptr_array_free(r->groups, TRUE);
+  g_free(r);
+}
+
+void umi_search_results_clear(UmiSearchResults *r) {
+  g_return_if_fail(r != NULL);
+  g_array_set_size(r->file, 0);
+  g_array_set_size(r->line, 0);
+  g_array_set_size(r->column, 0);
+  g_array_set_size(r->text_off, 0);
+  g_array_set_size(r->text_len, 0);
+  g_array_set_size(r->span_off, 0);
+  g_array_set_size(r->n_spans, 0);
+  g_byte_array_set_size(r->arena, 0);
+  g_array_set_size(r->spans, 0);
+  g_hash_table_remove_all(r->file_ids);
+  g_ptr_array_set_size(r->files, 0);
+  r->file_bytes = 0;
+  r->last_file  = G_MAXUINT32;
+  g_array_set_size(r->group_first, 0);
+  g_ptr_array_set_size(r->groups, 0);
+}
+
+/*---------------------------------------------------------------------------
+ * Files
+ *---------------------------------------------------------------------------*/
+guint32 umi_search_results_add_file(UmiSearchResults *r, const char *path) {
+  if (r->last_file < r->files->len && !strcmp(g_ptr_array_index(r->files, r->last_file), path))
+    return r->last_file;
+  guint32 id = GPOINTER_TO_UINT(g_hash_table_lookup(r->file_ids, path));
+  if (id) {
+    r->last_file = id - 1;
+    return r->last_file;
+  }
+  char *copy = g_strdup(path);
+  g_ptr_array_add(r->files, copy);
+  id = r->files->len;
+  g_hash_table_insert(r->file_ids, copy, GUINT_TO_POINTER(id));
+  r->file_bytes += strlen(copy) + 1;
+  r->last_file = id - 1;
+  return r->last_file;
+}
+
+const char *umi_search_results_file(const UmiSearchResults *r, guint32 file_id) {
+  return (r && file_id < r->files->len) ? g_ptr_array_index(r->files, file_id) : NULL;
+}
+
+guint umi_search_results_n_files(const UmiSearchResults *r) {
+  return r ? r->files->len : 0;
+}
+
+/*---------------------------------------------------------------------------
+ * Rows
+ *---------------------------------------------------------------------------*/
+static inline gboolean utf8_cont(guchar c) { return (c & 0xC0) == 0x80; }
+
+guint umi_search_results_add(UmiSearchResults *r, guint32 file_id, guint32 line,
+                             const char *text, gssize len,
+                             const UmiSearchSpan *spans, guint n_spans) {
+  g_return_val_if_fail(r != NULL && text != NULL, 0);
+  gsize n = len < 0 ? strlen(text) : (gsize)len;
+  const char *nl = memchr(text, '\n', n);
+  if (nl) n = (gsize)(nl - text);
+  if (n && text[n - 1] == '\r') --n;
+
+  /* Preview window: skip indentation, and for long lines start a little
+   * before the first match; never split a UTF-8 sequence. */
+  gsize first = n;
+  for (guint i = 0; i < n_spans; ++i) first = MIN(first, (gsize)spans[i].start);
+  if (!n_spans) first = 0;
+  gsize start = 0;
+  guint16 cut = 0;
+  while (start < first && (text[start] == ' ' || text[start] == '\t')) ++start;
+  if (first > start && first - start > UMI_SEARCH_PREVIEW_MAX - SR_CONTEXT) {
+    start = first - SR_CONTEXT;
+    cut   = SR_CUT_LEFT;
+    while (start < first && utf8_cont((guchar)text[start])) ++start;
+  }
+  gsize end = MIN(n, start + UMI_SEARCH_PREVIEW_MAX);
+  if (end < n)
+    while (end > start && utf8_cont((guchar)text[end])) --end;
+
+  const guint row     = r->file->len;
+  const guint32 off   = r->arena->len;
+  const guint16 tlen  = (guint16)(end - start) | cut;
+  const guint32 col   = (guint32)start;
+  const guint32 soff  = r->spans->len;
+  g_byte_array_append(r->arena, (const guint8 *)text + start, (guint)(end - start));
+  for (guint i = 0; i < n_spans; ++i) {
+    if (spans[i].start > end || (spans[i].end <= start && spans[i].end > spans[i].start)) continue;
+    UmiSearchSpan s = { (guint32)(MAX((gsize)spans[i].start, start) - start),
+                        (guint32)(MIN((gsize)spans[i].end, end) - start) };
+    if (s.end < s.start) s.end = s.start;
+    g_array_append_val(r->spans, s);
+    if (r->spans->len - soff == G_MAXUINT16) break;
+  }
+  const guint16 ns = (guint16)(r->spans->len - soff);
+  g_array_append_val(r->file, file_id);
+  g_array_append_val(r->line, line);
+  g_array_append_val(r->column, col);
+  g_array_append_val(r->text_off, off);
+  g_array_append_val(r->text_len, tlen);
+  g_array_append_val(r->span_off, soff);
+  g_array_append_val(r->n_spans, ns);
+  return row;
+}
+
+guint umi_search_results_n_rows(const UmiSearchResults *r) {
+  return r ? r->file->len : 0;
+}
+
+gboolean umi_search_results_row(const UmiSearchResults *r, guint i, UmiSearchRow *out) {
+  if (!r || i >= r->file->len) return FALSE;
+  out->file_id     = g_array_index(r->file, guint32, i);
+  out->line        = g_array_index(r->line, guint32, i);
+  out->column      = g_array_index(r->column, guint32, i);
+  out->preview     = (const char *)r->arena->data + g_array_index(r->text_off, guint32, i);
+  out->preview_len = g_array_index(r->text_len, guint16, i) & ~SR_CUT_LEFT;
+  out->n_spans     = g_array_index(r->n_spans, guint16, i);
+  out->spans       = out->n_spans
+                     ? &g_array_index(r->spans, UmiSearchSpan, g_array_index(r->span_off, guint32, i))
+                     : NULL;
+  return TRUE;
+}
+
+/* Append row 'i' of 'r' to 'out' as stored (previews are already windowed)
+ * under file 'id', with 'spans' instead of its own when given. */
+/*---------------------------------------------------------------------------
+ * Groups
+ *---------------------------------------------------------------------------*/
+guint umi_search_results_begin_group(UmiSearchResults *r, const char *label) {
+  g_return_val_if_fail(r != NULL, 0);
+  const guint32 first = r->file->len;
+  g_array_append_val(r->group_first, first);
+  g_ptr_array_add(r->groups, g_strdup(label ? label : ""));
+  return r->groups->len - 1;
+}
+
+guint umi_search_results_n_groups(const UmiSearchResults *r) {
+  return r ? r->groups->len : 0;
+}
+
+gint umi_search_results_row_group(const UmiSearchResults *r, guint row) {
+  if (!r || row >= r->file->len || !r->groups->len ||
+      row < g_array_index(r->group_first, guint32, 0))
+    return -1;
+  guint lo = 0, hi = r->groups->len;                /* last group starting <= row */
+  while (hi - lo > 1) {
+    const guint mid = (lo + hi) / 2;
+    if (g_array_index(r->group_first, guint32, mid) <= row) lo = mid;
+    else hi = mid;
+  }
+  return (gint)lo;
+}
+
+const char *umi_search_results_group(const UmiSearchResults *r, guint group, guint *first,
+                                     guint *n_rows) {
+  if (!r || group >= r->groups->len) return NULL;
+  const guint b = g_array_index(r->group_first, guint32, group);
+  const guint e = group + 1 < r->groups->len ? g_array_index(r->group_first, guint32, group + 1)
+                                             : r->file->len;
+  if (first) *first = b;
+  if (n_rows) *n_rows = e - b;
+  return g_ptr_array_index(r->groups, group);
+}
+
+static void row_copy(UmiSearchResults *out, const UmiSearchResults *r, guint i, guint32 id,
+                     const UmiSearchSpan *spans, guint16 ns) {
+  const guint32 off  = out->arena->len;
+  const guint32 soff = out->spans->len;
+  const guint16 tlen = g_array_index(r->text_len, guint16, i);
+  if (!spans) {
+    ns    = g_array_index(r->n_spans, guint16, i);
+    spans = ns ? &g_array_index(r->spans, UmiSearchSpan, g_array_index(r->span_off, guint32, i)) : NULL;
+  }
+  g_byte_array_append(out->arena, r->arena->data + g_array_index(r->text_off, guint32, i),
+                      tlen & ~SR_CUT_LEFT);
+  if (ns) g_array_append_vals(out->spans, spans, ns);
+  g_array_append_val(out->file, id);
+  g_array_append_vals(out->line, &g_array_index(r->line, guint32, i), 1);
+  g_array_append_vals(out->column, &g_array_index(r->column, guint32, i), 1);
+  g_array_append_val(out->text_off, off);
+  g_array_append_val(out->text_len, tlen);
+  g_array_append_val(out->span_off, soff);
+  g_array_append_val(out->n_spans, ns);
+}
+
+UmiSearchResults *umi_search_results_filter(const UmiSearchResults *r, UmiSearchFileFilter keep,
+                                            gpointer user) {
+  g_return_val_if_fail(r != NULL && keep != NULL, NULL);
+  UmiSearchResults *out = umi_search_results_new();
+  guint32 *map = g_new(guint32, r->files->len + 1);   /* old id -> new id */
+  for (guint f = 0; f < r->files->len; ++f) {
+    const char *path = g_ptr_array_index(r->files, f);
+    map[f] = keep(path, user) ? umi_search_results_add_file(out, path) : G_MAXUINT32;
+  }
+  for (guint i = 0; i < r->file->len; ++i) {
+    const guint32 id = map[g_array_index(r->file, guint32, i)];
+    if (id != G_MAXUINT32) row_copy(out, r, i, id, NULL, 0);
+  }
+  g_free(map);
+  return out;
+}
+
+static const char *find_literal(const char *hay, gsize n, const char *needle, gsize len) {
+  for (const char *end = hay + n; (gsize)(end - hay) >= len; ++hay) {
+    hay = memchr(hay, needle[0], (gsize)(end - hay) - len + 1);
+    if (!hay) return NULL;
+    if (!memcmp(hay, needle, len)) return hay;
+  }
+  return NULL;
+}
+
+UmiSearchResults *umi_search_results_narrow(const UmiSearchResults *r, const char *literal) {
+  g_return_val_if_fail(r != NULL && literal != NULL && *literal, NULL);
+  const gsize len = strlen(literal);
+  UmiSearchResults *out = umi_search_results_new();
+  guint32 *map = g_new(guint32, r->files->len + 1);   /* old id -> new id, added on use */
+  memset(map, 0xff, (r->files->len + 1) * sizeof(guint32));
+  GArray *spans = g_array_new(FALSE, FALSE, sizeof(UmiSearchSpan));
+  for (guint i = 0; i < r->file->len; ++i) {
+    const char   *text = (const char *)r->arena->data + g_array_index(r->text_off, guint32, i);
+    const guint16 tlen = g_array_index(r->text_len, guint16, i) & ~SR_CUT_LEFT;
+    const gboolean cut = (g_array_index(r->text_len, guint16, i) & SR_CUT_LEFT) != 0;
+    g_array_set_size(spans, 0);
+    for (const char *p = text, *hit; (hit = find_literal(p, (gsize)(text + tlen - p), literal, len));
+         p = hit + len) {
+      const UmiSearchSpan s = { (guint32)(hit - text), (guint32)(hit - text + len) };
+      g_array_append_val(spans, s);
+      if (spans->len == G_MAXUINT16) break;
+    }
+    if (!spans->len) {
+      /* A window that may have been cut short (a UTF-8 sequence is never
+       * split, hence the slack), or that starts past the indentation of a
+       * long line, cannot rule the rest of the line out. */
+      if (cut || tlen + 4u > UMI_SEARCH_PREVIEW_MAX) {
+        g_array_free(spans, TRUE);
+        g_free(map);
+        umi_search_results_unref(out);
+        return NULL;
+      }
+      continue;
+    }
+    const guint32 f = g_array_index(r->file, guint32, i);
+    if (map[f] == G_MAXUINT32) map[f] = umi_search_results_add_file(out, g_ptr_array_index(r->files, f));
+    row_copy(out, r, i, map[f], (const UmiSearchSpan *)spans->data, (guint16)spans->len);
+  }
+  g_array_free(spans, TRUE);
+  g_free(map);
+  return out;
+}
+
+gsize umi_search_results_memory(const UmiSearchResults *r) {
+  if (!r) return 0;
+  const gsize rows = r->file->len;
+  return rows * (5 * sizeof(guint32) + 2 * sizeof(guint16))
+         + r->arena->len + r->spans->len * sizeof(UmiSearchSpan)
+         + r->file_bytes + r->files->len * (sizeof(gpointer) + 3 * sizeof(gpointer))
+         + r->groups->len * (sizeof(guint32) + sizeof(gpointer));
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,459 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/search_stream.c
+ * PURPOSE: Shared file loop of the in-process search engines
+ *
+ * DESIGN:
+ *   - The file list is copied when the stream is filled, so watcher events
+ *     may be applied to the index while a search runs. One thread runs
+ *     umi_parallel_for over it and returns; the main loop is never blocked.
+ *   - A worker reads a file (a reused buffer when it is small: setting up
+ *     and faulting in a mapping costs more than copying a few pages, a
+ *     mapping otherwise), skips it when a NUL shows up early (binary, as
+ *     git and rg decide), and hands the bytes to the engine's scan.
+ *   - Rows go into the worker's chunk (line text, spans). Streaming: full
+ *     chunks are queued and one idle at a time drains the queue into the
+ *     store. Grouped: chunks stay with their worker; when every file is
+ *     done the thread sorts references to all rows by group, file and line
+ *     and idles move them into the store a slice at a time.
+ *   - Stopping (caller's cancellable, result cap) sets one atomic flag the
+ *     workers poll per file; engines poll it inside long files. on_done
+ *     runs from the idle that finds the thread finished.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include "search_stream.h"
+#include "file_meta.h"
+#include "parallel_for.h"
+
+#define SS_NONE          G_MAXUINT32
+#define SS_BATCH         256u         /* rows per callback                   */
+#define SS_CHUNK_ROWS    256u         /* rows a worker collects per hand-off */
+#define SS_IDLE_ROWS     8192u        /* sorted rows moved per idle          */
+#define SS_GRAIN         4u           /* files claimed at a time             */
+#define SS_BINARY_PROBE  8000u        /* a NUL in here: binary (git, rg)     */
+#define SS_MAP_MIN       (256 * 1024) /* smaller files are read, not mapped  */
+#define SS_ERR_MAX       (64 * 1024)
+
+/* A matching line as a worker found it; text and spans are in its chunk. */
+typedef struct {
+  guint32 group;
+  guint32 file;                     /* index into UmiSearchStream.files      */
+  guint32 line;
+  guint32 text_off, text_len;
+  guint32 span_off, n_spans;
+} SsRow;
+
+typedef struct {
+  GByteArray *text;
+  GArray     *rows;                 /* SsRow                                 */
+  GArray     *spans;                /* UmiSearchSpan, line-relative          */
+} SsChunk;
+
+typedef struct {
+  SsChunk    *chunk;                /* being filled, NULL if none            */
+  GByteArray *buf;                  /* contents of a small file              */
+} SsWorker;
+
+typedef struct {
+  guint32 worker;
+  guint32 row;
+} SsRef;
+
+struct _UmiSearchStream {
+  /* Fixed before the thread starts. */
+  gboolean               grouped;
+  UmiSearchStreamScanFn  scan;
+  UmiSearchStreamGroupFn group_label;
+  gpointer               engine;
+  GDestroyNotify         engine_free;
+  GStringChunk          *names;
+  GPtrArray             *files;     /* const char*, absolute                 */
+  GArray                *sizes;     /* gint64 per file from the walk, or -1  */
+  gsize                  root_len;  /* bytes before the relative path        */
+  guint                  max_results;
+  SsWorker              *workers;
+  guint                  n_workers;
+  GThread               *thread;
+  /* Shared with the workers. */
+  gint                   stop;      /* atomic: cancelled or capped           */
+  gint                   found;     /* atomic: rows produced                 */
+  GMutex                 lock;
+  GQueue                 ready;     /* SsChunk*                     (lock)   */
+  gboolean               posted;    /* a drain idle is pending      (lock)   */
+  gboolean               finished;  /* the thread is done           (lock)   */
+  gboolean               read_error;/*                              (lock)   */
+  GString               *err;      /*                              (lock)   */
+  /* Set by the thread before it finishes (grouped). */
+  GArray                *order;     /* SsRef, by group, file, line           */
+  /* Main loop only. */
+  guint                  next;      /* first entry of 'order' not yet added  */
+  guint32                group;     /* group of the open store group         */
+  UmiSearchResults      *res;
+  guint                  pending;   /* rows added, not yet reported          */
+  GCancellable          *user_cancel;
+  gulong                 user_handler;
+  UmiSearchSummary       sum;
+  UmiSearchBatchCb       on_batch;
+  UmiSearchDoneCb        on_done;
+  gpointer               user;
+};
+
+static SsChunk *chunk_new(void) {
+  SsChunk *c = g_new(SsChunk, 1);
+  c->text  = g_byte_array_sized_new(16 * 1024);
+  c->rows  = g_array_sized_new(FALSE, FALSE, sizeof(SsRow), SS_CHUNK_ROWS);
+  c->spans = g_array_sized_new(FALSE, FALSE, sizeof(UmiSearchSpan), SS_CHUNK_ROWS);
+  return c;
+}
+
+static void chunk_free(gpointer p) {
+  SsChunk *c = p;
+  if (!c) return;
+  g_byte_array_free(c->text, TRUE);
+  g_array_free(c->rows, TRUE);
+  g_array_free(c->spans, TRUE);
+  g_free(c);
+}
+
+/*---------------------------------------------------------------------------
+ * Workers
+ *---------------------------------------------------------------------------*/
+static gboolean drain_idle(gpointer data);
+
+static void post_locked(UmiSearchStream *ss, gboolean *need_idle) {
+  *need_idle = !ss->posted;
+  ss->posted = TRUE;
+}
+
+static void post_chunk(UmiSearchStream *ss, SsWorker *w) {
+  if (!w->chunk || ss->grouped) return;            /* grouped: kept to sort */
+  gboolean need;
+  g_mutex_lock(&ss->lock);
+  g_queue_push_tail(&ss->ready, w->chunk);
+  post_locked(ss, &need);
+  g_mutex_unlock(&ss->lock);
+  w->chunk = NULL;
+  if (need) g_idle_add(drain_idle, ss);
+}
+
+static void read_failed(UmiSearchStream *ss, const char *path, const char *msg) {
+  g_mutex_lock(&ss->lock);
+  ss->read_error = TRUE;
+  if (ss->err->len < SS_ERR_MAX) g_string_append_printf(ss->err, "%s: %s\n", path + ss->root_len, msg);
+  g_mutex_unlock(&ss->lock);
+}
+
+/* Whole file into w->buf ('e' set when it cannot be read). */
+static void read_file(SsWorker *w, const char *path, GError **e) {
+  FILE *fp = g_fopen(path, "rb");
+  if (!fp) {
+    const int errsv = errno;
+    g_set_error_literal(e, G_FILE_ERROR, g_file_error_from_errno(errsv), g_strerror(errsv));
+    return;
+  }
+  gsize got = 0, n;
+  g_byte_array_set_size(w->buf, MAX(w->buf->len, 64 * 1024));
+  while ((n = fread(w->buf->data + got, 1, w->buf->len - got, fp)) > 0)
+    if ((got += n) == w->buf->len) g_byte_array_set_size(w->buf, got * 2);
+  if (ferror(fp)) g_set_error_literal(e, G_FILE_ERROR, G_FILE_ERROR_IO, g_strerror(EIO));
+  fclose(fp);
+  g_byte_array_set_size(w->buf, (guint)got);  /* keeps its capacity */
+}
+
+static void search_file(UmiSearchStream *ss, guint worker, guint32 file) {
+  SsWorker *w = &ss->workers[worker];
+  const char *path = g_ptr_array_index(ss->files, file);
+  GError *e = NULL;
+  GMappedFile *mf = NULL;
+  if (g_array_index(ss->sizes, gint64, file) >= SS_MAP_MIN) mf = g_mapped_file_new(path, FALSE, &e);
+  else read_file(w, path, &e);
+  if (e) {                           /* gone since it was indexed: no error  */
+    if (!g_error_matches(e, G_FILE_ERROR, G_FILE_ERROR_NOENT)) read_failed(ss, path, e->message);
+    g_error_free(e);
+    return;
+  }
+  const guchar *data = mf ? (const guchar *)g_mapped_file_get_contents(mf) : w->buf->data;
+  const gsize   len  = mf ? g_mapped_file_get_length(mf) : w->buf->len;
+  if (len && !memchr(data, 0, MIN(len, SS_BINARY_PROBE)))
+    ss->scan(ss, worker, file, data, len, ss->engine);
+  if (mf) g_mapped_file_unref(mf);
+}
+
+static void search_range(guint b, guint e, guint worker, gpointer user) {
+  UmiSearchStream *ss = user;
+  SsWorker *w = &ss->workers[worker];
+  for (guint i = b; i < e && !g_atomic_int_get(&ss->stop); ++i) {
+    search_file(ss, worker, i);
+    if (w->chunk && w->chunk->rows->len >= SS_CHUNK_ROWS) post_chunk(ss, w);
+  }
+  post_chunk(ss, w);                 /* keep first results quick            */
+}
+
+static gint cmp_ref(gconstpointer a, gconstpointer b, gpointer user) {
+  const UmiSearchStream *ss = user;
+  const SsRef *p = a, *q = b;
+  const SsRow *x = &g_array_index(ss->workers[p->worker].chunk->rows, SsRow, p->row);
+  const SsRow *y = &g_array_index(ss->workers[q->worker].chunk->rows, SsRow, q->row);
+  if (x->group != y->group) return x->group < y->group ? -1 : 1;
+  if (x->file != y->file) return x->file < y->file ? -1 : 1;
+  return x->line < y->line ? -1 : (x->line > y->line ? 1 : 0);
+}
+
+static gpointer search_thread(gpointer data) {
+  UmiSearchStream *ss = data;
+  umi_parallel_for(ss->files->len, SS_GRAIN, search_range, ss);
+
+  if (ss->grouped) {
+    GArray *order = g_array_new(FALSE, FALSE, sizeof(SsRef));
+    for (guint32 w = 0; w < ss->n_workers; ++w)
+      for (guint32 r = 0; ss->workers[w].chunk && r < ss->workers[w].chunk->rows->len; ++r) {
+        SsRef ref = { w, r };
+        g_array_append_val(order, ref);
+      }
+    g_array_sort_with_data(order, cmp_ref, ss);
+    ss->order = order;
+  }
+  gboolean need;
+  g_mutex_lock(&ss->lock);
+  ss->finished = TRUE;
+  post_locked(ss, &need);
+  g_mutex_unlock(&ss->lock);
+  if (need) g_idle_add(drain_idle, ss);
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------
+ * Main loop side
+ *---------------------------------------------------------------------------*/
+static void stream_free(UmiSearchStream *ss) {
+  if (ss->user_cancel) {
+    g_cancellable_disconnect(ss->user_cancel, ss->user_handler);
+    g_object_unref(ss->user_cancel);
+  }
+  g_queue_clear_full(&ss->ready, chunk_free);
+  for (guint i = 0; i < ss->n_workers; ++i) {
+    chunk_free(ss->workers[i].chunk);
+    g_byte_array_free(ss->workers[i].buf, TRUE);
+  }
+  g_free(ss->workers);
+  if (ss->order) g_array_free(ss->order, TRUE);
+  if (ss->engine_free) ss->engine_free(ss->engine);
+  g_ptr_array_free(ss->files, TRUE);
+  g_array_free(ss->sizes, TRUE);
+  g_string_chunk_free(ss->names);
+  g_mutex_clear(&ss->lock);
+  g_string_free(ss->err, TRUE);
+  umi_search_results_unref(ss->res);
+  g_free(ss);
+}
+
+static gboolean is_cancelled(const UmiSearchStream *ss) {
+  return ss->user_cancel && g_cancellable_is_cancelled(ss->user_cancel);
+}
+
+static void finish(UmiSearchStream *ss) {
+  if (ss->thread) g_thread_join(ss->thread);       /* it is returning       */
+  ss->sum.cancelled = is_cancelled(ss);
+  if (ss->sum.spawned)
+    ss->sum.exit_status = g_atomic_int_get(&ss->stop) || ss->sum.truncated ? -1
+                          : ss->read_error ? 2 : ss->sum.n_rows ? 0 : 1;
+  ss->sum.error = ss->err->str;
+  if (ss->on_done) ss->on_done(&ss->sum, ss->user);
+  stream_free(ss);
+}
+
+static void on_user_cancel(GCancellable *c, gpointer data) {
+  (void)c;
+  g_atomic_int_set(&((UmiSearchStream *)data)->stop, 1);
+}
+
+static void flush_batch(UmiSearchStream *ss) {
+  if (!ss->pending) return;
+  const guint first = umi_search_results_n_rows(ss->res) - ss->pending;
+  const guint n = ss->pending;
+  ss->pending = 0;
+  ss->sum.n_rows += n;
+  ss->on_batch(ss->res, first, n, ss->user);
+}
+
+/* Row 'r' of chunk 'c' into the store; FALSE once the cap is reached. */
+static gboolean add_row(UmiSearchStream *ss, const SsChunk *c, const SsRow *r) {
+  if (ss->max_results && ss->sum.n_rows + ss->pending >= ss->max_results) {
+    ss->sum.truncated = TRUE;
+    g_atomic_int_set(&ss->stop, 1);
+    return FALSE;
+  }
+  if (ss->grouped && r->group != ss->group) {
+    flush_batch(ss);                               /* batches stay in one group */
+    umi_search_results_begin_group(ss->res, ss->group_label(r->group, ss->engine));
+    ss->group = r->group;
+  }
+  const char *path = g_ptr_array_index(ss->files, r->file);
+  const guint32 id = umi_search_results_add_file(ss->res, path + ss->root_len);
+  umi_search_results_add(ss->res, id, r->line, (const char *)c->text->data + r->text_off,
+                         (gssize)r->text_len,
+                         &g_array_index(c->spans, UmiSearchSpan, r->span_off), r->n_spans);
+  if (++ss->pending >= SS_BATCH) flush_batch(ss);
+  return TRUE;
+}
+
+/* Grouped: move the next slice of sorted rows into the store; the last
+ * idle ends the search. */
+static gboolean drain_sorted(UmiSearchStream *ss) {
+  const guint stop = MIN(ss->order->len, ss->next + SS_IDLE_ROWS);
+  for (; ss->next < stop && !is_cancelled(ss); ++ss->next) {
+    const SsRef   *ref = &g_array_index(ss->order, SsRef, ss->next);
+    const SsChunk *c   = ss->workers[ref->worker].chunk;
+    if (!add_row(ss, c, &g_array_index(c->rows, SsRow, ref->row))) break;
+  }
+  if (!is_cancelled(ss)) {
+    flush_batch(ss);
+    if (ss->next < ss->order->len && !ss->sum.truncated) return G_SOURCE_CONTINUE;
+  }
+  finish(ss);
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean drain_idle(gpointer data) {
+  UmiSearchStream *ss = data;
+  g_mutex_lock(&ss->lock);
+  GQueue ready = ss->ready;
+  g_queue_init(&ss->ready);
+  const gboolean finished = ss->finished;
+  ss->posted = FALSE;
+  g_mutex_unlock(&ss->lock);
+
+  if (ss->order) return drain_sorted(ss);          /* the thread is done    */
+  for (SsChunk *c; (c = g_queue_pop_head(&ready)); chunk_free(c))
+    for (guint i = 0; i < c->rows->len && !ss->sum.truncated && !is_cancelled(ss); ++i)
+      if (!add_row(ss, c, &g_array_index(c->rows, SsRow, i))) break;
+  if (!is_cancelled(ss)) flush_batch(ss);
+  if (finished) finish(ss);
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean failed_idle(gpointer data) {
+  finish(data);
+  return G_SOURCE_REMOVE;
+}
+
+/*---------------------------------------------------------------------------
+ * Public API
+ *---------------------------------------------------------------------------*/
+UmiSearchStream *umi_search_stream_new(UmiSearchStreamFlags flags,
+                                       UmiSearchStreamScanFn scan,
+                                       UmiSearchStreamGroupFn group_label,
+                                       gpointer engine, GDestroyNotify engine_free,
+                                       UmiSearchResults *out, guint max_results,
+                                       GCancellable *cancel, UmiSearchBatchCb on_batch,
+                                       UmiSearchDoneCb on_done, gpointer user) {
+  g_return_val_if_fail(scan != NULL && out != NULL && on_batch != NULL, NULL);
+  g_return_val_if_fail(!(flags & UMI_SEARCH_STREAM_GROUPED) || group_label != NULL, NULL);
+  UmiSearchStream *ss = g_new0(UmiSearchStream, 1);
+  ss->grouped     = (flags & UMI_SEARCH_STREAM_GROUPED) != 0;
+  ss->scan        = scan;
+  ss->group_label = group_label;
+  ss->engine      = engine;
+  ss->engine_free = engine_free;
+  ss->names       = g_string_chunk_new(64 * 1024);
+  ss->files       = g_ptr_array_new();
+  ss->sizes       = g_array_new(FALSE, FALSE, sizeof(gint64));
+  ss->max_results = max_results;
+  ss->err         = g_string_new(NULL);
+  ss->group       = SS_NONE;
+  ss->res         = umi_search_results_ref(out);
+  ss->on_batch    = on_batch;
+  ss->on_done     = on_done;
+  ss->user        = user;
+  ss->sum.exit_status = -1;
+  g_mutex_init(&ss->lock);
+  g_queue_init(&ss->ready);
+  if (cancel) ss->user_cancel = g_object_ref(cancel);
+  ss->n_workers = umi_parallel_workers();
+  ss->workers   = g_new0(SsWorker, ss->n_workers);
+  for (guint i = 0; i < ss->n_workers; ++i) ss->workers[i].buf = g_byte_array_new();
+  return ss;
+}
+
+static void set_root(UmiSearchStream *ss, const char *root) {
+  ss->root_len = strlen(root);
+  if (ss->root_len && !G_IS_DIR_SEPARATOR(root[ss->root_len - 1])) ss->root_len++;
+}
+
+void umi_search_stream_add_index(UmiSearchStream *ss, UmiFileIndex *idx,
+                                 gboolean (*keep)(const char *path)) {
+  g_return_if_fail(ss != NULL && idx != NULL);
+  set_root(ss, umi_index_root(idx));
+  UmiFileMeta *meta = umi_index_meta(idx);
+  UmiIndexIter it;
+  umi_index_iter_init(&it, idx);
+  while (umi_index_iter_next(&it)) {
+    const char *path = umi_index_iter_path(&it);
+    if (keep && !keep(path)) continue;
+    UmiFileStat st;
+    const gboolean known = meta && umi_file_meta_peek(meta, it.id, &st);
+    if (known && st.kind == UMI_FILE_KIND_BINARY) continue;
+    const gint64 size = known ? st.size : -1;
+    g_ptr_array_add(ss->files, g_string_chunk_insert(ss->names, path));
+    g_array_append_val(ss->sizes, size);
+  }
+  umi_index_iter_clear(&it);
+}
+
+void umi_search_stream_add_files(UmiSearchStream *ss, const char *root,
+                                 const char * const *files) {
+  g_return_if_fail(ss != NULL && root != NULL && files != NULL);
+  set_root(ss, root);
+  const gint64 unknown = -1;                       /* small-file path reads any size */
+  for (const char * const *f = files; *f; ++f) {
+    char *path = g_build_filename(root, *f, NULL);
+    g_ptr_array_add(ss->files, g_string_chunk_insert(ss->names, path));
+    g_array_append_val(ss->sizes, unknown);
+    g_free(path);
+  }
+}
+
+guint umi_search_stream_n_workers(const UmiSearchStream *ss) {
+  g_return_val_if_fail(ss != NULL, 0);
+  return ss->n_workers;
+}
+
+void umi_search_stream_run(UmiSearchStream *ss) {
+  g_return_if_fail(ss != NULL && !ss->thread);
+  ss->sum.spawned = TRUE;
+  if (ss->user_cancel)
+    ss->user_handler = g_cancellable_connect(ss->user_cancel, G_CALLBACK(on_user_cancel), ss, NULL);
+  ss->thread = g_thread_new("umi-search", search_thread, ss);
+}
+
+void umi_search_stream_fail(UmiSearchStream *ss, const char *error) {
+  g_return_if_fail(ss != NULL && !ss->thread);
+  g_string_assign(ss->err, error ? error : "");
+  g_idle_add(failed_idle, ss);
+}
+
+void umi_search_stream_row(UmiSearchStream *ss, guint worker, guint32 group, guint32 file,
+                           guint32 line, const guchar *text, gsize text_len,
+                           const UmiSearchSpan *spans, guint n_spans) {
+  SsWorker *w = &ss->workers[worker];
+  if (!w->chunk) w->chunk = chunk_new();
+  SsChunk *c = w->chunk;
+  SsRow row = { group, file, line, c->text->len, (guint32)text_len, c->spans->len, n_spans };
+  g_byte_array_append(c->text, text, (guint)text_len);
+  g_array_append_vals(c->spans, spans, n_spans);
+  g_array_append_val(c->rows, row);
+
+  /* One row past the cap is produced so the cap can tell "truncated". */
+  const guint found = (guint)g_atomic_int_add(&ss->found, 1) + 1;
+  if (ss->max_results && found > ss->max_results) g_atomic_int_set(&ss->stop, 1);
+}
+
+gboolean umi_search_stream_stopped(const UmiSearchStream *ss) {
+  return g_atomic_int_get(&((UmiSearchStream *)ss)->stop) != 0;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,438 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/struct_search.c
+ * PURPOSE: Structural (token-level) code search with wildcard holes
+ *
+ * DESIGN:
+ *   - A query compiles to a list of elements: literal tokens (compared by
+ *     their text) and holes. A file is tokenized once into an array, and a
+ *     second pass pairs its brackets, so a hole skips a whole "( ... )" in
+ *     one step and never takes half of one.
+ *   - Matching is a backtracking walk over the elements; only "$$" holes
+ *     branch (shortest run first, growing one unit at a time). Bindings
+ *     of named holes go on a trail that is unwound on backtracking. Each
+ *     start position has a step budget, so a pathological query gives up
+ *     instead of spinning.
+ *   - Prefilter: a file must contain the query's longest literal tokens
+ *     (up to SS_NEEDLES of them) as bytes, checked with memmem before any
+ *     tokenizing. A literal token is spelled the same in the source, so
+ *     this never drops a match.
+ *   - The file loop, reading, batching and cancellation are the shared
+ *     search stream's (search_stream.h); this file only matches tokens.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#define _GNU_SOURCE                   /* memmem */
+#include <string.h>
+#include "struct_search.h"
+#include "c_lexer.h"
+#include "search_stream.h"
+#include "symbol_index.h"
+
+#define SS_NONE          G_MAXUINT32
+#define SS_MAX_SLOTS     32u          /* named holes per query               */
+#define SS_NEEDLES       3u           /* literal tokens the prefilter checks */
+#define SS_BUDGET        20000u       /* backtracking steps per start        */
+#define SS_MAX_RUN       4096u        /* tokens one "$$" hole may take       */
+
+/*---------------------------------------------------------------------------
+ * Queries
+ *---------------------------------------------------------------------------*/
+typedef enum {
+  SS_LIT = 0,                       /* this token                            */
+  SS_ONE,                           /* $x: one token or one bracket group    */
+  SS_ANY                            /* $$x: balanced run, possibly empty     */
+} SsKind;
+
+typedef struct {
+  SsKind  kind;
+  gint    slot;                     /* named hole: binding index; else -1    */
+  guint32 off, len;                 /* literal: its text in 'text'           */
+} SsElem;
+
+struct _UmiStructQuery {
+  gint       ref;
+  char      *text;
+  SsElem    *el;
+  guint      n;
+  guint      n_slots;
+  GPtrArray *needles;               /* char*, longest first                  */
+};
+
+static gboolean is_open(const char *s, guint32 len) {
+  return len == 1 && (*s == '(' || *s == '[' || *s == '{');
+}
+
+static gboolean is_close(const char *s, guint32 len) {
+  return len == 1 && (*s == ')' || *s == ']' || *s == '}');
+}
+
+static char closer_of(char c) {
+  return c == '(' ? ')' : (c == '[' ? ']' : '}');
+}
+
+static gint cmp_len_desc(gconstpointer a, gconstpointer b) {
+  const gsize x = strlen(*(char * const *)a), y = strlen(*(char * const *)b);
+  return x > y ? -1 : (x < y ? 1 : 0);
+}
+
+static UmiStructQuery *query_fail(UmiStructQuery *q, GError **err, const char *msg) {
+  g_set_error_literal(err, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, msg);
+  umi_struct_query_unref(q);
+  return NULL;
+}
+
+UmiStructQuery *umi_struct_query_new(const char *text, GError **err) {
+  g_return_val_if_fail(text != NULL, NULL);
+  UmiStructQuery *q = g_new0(UmiStructQuery, 1);
+  q->ref     = 1;
+  q->text    = g_strdup(text);
+  q->needles = g_ptr_array_new_with_free_func(g_free);
+
+  GArray     *el    = g_array_new(FALSE, FALSE, sizeof(SsElem));
+  GHashTable *names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  GString    *stack = g_string_new(NULL);            /* expected closers */
+  gboolean    literal = FALSE, balanced = TRUE;
+  UmiCLexer   lx;
+  UmiCToken   t;
+  umi_c_lexer_init(&lx, q->text, strlen(q->text), 0);
+  while (umi_c_lexer_next(&lx, &t)) {
+    const char *s = q->text + t.off;
+    SsElem e = { SS_LIT, -1, t.off, t.len };
+    if (t.kind == UMI_CTOK_IDENT && s[0] == '$') {
+      const gboolean any  = t.len >= 2 && s[1] == '$';
+      const guint32  skip = any ? 2 : 1;
+      e.kind = any ? SS_ANY : SS_ONE;
+      if (t.len > skip && !(t.len == skip + 1 && s[skip] == '_')) {
+        char *name = g_strndup(s + skip, t.len - skip);
+        gpointer v;
+        if (g_hash_table_lookup_extended(names, name, NULL, &v)) {
+          e.slot = GPOINTER_TO_INT(v);
+          g_free(name);
+        } else {
+          e.slot = (gint)q->n_slots++;
+          g_hash_table_insert(names, name, GINT_TO_POINTER(e.slot));
+        }
+      }
+    } else {
+      literal = TRUE;
+      if (is_open(s, t.len)) {
+        g_string_append_c(stack, closer_of(*s));
+      } else if (is_close(s, t.len)) {
+        if (!stack->len || stack->str[stack->len - 1] != *s) balanced = FALSE;
+        else g_string_truncate(stack, stack->len - 1);
+      }
+      if (t.kind != UMI_CTOK_PUNCT || !q->needles->len) {
+        gboolean dup = FALSE;
+        for (guint i = 0; i < q->needles->len && !dup; ++i)
+          dup = strlen(q->needles->pdata[i]) == t.len && !memcmp(q->needles->pdata[i], s, t.len);
+        if (!dup) g_ptr_array_add(q->needles, g_strndup(s, t.len));
+      }
+    }
+    g_array_append_val(el, e);
+  }
+  g_hash_table_destroy(names);
+  const gboolean open_left = stack->len > 0;
+  g_string_free(stack, TRUE);
+  q->n  = el->len;
+  q->el = (SsElem *)(void *)g_array_free(el, FALSE);
+
+  if (!literal) return query_fail(q, err, "A structural query needs at least one token that is not a hole");
+  if (!balanced || open_left) return query_fail(q, err, "Brackets in the query do not balance");
+  if (q->n_slots > SS_MAX_SLOTS) return query_fail(q, err, "Too many named holes in the query");
+
+  /* Keep the longest few; a punctuator only stands in when there is
+   * nothing else. */
+  g_ptr_array_sort(q->needles, cmp_len_desc);
+  if (q->needles->len > 1 && strlen(q->needles->pdata[q->needles->len - 1]) == 1 &&
+      !umi_c_ident_char(*(const guchar *)q->needles->pdata[q->needles->len - 1]))
+    g_ptr_array_set_size(q->needles, q->needles->len - 1);
+  if (q->needles->len > SS_NEEDLES) g_ptr_array_set_size(q->needles, SS_NEEDLES);
+  return q;
+}
+
+UmiStructQuery *umi_struct_query_ref(UmiStructQuery *q) {
+  if (q) g_atomic_int_inc(&q->ref);
+  return q;
+}
+
+void umi_struct_query_unref(UmiStructQuery *q) {
+  if (!q || !g_atomic_int_dec_and_test(&q->ref)) return;
+  g_ptr_array_free(q->needles, TRUE);
+  g_free(q->el);
+  g_free(q->text);
+  g_free(q);
+}
+
+/*---------------------------------------------------------------------------
+ * Matching
+ *---------------------------------------------------------------------------*/
+#define SS_PLAIN   (G_MAXUINT32 - 1)  /* pair[]: not a bracket               */
+#define SS_CLOSER  (G_MAXUINT32 - 2)  /* pair[]: a closing bracket           */
+
+typedef struct {
+  GArray  *tok;                     /* UmiCToken                             */
+  GArray  *pair;                    /* guint32: opener -> its closer,        */
+                                    /*   SS_PLAIN, SS_CLOSER or SS_NONE      */
+  GArray  *stack;                   /* guint32 scratch                       */
+} SsTokens;
+
+typedef struct {
+  const UmiStructQuery *q;
+  const char           *src;
+  const UmiCToken      *tok;
+  const guint32        *pair;
+  guint32               nt;
+  guint32               bind_b[SS_MAX_SLOTS], bind_e[SS_MAX_SLOTS];
+  guint8                bound[SS_MAX_SLOTS];
+  guint8                trail[SS_MAX_SLOTS];
+  guint                 n_trail;
+  guint                 budget;
+} SsMatcher;
+
+static void tokenize(SsTokens *tk, const char *src, gsize len) {
+  UmiCLexer lx;
+  UmiCToken t;
+  g_array_set_size(tk->tok, 0);
+  g_array_set_size(tk->stack, 0);
+  umi_c_lexer_init(&lx, src, len, UMI_CLEX_SKIP_IF0);
+  while (umi_c_lexer_next(&lx, &t)) g_array_append_val(tk->tok, t);
+
+  const UmiCToken *tok = (const UmiCToken *)(const void *)tk->tok->data;
+  g_array_set_size(tk->pair, tk->tok->len);
+  guint32 *pair = (guint32 *)(void *)tk->pair->data;
+  for (guint32 i = 0; i < tk->tok->len; ++i) {
+    const char *s = src + tok[i].off;
+    if (tok[i].kind != UMI_CTOK_PUNCT) { pair[i] = SS_PLAIN; continue; }
+    if (is_open(s, tok[i].len)) {
+      pair[i] = SS_NONE;                               /* until closed */
+      g_array_append_val(tk->stack, i);
+    } else if (is_close(s, tok[i].len)) {
+      pair[i] = SS_CLOSER;
+      /* Pop to the matching opener; openers skipped are left unpaired. */
+      for (guint k = tk->stack->len; k-- > 0; ) {
+        const guint32 o = g_array_index(tk->stack, guint32, k);
+        if (closer_of(src[tok[o].off]) != *s) continue;
+        pair[o] = i;
+        g_array_set_size(tk->stack, k);
+        break;
+      }
+    } else {
+      pair[i] = SS_PLAIN;
+    }
+  }
+}
+
+static inline gboolean tok_is(const SsMatcher *m, guint32 ti, const SsElem *e) {
+  return m->tok[ti].len == e->len && !memcmp(m->src + m->tok[ti].off, m->q->text + e->off, e->len);
+}
+
+/* End of the unit starting at token 'ti' (a token or a bracket group), or
+ * SS_NONE when a hole cannot take it (end of file, a closer, an opener
+ * that is never closed). */
+static inline guint32 unit_end(const SsMatcher *m, guint32 ti) {
+  if (ti >= m->nt) return SS_NONE;
+  const guint32 p = m->pair[ti];
+  if (p == SS_PLAIN) return ti + 1;
+  if (p == SS_CLOSER || p == SS_NONE) return SS_NONE;
+  return p + 1;
+}
+
+static gboolean same_tokens(const SsMatcher *m, guint32 a, guint32 b, guint32 n) {
+  for (guint32 i = 0; i < n; ++i)
+    if (m->tok[a + i].len != m->tok[b + i].len ||
+        memcmp(m->src + m->tok[a + i].off, m->src + m->tok[b + i].off, m->tok[a + i].len))
+      return FALSE;
+  return TRUE;
+}
+
+/* Bind 'slot' to tokens [b, e), or check the binding it already has. */
+static gboolean bind(SsMatcher *m, gint slot, guint32 b, guint32 e) {
+  if (slot < 0) return TRUE;
+  if (m->bound[slot])
+    return m->bind_e[slot] - m->bind_b[slot] == e - b && same_tokens(m, m->bind_b[slot], b, e - b);
+  m->bound[slot]  = 1;
+  m->bind_b[slot] = b;
+  m->bind_e[slot] = e;
+  m->trail[m->n_trail++] = (guint8)slot;
+  return TRUE;
+}
+
+static void unwind(SsMatcher *m, guint to) {
+  while (m->n_trail > to) m->bound[m->trail[--m->n_trail]] = 0;
+}
+
+/* Match elements [qi, n) from token 'ti'; '*end' is the token after. */
+static gboolean match_from(SsMatcher *m, guint qi, guint32 ti, guint32 *end) {
+  for (; qi < m->q->n; ++qi) {
+    const SsElem *e = &m->q->el[qi];
+    if (e->kind == SS_LIT) {
+      if (ti >= m->nt || !tok_is(m, ti, e)) return FALSE;
+      ++ti;
+    } else if (e->kind == SS_ONE) {
+      const guint32 u = unit_end(m, ti);
+      if (u == SS_NONE || !bind(m, e->slot, ti, u)) return FALSE;
+      ti = u;
+    } else {
+      if (e->slot >= 0 && m->bound[e->slot]) {       /* a run already fixed */
+        const guint32 n = m->bind_e[e->slot] - m->bind_b[e->slot];
+        if (ti + n > m->nt || !same_tokens(m, m->bind_b[e->slot], ti, n)) return FALSE;
+        ti += n;
+        continue;
+      }
+      const guint mark = m->n_trail;
+      for (guint32 to = ti; ; ) {                     /* shortest run first */
+        if (bind(m, e->slot, ti, to) && match_from(m, qi + 1, to, end)) return TRUE;
+        unwind(m, mark);
+        if (!m->budget || !--m->budget) return FALSE;
+        to = unit_end(m, to);
+        if (to == SS_NONE || to - ti > SS_MAX_RUN) return FALSE;
+      }
+    }
+  }
+  *end = ti;
+  return TRUE;
+}
+
+/* Matches over tokenized 'src' into 'out', left to right. */
+static void match_tokens(const UmiStructQuery *q, const char *src, const SsTokens *tk, GArray *out) {
+  SsMatcher m;
+  memset(&m, 0, sizeof m);
+  m.q    = q;
+  m.src  = src;
+  m.tok  = (const UmiCToken *)(const void *)tk->tok->data;
+  m.pair = (const guint32 *)(const void *)tk->pair->data;
+  m.nt   = tk->tok->len;
+  const SsElem *first = &q->el[0];
+  for (guint32 ti = 0; ti < m.nt; ) {
+    if (first->kind == SS_LIT && !tok_is(&m, ti, first)) { ++ti; continue; }
+    guint32 end = ti;
+    unwind(&m, 0);
+    m.budget = SS_BUDGET;
+    if (!match_from(&m, 0, ti, &end) || end == ti) { ++ti; continue; }
+    const UmiCToken *a = &m.tok[ti], *z = &m.tok[end - 1];
+    UmiStructMatch r = { a->off, z->off + z->len, a->line, a->column };
+    g_array_append_val(out, r);
+    ti = end;
+  }
+}
+
+static void tokens_init(SsTokens *tk) {
+  tk->tok   = g_array_new(FALSE, FALSE, sizeof(UmiCToken));
+  tk->pair  = g_array_new(FALSE, FALSE, sizeof(guint32));
+  tk->stack = g_array_new(FALSE, FALSE, sizeof(guint32));
+}
+
+static void tokens_clear(SsTokens *tk) {
+  if (!tk->tok) return;
+  g_array_free(tk->tok, TRUE);
+  g_array_free(tk->pair, TRUE);
+  g_array_free(tk->stack, TRUE);
+}
+
+guint umi_struct_query_match(const UmiStructQuery *q, const char *src, gsize len, GArray *out) {
+  g_return_val_if_fail(q != NULL && out != NULL, 0);
+  g_array_set_size(out, 0);
+  if (!src || !len || len >= G_MAXUINT32) return 0;
+  SsTokens tk;
+  tokens_init(&tk);
+  tokenize(&tk, src, len);
+  match_tokens(q, src, &tk, out);
+  tokens_clear(&tk);
+  return out->len;
+}
+
+/*---------------------------------------------------------------------------
+ * Scanning (worker threads)
+ *---------------------------------------------------------------------------*/
+typedef struct {
+  SsTokens  tk;
+  GArray   *matches;                /* UmiStructMatch                        */
+  GArray   *spans;                  /* UmiSearchSpan of the current line     */
+} SsWorker;
+
+typedef struct {
+  UmiStructQuery *q;
+  SsWorker       *workers;
+  guint           n_workers;
+} SsSearch;
+
+static gboolean may_match(const UmiStructQuery *q, const guchar *data, gsize len) {
+  for (guint i = 0; i < q->needles->len; ++i) {
+    const char *n = q->needles->pdata[i];
+#if defined(__GLIBC__) || defined(__APPLE__) || defined(__FreeBSD__)
+    if (!memmem(data, len, n, strlen(n))) return FALSE;
+#else
+    if (!g_strstr_len((const char *)data, (gssize)len, n)) return FALSE;   /* stops at a NUL */
+#endif
+  }
+  return TRUE;
+}
+
+/* Matches of one file -> rows: one per line a match starts on, with a
+ * span per match cut at the line end. Spans past the preview window of
+ * the first one are dropped, as the other engines do. */
+static void scan_file(UmiSearchStream *ss, guint worker, guint32 file,
+                      const guchar *data, gsize len, gpointer engine) {
+  SsSearch *s = engine;
+  SsWorker *w = &s->workers[worker];
+  if (len >= G_MAXUINT32 || !may_match(s->q, data, len)) return;
+  tokenize(&w->tk, (const char *)data, len);
+  g_array_set_size(w->matches, 0);
+  match_tokens(s->q, (const char *)data, &w->tk, w->matches);
+
+  const UmiStructMatch *mt = (const UmiStructMatch *)(const void *)w->matches->data;
+  for (guint i = 0; i < w->matches->len; ) {
+    const gsize   bol   = mt[i].start - (mt[i].column - 1);
+    const guchar *nl    = memchr(data + mt[i].start, '\n', len - mt[i].start);
+    const gsize   eol   = nl ? (gsize)(nl - data) : len;
+    const gsize   limit = MIN(eol - bol, (gsize)(mt[i].column - 1) + UMI_SEARCH_PREVIEW_MAX);
+    const guint32 line  = mt[i].line;
+    g_array_set_size(w->spans, 0);
+    for (; i < w->matches->len && mt[i].line == line; ++i) {
+      const gsize a = mt[i].start - bol;
+      if (a > limit) continue;
+      UmiSearchSpan sp = { (guint32)a, (guint32)MIN(MIN((gsize)mt[i].end, eol) - bol, limit) };
+      g_array_append_val(w->spans, sp);
+    }
+    umi_search_stream_row(ss, worker, 0, file, line, data + bol, limit,
+                          (const UmiSearchSpan *)(const void *)w->spans->data, w->spans->len);
+  }
+}
+
+static void search_free(gpointer data) {
+  SsSearch *s = data;
+  for (guint i = 0; i < s->n_workers; ++i) {
+    tokens_clear(&s->workers[i].tk);
+    g_array_free(s->workers[i].matches, TRUE);
+    g_array_free(s->workers[i].spans, TRUE);
+  }
+  g_free(s->workers);
+  umi_struct_query_unref(s->q);
+  g_free(s);
+}
+
+/*---------------------------------------------------------------------------
+ * umi_struct_search_start:
+ *   Search the C / C++ files of the index on a thread; see struct_search.h.
+ *---------------------------------------------------------------------------*/
+void umi_struct_search_start(UmiFileIndex *idx, UmiStructQuery *q,
+                             UmiSearchResults *out, guint max_results,
+                             GCancellable *cancel, UmiSearchBatchCb on_batch,
+                             UmiSearchDoneCb on_done, gpointer user) {
+  g_return_if_fail(idx != NULL && q != NULL && out != NULL && on_batch != NULL);
+  SsSearch *s = g_new0(SsSearch, 1);
+  s->q = umi_struct_query_ref(q);
+  UmiSearchStream *ss = umi_search_stream_new(0, scan_file, NULL, s, search_free, out,
+                                              max_results, cancel, on_batch, on_done, user);
+  s->n_workers = umi_search_stream_n_workers(ss);
+  s->workers   = g_new0(SsWorker, s->n_workers);
+  for (guint i = 0; i < s->n_workers; ++i) {
+    tokens_init(&s->workers[i].tk);
+    s->workers[i].matches = g_array_new(FALSE, FALSE, sizeof(UmiStructMatch));
+    s->workers[i].spans   = g_array_new(FALSE, FALSE, sizeof(UmiSearchSpan));
+  }
+  umi_search_stream_add_index(ss, idx, umi_symbol_index_is_source);
+  umi_search_stream_run(ss);
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,1152 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/symbol_index.c
+ * PURPOSE: ctags-style C / C++ definition index (go-to-definition, "@symbol")
+ *
+ * DESIGN:
+ *   - Documents follow trigram_index.c: one version of one file, matched to
+ *     the file index by root-relative path, tombstoned (DOC_DEAD) when the
+ *     file changes or goes away, squeezed out once they are a quarter of
+ *     the index. A document's symbols are contiguous in 'syms'; names and
+ *     scopes are NUL-terminated strings in the 'names' pool (offset 0 is
+ *     the empty string).
+ *   - 'order' holds the live symbol numbers sorted by name (ASCII
+ *     case-folded, then exact), path and line. A sync sorts only the
+ *     symbols it added and merges them in, dropping those of dead
+ *     documents on the way: O(n) per sync, no re-sort.
+ *   - Extraction runs on umi_parallel_for workers in chunks; each worker
+ *     keeps its token array and string scratch across files.
+ *   - Parsing, per file:
+ *     1. Lex everything (skipping "#if 0"), then strip the directives:
+ *        #define names become macros, #else/#elif branches are dropped
+ *        up to their #endif, everything else goes.
+ *     2. Walk the remaining tokens with a stack of brace levels (file,
+ *        namespace, class, enum). Function bodies and initializers are
+ *        skipped whole, so nothing inside them is looked at. A statement
+ *        keeps just enough state to name typedefs ("typedef ... name;",
+ *        "(*name)(...)").
+ *
+ * SNAPSHOT (native endianness, local cache):
+ *   SyHeader, SySnapDoc[n_docs], SySym[n_syms], guint32 order[n_syms],
+ *   names pool, strings (relative paths, then the canonical root). Saved
+ *   compacted: symbol and document numbers are dense.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <string.h>
+#include <glib/gstdio.h>
+#include "symbol_index.h"
+#include "c_lexer.h"
+#include "quick_open.h"
+#include "file_meta.h"
+#include "file_io.h"
+#include "parallel_for.h"
+
+#define SY_MAX_FILE   (8u << 20)  /* larger files are not parsed             */
+#define SY_CHUNK      1024u       /* files extracted per parallel round      */
+#define SY_NO_DOC     G_MAXUINT32
+#define SY_MAGIC      "UMSY"
+#define SY_VERSION    1u
+
+enum {
+  DOC_DEAD = 1 << 0               /* tombstone                               */
+};
+
+typedef struct SyDoc {
+  guint32 file_id;                /* UMI_INDEX_NO_FILE until resolved        */
+  guint32 flags;
+  gint64  size;
+  gint64  mtime_us;
+  char   *rel;                    /* root-relative path (owned)              */
+  guint32 first;                  /* symbols [first, first + n)              */
+  guint32 n;
+} SyDoc;
+
+typedef struct SySym {
+  guint32 name;                   /* offsets into 'names'                    */
+  guint32 scope;
+  guint32 doc;
+  guint32 line;
+  guint32 column;
+  guint32 kind;                   /* UmiSymbolKind                           */
+} SySym;
+
+struct _UmiSymbolIndex {
+  UmiFileIndex *idx;
+  GArray       *docs;             /* SyDoc by document number                */
+  GHashTable   *by_path;          /* rel (doc->rel) -> doc + 1, live only    */
+  GArray       *syms;             /* SySym by symbol number                  */
+  GByteArray   *names;
+  GArray       *order;            /* guint32: live symbols, sorted           */
+  GHashTable   *dirty;            /* canonical absolute paths                */
+  guint         n_live;
+  guint         n_dead;
+  gboolean      reorder;          /* 'order' lacks new or keeps dead symbols */
+  guint64       synced_gen;       /* 0: resolve every document again         */
+  gboolean      verify;           /* loaded: stat-check documents on sync    */
+};
+
+#define DOC_AT(s, d)  (&g_array_index((s)->docs, SyDoc, (d)))
+#define SYM_AT(s, i)  (&g_array_index((s)->syms, SySym, (i)))
+#define NAME_AT(s, o) ((const char *)(s)->names->data + (o))
+
+static const char *const kind_names[] = {
+  "function", "struct", "union", "class", "enum", "enumerator", "typedef", "macro"
+};
+
+const char *umi_symbol_kind_name(UmiSymbolKind kind) {
+  return (guint)kind < G_N_ELEMENTS(kind_names) ? kind_names[kind] : "symbol";
+}
+
+gboolean umi_symbol_index_is_source(const char *path) {
+  static const char *const exts[] = {
+    "c", "h", "cc", "cp", "cpp", "cxx", "c++", "hh", "hpp", "hxx", "h++",
+    "inl", "ipp", "tcc", "ixx", "cppm", NULL
+  };
+  if (!path) return FALSE;
+  const char *dot = strrchr(path, '.');
+  if (!dot || strchr(dot, '/') || strchr(dot, G_DIR_SEPARATOR)) return FALSE;
+  for (guint i = 0; exts[i]; ++i)
+    if (!g_ascii_strcasecmp(dot + 1, exts[i])) return TRUE;
+  return FALSE;
+}
+
+/*---------------------------------------------------------------------------
+ * Parser
+ *---------------------------------------------------------------------------*/
+enum { SC_FILE, SC_NAMESPACE, SC_CLASS, SC_ENUM };
+
+typedef struct SyStmt {
+  gboolean typedef_;              /* inside "typedef ... ;"                  */
+  gboolean assign;                /* past a '=': no definitions follow       */
+  gboolean expect;                /* enum body: next name is an enumerator   */
+  gint     last;                  /* token of the last plain identifier      */
+  gint     fp;                    /* token of a "(*name)" declarator         */
+} SyStmt;
+
+typedef struct SyLevel {
+  guint8   kind;                  /* SC_*                                    */
+  gboolean fresh;                 /* the statement ends with the block       */
+  gsize    scope_len;             /* 'scope' before this level               */
+  SyStmt   outer;                 /* statement the block is part of          */
+} SyLevel;
+
+typedef struct SyParse {
+  const char      *src;
+  const UmiCToken *tk;
+  guint            n;
+  GArray          *levels;        /* SyLevel                                 */
+  GString         *scope;         /* "ns::Class" of the current level        */
+  SyStmt           st;
+  GArray          *out;           /* SySym, offsets into 'pool'              */
+  GString         *pool;          /* starts with the empty string            */
+  GString         *tmp;
+} SyParse;
+
+static inline gboolean is(const SyParse *p, guint i, const char *text) {
+  return i < p->n && umi_ctok_is(p->src, &p->tk[i], text);
+}
+
+static inline gboolean is_ident(const SyParse *p, guint i) {
+  return i < p->n && p->tk[i].kind == UMI_CTOK_IDENT;
+}
+
+static gboolean is_one_of(const SyParse *p, guint i, const char *const *words) {
+  for (guint k = 0; words[k]; ++k)
+    if (is(p, i, words[k])) return TRUE;
+  return FALSE;
+}
+
+/* Keywords that take a parenthesized operand and never name a function. */
+static const char *const call_keywords[] = {
+  "if", "for", "while", "switch", "return", "sizeof", "alignof", "_Alignof", "alignas",
+  "_Alignas", "decltype", "typeof", "__typeof__", "__attribute__", "__declspec",
+  "static_assert", "_Static_assert", "__asm__", "asm", "__asm", "noexcept", "throw",
+  "catch", "new", "delete", "requires", "defined", "_Generic", NULL
+};
+
+/* Allowed between a parameter list and the body. */
+static const char *const fn_qualifiers[] = {
+  "const", "volatile", "noexcept", "override", "final", "throw", "mutable", "constexpr",
+  "__attribute__", "__declspec", "__THROW", NULL
+};
+
+/* All-caps names (G_GNUC_CONST, EXPORT) are taken for attribute macros. */
+static gboolean is_macro_name(const SyParse *p, guint i) {
+  const UmiCToken *t = &p->tk[i];
+  if (t->len < 2) return FALSE;
+  gboolean alpha = FALSE;
+  for (guint32 k = 0; k < t->len; ++k) {
+    const char c = p->src[t->off + k];
+    if (g_ascii_islower(c)) return FALSE;
+    alpha |= g_ascii_isupper(c);
+  }
+  return alpha;
+}
+
+static void stmt_reset(SyStmt *st) {
+  memset(st, 0, sizeof *st);
+  st->last = st->fp = -1;
+}
+
+static guint8 top(const SyParse *p) {
+  return p->levels->len ? g_array_index(p->levels, SyLevel, p->levels->len - 1).kind : SC_FILE;
+}
+
+static void push(SyParse *p, guint8 kind, gboolean fresh, const char *name, gsize len) {
+  SyLevel lv = { kind, fresh, p->scope->len, p->st };
+  g_array_append_val(p->levels, lv);
+  if (len) {
+    if (p->scope->len) g_string_append(p->scope, "::");
+    g_string_append_len(p->scope, name, (gssize)len);
+  }
+  stmt_reset(&p->st);
+  p->st.expect = kind == SC_ENUM;
+}
+
+static void pop(SyParse *p) {
+  if (!p->levels->len) return;                        /* stray '}' */
+  const SyLevel *lv = &g_array_index(p->levels, SyLevel, p->levels->len - 1);
+  g_string_truncate(p->scope, lv->scope_len);
+  if (lv->fresh) stmt_reset(&p->st);
+  else p->st = lv->outer;
+  g_array_set_size(p->levels, p->levels->len - 1);
+}
+
+static void emit(SyParse *p, UmiSymbolKind kind, const char *name, gsize len,
+                 const UmiCToken *at, const char *qual, gsize qlen) {
+  if (!len) return;
+  SySym y = { (guint32)p->pool->len, 0, 0, at->line, at->column, kind };
+  g_string_append_len(p->pool, name, (gssize)len);
+  g_string_append_c(p->pool, '\0');
+  if (p->scope->len || qlen) {
+    y.scope = (guint32)p->pool->len;
+    g_string_append_len(p->pool, p->scope->str, (gssize)p->scope->len);
+    if (p->scope->len && qlen) g_string_append(p->pool, "::");
+    g_string_append_len(p->pool, qual, (gssize)qlen);
+    g_string_append_c(p->pool, '\0');
+  }
+  g_array_append_val(p->out, y);
+}
+
+static void emit_tok(SyParse *p, UmiSymbolKind kind, guint i) {
+  emit(p, kind, p->src + p->tk[i].off, p->tk[i].len, &p->tk[i], NULL, 0);
+}
+
+/* Index just past the group opening at 'i' ('(', '[' or '{'). */
+static guint skip_group(const SyParse *p, guint i) {
+  const char open  = p->src[p->tk[i].off];
+  const char close = open == '(' ? ')' : (open == '[' ? ']' : '}');
+  guint depth = 0;
+  for (; i < p->n; ++i) {
+    const UmiCToken *t = &p->tk[i];
+    if (t->kind != UMI_CTOK_PUNCT || t->len != 1) continue;
+    const char c = p->src[t->off];
+    if (c == open) depth++;
+    else if (c == close && --depth == 0) return i + 1;
+  }
+  return p->n;
+}
+
+/* Past template arguments opening at 'i'; stops early at ';', '{', '}'. */
+static guint skip_angle(const SyParse *p, guint i) {
+  gint depth = 0;
+  while (i < p->n) {
+    if (is(p, i, "(") || is(p, i, "[")) { i = skip_group(p, i); continue; }
+    if (is(p, i, ";") || is(p, i, "{") || is(p, i, "}")) return i;
+    if (is(p, i, "<")) depth++;
+    else if (is(p, i, ">")) depth--;
+    else if (is(p, i, ">>")) depth -= 2;
+    ++i;
+    if (depth <= 0) return i;
+  }
+  return i;
+}
+
+/* Step 1: drop the directives, keeping #define names. Returns the number
+ * of code tokens left at the front of 'tk'. */
+static guint strip_directives(SyParse *p, UmiCToken *tk, guint n) {
+  guint w = 0, drop = 0;                              /* drop: #if depth in a dropped branch */
+  for (guint i = 0; i < n; ) {
+    if (!(tk[i].flags & UMI_CTOK_PP)) {
+      if (!drop) tk[w++] = tk[i];
+      ++i;
+      continue;
+    }
+    guint e = i + 1;
+    while (e < n && (tk[e].flags & UMI_CTOK_PP) && !(tk[e].flags & UMI_CTOK_BOL)) ++e;
+    p->tk = tk;
+    p->n  = e;
+    if (is_ident(p, i + 1)) {
+      if (is(p, i + 1, "if") || is(p, i + 1, "ifdef") || is(p, i + 1, "ifndef")) {
+        if (drop) drop++;
+      } else if (is(p, i + 1, "endif")) {
+        if (drop) drop--;
+      } else if (is(p, i + 1, "else") || is(p, i + 1, "elif") ||
+                 is(p, i + 1, "elifdef") || is(p, i + 1, "elifndef")) {
+        if (!drop) drop = 1;
+      } else if (!drop && is(p, i + 1, "define") && is_ident(p, i + 2)) {
+        emit_tok(p, UMI_SYMBOL_MACRO, i + 2);
+      }
+    }
+    i = e;
+  }
+  return w;
+}
+
+/* Is there a function body after the parameter list opening at 'open'?
+ * Returns the index of its '{', or 0. */
+static guint init_list(const SyParse *p, guint k);
+
+static guint function_body(const SyParse *p, guint open) {
+  guint k = skip_group(p, open);
+  while (k < p->n) {
+    if (is(p, k, "{")) return k;
+    if (is(p, k, "try") && is(p, k + 1, "{")) return k + 1;
+    if (is(p, k, ":")) return init_list(p, k + 1);
+    if (is(p, k, "[")) { k = skip_group(p, k); continue; }
+    if (is(p, k, "&") || is(p, k, "&&")) { k++; continue; }
+    if (is(p, k, "->")) {                               /* trailing return type */
+      for (++k; k < p->n && !is(p, k, "{") && !is(p, k, ";") && !is(p, k, "="); )
+        k = (is(p, k, "(") || is(p, k, "[")) ? skip_group(p, k) : k + 1;
+      continue;
+    }
+    if (is_ident(p, k) && (is_one_of(p, k, fn_qualifiers) || is_macro_name(p, k))) {
+      k = is(p, k + 1, "(") ? skip_group(p, k + 1) : k + 1;
+      continue;
+    }
+    return 0;                                           /* ';', '=', K&R, ... */
+  }
+  return 0;
+}
+
+/* Constructor initializers "a(1), b{2}, Base<T>(x)" up to the body. */
+static guint init_list(const SyParse *p, guint k) {
+  for (;;) {
+    while (is_ident(p, k) || is(p, k, "::") || is(p, k, "<"))
+      k = is(p, k, "<") ? skip_angle(p, k) : k + 1;
+    if (!is(p, k, "(") && !is(p, k, "{")) return 0;
+    k = skip_group(p, k);
+    if (is(p, k, "...")) k++;
+    if (is(p, k, ",")) { k++; continue; }
+    return is(p, k, "{") ? k : 0;
+  }
+}
+
+/* Emit the function whose name spans tokens [first, last] ("~Foo" and
+ * "operator==" take several), with "A::B::" qualifiers before it. */
+static void emit_function(SyParse *p, guint first, guint last) {
+  g_string_truncate(p->tmp, 0);
+  for (guint k = first; k <= last; ++k) {
+    if (k > first && is_ident(p, k) && is_ident(p, k - 1)) g_string_append_c(p->tmp, ' ');
+    g_string_append_len(p->tmp, p->src + p->tk[k].off, p->tk[k].len);
+  }
+  /* Qualifiers, innermost first; template arguments ("Box<int>::") are
+   * stepped over and left out. */
+  guint quals[16], nq = 0, q = first;
+  while (nq < G_N_ELEMENTS(quals) && q >= 2 && is(p, q - 1, "::")) {
+    guint k = q - 2;
+    if (is(p, k, ">")) {
+      gint depth = 0;
+      for (;; --k) {
+        depth += is(p, k, ">") ? 1 : (is(p, k, "<") ? -1 : 0);
+        if (!depth || !k) break;
+      }
+      if (depth || !k) break;
+      --k;
+    }
+    if (!is_ident(p, k)) break;
+    quals[nq++] = k;
+    q = k;
+  }
+  const gsize nlen = p->tmp->len;
+  while (nq--) {
+    g_string_append_len(p->tmp, p->src + p->tk[quals[nq]].off, p->tk[quals[nq]].len);
+    if (nq) g_string_append(p->tmp, "::");
+  }
+  char *name = g_strndup(p->tmp->str, nlen);
+  emit(p, UMI_SYMBOL_FUNCTION, name, nlen, &p->tk[first], p->tmp->str + nlen, p->tmp->len - nlen);
+  g_free(name);
+}
+
+static void typedef_name(SyParse *p) {
+  const gint i = p->st.fp >= 0 ? p->st.fp : p->st.last;
+  if (i >= 0) emit_tok(p, UMI_SYMBOL_TYPEDEF, (guint)i);
+  p->st.last = p->st.fp = -1;
+}
+
+/* "struct|union|class|enum [attrs] [name] [: bases] {". */
+static guint record_step(SyParse *p, guint i) {
+  const UmiSymbolKind kind = is(p, i, "struct") ? UMI_SYMBOL_STRUCT
+                           : is(p, i, "union")  ? UMI_SYMBOL_UNION
+                           : is(p, i, "class")  ? UMI_SYMBOL_CLASS : UMI_SYMBOL_ENUM;
+  guint k = i + 1;
+  if (kind == UMI_SYMBOL_ENUM && (is(p, k, "class") || is(p, k, "struct"))) k++;
+  gint name = -1;
+  while (k < p->n) {
+    if (is_ident(p, k)) {
+      if (is(p, k + 1, "(") && is_one_of(p, k, call_keywords)) { k = skip_group(p, k + 1); continue; }
+      if (is(p, k, "final")) { k++; continue; }
+      /* "struct foo bar(...)": 'bar' is not ours, unless 'foo' was a macro */
+      if (name >= 0 && (guint)name == k - 1 && !is_macro_name(p, (guint)name)) break;
+      name = (gint)k++;
+    } else if (is(p, k, "::")) {
+      k++;
+    } else if (is(p, k, "[")) {
+      k = skip_group(p, k);
+    } else if (is(p, k, "<") && name >= 0) {
+      k = skip_angle(p, k);
+    } else {
+      break;
+    }
+  }
+  if (is(p, k, ":")) {                                  /* bases / underlying type */
+    guint j = k + 1;
+    while (j < p->n && !is(p, j, "{") && !is(p, j, ";") && !is(p, j, "(") && !is(p, j, ")"))
+      j = is(p, j, "<") ? skip_angle(p, j) : j + 1;
+    if (is(p, j, "{")) k = j;
+  }
+  if (!is(p, k, "{")) {                                 /* "struct x *p", "struct x;" */
+    if (name >= 0) p->st.last = name;
+    return k;
+  }
+  const UmiCToken *t = name >= 0 ? &p->tk[name] : NULL;
+  if (t) emit_tok(p, kind, (guint)name);
+  push(p, kind == UMI_SYMBOL_ENUM ? SC_ENUM : SC_CLASS, FALSE,
+       t ? p->src + t->off : NULL, t ? t->len : 0);
+  return k + 1;
+}
+
+static guint enum_step(SyParse *p, guint i) {
+  if (is(p, i, "}")) { pop(p); return i + 1; }
+  if (is(p, i, ",")) { p->st.expect = TRUE; return i + 1; }
+  if (is(p, i, "(") || is(p, i, "[") || is(p, i, "{")) return skip_group(p, i);
+  if (p->st.expect && is_ident(p, i) &&
+      (is(p, i + 1, "=") || is(p, i + 1, ",") || is(p, i + 1, "}") || is(p, i + 1, "[") ||
+       is_ident(p, i + 1))) {
+    emit_tok(p, UMI_SYMBOL_ENUMERATOR, i);
+    p->st.expect = FALSE;
+  }
+  return i + 1;
+}
+
+static guint ident_step(SyParse *p, guint i) {
+  if (is(p, i, "typedef")) { p->st.typedef_ = TRUE; return i + 1; }
+  if (is(p, i, "struct") || is(p, i, "union") || is(p, i, "class") || is(p, i, "enum"))
+    return record_step(p, i);
+  if (is(p, i, "namespace")) {
+    guint k = i + 1;
+    while (is_ident(p, k) || is(p, k, "::")) k++;
+    if (!is(p, k, "{")) return k;                       /* alias */
+    const UmiCToken *a = &p->tk[i + 1], *b = &p->tk[k - 1];
+    push(p, SC_NAMESPACE, TRUE, p->src + a->off, k > i + 1 ? b->off + b->len - a->off : 0);
+    return k + 1;
+  }
+  if (is(p, i, "extern") && i + 2 < p->n && p->tk[i + 1].kind == UMI_CTOK_STRING && is(p, i + 2, "{")) {
+    push(p, SC_NAMESPACE, TRUE, NULL, 0);               /* extern "C" { */
+    return i + 3;
+  }
+  if (is(p, i, "template")) return is(p, i + 1, "<") ? skip_angle(p, i + 1) : i + 1;
+  if (is(p, i, "using")) {
+    if (!is_ident(p, i + 1) || !is(p, i + 2, "=")) return i + 1;
+    emit_tok(p, UMI_SYMBOL_TYPEDEF, i + 1);
+    guint k = i + 3;
+    while (k < p->n && !is(p, k, ";")) k = (is(p, k, "(") || is(p, k, "{")) ? skip_group(p, k) : k + 1;
+    return k;
+  }
+  if (is_one_of(p, i, call_keywords)) return is(p, i + 1, "(") ? skip_group(p, i + 1) : i + 1;
+
+  const gboolean can_define = !p->st.typedef_ && !p->st.assign;
+  if (is(p, i, "operator")) {
+    guint j = i + 1;
+    if (is(p, j, "(") && is(p, j + 1, ")")) j += 2;     /* operator() */
+    while (j < p->n && j < i + 4 && !is(p, j, "(")) j++;
+    const guint body = can_define && is(p, j, "(") ? function_body(p, j) : 0;
+    if (!body) return i + 1;
+    emit_function(p, i, j - 1);
+    stmt_reset(&p->st);
+    return skip_group(p, body);
+  }
+  if (can_define && is(p, i + 1, "(")) {
+    const guint body = function_body(p, i + 1);
+    if (body) {
+      const gboolean dtor = i > 0 && is(p, i - 1, "~") && p->tk[i - 1].off + 1 == p->tk[i].off;
+      emit_function(p, dtor ? i - 1 : i, i);
+      stmt_reset(&p->st);
+      return skip_group(p, body);
+    }
+  }
+  p->st.last = (gint)i;
+  return i + 1;
+}
+
+static guint paren_step(SyParse *p, guint i) {
+  const guint end = skip_group(p, i);
+  /* "typedef ret (*name)(args)", "(CALLCONV *name)", "(*name[4])" */
+  if (p->st.typedef_ && p->st.fp < 0 && (is(p, end, "(") || is(p, end, "["))) {
+    for (guint k = i + 1; k <= i + 2 && k + 1 < end; ++k)
+      if ((is(p, k, "*") || is(p, k, "^") || is(p, k, "&")) && is_ident(p, k + 1)) {
+        p->st.fp = (gint)(k + 1);
+        break;
+      }
+  }
+  return end;
+}
+
+/* Step 2: the definitions among the code tokens. */
+static void parse(SyParse *p) {
+  guint i = 0;
+  while (i < p->n) {
+    if (top(p) == SC_ENUM) { i = enum_step(p, i); continue; }
+    const UmiCToken *t = &p->tk[i];
+    if (t->kind == UMI_CTOK_IDENT) { i = ident_step(p, i); continue; }
+    if (t->kind != UMI_CTOK_PUNCT || t->len != 1) { i++; continue; }
+    switch (p->src[t->off]) {
+      case '(': i = paren_step(p, i); break;
+      case '[': i = skip_group(p, i); break;
+      case '{': i = skip_group(p, i); break;            /* initializer, unknown block */
+      case '}': pop(p); i++; break;
+      case '=': p->st.assign = TRUE; i++; break;
+      case ',':
+        if (p->st.typedef_) typedef_name(p);
+        i++;
+        break;
+      case ';':
+        if (p->st.typedef_) typedef_name(p);
+        stmt_reset(&p->st);
+        i++;
+        break;
+      default: i++; break;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------
+ * Documents
+ *---------------------------------------------------------------------------*/
+static void kill_doc(UmiSymbolIndex *s, guint32 d) {
+  SyDoc *doc = DOC_AT(s, d);
+  if (doc->flags & DOC_DEAD) return;
+  g_hash_table_remove(s->by_path, doc->rel);
+  doc->flags |= DOC_DEAD;
+  s->n_dead++;
+  s->n_live--;
+  if (doc->n) s->reorder = TRUE;
+}
+
+static guint32 doc_for(const UmiSymbolIndex *s, const char *rel) {
+  const gpointer v = g_hash_table_lookup(s->by_path, rel);
+  return v ? GPOINTER_TO_UINT(v) - 1 : SY_NO_DOC;
+}
+
+static guint32 add_doc(UmiSymbolIndex *s, guint32 file_id, char *rel, gint64 size,
+                       gint64 mtime_us, guint32 n_syms) {
+  SyDoc doc = { file_id, 0, size, mtime_us, rel, s->syms->len, n_syms };
+  g_array_append_val(s->docs, doc);
+  const guint32 d = s->docs->len - 1;
+  g_hash_table_insert(s->by_path, rel, GUINT_TO_POINTER(d + 1));
+  s->n_live++;
+  return d;
+}
+
+static const char *rel_of(const UmiSymbolIndex *s, const char *abs) {
+  const char *root = umi_index_root(s->idx);
+  const gsize rl = strlen(root);
+  if (strncmp(abs, root, rl) != 0 || abs[rl] != G_DIR_SEPARATOR) return NULL;
+  return abs + rl + 1;
+}
+
+/* Sort order of symbols: name (folded, then exact), path, line. */
+static gint cmp_sym(gconstpointer a, gconstpointer b, gpointer user) {
+  const UmiSymbolIndex *s = user;
+  const SySym *x = SYM_AT(s, *(const guint32 *)a), *y = SYM_AT(s, *(const guint32 *)b);
+  const char *nx = NAME_AT(s, x->name), *ny = NAME_AT(s, y->name);
+  gint r = g_ascii_strcasecmp(nx, ny);
+  if (!r) r = strcmp(nx, ny);
+  if (!r && x->doc != y->doc) r = strcmp(DOC_AT(s, x->doc)->rel, DOC_AT(s, y->doc)->rel);
+  if (!r) r = x->line < y->line ? -1 : (x->line > y->line ? 1 : 0);
+  return r;
+}
+
+/* Merge symbols [first_new, len) into 'order', dropping dead ones. */
+static void merge_order(UmiSymbolIndex *s, guint32 first_new) {
+  GArray *fresh = g_array_sized_new(FALSE, FALSE, sizeof(guint32), s->syms->len - first_new);
+  for (guint32 i = first_new; i < s->syms->len; ++i)
+    if (!(DOC_AT(s, SYM_AT(s, i)->doc)->flags & DOC_DEAD)) g_array_append_val(fresh, i);
+  g_array_sort_with_data(fresh, cmp_sym, s);
+
+  GArray *order = g_array_sized_new(FALSE, FALSE, sizeof(guint32), s->order->len + fresh->len);
+  const guint32 *a = (const guint32 *)(const void *)s->order->data;
+  const guint32 *b = (const guint32 *)(const void *)fresh->data;
+  guint ia = 0, ib = 0;
+  while (ia < s->order->len || ib < fresh->len) {
+    if (ia < s->order->len && (DOC_AT(s, SYM_AT(s, a[ia])->doc)->flags & DOC_DEAD)) { ia++; continue; }
+    if (ib >= fresh->len || (ia < s->order->len && cmp_sym(&a[ia], &b[ib], s) <= 0))
+      g_array_append_val(order, a[ia++]);
+    else
+      g_array_append_val(order, b[ib++]);
+  }
+  g_array_free(fresh, TRUE);
+  g_array_free(s->order, TRUE);
+  s->order   = order;
+  s->reorder = FALSE;
+}
+
+/*---------------------------------------------------------------------------
+ * Extraction (parallel)
+ *---------------------------------------------------------------------------*/
+typedef struct SyExtract {
+  guint32  file_id;
+  gint64   size;
+  gint64   mtime_us;
+  char    *rel;                   /* NULL: file vanished, skip               */
+  SySym   *syms;                  /* offsets into 'pool'                     */
+  guint    n_syms;
+  char    *pool;
+  gsize    pool_len;
+} SyExtract;
+
+typedef struct SyWorker {
+  GArray  *toks;                  /* UmiCToken scratch                       */
+  SyParse  p;
+} SyWorker;
+
+typedef struct SyExtractRun {
+  UmiSymbolIndex *s;
+  const guint32  *ids;
+  SyExtract      *out;
+  SyWorker       *workers;
+} SyExtractRun;
+
+static void parse_text(SyWorker *w, const char *src, gsize len) {
+  SyParse *p = &w->p;
+  g_array_set_size(w->toks, 0);
+  g_array_set_size(p->levels, 0);
+  g_array_set_size(p->out, 0);
+  g_string_truncate(p->scope, 0);
+  g_string_truncate(p->pool, 0);
+  g_string_append_c(p->pool, '\0');
+  stmt_reset(&p->st);
+  p->src = src;
+
+  UmiCLexer lx;
+  UmiCToken t;
+  umi_c_lexer_init(&lx, src, len, UMI_CLEX_SKIP_IF0);
+  while (umi_c_lexer_next(&lx, &t)) g_array_append_val(w->toks, t);
+  UmiCToken *tk = (UmiCToken *)(void *)w->toks->data;
+  const guint n = strip_directives(p, tk, w->toks->len);
+  p->tk = tk;
+  p->n  = n;
+  parse(p);
+}
+
+static void extract_one(UmiSymbolIndex *s, SyWorker *w, guint32 file_id, SyExtract *ex) {
+  ex->file_id = file_id;
+  UmiFileStat st;
+  char *path = umi_index_file_path(s->idx, file_id);
+  if (!path || !umi_file_meta_stat(umi_index_meta(s->idx), file_id, &st)) {
+    g_free(path);
+    return;
+  }
+  const char *rel = rel_of(s, path);
+  if (!rel) { g_free(path); return; }
+  ex->rel      = g_strdup(rel);
+  ex->size     = st.size;
+  ex->mtime_us = st.mtime_us;
+
+  if (st.kind != UMI_FILE_KIND_BINARY && st.size <= (gint64)SY_MAX_FILE) {
+    GMappedFile *mf = g_mapped_file_new(path, FALSE, NULL);
+    const char *src = mf ? g_mapped_file_get_contents(mf) : NULL;
+    const gsize n   = mf ? g_mapped_file_get_length(mf) : 0;
+    if (n && !memchr(src, '\0', MIN(n, (gsize)8000))) {
+      parse_text(w, src, n);
+      if (w->p.out->len) {
+        ex->n_syms   = w->p.out->len;
+        ex->syms     = g_memdup2(w->p.out->data, (gsize)ex->n_syms * sizeof(SySym));
+        ex->pool_len = w->p.pool->len;
+        ex->pool     = g_memdup2(w->p.pool->str, ex->pool_len);
+      }
+    }
+    if (mf) g_mapped_file_unref(mf);
+  }
+  g_free(path);
+}
+
+static void extract_range(guint b, guint e, guint worker, gpointer user) {
+  SyExtractRun *r = user;
+  SyWorker     *w = &r->workers[worker];
+  if (!w->toks) {
+    w->toks     = g_array_sized_new(FALSE, FALSE, sizeof(UmiCToken), 1 << 14);
+    w->p.levels = g_array_new(FALSE, FALSE, sizeof(SyLevel));
+    w->p.out    = g_array_new(FALSE, FALSE, sizeof(SySym));
+    w->p.scope  = g_string_new(NULL);
+    w->p.pool   = g_string_new(NULL);
+    w->p.tmp    = g_string_new(NULL);
+  }
+  for (guint i = b; i < e; ++i) extract_one(r->s, w, r->ids[i], &r->out[i]);
+}
+
+static void worker_clear(SyWorker *w) {
+  if (!w->toks) return;
+  g_array_free(w->toks, TRUE);
+  g_array_free(w->p.levels, TRUE);
+  g_array_free(w->p.out, TRUE);
+  g_string_free(w->p.scope, TRUE);
+  g_string_free(w->p.pool, TRUE);
+  g_string_free(w->p.tmp, TRUE);
+}
+
+/* Index the files in 'ids' as new documents. */
+static void add_files(UmiSymbolIndex *s, const GArray *ids) {
+  if (ids->len == 0) return;
+  const guint nw = umi_parallel_workers();
+  SyWorker *workers = g_new0(SyWorker, nw);
+
+  for (guint base = 0; base < ids->len; base += SY_CHUNK) {
+    const guint n = MIN(SY_CHUNK, ids->len - base);
+    SyExtract *ex = g_new0(SyExtract, n);
+    SyExtractRun run = { s, (const guint32 *)(const void *)ids->data + base, ex, workers };
+    umi_parallel_for(n, 4, extract_range, &run);
+
+    for (guint i = 0; i < n; ++i) {
+      if (!ex[i].rel) continue;
+      const guint32 old = doc_for(s, ex[i].rel);
+      if (old != SY_NO_DOC) kill_doc(s, old);
+      const guint32 d = add_doc(s, ex[i].file_id, ex[i].rel, ex[i].size, ex[i].mtime_us, ex[i].n_syms);
+      const guint32 at = s->names->len;
+      g_byte_array_append(s->names, (const guint8 *)ex[i].pool, (guint)ex[i].pool_len);
+      for (guint k = 0; k < ex[i].n_syms; ++k) {
+        SySym y = ex[i].syms[k];
+        y.name += at;
+        y.scope = y.scope ? y.scope + at : 0;
+        y.doc   = d;
+        g_array_append_val(s->syms, y);
+      }
+      if (ex[i].n_syms) s->reorder = TRUE;
+      g_free(ex[i].syms);
+      g_free(ex[i].pool);
+    }
+    g_free(ex);
+  }
+
+  for (guint i = 0; i < nw; ++i) worker_clear(&workers[i]);
+  g_free(workers);
+}
+
+/*---------------------------------------------------------------------------
+ * Compaction: drop tombstones and their symbols, renumber densely. 'order'
+ * must be free of dead symbols (merge first); it keeps its order.
+ *---------------------------------------------------------------------------*/
+static void compact(UmiSymbolIndex *s) {
+  if (s->n_dead == 0) return;
+  guint32    *remap = g_new(guint32, MAX(s->syms->len, 1u));
+  GArray     *docs  = g_array_sized_new(FALSE, FALSE, sizeof(SyDoc), s->n_live);
+  GArray     *syms  = g_array_sized_new(FALSE, FALSE, sizeof(SySym), s->order->len);
+  GByteArray *names = g_byte_array_new();
+  g_byte_array_append(names, (const guint8 *)"", 1);
+  for (guint d = 0; d < s->docs->len; ++d) {
+    SyDoc *doc = DOC_AT(s, d);
+    if (doc->flags & DOC_DEAD) {
+      g_free(doc->rel);
+      continue;
+    }
+    const guint32 first = syms->len;
+    for (guint32 k = doc->first; k < doc->first + doc->n; ++k) {
+      SySym y = *SYM_AT(s, k);
+      remap[k] = syms->len;
+      y.doc    = docs->len;
+      const char *nm = NAME_AT(s, y.name), *sc = NAME_AT(s, y.scope);
+      y.name = names->len;
+      g_byte_array_append(names, (const guint8 *)nm, (guint)strlen(nm) + 1);
+      if (*sc) {
+        y.scope = names->len;
+        g_byte_array_append(names, (const guint8 *)sc, (guint)strlen(sc) + 1);
+      }
+      g_array_append_val(syms, y);
+    }
+    doc->first = first;
+    g_array_append_val(docs, *doc);
+  }
+  for (guint i = 0; i < s->order->len; ++i)
+    g_array_index(s->order, guint32, i) = remap[g_array_index(s->order, guint32, i)];
+  g_array_free(s->docs, TRUE);
+  g_array_free(s->syms, TRUE);
+  g_byte_array_free(s->names, TRUE);
+  s->docs  = docs;
+  s->syms  = syms;
+  s->names = names;
+  g_hash_table_remove_all(s->by_path);
+  for (guint d = 0; d < docs->len; ++d)
+    g_hash_table_insert(s->by_path, DOC_AT(s, d)->rel, GUINT_TO_POINTER(d + 1));
+  g_free(remap);
+  s->n_dead = 0;
+}
+
+/*---------------------------------------------------------------------------
+ * Lifecycle
+ *---------------------------------------------------------------------------*/
+UmiSymbolIndex *umi_symbol_index_new(UmiFileIndex *idx) {
+  g_return_val_if_fail(idx != NULL, NULL);
+  UmiSymbolIndex *s = g_new0(UmiSymbolIndex, 1);
+  s->idx     = idx;
+  s->docs    = g_array_new(FALSE, FALSE, sizeof(SyDoc));
+  s->by_path = g_hash_table_new(g_str_hash, g_str_equal);
+  s->syms    = g_array_new(FALSE, FALSE, sizeof(SySym));
+  s->names   = g_byte_array_new();
+  s->order   = g_array_new(FALSE, FALSE, sizeof(guint32));
+  s->dirty   = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  g_byte_array_append(s->names, (const guint8 *)"", 1);
+  return s;
+}
+
+void umi_symbol_index_free(UmiSymbolIndex *s) {
+  if (!s) return;
+  for (guint d = 0; d < s->docs->len; ++d) g_free(DOC_AT(s, d)->rel);
+  g_array_free(s->docs, TRUE);
+  g_hash_table_destroy(s->by_path);
+  g_array_free(s->syms, TRUE);
+  g_byte_array_free(s->names, TRUE);
+  g_array_free(s->order, TRUE);
+  g_hash_table_destroy(s->dirty);
+  g_free(s);
+}
+
+void umi_symbol_index_mark_dirty(UmiSymbolIndex *s, const char *path) {
+  if (!s || !path || !*path) return;
+  g_hash_table_add(s->dirty, g_canonicalize_filename(path, NULL));
+}
+
+static gint cmp_u32(gconstpointer a, gconstpointer b) {
+  const guint32 x = *(const guint32 *)a, y = *(const guint32 *)b;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+guint umi_symbol_index_sync(UmiSymbolIndex *s) {
+  g_return_val_if_fail(s != NULL, 0);
+  const guint64 gen = umi_index_generation(s->idx);
+  if (gen == s->synced_gen && g_hash_table_size(s->dirty) == 0 && !s->reorder) return 0;
+
+  GArray *todo = g_array_new(FALSE, FALSE, sizeof(guint32));
+  UmiFileMeta *meta = umi_index_meta(s->idx);
+
+  /* File set moved (or ids were renumbered): match documents by path. */
+  if (gen != s->synced_gen) {
+    guint8 *seen = g_new0(guint8, MAX(s->docs->len, 1u));
+    UmiIndexIter it;
+    umi_index_iter_init(&it, s->idx);
+    while (umi_index_iter_next(&it)) {
+      const char *path = umi_index_iter_path(&it);
+      if (!umi_symbol_index_is_source(path)) continue;
+      const char   *rel = rel_of(s, path);
+      const guint32 d   = rel ? doc_for(s, rel) : SY_NO_DOC;
+      if (d == SY_NO_DOC) {
+        g_array_append_val(todo, it.id);
+        continue;
+      }
+      SyDoc *doc = DOC_AT(s, d);
+      doc->file_id = it.id;
+      seen[d] = 1;
+      if (s->verify) {                                 /* changed while closed? */
+        UmiFileStat st;
+        if (!umi_file_meta_stat(meta, it.id, &st) ||
+            st.size != doc->size || st.mtime_us != doc->mtime_us)
+          g_array_append_val(todo, it.id);
+      }
+    }
+    umi_index_iter_clear(&it);
+    for (guint d = 0; d < s->docs->len; ++d)
+      if (!seen[d] && !(DOC_AT(s, d)->flags & DOC_DEAD)) kill_doc(s, d);
+    g_free(seen);
+    s->synced_gen = gen;
+    s->verify     = FALSE;
+  }
+
+  /* Content changes reported by the watcher. */
+  GHashTableIter hi;
+  gpointer key;
+  g_hash_table_iter_init(&hi, s->dirty);
+  while (g_hash_table_iter_next(&hi, &key, NULL)) {
+    const char *rel = rel_of(s, key);
+    if (!rel || !umi_symbol_index_is_source(rel)) continue;
+    const guint32 d = doc_for(s, rel);
+    if (d != SY_NO_DOC) kill_doc(s, d);
+    const guint32 id = umi_index_lookup(s->idx, key);
+    if (id != UMI_INDEX_NO_FILE) g_array_append_val(todo, id);
+  }
+  g_hash_table_remove_all(s->dirty);
+
+  g_array_sort(todo, cmp_u32);
+  guint n = 0;
+  for (guint i = 0; i < todo->len; ++i)                /* dedup */
+    if (n == 0 || g_array_index(todo, guint32, n - 1) != g_array_index(todo, guint32, i))
+      g_array_index(todo, guint32, n++) = g_array_index(todo, guint32, i);
+  g_array_set_size(todo, n);
+
+  const guint32 first_new = s->syms->len;
+  add_files(s, todo);
+  if (s->reorder) merge_order(s, first_new);
+  if (s->n_dead > 1024 && s->n_dead * 4 > s->docs->len) compact(s);
+  g_array_free(todo, TRUE);
+  return n;
+}
+
+guint umi_symbol_index_n_files(const UmiSymbolIndex *s) {
+  return s ? s->n_live : 0;
+}
+
+guint umi_symbol_index_n_symbols(const UmiSymbolIndex *s) {
+  return s ? s->order->len : 0;
+}
+
+/*---------------------------------------------------------------------------
+ * Lookup
+ *---------------------------------------------------------------------------*/
+static void fill(const UmiSymbolIndex *s, guint32 i, UmiSymbol *o) {
+  const SySym *y = SYM_AT(s, i);
+  const SyDoc *d = DOC_AT(s, y->doc);
+  o->name    = NAME_AT(s, y->name);
+  o->scope   = NAME_AT(s, y->scope);
+  o->path    = d->rel;
+  o->file_id = d->file_id;
+  o->line    = y->line;
+  o->column  = y->column;
+  o->kind    = (UmiSymbolKind)y->kind;
+}
+
+static inline const char *order_name(const UmiSymbolIndex *s, guint pos) {
+  return NAME_AT(s, SYM_AT(s, g_array_index(s->order, guint32, pos))->name);
+}
+
+/* First position whose name is not below 'key': exact order when 'plen'
+ * is 0, else case-folded comparison of the first 'plen' bytes. */
+static guint lower_bound(const UmiSymbolIndex *s, const char *key, gsize plen) {
+  guint lo = 0, hi = s->order->len;
+  while (lo < hi) {
+    const guint mid = lo + (hi - lo) / 2;
+    const char *nm = order_name(s, mid);
+    gint r;
+    if (plen) {
+      r = g_ascii_strncasecmp(nm, key, plen);
+    } else {
+      r = g_ascii_strcasecmp(nm, key);
+      if (!r) r = strcmp(nm, key);
+    }
+    if (r < 0) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+guint umi_symbol_index_lookup(UmiSymbolIndex *s, const char *name, GArray *out) {
+  g_return_val_if_fail(s != NULL && out != NULL, 0);
+  g_array_set_size(out, 0);
+  umi_symbol_index_sync(s);
+  if (!name || !*name) return 0;
+  for (guint pos = lower_bound(s, name, 0); pos < s->order->len; ++pos) {
+    if (strcmp(order_name(s, pos), name) != 0) break;
+    UmiSymbol o;
+    fill(s, g_array_index(s->order, guint32, pos), &o);
+    g_array_append_val(out, o);
+  }
+  return out->len;
+}
+
+typedef struct SyRank {
+  guint32 pos;                    /* in 'order'                              */
+  gint    score;
+} SyRank;
+
+static gint cmp_rank(gconstpointer a, gconstpointer b) {
+  const SyRank *x = a, *y = b;
+  if (x->score != y->score) return x->score > y->score ? -1 : 1;
+  return x->pos < y->pos ? -1 : (x->pos > y->pos ? 1 : 0);
+}
+
+static void take(const UmiSymbolIndex *s, GArray *ranks, guint max, GArray *out) {
+  g_array_sort(ranks, cmp_rank);
+  for (guint i = 0; i < ranks->len && out->len < max; ++i) {
+    UmiSymbol o;
+    fill(s, g_array_index(s->order, guint32, g_array_index(ranks, SyRank, i).pos), &o);
+    g_array_append_val(out, o);
+  }
+}
+
+guint umi_symbol_index_query(UmiSymbolIndex *s, const char *query, guint max, GArray *out) {
+  g_return_val_if_fail(s != NULL && out != NULL, 0);
+  g_array_set_size(out, 0);
+  umi_symbol_index_sync(s);
+  if (!query) return 0;
+  if (*query == '@') query++;
+  while (*query == ' ') query++;
+  const gsize qlen = strlen(query);
+  if (!qlen || !max) return 0;
+
+  /* Names starting with the query: exact ones, then shorter, then sorted. */
+  const guint lo = lower_bound(s, query, qlen);
+  guint hi = lo;
+  GArray *ranks = g_array_new(FALSE, FALSE, sizeof(SyRank));
+  for (; hi < s->order->len; ++hi) {
+    const char *nm = order_name(s, hi);
+    if (g_ascii_strncasecmp(nm, query, qlen) != 0) break;
+    const gsize len = strlen(nm);
+    SyRank r = { hi, (len == qlen ? 1 << 20 : 0) + (strncmp(nm, query, qlen) ? 0 : 1 << 19) -
+                     (gint)MIN(len, (gsize)(1 << 18)) };
+    g_array_append_val(ranks, r);
+  }
+  take(s, ranks, max, out);
+
+  /* Then fuzzy matches elsewhere. */
+  if (out->len < max) {
+    g_array_set_size(ranks, 0);
+    for (guint pos = 0; pos < s->order->len; ++pos) {
+      if (pos == lo && hi > lo) { pos = hi - 1; continue; }   /* listed above */
+      const gint sc = umi_quick_open_score(query, order_name(s, pos));
+      if (sc == UMI_QUICK_OPEN_NO_MATCH) continue;
+      SyRank r = { pos, sc };
+      g_array_append_val(ranks, r);
+    }
+    take(s, ranks, max, out);
+  }
+  g_array_free(ranks, TRUE);
+  return out->len;
+}
+
+/*---------------------------------------------------------------------------
+ * Snapshot
+ *---------------------------------------------------------------------------*/
+typedef struct SyHeader {
+  char    magic[4];
+  guint32 version;
+  guint32 n_docs;
+  guint32 n_syms;
+  guint32 names_len;
+  guint32 strings_len;
+  guint32 root_off;
+  guint32 reserved;
+} SyHeader;
+
+typedef struct SySnapDoc {
+  gint64  size;
+  gint64  mtime_us;
+  guint32 path_off;
+  guint32 n_syms;
+} SySnapDoc;
+
+gboolean umi_symbol_index_save(UmiSymbolIndex *s, const char *snapshot_path, GError **err) {
+  g_return_val_if_fail(s != NULL && snapshot_path != NULL, FALSE);
+  if (s->reorder) merge_order(s, s->syms->len);
+  compact(s);
+
+  GByteArray *strings = g_byte_array_new();
+  GArray     *sdocs   = g_array_sized_new(FALSE, FALSE, sizeof(SySnapDoc), s->docs->len);
+  for (guint d = 0; d < s->docs->len; ++d) {
+    const SyDoc *doc = DOC_AT(s, d);
+    SySnapDoc sd = { doc->size, doc->mtime_us, strings->len, doc->n };
+    g_byte_array_append(strings, (const guint8 *)doc->rel, (guint)strlen(doc->rel) + 1);
+    g_array_append_val(sdocs, sd);
+  }
+  const char *root = umi_index_root(s->idx);
+  const guint32 root_off = strings->len;
+  g_byte_array_append(strings, (const guint8 *)root, (guint)strlen(root) + 1);
+
+  SyHeader h;
+  memset(&h, 0, sizeof h);
+  memcpy(h.magic, SY_MAGIC, 4);
+  h.version     = SY_VERSION;
+  h.n_docs      = sdocs->len;
+  h.n_syms      = s->syms->len;
+  h.names_len   = s->names->len;
+  h.strings_len = strings->len;
+  h.root_off    = root_off;
+
+  GByteArray *out = g_byte_array_new();
+  g_byte_array_append(out, (const guint8 *)&h, sizeof h);
+  g_byte_array_append(out, (const guint8 *)sdocs->data, sdocs->len * (guint)sizeof(SySnapDoc));
+  g_byte_array_append(out, (const guint8 *)s->syms->data, s->syms->len * (guint)sizeof(SySym));
+  g_byte_array_append(out, (const guint8 *)s->order->data, s->order->len * (guint)sizeof(guint32));
+  g_byte_array_append(out, s->names->data, s->names->len);
+  g_byte_array_append(out, strings->data, strings->len);
+
+  char *parent = g_path_get_dirname(snapshot_path);
+  g_mkdir_with_parents(parent, 0755);
+  g_free(parent);
+  const gboolean ok = umi_file_save_atomic(snapshot_path, (const char *)out->data, out->len, err);
+
+  g_byte_array_free(out, TRUE);
+  g_byte_array_free(strings, TRUE);
+  g_array_free(sdocs, TRUE);
+  return ok;
+}
+
+static gboolean load(UmiSymbolIndex *s, const char *data, gsize len) {
+  SyHeader h;
+  if (len < sizeof h) return FALSE;
+  memcpy(&h, data, sizeof h);
+  if (memcmp(h.magic, SY_MAGIC, 4) != 0 || h.version != SY_VERSION) return FALSE;
+  const guint64 need = sizeof h + (guint64)h.n_docs * sizeof(SySnapDoc) +
+                       (guint64)h.n_syms * (sizeof(SySym) + sizeof(guint32)) +
+                       h.names_len + h.strings_len;
+  if (need != len || h.strings_len == 0 || h.root_off >= h.strings_len || h.names_len == 0)
+    return FALSE;
+
+  const SySnapDoc *sdocs   = (const SySnapDoc *)(const void *)(data + sizeof h);
+  const SySym     *syms    = (const SySym *)(const void *)(sdocs + h.n_docs);
+  const guint32   *order   = (const guint32 *)(const void *)(syms + h.n_syms);
+  const char      *names   = (const char *)(order + h.n_syms);
+  const char      *strings = names + h.names_len;
+  if (names[0] != '\0' || names[h.names_len - 1] != '\0') return FALSE;
+  if (strings[h.strings_len - 1] != '\0') return FALSE;
+  if (h.root_off > 0 && strings[h.root_off - 1] != '\0') return FALSE;
+  if (g_strcmp0(strings + h.root_off, umi_index_root(s->idx)) != 0) return FALSE;
+  guint64 total = 0;
+  for (guint32 i = 0; i < h.n_docs; ++i) {
+    if (sdocs[i].path_off >= h.root_off) return FALSE;
+    total += sdocs[i].n_syms;
+  }
+  if (total != h.n_syms) return FALSE;
+  for (guint32 d = 0, i = 0; d < h.n_docs; ++d)
+    for (guint32 k = 0; k < sdocs[d].n_syms; ++k, ++i)
+      if (syms[i].doc != d || syms[i].name >= h.names_len || syms[i].scope >= h.names_len)
+        return FALSE;
+  for (guint32 i = 0; i < h.n_syms; ++i)
+    if (order[i] >= h.n_syms) return FALSE;
+
+  for (guint32 d = 0; d < h.n_docs; ++d) {
+    add_doc(s, UMI_INDEX_NO_FILE, g_strdup(strings + sdocs[d].path_off),
+            sdocs[d].size, sdocs[d].mtime_us, sdocs[d].n_syms);
+    g_array_append_vals(s->syms, syms + DOC_AT(s, d)->first, sdocs[d].n_syms);
+  }
+  g_array_append_vals(s->order, order, h.n_syms);
+  g_byte_array_set_size(s->names, 0);
+  g_byte_array_append(s->names, (const guint8 *)names, h.names_len);
+  return TRUE;
+}
+
+UmiSymbolIndex *umi_symbol_index_open(UmiFileIndex *idx, const char *snapshot_path) {
+  UmiSymbolIndex *s = umi_symbol_index_new(idx);
+  if (!s || !snapshot_path) return s;
+  GMappedFile *mf = g_mapped_file_new(snapshot_path, FALSE, NULL);
+  if (!mf) return s;
+  if (load(s, g_mapped_file_get_contents(mf), g_mapped_file_get_length(mf))) {
+    s->synced_gen = 0;
+    s->verify     = TRUE;
+  } else {                                             /* stale or foreign  */
+    umi_symbol_index_free(s);
+    s = umi_symbol_index_new(idx);
+  }
+  g_mapped_file_unref(mf);
+  return s;
+}
+
+char *umi_symbol_index_snapshot_path_for(const char *root) {
+  if (!root || !*root) return NULL;
+  char *canon = g_canonicalize_filename(root, NULL);
+  char *key   = g_compute_checksum_for_string(G_CHECKSUM_SHA1, canon, -1);
+  char *leaf  = g_strconcat(key, ".sym", NULL);
+  char *path  = g_build_filename(g_get_user_cache_dir(), "umicom-studio-ide", "index", leaf, NULL);
+  g_free(leaf);
+  g_free(key);
+  g_free(canon);
+  return path;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,996 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/search/trigram_index.c
+ * PURPOSE: Trigram content index for in-process full-text search
+ *
+ * DESIGN:
+ *   - A document is one version of one file. Documents are numbered in the
+ *     order they are indexed; a changed file gets a new number and its old
+ *     document is tombstoned (DOC_DEAD), so every posting list stays sorted
+ *     by construction and is only ever appended to.
+ *   - Trigram code = three ASCII-lowercased bytes (24 bits). Trigrams that
+ *     span a line break are not indexed (queries never need them).
+ *   - Posting list = ascending document numbers, LEB128 varint deltas.
+ *     Intersection decodes the shortest list first and streams the others
+ *     against it.
+ *   - Extraction (read + trigram set) runs on umi_parallel_for workers, in
+ *     chunks; each worker dedups with its own 2 MiB bitmap. Appending to the
+ *     posting lists happens on the calling thread, in document order.
+ *   - Documents are matched to index files by root-relative path, so the
+ *     index survives umi_index_refresh()/open() renumbering file ids.
+ *
+ * SNAPSHOT (native endianness, local cache):
+ *   TgHeader, TgSnapDoc[n_docs], TgSnapPost[n_posts], posting bytes,
+ *   strings (relative paths, then the canonical root). Saved compacted, so
+ *   document numbers are dense.
+ *
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <string.h>
+#include <glib/gstdio.h>
+#include "trigram_index.h"
+#include "file_meta.h"
+#include "file_io.h"
+#include "parallel_for.h"
+
+#define TG_MAX_FILE   (8u << 20)  /* larger files: searched, not indexed     */
+#define TG_MAX_LINE   1024u       /* hit text cap                            */
+#define TG_CHUNK      2048u       /* files extracted per parallel round      */
+#define TG_BITMAP     ((1u << 24) / 8u)
+#define TG_NO_DOC     G_MAXUINT32
+#define TG_MAGIC      "UMTG"
+#define TG_VERSION    1u
+
+enum {
+  DOC_DEAD      = 1 << 0,         /* tombstone                               */
+  DOC_UNINDEXED = 1 << 1,         /* too big: no postings, always verified   */
+  DOC_BINARY    = 1 << 2          /* never searched                          */
+};
+
+typedef struct TgDoc {
+  guint32 file_id;                /* for synced_gen; UMI_INDEX_NO_FILE if    */
+  guint32 flags;                  /*   not resolved yet                      */
+  gint64  size;
+  gint64  mtime_us;
+  char   *rel;                    /* root-relative path (owned)              */
+} TgDoc;
+
+typedef struct TgPost {
+  GByteArray *data;               /* varint deltas, first entry absolute     */
+  guint32     n;
+  guint32     last;
+} TgPost;
+
+struct _UmiTrigramIndex {
+  UmiFileIndex *idx;
+  GArray       *docs;             /* TgDoc by document number                */
+  GHashTable   *by_path;          /* rel (doc->rel) -> doc + 1, live only    */
+  GHashTable   *posts;            /* code -> TgPost*                         */
+  GHashTable   *dirty;            /* canonical absolute paths                */
+  guint         n_live;
+  guint         n_dead;
+  guint64       synced_gen;       /* 0: resolve every document again         */
+  gboolean      verify;           /* loaded: stat-check documents on sync    */
+};
+
+#define DOC_AT(t, d) (&g_array_index((t)->docs, TgDoc, (d)))
+
+/*---------------------------------------------------------------------------
+ * Varints and posting lists
+ *---------------------------------------------------------------------------*/
+static void put_varint(GByteArray *b, guint32 v) {
+  guint8 tmp[5];
+  guint  n = 0;
+  while (v >= 0x80) { tmp[n++] = (guint8)(v | 0x80); v >>= 7; }
+  tmp[n++] = (guint8)v;
+  g_byte_array_append(b, tmp, n);
+}
+
+static inline const guint8 *get_varint(const guint8 *p, const guint8 *end, guint32 *out) {
+  guint32 v = 0;
+  for (guint shift = 0; p < end && shift < 35; shift += 7) {
+    const guint8 c = *p++;
+    v |= (guint32)(c & 0x7f) << shift;
+    if (!(c & 0x80)) { *out = v; return p; }
+  }
+  return NULL;                                        /* truncated/corrupt */
+}
+
+static void post_free(gpointer p) {
+  TgPost *pl = p;
+  g_byte_array_free(pl->data, TRUE);
+  g_free(pl);
+}
+
+static void post_append(TgPost *pl, guint32 doc) {
+  put_varint(pl->data, pl->n ? doc - pl->last : doc);
+  pl->last = doc;
+  pl->n++;
+}
+
+/* Decode a whole list into 'out' (appended). */
+static void post_decode(const TgPost *pl, GArray *out) {
+  const guint8 *p = pl->data->data, *end = p + pl->data->len;
+  guint32 cur = 0;
+  for (guint32 i = 0; i < pl->n && p; ++i) {
+    guint32 d;
+    if (!(p = get_varint(p, end, &d))) break;
+    cur = i ? cur + d : d;
+    g_array_append_val(out, cur);
+  }
+}
+
+/* Keep the entries of 'acc' (ascending) that are also in 'pl'. */
+static void post_intersect(const TgPost *pl, GArray *acc) {
+  const guint8 *p = pl->data->data, *end = p + pl->data->len;
+  guint32 cur = 0, left = pl->n;
+  guint   keep = 0;
+  gboolean have = FALSE;
+  for (guint i = 0; i < acc->len; ++i) {
+    const guint32 want = g_array_index(acc, guint32, i);
+    while ((!have || cur < want) && left > 0) {
+      guint32 d;
+      if (!(p = get_varint(p, end, &d))) { left = 0; break; }
+      cur = have ? cur + d : d;
+      have = TRUE;
+      --left;
+    }
+    if (have && cur == want) g_array_index(acc, guint32, keep++) = want;
+    else if (left == 0 && (!have || cur < want)) break;
+  }
+  g_array_set_size(acc, keep);
+}
+
+/* g_ascii_tolower() works on gchar: bytes >= 0x80 come back negative and
+ * must be narrowed again, or the code leaves the 24-bit space. */
+static inline guint32 gram_code(guchar a, guchar b, guchar c) {
+  return ((guint32)(guchar)g_ascii_tolower(a) << 16) | ((guint32)(guchar)g_ascii_tolower(b) << 8) |
+         (guint32)(guchar)g_ascii_tolower(c);
+}
+
+static inline gboolean is_eol(guchar c) { return c == '\n' || c == '\r'; }
+
+/*---------------------------------------------------------------------------
+ * Documents
+ *---------------------------------------------------------------------------*/
+static void kill_doc(UmiTrigramIndex *t, guint32 d) {
+  TgDoc *doc = DOC_AT(t, d);
+  if (doc->flags & DOC_DEAD) return;
+  g_hash_table_remove(t->by_path, doc->rel);
+  doc->flags |= DOC_DEAD;
+  t->n_dead++;
+  t->n_live--;
+}
+
+static guint32 doc_for(const UmiTrigramIndex *t, const char *rel) {
+  const gpointer v = g_hash_table_lookup(t->by_path, rel);
+  return v ? GPOINTER_TO_UINT(v) - 1 : TG_NO_DOC;
+}
+
+static guint32 add_doc(UmiTrigramIndex *t, guint32 file_id, char *rel, gint64 size,
+                       gint64 mtime_us, guint32 flags) {
+  TgDoc doc = { file_id, flags, size, mtime_us, rel };
+  g_array_append_val(t->docs, doc);
+  const guint32 d = t->docs->len - 1;
+  g_hash_table_insert(t->by_path, rel, GUINT_TO_POINTER(d + 1));
+  t->n_live++;
+  return d;
+}
+
+static const char *rel_of(const UmiTrigramIndex *t, const char *abs) {
+  const char *root = umi_index_root(t->idx);
+  const gsize rl = strlen(root);
+  if (strncmp(abs, root, rl) != 0 || abs[rl] != G_DIR_SEPARATOR) return NULL;
+  return abs + rl + 1;
+}
+
+/*---------------------------------------------------------------------------
+ * Extraction (parallel)
+ *---------------------------------------------------------------------------*/
+typedef struct TgExtract {
+  guint32  file_id;
+  guint32  flags;
+  gint64   size;
+  gint64   mtime_us;
+  char    *rel;                   /* NULL: file vanished, skip               */
+  guint32 *codes;
+  guint    n_codes;
+} TgExtract;
+
+typedef struct TgWorker {
+  guint8 *seen;                   /* TG_BITMAP bytes, all clear between files */
+  GArray *codes;                  /* guint32 scratch                          */
+} TgWorker;
+
+typedef struct TgExtractRun {
+  UmiTrigramIndex *t;
+  const guint32   *ids;
+  TgExtract       *out;
+  TgWorker        *workers;
+} TgExtractRun;
+
+static void extract_one(UmiTrigramIndex *t, TgWorker *w, guint32 file_id, TgExtract *ex) {
+  ex->file_id = file_id;
+  UmiFileStat st;
+  char *path = umi_index_file_path(t->idx, file_id);
+  if (!path || !umi_file_meta_stat(umi_index_meta(t->idx), file_id, &st)) {
+    g_free(path);
+    return;
+  }
+  const char *rel = rel_of(t, path);
+  if (!rel) { g_free(path); return; }
+  ex->rel      = g_strdup(rel);
+  ex->size     = st.size;
+  ex->mtime_us = st.mtime_us;
+
+  if (st.kind == UMI_FILE_KIND_BINARY) {
+    ex->flags = DOC_BINARY;
+  } else if (st.size > (gint64)TG_MAX_FILE) {
+    ex->flags = umi_file_meta_kind(umi_index_meta(t->idx), file_id) == UMI_FILE_KIND_BINARY
+                  ? DOC_BINARY : DOC_UNINDEXED;
+  } else {
+    GMappedFile *mf = g_mapped_file_new(path, FALSE, NULL);
+    const guchar *s = mf ? (const guchar *)g_mapped_file_get_contents(mf) : NULL;
+    const gsize   n = mf ? g_mapped_file_get_length(mf) : 0;
+    if (n && memchr(s, '\0', MIN(n, (gsize)8000))) {
+      ex->flags = DOC_BINARY;                          /* same rule as meta  */
+    } else if (n >= 3) {
+      g_array_set_size(w->codes, 0);
+      for (gsize i = 0; i + 2 < n; ++i) {
+        if (is_eol(s[i + 2])) { i += 2; continue; }    /* skip past the EOL  */
+        if (is_eol(s[i + 1])) { i += 1; continue; }
+        if (is_eol(s[i])) continue;
+        const guint32 c = gram_code(s[i], s[i + 1], s[i + 2]);
+        const guint8  bit = (guint8)(1u << (c & 7));
+        if (w->seen[c >> 3] & bit) continue;
+        w->seen[c >> 3] |= bit;
+        g_array_append_val(w->codes, c);
+      }
+      for (guint k = 0; k < w->codes->len; ++k) {
+        const guint32 c = g_array_index(w->codes, guint32, k);
+        w->seen[c >> 3] = 0;                           /* cheap reset        */
+      }
+      ex->n_codes = w->codes->len;
+      ex->codes   = g_memdup2(w->codes->data, (gsize)w->codes->len * sizeof(guint32));
+    }
+    if (mf) g_mapped_file_unref(mf);
+  }
+  g_free(path);
+}
+
+static void extract_range(guint b, guint e, guint worker, gpointer user) {
+  TgExtractRun *r = user;
+  TgWorker     *w = &r->workers[worker];
+  if (!w->seen) {
+    w->seen  = g_malloc0(TG_BITMAP);
+    w->codes = g_array_sized_new(FALSE, FALSE, sizeof(guint32), 4096);
+  }
+  for (guint i = b; i < e; ++i) extract_one(r->t, w, r->ids[i], &r->out[i]);
+}
+
+/* Index the files in 'ids' (ascending) as new documents. */
+static void add_files(UmiTrigramIndex *t, const GArray *ids) {
+  if (ids->len == 0) return;
+  const guint nw = umi_parallel_workers();
+  TgWorker *workers = g_new0(TgWorker, nw);
+
+  for (guint base = 0; base < ids->len; base += TG_CHUNK) {
+    const guint n = MIN(TG_CHUNK, ids->len - base);
+    TgExtract *ex = g_new0(TgExtract, n);
+    TgExtractRun run = { t, (const guint32 *)(const void *)ids->data + base, ex, workers };
+    umi_parallel_for(n, 8, extract_range, &run);
+
+    for (guint i = 0; i < n; ++i) {
+      if (!ex[i].rel) continue;
+      const guint32 old = doc_for(t, ex[i].rel);
+      if (old != TG_NO_DOC) kill_doc(t, old);
+      const guint32 d = add_doc(t, ex[i].file_id, ex[i].rel, ex[i].size,
+                                ex[i].mtime_us, ex[i].flags);
+      for (guint k = 0; k < ex[i].n_codes; ++k) {
+        const guint32 c = ex[i].codes[k];
+        TgPost *pl = g_hash_table_lookup(t->posts, GUINT_TO_POINTER(c));
+        if (!pl) {
+          pl = g_new0(TgPost, 1);
+          pl->data = g_byte_array_new();
+          g_hash_table_insert(t->posts, GUINT_TO_POINTER(c), pl);
+        }
+        post_append(pl, d);
+      }
+      g_free(ex[i].codes);
+    }
+    g_free(ex);
+  }
+
+  for (guint i = 0; i < nw; ++i) {
+    g_free(workers[i].seen);
+    if (workers[i].codes) g_array_free(workers[i].codes, TRUE);
+  }
+  g_free(workers);
+}
+
+/*---------------------------------------------------------------------------
+ * Compaction: drop tombstones, renumber densely (order is preserved, so
+ * every list stays ascending).
+ *---------------------------------------------------------------------------*/
+static void compact(UmiTrigramIndex *t) {
+  if (t->n_dead == 0) return;
+  guint32 *remap = g_new(guint32, MAX(t->docs->len, 1u));
+  GArray  *docs  = g_array_sized_new(FALSE, FALSE, sizeof(TgDoc), t->n_live);
+  for (guint d = 0; d < t->docs->len; ++d) {
+    TgDoc *doc = DOC_AT(t, d);
+    if (doc->flags & DOC_DEAD) {
+      remap[d] = TG_NO_DOC;
+      g_free(doc->rel);
+      continue;
+    }
+    remap[d] = docs->len;
+    g_array_append_val(docs, *doc);
+  }
+  g_array_free(t->docs, TRUE);
+  t->docs = docs;
+  g_hash_table_remove_all(t->by_path);
+  for (guint d = 0; d < docs->len; ++d)
+    g_hash_table_insert(t->by_path, DOC_AT(t, d)->rel, GUINT_TO_POINTER(d + 1));
+
+  GArray *tmp = g_array_new(FALSE, FALSE, sizeof(guint32));
+  GHashTableIter it;
+  gpointer key, val;
+  g_hash_table_iter_init(&it, t->posts);
+  while (g_hash_table_iter_next(&it, &key, &val)) {
+    TgPost *pl = val;
+    g_array_set_size(tmp, 0);
+    post_decode(pl, tmp);
+    g_byte_array_set_size(pl->data, 0);
+    pl->n = 0;
+    for (guint i = 0; i < tmp->len; ++i) {
+      const guint32 nd = remap[g_array_index(tmp, guint32, i)];
+      if (nd != TG_NO_DOC) post_append(pl, nd);
+    }
+    if (pl->n == 0) g_hash_table_iter_remove(&it);
+  }
+  g_array_free(tmp, TRUE);
+  g_free(remap);
+  t->n_dead = 0;
+}
+
+static void maybe_compact(UmiTrigramIndex *t) {
+  if (t->n_dead > 1024 && t->n_dead * 4 > t->docs->len) compact(t);
+}
+
+/*---------------------------------------------------------------------------
+ * Lifecycle
+ *---------------------------------------------------------------------------*/
+UmiTrigramIndex *umi_trigram_index_new(UmiFileIndex *idx) {
+  g_return_val_if_fail(idx != NULL, NULL);
+  UmiTrigramIndex *t = g_new0(UmiTrigramIndex, 1);
+  t->idx     = idx;
+  t->docs    = g_array_new(FALSE, FALSE, sizeof(TgDoc));
+  t->by_path = g_hash_table_new(g_str_hash, g_str_equal);
+  t->posts   = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, post_free);
+  t->dirty   = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  return t;
+}
+
+void umi_trigram_index_free(UmiTrigramIndex *t) {
+  if (!t) return;
+  for (guint d = 0; d < t->docs->len; ++d) g_free(DOC_AT(t, d)->rel);
+  g_array_free(t->docs, TRUE);
+  g_hash_table_destroy(t->by_path);
+  g_hash_table_destroy(t->posts);
+  g_hash_table_destroy(t->dirty);
+  g_free(t);
+}
+
+void umi_trigram_index_mark_dirty(UmiTrigramIndex *t, const char *path) {
+  if (!t || !path || !*path) return;
+  g_hash_table_add(t->dirty, g_canonicalize_filename(path, NULL));
+}
+
+static gint cmp_u32(gconstpointer a, gconstpointer b) {
+  const guint32 x = *(const guint32 *)a, y = *(const guint32 *)b;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+guint umi_trigram_index_sync(UmiTrigramIndex *t) {
+  g_return_val_if_fail(t != NULL, 0);
+  GArray *todo = g_array_new(FALSE, FALSE, sizeof(guint32));
+  UmiFileMeta *meta = umi_index_meta(t->idx);
+
+  /* File set moved (or ids were renumbered): match documents by path. */
+  const guint64 gen = umi_index_generation(t->idx);
+  if (gen != t->synced_gen) {
+    guint8 *seen = g_new0(guint8, MAX(t->docs->len, 1u));
+    UmiIndexIter it;
+    umi_index_iter_init(&it, t->idx);
+    while (umi_index_iter_next(&it)) {
+      const char   *rel = rel_of(t, umi_index_iter_path(&it));
+      const guint32 d   = rel ? doc_for(t, rel) : TG_NO_DOC;
+      if (d == TG_NO_DOC) {
+        g_array_append_val(todo, it.id);
+        continue;
+      }
+      TgDoc *doc = DOC_AT(t, d);
+      doc->file_id = it.id;
+      seen[d] = 1;
+      if (t->verify) {                                 /* changed while closed? */
+        UmiFileStat st;
+        if (!umi_file_meta_stat(meta, it.id, &st) ||
+            st.size != doc->size || st.mtime_us != doc->mtime_us)
+          g_array_append_val(todo, it.id);
+      }
+    }
+    umi_index_iter_clear(&it);
+    for (guint d = 0; d < t->docs->len; ++d)
+      if (!seen[d] && !(DOC_AT(t, d)->flags & DOC_DEAD)) kill_doc(t, d);
+    g_free(seen);
+    t->synced_gen = gen;
+    t->verify     = FALSE;
+  }
+
+  /* Content changes reported by the watcher. */
+  GHashTableIter hi;
+  gpointer key;
+  g_hash_table_iter_init(&hi, t->dirty);
+  while (g_hash_table_iter_next(&hi, &key, NULL)) {
+    const char *rel = rel_of(t, key);
+    if (!rel) continue;
+    const guint32 d = doc_for(t, rel);
+    if (d != TG_NO_DOC) kill_doc(t, d);
+    const guint32 id = umi_index_lookup(t->idx, key);
+    if (id != UMI_INDEX_NO_FILE) g_array_append_val(todo, id);
+  }
+  g_hash_table_remove_all(t->dirty);
+
+  g_array_sort(todo, cmp_u32);
+  guint n = 0;
+  for (guint i = 0; i < todo->len; ++i)                /* dedup */
+    if (n == 0 || g_array_index(todo, guint32, n - 1) != g_array_index(todo, guint32, i))
+      g_array_index(todo, guint32, n++) = g_array_index(todo, guint32, i);
+  g_array_set_size(todo, n);
+
+  add_files(t, todo);
+  maybe_compact(t);
+  g_array_free(todo, TRUE);
+  return n;
+}
+
+guint umi_trigram_index_n_docs(const UmiTrigramIndex *t) {
+  return t ? t->n_live : 0;
+}
+
+guint umi_trigram_index_n_trigrams(const UmiTrigramIndex *t) {
+  return t ? g_hash_table_size(t->posts) : 0;
+}
+
+/*---------------------------------------------------------------------------
+ * Query planning: literal runs every match must contain
+ *---------------------------------------------------------------------------*/
+static void flush_run(GString *cur, GPtrArray *runs) {
+  if (cur->len >= 3) g_ptr_array_add(runs, g_strndup(cur->str, cur->len));
+  g_string_truncate(cur, 0);
+}
+
+/* Past a bracket expression starting at p ('['). */
+static const char *skip_class(const char *p) {
+  ++p;
+  if (*p == '^') ++p;
+  if (*p == ']') ++p;                                  /* literal ']' first  */
+  for (; *p && *p != ']'; ++p)
+    if (*p == '\\' && p[1]) ++p;
+  return *p ? p + 1 : p;
+}
+
+/* Past a group starting at p ('('), nested groups and classes included. */
+static const char *skip_group(const char *p) {
+  gint depth = 0;
+  while (*p) {
+    if (*p == '\\' && p[1]) { p += 2; continue; }
+    if (*p == '[') { p = skip_class(p); continue; }
+    if (*p == '(') ++depth;
+    else if (*p == ')' && --depth == 0) return p + 1;
+    ++p;
+  }
+  return p;
+}
+
+/* Past the argument of escape letter 'e' (p just after it): "\x41",
+ * "\x{263a}", "\012", "\cA", "\pL", "\k<name>", "\Q...\E" and the like.
+ * None of it is literal text of the run. */
+static const char *skip_escape_arg(const char *p, char e) {
+  const char *close = NULL;
+  if (*p == '{') close = "}";
+  else if (*p == '<' && (e == 'k' || e == 'g')) close = ">";
+  else if (*p == '\'' && (e == 'k' || e == 'g')) close = "'";
+  if (close && strchr("xoupPNgk", e)) {
+    const char *end = strchr(p + 1, *close);
+    return end ? end + 1 : p + strlen(p);
+  }
+  guint n = 0;
+  switch (e) {
+  case 'x': while (n < 2 && g_ascii_isxdigit(*p)) { ++p; ++n; } break;
+  case 'u': while (n < 4 && g_ascii_isxdigit(*p)) { ++p; ++n; } break;
+  case 'c': case 'p': case 'P': if (*p) ++p; break;
+  case 'g': if (*p == '-' || *p == '+') ++p; while (g_ascii_isdigit(*p)) ++p; break;
+  case 'Q': {
+    const char *end = strstr(p, "\\E");
+    return end ? end + 2 : p + strlen(p);
+  }
+  default:
+    if (e >= '0' && e <= '9') while (n < 2 && g_ascii_isdigit(*p)) { ++p; ++n; }
+    break;
+  }
+  return p;
+}
+
+/* Conservative: whatever is dropped only widens the candidate set. Groups,
+ * classes and escapes like \w or \x41 end a run; an optional atom ('?', '*',
+ * '{0,') is left out; top-level alternation and inline options ("(?x)")
+ * give up entirely. */
+static void regex_runs(const char *p, GPtrArray *runs) {
+  if (strstr(p, "(?")) return;
+  for (const char *q = p; *q; ) {                      /* top-level '|'?     */
+    if (*q == '\\' && q[1]) { q += 2; continue; }
+    if (*q == '[') { q = skip_class(q); continue; }
+    if (*q == '(') { q = skip_group(q); continue; }
+    if (*q == '|') return;
+    ++q;
+  }
+
+  GString *cur = g_string_new(NULL);
+  while (*p) {
+    gint lit = -1;
+    if (*p == '\\') {
+      if (!p[1]) break;
+      const char e = p[1];
+      p += 2;
+      if (e == 't') lit = '\t';
+      else if (!g_ascii_isalnum(e)) lit = (guchar)e;
+      else p = skip_escape_arg(p, e);                 /* ends the run       */
+    } else if (*p == '[') {
+      p = skip_class(p);
+    } else if (*p == '(') {
+      p = skip_group(p);
+    } else if (strchr(".^$|)*+?{", *p)) {
+      ++p;
+    } else {
+      lit = (guchar)*p++;
+    }
+
+    gboolean optional = FALSE, repeated = FALSE;
+    if (*p == '*' || *p == '?') {
+      optional = TRUE; ++p;
+    } else if (*p == '+') {
+      repeated = TRUE; ++p;
+    } else if (*p == '{') {
+      const char *e = strchr(p, '}');
+      if (e) { optional = (p[1] == '0' || p[1] == ','); repeated = TRUE; p = e + 1; }
+    }
+    if ((optional || repeated) && (*p == '?' || *p == '+')) ++p;   /* lazy etc. */
+
+    if (lit < 0 || optional) { flush_run(cur, runs); continue; }
+    g_string_append_c(cur, (char)lit);
+    if (repeated) flush_run(cur, runs);
+  }
+  flush_run(cur, runs);
+  g_string_free(cur, TRUE);
+}
+
+void umi_trigram_literal_runs(const char *pattern, UmiTrigramFlags flags, GPtrArray *runs) {
+  g_return_if_fail(pattern != NULL && runs != NULL);
+  if (flags & UMI_TRIGRAM_REGEX) regex_runs(pattern, runs);
+  else if (*pattern)             g_ptr_array_add(runs, g_strdup(pattern));
+}
+
+/* Distinct trigram codes of 'runs'. Caseless: bytes >= 0x80 fold in ways
+ * ASCII folding cannot follow, so grams containing them are skipped. */
+static void run_grams(GPtrArray *runs, gboolean caseless, GArray *codes) {
+  for (guint r = 0; r < runs->len; ++r) {
+    const guchar *s = runs->pdata[r];
+    const gsize n = strlen((const char *)s);
+    for (gsize i = 0; i + 2 < n; ++i) {
+      if (is_eol(s[i]) || is_eol(s[i + 1]) || is_eol(s[i + 2])) continue;
+      if (caseless && (s[i] >= 0x80 || s[i + 1] >= 0x80 || s[i + 2] >= 0x80)) continue;
+      const guint32 c = gram_code(s[i], s[i + 1], s[i + 2]);
+      gboolean dup = FALSE;
+      for (guint k = 0; k < codes->len && !dup; ++k) dup = g_array_index(codes, guint32, k) == c;
+      if (!dup) g_array_append_val(codes, c);
+    }
+  }
+}
+
+static gint cmp_post_len(gconstpointer a, gconstpointer b) {
+  const TgPost *x = *(TgPost * const *)a, *y = *(TgPost * const *)b;
+  return x->n < y->n ? -1 : (x->n > y->n ? 1 : 0);
+}
+
+/* Candidate documents, ascending. 'narrowed' (may be NULL): the pattern
+ * had trigrams, so not every document is a candidate by default. */
+static GArray *plan(UmiTrigramIndex *t, const char *pattern, UmiTrigramFlags flags,
+                    gboolean *narrowed) {
+  GPtrArray *runs = g_ptr_array_new_with_free_func(g_free);
+  umi_trigram_literal_runs(pattern, flags, runs);
+  GArray *codes = g_array_new(FALSE, FALSE, sizeof(guint32));
+  run_grams(runs, (flags & UMI_TRIGRAM_CASELESS) != 0, codes);
+  g_ptr_array_free(runs, TRUE);
+
+  GArray *cands = g_array_new(FALSE, FALSE, sizeof(guint32));
+  if (narrowed) *narrowed = codes->len > 0;
+  if (codes->len == 0) {                               /* nothing to narrow */
+    for (guint32 d = 0; d < t->docs->len; ++d) g_array_append_val(cands, d);
+  } else {
+    GPtrArray *lists = g_ptr_array_new();
+    gboolean missing = FALSE;
+    for (guint k = 0; k < codes->len && !missing; ++k) {
+      TgPost *pl = g_hash_table_lookup(t->posts, GUINT_TO_POINTER(g_array_index(codes, guint32, k)));
+      if (pl) g_ptr_array_add(lists, pl);
+      else    missing = TRUE;
+    }
+    if (!missing) {
+      g_ptr_array_sort(lists, cmp_post_len);
+      post_decode(lists->pdata[0], cands);
+      for (guint k = 1; k < lists->len && cands->len; ++k) post_intersect(lists->pdata[k], cands);
+    }
+    g_ptr_array_free(lists, TRUE);
+
+    /* Unindexed documents are candidates for every query. */
+    GArray *all = g_array_sized_new(FALSE, FALSE, sizeof(guint32), cands->len);
+    guint i = 0;
+    for (guint32 d = 0; d < t->docs->len; ++d) {
+      const gboolean listed = i < cands->len && g_array_index(cands, guint32, i) == d;
+      if (listed) ++i;
+      if (listed || (DOC_AT(t, d)->flags & DOC_UNINDEXED)) g_array_append_val(all, d);
+    }
+    g_array_free(cands, TRUE);
+    cands = all;
+  }
+  g_array_free(codes, TRUE);
+
+  guint keep = 0;
+  for (guint i = 0; i < cands->len; ++i) {
+    const guint32 d = g_array_index(cands, guint32, i);
+    if (!(DOC_AT(t, d)->flags & (DOC_DEAD | DOC_BINARY))) g_array_index(cands, guint32, keep++) = d;
+  }
+  g_array_set_size(cands, keep);
+  return cands;
+}
+
+/*---------------------------------------------------------------------------
+ * Verification (parallel)
+ *---------------------------------------------------------------------------*/
+typedef struct TgHit {
+  guint32       cand;             /* position in the sorted candidate list   */
+  UmiTrigramHit h;
+} TgHit;
+
+typedef struct TgSearch {
+  UmiTrigramIndex *t;
+  const guint32   *cands;
+  const char      *needle;
+  gsize            nlen;
+  gboolean         caseless;
+  GRegex          *re;
+  guint            max_hits;
+  GArray         **hits;          /* per worker TgHit                        */
+  gint             total;         /* atomic                                  */
+} TgSearch;
+
+static const guchar *find_literal(const guchar *h, gsize hl, const guchar *n, gsize nl,
+                                  gboolean caseless) {
+  if (nl == 0 || hl < nl) return NULL;
+  const guchar *end = h + hl - nl + 1;
+  if (!caseless) {
+    for (const guchar *p = h; p < end; ++p) {
+      p = memchr(p, n[0], (gsize)(end - p));
+      if (!p) return NULL;
+      if (memcmp(p, n, nl) == 0) return p;
+    }
+    return NULL;
+  }
+  const guchar lo = (guchar)g_ascii_tolower(n[0]), up = (guchar)g_ascii_toupper(n[0]);
+  for (const guchar *p = h; p < end; ++p) {
+    if (*p != lo && *p != up) continue;
+    gsize k = 1;
+    while (k < nl && g_ascii_tolower(p[k]) == g_ascii_tolower(n[k])) ++k;
+    if (k == nl) return p;
+  }
+  return NULL;
+}
+
+/* Record a match at [s, e) of 'data'; 'line'/'line_at' track the line of
+ * the previous match so counting newlines stays linear per file. */
+static void add_hit(TgSearch *r, GArray *out, guint cand, guint32 file_id,
+                    const guchar *data, gsize len, gsize s, gsize e,
+                    guint32 *line, gsize *line_at) {
+  for (gsize i = *line_at; i < s; ++i) if (data[i] == '\n') ++*line;
+  *line_at = s;
+  g_atomic_int_inc(&r->total);
+  if (out->len >= r->max_hits) return;
+
+  gsize bol = s;
+  while (bol > 0 && data[bol - 1] != '\n') --bol;
+  const guchar *nl = memchr(data + s, '\n', len - s);
+  gsize eol = nl ? (gsize)(nl - data) : len;
+  if (eol > bol && data[eol - 1] == '\r') --eol;
+  if (eol - bol > TG_MAX_LINE) eol = bol + TG_MAX_LINE;
+
+  TgHit hit;
+  hit.cand     = cand;
+  hit.h.file_id = file_id;
+  hit.h.line   = *line;
+  hit.h.column = (guint32)(s - bol) + 1;
+  hit.h.length = (guint32)(e - s);
+  hit.h.text   = g_strndup((const char *)data + bol, eol > bol ? eol - bol : 0);
+  g_array_append_val(out, hit);
+}
+
+static void verify_range(guint b, guint e, guint worker, gpointer user) {
+  TgSearch *r   = user;
+  GArray   *out = r->hits[worker];
+  for (guint i = b; i < e; ++i) {
+    const TgDoc *doc = DOC_AT(r->t, r->cands[i]);
+    char *path = umi_index_file_path(r->t->idx, doc->file_id);
+    GMappedFile *mf = path ? g_mapped_file_new(path, FALSE, NULL) : NULL;
+    g_free(path);
+    if (!mf) continue;
+    const guchar *data = (const guchar *)g_mapped_file_get_contents(mf);
+    const gsize   len  = g_mapped_file_get_length(mf);
+    guint32 line = 1;
+    gsize   line_at = 0;
+
+    if (len == 0) {
+      /* nothing to match */
+    } else if (r->re) {
+      GMatchInfo *mi = NULL;
+      g_regex_match_full(r->re, (const char *)data, (gssize)len, 0, 0, &mi, NULL);
+      while (g_match_info_matches(mi)) {
+        gint s = 0, en = 0;
+        if (g_match_info_fetch_pos(mi, 0, &s, &en) && s >= 0)
+          add_hit(r, out, i, doc->file_id, data, len, (gsize)s, (gsize)en, &line, &line_at);
+        if (!g_match_info_next(mi, NULL)) break;
+      }
+      g_match_info_free(mi);
+    } else {
+      const guchar *p = data, *end = data + len;
+      const guchar *m;
+      while ((m = find_literal(p, (gsize)(end - p), (const guchar *)r->needle, r->nlen, r->caseless))) {
+        const gsize s = (gsize)(m - data);
+        add_hit(r, out, i, doc->file_id, data, len, s, s + r->nlen, &line, &line_at);
+        p = m + r->nlen;
+      }
+    }
+    g_mapped_file_unref(mf);
+  }
+}
+
+static gint cmp_tg_hits(gconstpointer a, gconstpointer b) {
+  const TgHit *x = a, *y = b;
+  if (x->cand != y->cand)       return x->cand < y->cand ? -1 : 1;
+  if (x->h.line != y->h.line)     return x->h.line < y->h.line ? -1 : 1;
+  if (x->h.column != y->h.column) return x->h.column < y->h.column ? -1 : 1;
+  return 0;
+}
+
+static gint cmp_cands_by_path(gconstpointer a, gconstpointer b, gpointer user) {
+  const UmiTrigramIndex *t = user;
+  return strcmp(DOC_AT(t, *(const guint32 *)a)->rel, DOC_AT(t, *(const guint32 *)b)->rel);
+}
+
+static void hit_clear(gpointer p) {
+  g_free(((UmiTrigramHit *)p)->text);
+}
+
+GArray *umi_trigram_hits_new(void) {
+  GArray *a = g_array_new(FALSE, FALSE, sizeof(UmiTrigramHit));
+  g_array_set_clear_func(a, hit_clear);
+  return a;
+}
+
+guint umi_trigram_index_search(UmiTrigramIndex *t, const char *pattern,
+                               UmiTrigramFlags flags, guint max_hits,
+                               GArray *out_hits, GError **err) {
+  g_return_val_if_fail(t != NULL && out_hits != NULL, 0);
+  g_array_set_size(out_hits, 0);
+  if (!pattern || !*pattern) return 0;
+
+  GRegex *re = NULL;
+  if (flags & UMI_TRIGRAM_REGEX) {
+    GRegexCompileFlags cf = G_REGEX_MULTILINE | G_REGEX_RAW | G_REGEX_OPTIMIZE;
+    if (flags & UMI_TRIGRAM_CASELESS) cf |= G_REGEX_CASELESS;
+    re = g_regex_new(pattern, cf, 0, err);
+    if (!re) return 0;
+  }
+
+  umi_trigram_index_sync(t);
+  GArray *cands = plan(t, pattern, flags, NULL);
+  g_array_sort_with_data(cands, cmp_cands_by_path, t);
+
+  const guint nw = umi_parallel_workers();
+  TgSearch run = { t, (const guint32 *)(const void *)cands->data, pattern, strlen(pattern),
+                   (flags & UMI_TRIGRAM_CASELESS) != 0, re, max_hits, g_new0(GArray *, nw), 0 };
+  for (guint i = 0; i < nw; ++i) run.hits[i] = g_array_new(FALSE, FALSE, sizeof(TgHit));
+
+  umi_parallel_for(cands->len, 4, verify_range, &run);
+
+  /* Each worker claims chunks in ascending order, so the hits it dropped
+   * past max_hits sort after the ones it kept: the merged prefix is exact. */
+  GArray *all = g_array_new(FALSE, FALSE, sizeof(TgHit));
+  for (guint i = 0; i < nw; ++i) {
+    g_array_append_vals(all, run.hits[i]->data, run.hits[i]->len);
+    g_array_free(run.hits[i], TRUE);
+  }
+  g_free(run.hits);
+  g_array_sort(all, cmp_tg_hits);
+  for (guint i = 0; i < all->len; ++i) {
+    TgHit *h = &g_array_index(all, TgHit, i);
+    if (i < max_hits) g_array_append_val(out_hits, h->h);
+    else              g_free(h->h.text);
+  }
+  g_array_free(all, TRUE);
+  g_array_free(cands, TRUE);
+  if (re) g_regex_unref(re);
+  return (guint)g_atomic_int_get(&run.total);
+}
+
+gboolean umi_trigram_index_candidates(UmiTrigramIndex *t, const char *pattern,
+                                      UmiTrigramFlags flags, GPtrArray *out_rel) {
+  g_return_val_if_fail(t != NULL && pattern != NULL && out_rel != NULL, FALSE);
+  umi_trigram_index_sync(t);
+  gboolean narrowed = FALSE;
+  GArray *cands = plan(t, pattern, flags, &narrowed);
+  if (narrowed) {
+    g_array_sort_with_data(cands, cmp_cands_by_path, t);
+    for (guint i = 0; i < cands->len; ++i)
+      g_ptr_array_add(out_rel, g_strdup(DOC_AT(t, g_array_index(cands, guint32, i))->rel));
+  }
+  g_array_free(cands, TRUE);
+  return narrowed;
+}
+
+/*---------------------------------------------------------------------------
+ * Snapshot
+ *---------------------------------------------------------------------------*/
+typedef struct TgHeader {
+  char    magic[4];
+  guint32 version;
+  guint32 n_docs;
+  guint32 n_posts;
+  guint64 bytes_len;
+  guint32 strings_len;
+  guint32 root_off;
+} TgHeader;
+
+typedef struct TgSnapDoc {
+  gint64  size;
+  gint64  mtime_us;
+  guint32 path_off;
+  guint32 flags;
+} TgSnapDoc;
+
+typedef struct TgSnapPost {
+  guint32 code;
+  guint32 n;
+  guint32 last;
+  guint32 len;
+  guint64 off;
+} TgSnapPost;
+
+gboolean umi_trigram_index_save(UmiTrigramIndex *t, const char *snapshot_path, GError **err) {
+  g_return_val_if_fail(t != NULL && snapshot_path != NULL, FALSE);
+  compact(t);
+
+  GByteArray *strings = g_byte_array_new();
+  GByteArray *bytes   = g_byte_array_new();
+  GArray     *sdocs   = g_array_sized_new(FALSE, FALSE, sizeof(TgSnapDoc), t->docs->len);
+  GArray     *sposts  = g_array_sized_new(FALSE, FALSE, sizeof(TgSnapPost), g_hash_table_size(t->posts));
+
+  for (guint d = 0; d < t->docs->len; ++d) {
+    const TgDoc *doc = DOC_AT(t, d);
+    TgSnapDoc sd = { doc->size, doc->mtime_us, strings->len, doc->flags };
+    g_byte_array_append(strings, (const guint8 *)doc->rel, (guint)strlen(doc->rel) + 1);
+    g_array_append_val(sdocs, sd);
+  }
+  GHashTableIter it;
+  gpointer key, val;
+  g_hash_table_iter_init(&it, t->posts);
+  while (g_hash_table_iter_next(&it, &key, &val)) {
+    const TgPost *pl = val;
+    TgSnapPost sp = { GPOINTER_TO_UINT(key), pl->n, pl->last, pl->data->len, bytes->len };
+    g_byte_array_append(bytes, pl->data->data, pl->data->len);
+    g_array_append_val(sposts, sp);
+  }
+  const char *root = umi_index_root(t->idx);
+  const guint32 root_off = strings->len;
+  g_byte_array_append(strings, (const guint8 *)root, (guint)strlen(root) + 1);
+
+  TgHeader h;
+  memcpy(h.magic, TG_MAGIC, 4);
+  h.version     = TG_VERSION;
+  h.n_docs      = sdocs->len;
+  h.n_posts     = sposts->len;
+  h.bytes_len   = bytes->len;
+  h.strings_len = strings->len;
+  h.root_off    = root_off;
+
+  GByteArray *out = g_byte_array_new();
+  g_byte_array_append(out, (const guint8 *)&h, sizeof h);
+  g_byte_array_append(out, (const guint8 *)sdocs->data, sdocs->len * (guint)sizeof(TgSnapDoc));
+  g_byte_array_append(out, (const guint8 *)sposts->data, sposts->len * (guint)sizeof(TgSnapPost));
+  g_byte_array_append(out, bytes->data, bytes->len);
+  g_byte_array_append(out, strings->data, strings->len);
+
+  char *parent = g_path_get_dirname(snapshot_path);
+  g_mkdir_with_parents(parent, 0755);
+  g_free(parent);
+  const gboolean ok = umi_file_save_atomic(snapshot_path, (const char *)out->data, out->len, err);
+
+  g_byte_array_free(out, TRUE);
+  g_byte_array_free(strings, TRUE);
+  g_byte_array_free(bytes, TRUE);
+  g_array_free(sdocs, TRUE);
+  g_array_free(sposts, TRUE);
+  return ok;
+}
+
+static gboolean load(UmiTrigramIndex *t, const char *data, gsize len) {
+  TgHeader h;
+  if (len < sizeof h) return FALSE;
+  memcpy(&h, data, sizeof h);
+  if (memcmp(h.magic, TG_MAGIC, 4) != 0 || h.version != TG_VERSION) return FALSE;
+  const guint64 need = sizeof h + (guint64)h.n_docs * sizeof(TgSnapDoc) +
+                       (guint64)h.n_posts * sizeof(TgSnapPost) + h.bytes_len + h.strings_len;
+  if (need != len || h.strings_len == 0 || h.root_off >= h.strings_len) return FALSE;
+
+  const TgSnapDoc  *sdocs   = (const TgSnapDoc *)(const void *)(data + sizeof h);
+  const TgSnapPost *sposts  = (const TgSnapPost *)(const void *)(sdocs + h.n_docs);
+  const guint8     *bytes   = (const guint8 *)(sposts + h.n_posts);
+  const char       *strings = (const char *)(bytes + h.bytes_len);
+  if (strings[h.strings_len - 1] != '\0') return FALSE;
+  if (h.root_off > 0 && strings[h.root_off - 1] != '\0') return FALSE;
+  if (g_strcmp0(strings + h.root_off, umi_index_root(t->idx)) != 0) return FALSE;
+  for (guint32 i = 0; i < h.n_docs; ++i)
+    if (sdocs[i].path_off >= h.root_off || (sdocs[i].flags & DOC_DEAD)) return FALSE;
+  for (guint32 i = 0; i < h.n_posts; ++i)
+    if (sposts[i].off + sposts[i].len > h.bytes_len || sposts[i].last >= h.n_docs) return FALSE;
+
+  for (guint32 i = 0; i < h.n_docs; ++i)
+    add_doc(t, UMI_INDEX_NO_FILE, g_strdup(strings + sdocs[i].path_off),
+            sdocs[i].size, sdocs[i].mtime_us, sdocs[i].flags);
+  for (guint32 i = 0; i < h.n_posts; ++i) {
+    TgPost *pl = g_new0(TgPost, 1);
+    pl->data = g_byte_array_sized_new(sposts[i].len);
+    g_byte_array_append(pl->data, bytes + sposts[i].off, sposts[i].len);
+    pl->n    = sposts[i].n;
+    pl->last = sposts[i].last;
+    g_hash_table_insert(t->posts, GUINT_TO_POINTER(sposts[i].code), pl);
+  }
+  return TRUE;
+}
+
+UmiTrigramIndex *umi_trigram_index_open(UmiFileIndex *idx, const char *snapshot_path) {
+  UmiTrigramIndex *t = umi_trigram_index_new(idx);
+  if (!t || !snapshot_path) return t;
+  GMappedFile *mf = g_mapped_file_new(snapshot_path, FALSE, NULL);
+  if (!mf) return t;
+  if (load(t, g_mapped_file_get_contents(mf), g_mapped_file_get_length(mf))) {
+    t->synced_gen = 0;
+    t->verify     = TRUE;
+  } else {                                             /* stale or foreign  */
+    umi_trigram_index_free(t);
+    t = umi_trigram_index_new(idx);
+  }
+  g_mapped_file_unref(mf);
+  return t;
+}
+
+char *umi_trigram_index_snapshot_path_for(const char *root) {
+  if (!root || !*root) return NULL;
+  char *canon = g_canonicalize_filename(root, NULL);
+  char *key   = g_compute_checksum_for_string(G_CHECKSUM_SHA1, canon, -1);
+  char *leaf  = g_strconcat(key, ".tri", NULL);
+  char *path  = g_build_filename(g_get_user_cache_dir(), "umicom-studio-ide", "index", leaf, NULL);
+  g_free(leaf);
+  g_free(key);
+  g_free(canon);
+  return path;
+}
+/*---------------------------------------------------------------------------*/
@@ -4,75 +4,751 @@
  *
  * PURPOSE:
  *   Maintain a simple in-memory index of files under a root directory.
- *   - Build the index from disk (recursive scan via fs_walk)
- *   - Refresh it (clear + rescan)
+ *   - Build the index from disk (recursive, parallel scan via fs_walk);
+ *     inside a git work tree the tracked files come from .git/index and
+ *     only directories git does not know about are walked
+ *   - Refresh it (clear + rescan), or patch it in place from created /
+ *     deleted / renamed events (binary search on the sorted tables)
+ *   - Persist it as an mmap-able snapshot and reopen it with per-directory
+ *     mtime reconciliation (only changed directories are re-read)
+ *   - Own the per-file metadata cache (file_meta.h): the walk stats files
+ *     as it lists them, CHANGED events invalidate, snapshots carry it over
  *   - Free all resources
  *
+ * STORAGE:
+ *   Paths are not stored whole. The index keeps:
+ *     arena     : every distinct leaf name once (interned), NUL-terminated,
+ *                 addressed by 32-bit offsets;
+ *     dirs      : IdxDir { parent id, name offset, rank, mtime } by dir id;
+ *     files     : IdxFile { dir id, name offset } by file id (8 bytes);
+ *     dir_order : live dir ids in path order (separator sorts first, so a
+ *                 directory's subtree is one contiguous run);
+ *     order     : live file ids sorted by (dir rank, name), i.e. a dir's
+ *                 files, then its subdirectories' files.
+ *   A file id is its slot in 'files' and stays valid until the next
+ *   refresh/open; deleted slots become tombstones. Full paths are rebuilt
+ *   on demand from the parent chain.
+ *
  * NOTES:
  *   - Matches the public API in src/util/fs/include/file_index.h exactly:
  *       UmiFileIndex *umi_index_build(const char *root);
  *       void          umi_index_refresh(UmiFileIndex *idx);
  *       void          umi_index_free(UmiFileIndex *idx);
- *   - Stores g_strdup'd, canonicalized (normalized) file paths in a GPtrArray.
+ *   - umi_index_files() still returns full paths, materialized once per
+ *     generation; prefer the zero-copy UmiIndexIter for large trees.
  *   - No GTK dependencies; pure GLib.
  *
  * THREADING:
- *   - Synchronous; call off the GTK main loop if the tree is large.
+ *   - Synchronous for the caller (the scan itself fans out over worker
+ *     threads); call off the GTK main loop if the tree is large.
  *
  * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-12 | MIT
  *---------------------------------------------------------------------------*/
 #include "include/file_index.h"
+#include "include/file_meta.h"
 #include "include/fs_walk.h"
+#include "include/ignore_rules.h"
+#include "include/file_io.h"
+#include "git_index.h"
+#include "parallel_for.h"
+#include <glib/gstdio.h>
 #include <string.h>
+#include <sys/stat.h>
+
+#define NO_ID G_MAXUINT32
+
+/*---------------------------------------------------------------------------
+ * A directory known to the index. Directories the walker descended into
+ * carry the mtime sampled when they were opened; reconciliation compares it
+ * against the live mtime to decide whether the listing must be read again.
+ *-------------------------------------------------------------------------*/
+typedef struct IdxDir {
+    guint32 parent;      /* NO_ID for the root (id 0)                       */
+    guint32 name_off;    /* leaf name in the arena ("" for the root)        */
+    guint32 rank;        /* position in dir_order                           */
+    guint32 live;        /* 0 once deleted (slot kept, ids stay stable)     */
+    gint64  mtime_us;    /* microseconds since the epoch, -1 if unknown     */
+    gint64  ign_stamp;   /* umi_ignore_stamp() when listed, 0 if no files   */
+} IdxDir;
+
+typedef struct IdxFile {
+    guint32 dir;         /* NO_ID marks a tombstone                         */
+    guint32 name_off;
+} IdxFile;
 
 /*---------------------------------------------------------------------------
  * Private structure for the index. Kept internal to avoid ABI churn.
  *-------------------------------------------------------------------------*/
 struct _UmiFileIndex {
-    char      *root;     /* Absolute, canonical root directory path      */
-    GPtrArray *files;    /* Owned array of g_strdup'd file paths         */
+    char       *root;        /* Absolute, canonical root directory path     */
+    GByteArray *arena;       /* interned leaf names                          */
+    guint32    *names;       /* open-addressing set: arena offset + 1        */
+    guint       names_cap;   /* power of two                                 */
+    guint       names_len;
+    guint       arena_mark;  /* arena size after the last compaction         */
+    GArray     *dirs;        /* IdxDir by dir id                             */
+    GArray     *files;       /* IdxFile by file id                           */
+    GArray     *dir_order;   /* guint32 dir ids, path order                  */
+    GArray     *order;       /* guint32 file ids, (rank, name) order         */
+    GHashTable *scan_dirs;   /* while walking: abs dir path -> id + 1        */
+    UmiIgnore  *ignore;      /* .gitignore/.ignore rules under root          */
+    UmiFileMeta *meta;       /* stat/kind/hash by file id                    */
+    GPtrArray  *paths_cache; /* umi_index_files() view, see paths_gen        */
+    guint64     paths_gen;
+    guint64     generation;  /* bumped whenever the file set changes        */
+    guint64     epoch;       /* bumped whenever file ids start over         */
 };
 
+#define DIR_AT(idx, id)   (&g_array_index((idx)->dirs,  IdxDir,  (id)))
+#define FILE_AT(idx, id)  (&g_array_index((idx)->files, IdxFile, (id)))
+#define NAME_AT(idx, off) ((const char *)(idx)->arena->data + (off))
+
+/*===========================================================================
+ * Name arena
+ *=========================================================================*/
+
+static void
+names_insert_slot(guint32 *slots, guint cap, const char *arena, guint32 off)
+{
+    const guint mask = cap - 1;
+    guint h = g_str_hash(arena + off) & mask;
+    while (slots[h]) h = (h + 1) & mask;
+    slots[h] = off + 1;
+}
+
+static void
+names_grow(UmiFileIndex *idx)
+{
+    const guint cap = idx->names_cap ? idx->names_cap * 2 : 1024;
+    guint32 *slots = g_new0(guint32, cap);
+    for (guint i = 0; i < idx->names_cap; ++i)
+        if (idx->names[i])
+            names_insert_slot(slots, cap, (const char *)idx->arena->data, idx->names[i] - 1);
+    g_free(idx->names);
+    idx->names     = slots;
+    idx->names_cap = cap;
+}
+
+/* Offset of 'name' in the arena, appending it the first time it is seen. */
+static guint32
+intern(UmiFileIndex *idx, const char *name)
+{
+    if ((idx->names_len + 1) * 4 >= idx->names_cap * 3) names_grow(idx);
+
+    const guint mask = idx->names_cap - 1;
+    guint h = g_str_hash(name) & mask;
+    for (; idx->names[h]; h = (h + 1) & mask) {
+        const guint32 off = idx->names[h] - 1;
+        if (strcmp(NAME_AT(idx, off), name) == 0) return off;
+    }
+    const guint32 off = idx->arena->len;
+    g_byte_array_append(idx->arena, (const guint8 *)name, (guint)strlen(name) + 1);
+    idx->names[h] = off + 1;
+    idx->names_len++;
+    return off;
+}
+
+/* Rebuild the name set from an arena that was filled wholesale. */
+static void
+names_rebuild(UmiFileIndex *idx)
+{
+    g_clear_pointer(&idx->names, g_free);
+    idx->names_cap = 0;
+    idx->names_len = 0;
+    for (guint32 off = 0; off < idx->arena->len; off += (guint32)strlen(NAME_AT(idx, off)) + 1) {
+        if ((idx->names_len + 1) * 4 >= idx->names_cap * 3) names_grow(idx);
+        names_insert_slot(idx->names, idx->names_cap, (const char *)idx->arena->data, off);
+        idx->names_len++;
+    }
+}
+
 /*---------------------------------------------------------------------------
- * Helper: free all file strings and reset the array to empty.
+ * Names of deleted entries stay in the arena. Once it has doubled since the
+ * last compaction, re-intern the names still referenced into a fresh arena.
+ * Ids are unaffected; only name offsets move.
  *-------------------------------------------------------------------------*/
 static void
-clear_files(UmiFileIndex *idx)
+maybe_compact(UmiFileIndex *idx)
 {
-    if (!idx || !idx->files) return;
-    /* GPtrArray does not have a clear-with-free; remove one by one to free. */
+    if (idx->arena->len < 64 * 1024 || idx->arena->len < idx->arena_mark * 2) return;
+
+    GByteArray *old = idx->arena;
+    idx->arena = g_byte_array_sized_new(idx->arena_mark);
+    g_clear_pointer(&idx->names, g_free);
+    idx->names_cap = 0;
+    idx->names_len = 0;
+
+    for (guint i = 0; i < idx->dirs->len; ++i) {
+        IdxDir *d = DIR_AT(idx, i);
+        if (d->live) d->name_off = intern(idx, (const char *)old->data + d->name_off);
+    }
     for (guint i = 0; i < idx->files->len; ++i) {
-        g_free(idx->files->pdata[i]);
+        IdxFile *f = FILE_AT(idx, i);
+        if (f->dir != NO_ID) f->name_off = intern(idx, (const char *)old->data + f->name_off);
+    }
+    g_byte_array_free(old, TRUE);
+    idx->arena_mark = idx->arena->len;
+}
+
+/*===========================================================================
+ * Tables
+ *=========================================================================*/
+
+static guint32
+new_dir(UmiFileIndex *idx, guint32 parent, const char *name, gint64 mtime_us)
+{
+    IdxDir d = { parent, intern(idx, name), 0, 1, mtime_us, 0 };
+    g_array_append_val(idx->dirs, d);
+    return idx->dirs->len - 1;
+}
+
+static guint32
+new_file(UmiFileIndex *idx, guint32 dir, const char *name)
+{
+    IdxFile f = { dir, intern(idx, name) };
+    g_array_append_val(idx->files, f);
+    return idx->files->len - 1;
+}
+
+/* Drop every entry and recreate the root directory (id 0). */
+static void
+reset_tables(UmiFileIndex *idx)
+{
+    g_byte_array_set_size(idx->arena, 0);
+    g_clear_pointer(&idx->names, g_free);
+    idx->names_cap = 0;
+    idx->names_len = 0;
+    g_array_set_size(idx->dirs, 0);
+    g_array_set_size(idx->files, 0);
+    g_array_set_size(idx->dir_order, 0);
+    g_array_set_size(idx->order, 0);
+    umi_file_meta_reset(idx->meta);                     /* ids start over   */
+    idx->epoch++;
+    (void)new_dir(idx, NO_ID, "", -1);
+}
+
+/* Append the path of 'dir' relative to the root ("" for the root). */
+static void
+dir_rel_path(const UmiFileIndex *idx, guint32 dir, GString *out)
+{
+    const IdxDir *d = DIR_AT(idx, dir);
+    if (d->parent == NO_ID) return;
+    dir_rel_path(idx, d->parent, out);
+    if (d->parent != 0) g_string_append_c(out, G_DIR_SEPARATOR);
+    g_string_append(out, NAME_AT(idx, d->name_off));
+}
+
+/* Append the absolute path of 'dir'. */
+static void
+dir_abs_path(const UmiFileIndex *idx, guint32 dir, GString *out)
+{
+    g_string_append(out, idx->root);
+    if (dir == 0) return;
+    g_string_append_c(out, G_DIR_SEPARATOR);
+    dir_rel_path(idx, dir, out);
+}
+
+/* Path order used for dir_order: like strcmp, but the separator sorts
+ * before every other byte so "a" < "a/b" < "a-b" and subtrees stay
+ * contiguous (same rule as the sorted parallel walker). */
+static int
+path_cmp(const char *a, const char *b)
+{
+    const unsigned char *pa = (const unsigned char *)a;
+    const unsigned char *pb = (const unsigned char *)b;
+    while (*pa && *pa == *pb) { ++pa; ++pb; }
+    const int ca = (*pa == G_DIR_SEPARATOR) ? 1 : (*pa ? *pa + 1 : 0);
+    const int cb = (*pb == G_DIR_SEPARATOR) ? 1 : (*pb ? *pb + 1 : 0);
+    return ca - cb;
+}
+
+static void
+assign_ranks(UmiFileIndex *idx)
+{
+    for (guint i = 0; i < idx->dir_order->len; ++i)
+        DIR_AT(idx, g_array_index(idx->dir_order, guint32, i))->rank = i;
+}
+
+static gint
+cmp_dir_ids(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    char **rel = (char **)user_data;
+    return path_cmp(rel[*(const guint32 *)a], rel[*(const guint32 *)b]);
+}
+
+static int
+file_key_cmp(const UmiFileIndex *idx, const IdxFile *f, guint32 rank, const char *name)
+{
+    const guint32 r = DIR_AT(idx, f->dir)->rank;
+    if (r != rank) return r < rank ? -1 : 1;
+    return strcmp(NAME_AT(idx, f->name_off), name);
+}
+
+static gint
+cmp_file_ids(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const UmiFileIndex *idx = (const UmiFileIndex *)user_data;
+    const IdxFile *fb = FILE_AT(idx, *(const guint32 *)b);
+    return file_key_cmp(idx, FILE_AT(idx, *(const guint32 *)a),
+                        DIR_AT(idx, fb->dir)->rank, NAME_AT(idx, fb->name_off));
+}
+
+/*---------------------------------------------------------------------------
+ * Helper: rebuild dir_order/ranks/order from the tables (after a full walk
+ * or a snapshot load). Relative dir paths are materialized only for the
+ * duration of the sort.
+ *-------------------------------------------------------------------------*/
+static void
+rebuild_order(UmiFileIndex *idx)
+{
+    char   **rel = g_new0(char *, idx->dirs->len);
+    GString *buf = g_string_new(NULL);
+
+    g_array_set_size(idx->dir_order, 0);
+    for (guint32 i = 0; i < idx->dirs->len; ++i) {
+        if (!DIR_AT(idx, i)->live) continue;
+        g_string_truncate(buf, 0);
+        dir_rel_path(idx, i, buf);
+        rel[i] = g_strdup(buf->str);
+        g_array_append_val(idx->dir_order, i);
     }
-    g_ptr_array_set_size(idx->files, 0);
+    g_array_sort_with_data(idx->dir_order, cmp_dir_ids, rel);
+    assign_ranks(idx);
+
+    for (guint i = 0; i < idx->dirs->len; ++i) g_free(rel[i]);
+    g_free(rel);
+    g_string_free(buf, TRUE);
+
+    g_array_set_size(idx->order, 0);
+    for (guint32 i = 0; i < idx->files->len; ++i)
+        if (FILE_AT(idx, i)->dir != NO_ID) g_array_append_val(idx->order, i);
+    g_array_sort_with_data(idx->order, cmp_file_ids, idx);
+}
+
+/*===========================================================================
+ * Walking
+ *=========================================================================*/
+
+/* Id of the directory at absolute 'path' during a walk, creating it (and
+ * any missing ancestors) on first sight. Walker batches from different
+ * workers may report a child before its parent. */
+static guint32
+intern_dir(UmiFileIndex *idx, const char *path)
+{
+    gpointer hit = g_hash_table_lookup(idx->scan_dirs, path);
+    if (hit) return GPOINTER_TO_UINT(hit) - 1;
+    if (strlen(path) <= strlen(idx->root)) return 0;   /* never above root */
+
+    char *parent = g_path_get_dirname(path);
+    const guint32 pid = intern_dir(idx, parent);
+    g_free(parent);
+
+    const char *slash = strrchr(path, G_DIR_SEPARATOR);
+    const guint32 id = new_dir(idx, pid, slash ? slash + 1 : path, -1);
+    g_hash_table_insert(idx->scan_dirs, g_strdup(path), GUINT_TO_POINTER(id + 1));
+    return id;
+}
+
+static void
+scan_seed(UmiFileIndex *idx, const char *path, guint32 id)
+{
+    g_hash_table_insert(idx->scan_dirs, g_strdup(path), GUINT_TO_POINTER(id + 1));
 }
 
 /*---------------------------------------------------------------------------
- * Walker callback: collect only REGULAR FILES (not directories).
+ * Walker batch callback: collect REGULAR FILES, plus the directories the
+ * walker descended into (those carry an mtime) for snapshot reconciliation.
+ * File stats gathered by the walk go straight into the metadata cache.
+ * The parallel walker serializes deliveries, so no locking is needed here.
  *-------------------------------------------------------------------------*/
 static void
-on_visit(const char *path, gboolean is_dir, gpointer user)
+on_batch(const UmiFsEntry *entries, guint n, gpointer user)
 {
     UmiFileIndex *idx = (UmiFileIndex *)user;
-    if (!idx || !idx->files) return;
+    if (!idx || !idx->scan_dirs) return;
+
+    GString *dir     = g_string_new(NULL);
+    guint32  dir_id  = NO_ID;
 
-    if (is_dir) {
-        return;                                         /* ignore directories   */
+    for (guint i = 0; i < n; ++i) {
+        const char *path = entries[i].path;
+        if (entries[i].is_dir) {
+            if (entries[i].mtime_us >= 0) {
+                const guint32 id = intern_dir(idx, path); /* may grow 'dirs' */
+                DIR_AT(idx, id)->mtime_us  = entries[i].mtime_us;
+                DIR_AT(idx, id)->ign_stamp = umi_ignore_stamp(idx->ignore, path);
+            }
+            continue;
+        }
+        const char *slash = strrchr(path, G_DIR_SEPARATOR);
+        if (!slash) continue;
+        /* Consecutive files usually share a directory: resolve it once. */
+        const gsize dl = (gsize)(slash - path);
+        if (dir_id == NO_ID || dir->len != dl || memcmp(dir->str, path, dl) != 0) {
+            g_string_truncate(dir, 0);
+            g_string_append_len(dir, path, (gssize)dl);
+            dir_id = intern_dir(idx, dir->str);
+        }
+        const guint32 id = new_file(idx, dir_id, slash + 1);
+        if (entries[i].size >= 0)
+            umi_file_meta_record(idx->meta, id, entries[i].size,
+                                 entries[i].mtime_us, entries[i].ino);
     }
-    /* Own a duplicate of the canonicalized path. */
-    g_ptr_array_add(idx->files, g_strdup(path));
+    g_string_free(dir, TRUE);
 }
 
 /*---------------------------------------------------------------------------
- * Stable sort: correctly-typed comparator (no casting warnings).
+ * Helper: walk 'dir' (idx->root or a new subtree) with the parallel walker.
+ * 'dir_id' is the id 'dir' itself already has. Ordering is left to the
+ * caller.
  *-------------------------------------------------------------------------*/
+static gboolean
+scan_tree(UmiFileIndex *idx, const char *dir, guint32 dir_id)
+{
+    const gboolean own = (idx->scan_dirs == NULL);
+    if (own) idx->scan_dirs = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    scan_seed(idx, dir, dir_id);
+
+    UmiFsWalkOptions opts = { 0 };
+    opts.include_hidden = FALSE;
+    opts.ignore         = idx->ignore;
+    opts.stat_files     = TRUE;                         /* feeds idx->meta  */
+    const gboolean ok = umi_fs_walk_parallel(dir, &opts, on_batch, idx);
+
+    if (own) g_clear_pointer(&idx->scan_dirs, g_hash_table_destroy);
+    return ok;
+}
+
+static const char *rel_to_root(const UmiFileIndex *idx, const char *path);
+static gboolean    stat_dir_mtime(const char *path, gint64 *out_mtime_us);
+
+/*===========================================================================
+ * Git-assisted scan
+ *
+ * The directories holding tracked files are known up front from the git
+ * index, so they are listed all at once in parallel instead of being
+ * discovered level by level. A listed name that the index tracks needs no
+ * stat() (metadata is left to file_meta, which stats lazily); a subdir the
+ * index knows is listed on its own; anything else is untracked and typed
+ * here, and untracked directories get a normal walk. The result is exactly
+ * what scan_tree() would produce: the same hidden/ignore rules apply, files
+ * deleted from the work tree drop out, new untracked ones show up.
+ *=========================================================================*/
+typedef struct GitLeaf {
+    const char *name;        /* points into the UmiGitIndex                 */
+    guint32     mode;
+} GitLeaf;
+
+typedef struct GitDir {
+    char      *rel;          /* root-relative, "" for the root              */
+    gint       parent;       /* index in GitScan.dirs, -1 for the root      */
+    GArray    *leaves;       /* GitLeaf, sorted by name (index order)       */
+    /* Filled by the listing pass. */
+    gboolean   listed;
+    gboolean   seen;         /* the parent listing kept it as a real dir   */
+    gint64     mtime_us;
+    GPtrArray *files;        /* leaf names to add                           */
+    GPtrArray *untracked;    /* absolute paths of untracked subdirs         */
+} GitDir;
+
+typedef struct GitScan {
+    UmiFileIndex *idx;
+    GitDir       *dirs;
+    guint         n_dirs;
+    GHashTable   *by_rel;    /* rel -> index + 1 (keys owned by 'dirs')     */
+} GitScan;
+
+static const GitLeaf *
+git_leaf_find(const GArray *leaves, const char *name)
+{
+    guint lo = 0, hi = leaves->len;
+    while (lo < hi) {
+        const guint mid = lo + (hi - lo) / 2;
+        const int c = strcmp(g_array_index(leaves, GitLeaf, mid).name, name);
+        if (c == 0) return &g_array_index(leaves, GitLeaf, mid);
+        if (c < 0) lo = mid + 1; else hi = mid;
+    }
+    return NULL;
+}
+
 static gint
-cmp_paths(gconstpointer a, gconstpointer b, gpointer user_data)
+cmp_str_ptrs(gconstpointer a, gconstpointer b)
 {
-    (void)user_data;
-    const char *sa = (const char *)a;
-    const char *sb = (const char *)b;
-    return g_strcmp0(sa, sb);
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/* List one tracked directory (see the section comment). */
+static void
+git_list_dir(GitScan *gs, GitDir *gd)
+{
+    UmiFileIndex *idx = gs->idx;
+    char *abs = *gd->rel ? g_build_filename(idx->root, gd->rel, NULL) : g_strdup(idx->root);
+    GDir *d = stat_dir_mtime(abs, &gd->mtime_us) ? g_dir_open(abs, 0, NULL) : NULL;
+    if (!d) { g_free(abs); return; }
+    gd->listed    = TRUE;
+    gd->files     = g_ptr_array_new_with_free_func(g_free);
+    gd->untracked = g_ptr_array_new_with_free_func(g_free);
+
+    UmiIgnoreScope *scope = umi_ignore_scope_new(idx->ignore, abs);
+    GString *rel = g_string_new(NULL);
+    for (const char *name = g_dir_read_name(d); name; name = g_dir_read_name(d)) {
+        if (name[0] == '.') continue;                   /* same rule as walk */
+        char *full = g_build_filename(abs, name, NULL);
+
+        const GitLeaf *leaf = git_leaf_find(gd->leaves, name);
+        if (leaf) {
+            /* Tracked: a file unless it is a symlink resolving to a dir. */
+            const gboolean is_dir = leaf->mode == UMI_GIT_MODE_SYMLINK &&
+                                    g_file_test(full, G_FILE_TEST_IS_DIR);
+            if (!is_dir && !umi_ignore_scope_match(scope, name, FALSE))
+                g_ptr_array_add(gd->files, g_strdup(name));
+            g_free(full);
+            continue;
+        }
+        g_string_assign(rel, gd->rel);
+        if (rel->len) g_string_append_c(rel, G_DIR_SEPARATOR);
+        g_string_append(rel, name);
+        const guint sub = GPOINTER_TO_UINT(g_hash_table_lookup(gs->by_rel, rel->str));
+        if (sub) {
+            /* A tracked subdir lists itself; only confirm it here. Each
+             * dir has one parent, so this flag has a single writer. */
+            if (!g_file_test(full, G_FILE_TEST_IS_SYMLINK) &&
+                !umi_ignore_scope_match(scope, name, TRUE))
+                gs->dirs[sub - 1].seen = TRUE;
+            g_free(full);
+            continue;
+        }
+        const gboolean is_dir = g_file_test(full, G_FILE_TEST_IS_DIR);
+        if (umi_ignore_scope_match(scope, name, is_dir)) {
+            g_free(full);                               /* pruned           */
+        } else if (!is_dir) {
+            g_ptr_array_add(gd->files, g_strdup(name));
+            g_free(full);
+        } else if (!g_file_test(full, G_FILE_TEST_IS_SYMLINK)) {
+            g_ptr_array_add(gd->untracked, full);       /* walked later     */
+        } else {
+            g_free(full);                               /* not descended    */
+        }
+    }
+    g_string_free(rel, TRUE);
+    umi_ignore_scope_free(scope);
+    g_dir_close(d);
+    g_free(abs);
+}
+
+static void
+git_list_range(guint begin, guint end, guint worker, gpointer user)
+{
+    (void)worker;
+    GitScan *gs = user;
+    for (guint i = begin; i < end; ++i) git_list_dir(gs, &gs->dirs[i]);
+}
+
+/* Index of the tracked dir 'rel', adding it and its ancestors if new. */
+static guint
+git_dir_intern(GHashTable *set, GPtrArray *rels, const char *rel)
+{
+    gpointer hit = g_hash_table_lookup(set, rel);
+    if (hit) return GPOINTER_TO_UINT(hit) - 1;
+    const char *slash = strrchr(rel, G_DIR_SEPARATOR);
+    if (slash) {
+        char *parent = g_strndup(rel, (gsize)(slash - rel));
+        (void)git_dir_intern(set, rels, parent);
+        g_free(parent);
+    }
+    char *own = g_strdup(rel);
+    g_ptr_array_add(rels, own);
+    g_hash_table_insert(set, own, GUINT_TO_POINTER(rels->len));
+    return rels->len - 1;
+}
+
+/* Collect the tracked files under the root, grouped by directory. Returns
+ * FALSE when there is nothing to work from (caller walks instead). */
+static gboolean
+git_collect(GitScan *gs, const UmiGitIndex *gi, const char *prefix)
+{
+    const gsize plen = strlen(prefix);
+    GPtrArray  *rels = g_ptr_array_new();
+    GHashTable *set  = g_hash_table_new(g_str_hash, g_str_equal);
+    GPtrArray  *leaf_dir = g_ptr_array_new();           /* per leaf: dir rel */
+    GArray     *leaves   = g_array_new(FALSE, FALSE, sizeof(GitLeaf));
+    GString    *dir      = g_string_new(NULL);
+    const char *last     = NULL;
+    guint       dir_i    = 0;
+
+    (void)git_dir_intern(set, rels, "");
+    for (guint i = 0; i < umi_git_index_count(gi); ++i) {
+        const UmiGitIndexEntry *e = umi_git_index_entry(gi, i);
+        if (last && strcmp(last, e->path) == 0) continue;   /* conflict stages */
+        last = e->path;
+        if (e->flags & UMI_GIT_ENTRY_SKIP_WORKTREE) continue;
+        if (e->mode != UMI_GIT_MODE_FILE && e->mode != UMI_GIT_MODE_EXEC &&
+            e->mode != UMI_GIT_MODE_SYMLINK) continue;       /* gitlinks, sparse dirs */
+        if (strncmp(e->path, prefix, plen) != 0) continue;
+        const char *rel = e->path + plen;
+
+        gboolean hidden = (rel[0] == '.');
+        for (const char *s = strchr(rel, '/'); s && !hidden; s = strchr(s + 1, '/'))
+            hidden = (s[1] == '.');
+        if (hidden) continue;                           /* same rule as walk */
+
+        const char *slash = strrchr(rel, '/');
+        const gsize dl = slash ? (gsize)(slash - rel) : 0;
+        if (dir->len != dl || strncmp(dir->str, rel, dl) != 0) {
+            g_string_truncate(dir, 0);
+            g_string_append_len(dir, rel, (gssize)dl);
+            if (G_DIR_SEPARATOR != '/') g_strdelimit(dir->str, "/", G_DIR_SEPARATOR);
+            dir_i = git_dir_intern(set, rels, dir->str);
+            if (G_DIR_SEPARATOR != '/') g_strdelimit(dir->str, G_DIR_SEPARATOR_S, '/');
+        }
+        GitLeaf l = { slash ? slash + 1 : rel, e->mode };
+        g_array_append_val(leaves, l);
+        g_ptr_array_add(leaf_dir, GUINT_TO_POINTER(dir_i));
+    }
+    g_string_free(dir, TRUE);
+
+    const gboolean any = leaves->len > 0;
+    if (any) {
+        /* Sorted, a parent precedes its children. */
+        g_ptr_array_sort(rels, cmp_str_ptrs);
+        guint *remap = g_new(guint, rels->len);
+        gs->n_dirs = rels->len;
+        gs->dirs   = g_new0(GitDir, rels->len);
+        gs->by_rel = g_hash_table_new(g_str_hash, g_str_equal);
+        for (guint i = 0; i < rels->len; ++i) {
+            GitDir *gd = &gs->dirs[i];
+            gd->rel    = g_ptr_array_index(rels, i);
+            gd->leaves = g_array_new(FALSE, FALSE, sizeof(GitLeaf));
+            remap[GPOINTER_TO_UINT(g_hash_table_lookup(set, gd->rel)) - 1] = i;
+            g_hash_table_insert(gs->by_rel, gd->rel, GUINT_TO_POINTER(i + 1));
+            const char *slash = strrchr(gd->rel, G_DIR_SEPARATOR);
+            if (!*gd->rel) {
+                gd->parent = -1;
+            } else {
+                char *parent = slash ? g_strndup(gd->rel, (gsize)(slash - gd->rel)) : g_strdup("");
+                gd->parent = (gint)GPOINTER_TO_UINT(g_hash_table_lookup(gs->by_rel, parent)) - 1;
+                g_free(parent);
+            }
+        }
+        for (guint i = 0; i < leaves->len; ++i) {
+            GitDir *gd = &gs->dirs[remap[GPOINTER_TO_UINT(g_ptr_array_index(leaf_dir, i))]];
+            g_array_append_val(gd->leaves, g_array_index(leaves, GitLeaf, i));
+        }
+        g_free(remap);
+    } else {
+        g_ptr_array_set_free_func(rels, g_free);
+    }
+    g_hash_table_destroy(set);
+    g_ptr_array_free(rels, TRUE);                       /* strings moved     */
+    g_ptr_array_free(leaf_dir, TRUE);
+    g_array_free(leaves, TRUE);
+    return any;
+}
+
+static void
+git_scan_clear(GitScan *gs)
+{
+    for (guint i = 0; i < gs->n_dirs; ++i) {
+        GitDir *gd = &gs->dirs[i];
+        g_free(gd->rel);
+        g_array_free(gd->leaves, TRUE);
+        if (gd->files) g_ptr_array_free(gd->files, TRUE);
+        if (gd->untracked) g_ptr_array_free(gd->untracked, TRUE);
+    }
+    g_free(gs->dirs);
+    if (gs->by_rel) g_hash_table_destroy(gs->by_rel);
+}
+
+/*---------------------------------------------------------------------------
+ * Helper: fill the (freshly reset) tables from the git index when the root
+ * lies inside a work tree. FALSE, with the tables untouched, when there is
+ * no usable index; the caller then walks the whole tree.
+ *-------------------------------------------------------------------------*/
+static gboolean
+git_scan(UmiFileIndex *idx)
+{
+    char *worktree = NULL, *gitdir = NULL;
+    if (!umi_git_find_repo(idx->root, &worktree, &gitdir)) return FALSE;
+    UmiGitIndex *gi = umi_git_index_read(gitdir, NULL);
+    g_free(gitdir);
+    if (!gi) { g_free(worktree); return FALSE; }
+
+    /* The index holds '/'-separated paths relative to the work tree. */
+    const char *sub = idx->root + strlen(worktree);
+    while (*sub == G_DIR_SEPARATOR) ++sub;
+    char *prefix = g_strconcat(sub, *sub ? "/" : "", NULL);
+    if (G_DIR_SEPARATOR != '/') g_strdelimit(prefix, G_DIR_SEPARATOR_S, '/');
+    g_free(worktree);
+
+    GitScan gs = { idx, NULL, 0, NULL };
+    gboolean ok = git_collect(&gs, gi, prefix);
+    g_free(prefix);
+    if (ok) {
+        umi_parallel_for(gs.n_dirs, 4, git_list_range, &gs);
+        ok = gs.dirs[0].listed;
+    }
+    if (ok) {
+        guint32 *ids = g_new(guint32, gs.n_dirs);
+        GString *abs = g_string_new(NULL);
+        for (guint i = 0; i < gs.n_dirs; ++i) {
+            GitDir *gd = &gs.dirs[i];
+            ids[i] = NO_ID;
+            if (!gd->listed) continue;
+            if (gd->parent >= 0) {
+                if (!gd->seen || ids[gd->parent] == NO_ID) continue;   /* gone, pruned */
+                const char *slash = strrchr(gd->rel, G_DIR_SEPARATOR);
+                ids[i] = new_dir(idx, ids[gd->parent], slash ? slash + 1 : gd->rel, gd->mtime_us);
+            } else {
+                ids[i] = 0;
+                DIR_AT(idx, 0)->mtime_us = gd->mtime_us;
+            }
+            g_string_truncate(abs, 0);
+            dir_abs_path(idx, ids[i], abs);
+            DIR_AT(idx, ids[i])->ign_stamp = umi_ignore_stamp(idx->ignore, abs->str);
+            for (guint k = 0; k < gd->files->len; ++k)
+                (void)new_file(idx, ids[i], g_ptr_array_index(gd->files, k));
+        }
+        for (guint i = 0; i < gs.n_dirs; ++i) {         /* untracked subtrees */
+            GitDir *gd = &gs.dirs[i];
+            if (ids[i] == NO_ID) continue;
+            for (guint k = 0; k < gd->untracked->len; ++k) {
+                const char *path = g_ptr_array_index(gd->untracked, k);
+                const guint32 id = new_dir(idx, ids[i], strrchr(path, G_DIR_SEPARATOR) + 1, -1);
+                (void)scan_tree(idx, path, id);
+            }
+        }
+        g_string_free(abs, TRUE);
+        g_free(ids);
+    }
+    git_scan_clear(&gs);
+    umi_git_index_free(gi);
+    return ok;
+}
+
+static UmiFileIndex *
+index_new_empty(const char *root)
+{
+    UmiFileIndex *idx = g_new0(UmiFileIndex, 1);
+    idx->root      = g_canonicalize_filename(root, NULL);
+    idx->ignore    = umi_ignore_new(idx->root);
+    idx->meta      = umi_file_meta_new(idx);
+    idx->arena     = g_byte_array_new();
+    idx->dirs      = g_array_new(FALSE, FALSE, sizeof(IdxDir));
+    idx->files     = g_array_new(FALSE, FALSE, sizeof(IdxFile));
+    idx->dir_order = g_array_new(FALSE, FALSE, sizeof(guint32));
+    idx->order     = g_array_new(FALSE, FALSE, sizeof(guint32));
+    idx->generation = 1;
+    reset_tables(idx);
+    return idx;
+}
+
+static void
+full_scan(UmiFileIndex *idx)
+{
+    reset_tables(idx);
+    if (!git_scan(idx)) (void)scan_tree(idx, idx->root, 0);
+    rebuild_order(idx);
+    idx->arena_mark = idx->arena->len;
 }
 
 /*---------------------------------------------------------------------------
@@ -83,19 +759,12 @@ umi_index_build(const char *root)
 {
     if (!root || !*root) return NULL;
 
-    UmiFileIndex *idx = g_new0(UmiFileIndex, 1);
-    idx->root  = g_canonicalize_filename(root, NULL);
-    idx->files = g_ptr_array_new_with_free_func(g_free);
-
-    /* Walk and collect; include_hidden = FALSE by default. */
-    if (!umi_fs_walk(idx->root, FALSE, on_visit, idx)) {
-        /* If walking fails, return a valid (empty) index so callers can still
-         * inspect 'root' and later attempt refresh().
-         */
-    }
+    UmiFileIndex *idx = index_new_empty(root);
 
-    /* Sort for deterministic iteration order. */
-    g_ptr_array_sort_with_data(idx->files, cmp_paths, NULL);
+    /* Walk, collect and sort for deterministic iteration order. If walking
+     * fails we still return a valid (empty) index so callers can inspect
+     * 'root' and later attempt refresh(). */
+    full_scan(idx);
     return idx;
 }
 
@@ -107,9 +776,9 @@ umi_index_refresh(UmiFileIndex *idx)
 {
     if (!idx) return;
 
-    clear_files(idx);
-    (void)umi_fs_walk(idx->root, FALSE, on_visit, idx);
-    g_ptr_array_sort_with_data(idx->files, cmp_paths, NULL);
+    umi_ignore_invalidate(idx->ignore, NULL);          /* re-read rules too */
+    full_scan(idx);
+    idx->generation++;
 }
 
 /*---------------------------------------------------------------------------
@@ -120,23 +789,868 @@ umi_index_free(UmiFileIndex *idx)
 {
     if (!idx) return;
 
-    clear_files(idx);
-    if (idx->files) g_ptr_array_free(idx->files, TRUE);
+    g_byte_array_free(idx->arena, TRUE);
+    g_free(idx->names);
+    g_array_free(idx->dirs, TRUE);
+    g_array_free(idx->files, TRUE);
+    g_array_free(idx->dir_order, TRUE);
+    g_array_free(idx->order, TRUE);
+    if (idx->paths_cache) g_ptr_array_free(idx->paths_cache, TRUE);
+    umi_file_meta_free(idx->meta);
+    umi_ignore_free(idx->ignore);
     g_clear_pointer(&idx->root, g_free);
     g_free(idx);
 }
 
+/*===========================================================================
+ * Incremental updates
+ *
+ * dir_order is sorted by path with the separator first, so a directory's
+ * subtree is the contiguous run [rank, end). Files are sorted by (dir
+ * rank, name), so that subtree's files are contiguous in 'order' as well:
+ * single entries are found by binary search and a whole subtree is removed
+ * with one g_array_remove_range().
+ *=========================================================================*/
+
+/* Binary search dir_order for 'rel'; returns the insertion point. */
+static guint
+dir_lower_bound(const UmiFileIndex *idx, const char *rel, GString *scratch)
+{
+    guint lo = 0, hi = idx->dir_order->len;
+    while (lo < hi) {
+        const guint mid = lo + (hi - lo) / 2;
+        g_string_truncate(scratch, 0);
+        dir_rel_path(idx, g_array_index(idx->dir_order, guint32, mid), scratch);
+        if (path_cmp(scratch->str, rel) < 0) lo = mid + 1;
+        else                                 hi = mid;
+    }
+    return lo;
+}
+
+/* Dir id for a root-relative path, or NO_ID. */
+static guint32
+find_dir(const UmiFileIndex *idx, const char *rel)
+{
+    if (!*rel) return 0;
+    GString *s = g_string_new(NULL);
+    const guint pos = dir_lower_bound(idx, rel, s);
+    guint32 id = NO_ID;
+    if (pos < idx->dir_order->len) {
+        g_string_truncate(s, 0);
+        const guint32 cand = g_array_index(idx->dir_order, guint32, pos);
+        dir_rel_path(idx, cand, s);
+        if (strcmp(s->str, rel) == 0) id = cand;
+    }
+    g_string_free(s, TRUE);
+    return id;
+}
+
+/* Dir id for 'rel', inserting it and any missing ancestors into the tables
+ * and dir_order (used when an event names a file in an unseen directory). */
+static guint32
+ensure_dir(UmiFileIndex *idx, const char *rel)
+{
+    const guint32 found = find_dir(idx, rel);
+    if (found != NO_ID) return found;
+
+    const char *slash = strrchr(rel, G_DIR_SEPARATOR);
+    char *parent = slash ? g_strndup(rel, (gsize)(slash - rel)) : g_strdup("");
+    const guint32 pid = ensure_dir(idx, parent);
+    g_free(parent);
+
+    const guint32 id = new_dir(idx, pid, slash ? slash + 1 : rel, -1);
+    GString *s = g_string_new(NULL);
+    const guint pos = dir_lower_bound(idx, rel, s);
+    g_string_free(s, TRUE);
+    g_array_insert_val(idx->dir_order, pos, id);
+    assign_ranks(idx);
+    return id;
+}
+
+/* First position in 'order' whose key is >= (rank, name). */
+static guint
+file_lower_bound(const UmiFileIndex *idx, guint32 rank, const char *name)
+{
+    guint lo = 0, hi = idx->order->len;
+    while (lo < hi) {
+        const guint mid = lo + (hi - lo) / 2;
+        const IdxFile *f = FILE_AT(idx, g_array_index(idx->order, guint32, mid));
+        if (file_key_cmp(idx, f, rank, name) < 0) lo = mid + 1;
+        else                                      hi = mid;
+    }
+    return lo;
+}
+
+static gboolean
+is_descendant(const UmiFileIndex *idx, guint32 dir, guint32 ancestor)
+{
+    for (guint32 d = DIR_AT(idx, dir)->parent; d != NO_ID; d = DIR_AT(idx, d)->parent)
+        if (d == ancestor) return TRUE;
+    return FALSE;
+}
+
+/* Remove directory 'dir' with its whole subtree. */
+static void
+delete_dir(UmiFileIndex *idx, guint32 dir)
+{
+    const guint start = DIR_AT(idx, dir)->rank;
+    guint end = start + 1;
+    while (end < idx->dir_order->len &&
+           is_descendant(idx, g_array_index(idx->dir_order, guint32, end), dir)) ++end;
+
+    const guint fs = file_lower_bound(idx, start, "");
+    const guint fe = (end < idx->dir_order->len) ? file_lower_bound(idx, end, "")
+                                                 : idx->order->len;
+    for (guint i = fs; i < fe; ++i)
+        FILE_AT(idx, g_array_index(idx->order, guint32, i))->dir = NO_ID;
+    if (fe > fs) g_array_remove_range(idx->order, fs, fe - fs);
+
+    for (guint i = start; i < end; ++i)
+        DIR_AT(idx, g_array_index(idx->dir_order, guint32, i))->live = 0;
+    g_array_remove_range(idx->dir_order, start, end - start);
+    assign_ranks(idx);
+}
+
+/* Inside the root, not hidden (no path component starting with '.') and
+ * not ignored, i.e. something a full scan would have picked up. */
+static gboolean
+is_indexable(const UmiFileIndex *idx, const char *path)
+{
+    const char *rel = rel_to_root(idx, path);
+    if (!rel || !*rel) return FALSE;
+    for (const char *p = rel; *p; ) {
+        if (*p == '.') return FALSE;
+        const char *sep = strchr(p, G_DIR_SEPARATOR);
+        if (!sep) break;
+        p = sep + 1;
+    }
+    return !umi_ignore_is_ignored(idx->ignore, path, g_file_test(path, G_FILE_TEST_IS_DIR));
+}
+
+/* Split a root-relative path into its parent ("" for top level) and leaf. */
+static char *
+split_rel(const char *rel, const char **out_leaf)
+{
+    const char *slash = strrchr(rel, G_DIR_SEPARATOR);
+    *out_leaf = slash ? slash + 1 : rel;
+    return slash ? g_strndup(rel, (gsize)(slash - rel)) : g_strdup("");
+}
+
+/* Position in 'order' of the live file at root-relative 'rel', or -1. */
+static gint
+find_file_pos(const UmiFileIndex *idx, const char *rel)
+{
+    const char *leaf;
+    char *parent = split_rel(rel, &leaf);
+    const guint32 pid = find_dir(idx, parent);
+    g_free(parent);
+    if (pid == NO_ID) return -1;
+
+    const guint pos = file_lower_bound(idx, DIR_AT(idx, pid)->rank, leaf);
+    if (pos >= idx->order->len) return -1;
+    const IdxFile *f = FILE_AT(idx, g_array_index(idx->order, guint32, pos));
+    if (f->dir != pid || strcmp(NAME_AT(idx, f->name_off), leaf) != 0) return -1;
+    return (gint)pos;
+}
+
+/* Drop 'path' (file or directory subtree). TRUE if anything was removed. */
+static gboolean
+apply_deleted(UmiFileIndex *idx, const char *path)
+{
+    const char *rel = rel_to_root(idx, path);
+    if (!rel || !*rel) return FALSE;
+
+    const guint32 dir = find_dir(idx, rel);
+    if (dir != NO_ID) {
+        delete_dir(idx, dir);
+        return TRUE;
+    }
+
+    const gint pos = find_file_pos(idx, rel);
+    if (pos < 0) return FALSE;
+    const guint32 id = g_array_index(idx->order, guint32, pos);
+    FILE_AT(idx, id)->dir = NO_ID;
+    umi_file_meta_invalidate(idx->meta, id);
+    g_array_remove_index(idx->order, (guint)pos);
+    return TRUE;
+}
+
+/* Add 'path': one binary insertion for a file; for a directory, a walk
+ * whose dirs and files each land as one contiguous block. */
+static gboolean
+apply_created(UmiFileIndex *idx, const char *path)
+{
+    const char *rel = rel_to_root(idx, path);
+    const char *leaf;
+    char *parent = split_rel(rel, &leaf);
+
+    if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
+        if (g_file_test(path, G_FILE_TEST_IS_SYMLINK) ||   /* not descended */
+            find_dir(idx, rel) != NO_ID) { g_free(parent); return FALSE; }
+
+        const guint32 pid = ensure_dir(idx, parent);
+        g_free(parent);
+
+        const guint d0 = idx->dirs->len, f0 = idx->files->len;
+        const guint32 id = new_dir(idx, pid, leaf, -1);
+        (void)scan_tree(idx, path, id);
+
+        /* New dirs: sorted among themselves, then spliced in at the
+         * subtree root's position (the subtree is contiguous). */
+        GArray *nd = g_array_sized_new(FALSE, FALSE, sizeof(guint32), idx->dirs->len - d0);
+        char  **relp = g_new0(char *, idx->dirs->len);
+        GString *s = g_string_new(NULL);
+        for (guint32 i = d0; i < idx->dirs->len; ++i) {
+            g_string_truncate(s, 0);
+            dir_rel_path(idx, i, s);
+            relp[i] = g_strdup(s->str);
+            g_array_append_val(nd, i);
+        }
+        g_array_sort_with_data(nd, cmp_dir_ids, relp);
+        const guint at = dir_lower_bound(idx, rel, s);
+        g_array_insert_vals(idx->dir_order, at, nd->data, nd->len);
+        assign_ranks(idx);
+        for (guint i = d0; i < idx->dirs->len; ++i) g_free(relp[i]);
+        g_free(relp);
+        g_string_free(s, TRUE);
+        g_array_free(nd, TRUE);
+
+        /* New files: same idea, one block at the first new key. */
+        if (idx->files->len > f0) {
+            GArray *nf = g_array_sized_new(FALSE, FALSE, sizeof(guint32), idx->files->len - f0);
+            for (guint32 i = f0; i < idx->files->len; ++i) g_array_append_val(nf, i);
+            g_array_sort_with_data(nf, cmp_file_ids, idx);
+            const IdxFile *first = FILE_AT(idx, g_array_index(nf, guint32, 0));
+            const guint fat = file_lower_bound(idx, DIR_AT(idx, first->dir)->rank,
+                                               NAME_AT(idx, first->name_off));
+            g_array_insert_vals(idx->order, fat, nf->data, nf->len);
+            g_array_free(nf, TRUE);
+        }
+        return TRUE;
+    }
+    if (!g_file_test(path, G_FILE_TEST_EXISTS)) { g_free(parent); return FALSE; } /* raced away */
+
+    const guint32 pid = ensure_dir(idx, parent);
+    g_free(parent);
+    const guint pos = file_lower_bound(idx, DIR_AT(idx, pid)->rank, leaf);
+    if (pos < idx->order->len) {
+        const IdxFile *f = FILE_AT(idx, g_array_index(idx->order, guint32, pos));
+        if (f->dir == pid && strcmp(NAME_AT(idx, f->name_off), leaf) == 0) {
+            /* Replaced in place (e.g. an atomic save renamed over it). */
+            umi_file_meta_invalidate(idx->meta, g_array_index(idx->order, guint32, pos));
+            return FALSE;
+        }
+    }
+    const guint32 id = new_file(idx, pid, leaf);
+    g_array_insert_val(idx->order, pos, id);
+    return TRUE;
+}
+
+/* 'path' is an ignore file that appeared, changed or went away: forget the
+ * cached rules of its directory and walk that directory again, since any
+ * part of the subtree may have become (un)ignored. Returns FALSE when
+ * 'path' is not an ignore file; '*changed' is set if the index moved. */
+static gboolean
+apply_rules_file(UmiFileIndex *idx, const char *path, gboolean *changed)
+{
+    const char *slash = strrchr(path, G_DIR_SEPARATOR);
+    if (!slash || !umi_ignore_is_rule_file(slash + 1)) return FALSE;
+
+    char *dir = g_strndup(path, (gsize)(slash - path));
+    const char *rel = rel_to_root(idx, dir);
+    if (rel && !*rel) {
+        umi_ignore_invalidate(idx->ignore, dir);
+        full_scan(idx);                                 /* root rules: all  */
+        *changed = TRUE;
+    } else if (rel) {
+        umi_ignore_invalidate(idx->ignore, dir);
+        const guint32 id = find_dir(idx, rel);
+        if (id != NO_ID) {                              /* else not indexed */
+            delete_dir(idx, id);
+            (void)apply_created(idx, dir);
+            *changed = TRUE;
+        }
+    }
+    g_free(dir);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------
+ * Public: patch the index from a single filesystem event.
+ *-------------------------------------------------------------------------*/
+gboolean
+umi_index_apply(UmiFileIndex *idx, UmiIndexEvent kind,
+                const char *path, const char *new_path)
+{
+    if (!idx || !path || !*path) return FALSE;
+
+    char *p = g_canonicalize_filename(path, NULL);
+    gboolean changed = FALSE;
+
+    switch (kind) {
+    case UMI_INDEX_CREATED:
+        if (!apply_rules_file(idx, p, &changed) && is_indexable(idx, p))
+            changed = apply_created(idx, p);
+        break;
+    case UMI_INDEX_DELETED:
+        if (!apply_rules_file(idx, p, &changed))
+            changed = apply_deleted(idx, p);
+        break;
+    case UMI_INDEX_RENAMED:
+        if (!apply_rules_file(idx, p, &changed))
+            changed = apply_deleted(idx, p);
+        if (new_path && *new_path) {
+            char *q = g_canonicalize_filename(new_path, NULL);
+            if (!apply_rules_file(idx, q, &changed) && is_indexable(idx, q))
+                changed = apply_created(idx, q) || changed;
+            g_free(q);
+        }
+        break;
+    case UMI_INDEX_CHANGED:
+        if (!apply_rules_file(idx, p, &changed)) {      /* contents only    */
+            const char *rel = rel_to_root(idx, p);
+            const gint pos = (rel && *rel) ? find_file_pos(idx, rel) : -1;
+            if (pos >= 0)
+                umi_file_meta_invalidate(idx->meta, g_array_index(idx->order, guint32, pos));
+        }
+        break;
+    }
+
+    g_free(p);
+    if (changed) {
+        maybe_compact(idx);
+        idx->generation++;
+    }
+    return changed;
+}
+
+/*---------------------------------------------------------------------------
+ * Public: generation counter (changes whenever the file set changes).
+ *-------------------------------------------------------------------------*/
+guint64
+umi_index_generation(const UmiFileIndex *idx)
+{
+    return idx ? idx->generation : 0;
+}
+
 /*---------------------------------------------------------------------------
- * Public helper: expose a read-only view (non-owning) of the paths, for panels
- * that want to render lists without copying.
+ * Public: id epoch (changes whenever file ids are renumbered).
+ *-------------------------------------------------------------------------*/
+guint64
+umi_index_epoch(const UmiFileIndex *idx)
+{
+    return idx ? idx->epoch : 0;
+}
+
+/*===========================================================================
+ * Read access
+ *=========================================================================*/
+
+guint
+umi_index_count(const UmiFileIndex *idx)
+{
+    return idx ? idx->order->len : 0;
+}
+
+const char *
+umi_index_root(const UmiFileIndex *idx)
+{
+    return idx ? idx->root : NULL;
+}
+
+void
+umi_index_iter_init(UmiIndexIter *it, const UmiFileIndex *idx)
+{
+    memset(it, 0, sizeof *it);
+    it->idx      = idx;
+    it->dir      = NO_ID;
+    it->path     = g_string_new(NULL);
+    it->path_dir = NO_ID;
+}
+
+gboolean
+umi_index_iter_next(UmiIndexIter *it)
+{
+    if (!it->idx || it->pos >= it->idx->order->len) return FALSE;
+    it->id = g_array_index(it->idx->order, guint32, it->pos++);
+    const IdxFile *f = FILE_AT(it->idx, it->id);
+    it->dir  = f->dir;
+    it->name = NAME_AT(it->idx, f->name_off);
+    return TRUE;
+}
+
+const char *
+umi_index_iter_path(UmiIndexIter *it)
+{
+    if (!it->name) return NULL;
+    /* Files come grouped by directory: rebuild the prefix only on change. */
+    if (it->path_dir != it->dir) {
+        g_string_truncate(it->path, 0);
+        dir_abs_path(it->idx, it->dir, it->path);
+        g_string_append_c(it->path, G_DIR_SEPARATOR);
+        it->dir_len  = it->path->len;
+        it->path_dir = it->dir;
+    }
+    g_string_truncate(it->path, it->dir_len);
+    g_string_append(it->path, it->name);
+    return it->path->str;
+}
+
+void
+umi_index_iter_clear(UmiIndexIter *it)
+{
+    if (it->path) g_string_free(it->path, TRUE);
+    it->path = NULL;
+    it->name = NULL;
+}
+
+static const IdxFile *
+live_file(const UmiFileIndex *idx, guint32 file_id)
+{
+    if (!idx || file_id >= idx->files->len) return NULL;
+    const IdxFile *f = FILE_AT(idx, file_id);
+    return f->dir == NO_ID ? NULL : f;
+}
+
+const char *
+umi_index_file_name(const UmiFileIndex *idx, guint32 file_id)
+{
+    const IdxFile *f = live_file(idx, file_id);
+    return f ? NAME_AT(idx, f->name_off) : NULL;
+}
+
+char *
+umi_index_file_path(const UmiFileIndex *idx, guint32 file_id)
+{
+    const IdxFile *f = live_file(idx, file_id);
+    if (!f) return NULL;
+    GString *s = g_string_new(NULL);
+    dir_abs_path(idx, f->dir, s);
+    g_string_append_c(s, G_DIR_SEPARATOR);
+    g_string_append(s, NAME_AT(idx, f->name_off));
+    return g_string_free(s, FALSE);
+}
+
+guint32
+umi_index_lookup(const UmiFileIndex *idx, const char *path)
+{
+    if (!idx || !path || !*path) return UMI_INDEX_NO_FILE;
+    char *p = g_canonicalize_filename(path, NULL);
+    const char *rel = rel_to_root(idx, p);
+    const gint pos = (rel && *rel) ? find_file_pos(idx, rel) : -1;
+    g_free(p);
+    return pos < 0 ? UMI_INDEX_NO_FILE : g_array_index(idx->order, guint32, pos);
+}
+
+UmiFileMeta *
+umi_index_meta(const UmiFileIndex *idx)
+{
+    return idx ? idx->meta : NULL;
+}
+
+/*---------------------------------------------------------------------------
+ * Public helper: read-only view of full paths for panels that want plain
+ * strings. Materialized once per generation and owned by the index; this
+ * is the one place full paths are kept, so big trees should iterate.
  *-------------------------------------------------------------------------*/
 const char * const *
 umi_index_files_real(const UmiFileIndex *idx, guint *out_len)
 {
-    if (!idx || !idx->files) {
+    if (!idx) {
         if (out_len) *out_len = 0;
         return NULL;
     }
-    if (out_len) *out_len = idx->files->len;
-    return (const char * const *)idx->files->pdata;
+    UmiFileIndex *mut = (UmiFileIndex *)idx;          /* cache only */
+    if (!mut->paths_cache || mut->paths_gen != idx->generation) {
+        if (mut->paths_cache) g_ptr_array_free(mut->paths_cache, TRUE);
+        mut->paths_cache = g_ptr_array_new_full(idx->order->len, g_free);
+        UmiIndexIter it;
+        umi_index_iter_init(&it, idx);
+        while (umi_index_iter_next(&it))
+            g_ptr_array_add(mut->paths_cache, g_strdup(umi_index_iter_path(&it)));
+        umi_index_iter_clear(&it);
+        mut->paths_gen = idx->generation;
+    }
+    if (out_len) *out_len = mut->paths_cache->len;
+    return (const char * const *)mut->paths_cache->pdata;
+}
+
+/*===========================================================================
+ * Persistent snapshot
+ *
+ * FORMAT (native endianness; it is a local cache, not an exchange format):
+ *
+ *   SnapHeader
+ *   SnapDir [n_dirs]    in dir_order; parent is an index into this table
+ *                       (parents precede children; entry 0 is the root)
+ *   SnapFile[n_files]   in file order (grouped by dir, names sorted)
+ *   SnapMeta[n_files]   metadata cache entry of each file, same order
+ *   strings             the name arena verbatim, then the canonical root
+ *
+ * The tables mirror the in-memory layout, so loading is a copy of the
+ * arena plus one pass over the tables; nothing is re-parsed beyond bounds
+ * checks. Reconciliation costs one stat() per directory, plus a read of
+ * the ignore files of directories that had some (or whose mtime moved):
+ * when a directory's rules changed, its whole subtree is walked again.
+ *=========================================================================*/
+
+#define SNAP_MAGIC   "UMIX"
+#define SNAP_VERSION 4u
+
+typedef struct SnapHeader {
+    char    magic[4];
+    guint32 version;
+    guint32 n_dirs;
+    guint32 n_files;
+    guint32 strings_len;
+    guint32 root_off;    /* canonical root the snapshot was taken from    */
+} SnapHeader;
+
+typedef struct SnapDir {
+    guint32 parent;      /* NO_ID for the root                            */
+    guint32 name_off;
+    gint64  mtime_us;
+    gint64  ign_stamp;   /* umi_ignore_stamp() when the dir was listed    */
+} SnapDir;
+
+typedef struct SnapFile {
+    guint32 dir_id;
+    guint32 name_off;
+} SnapFile;
+
+#define SNAP_META_KNOWN 0x100u   /* flags: stat fields valid              */
+#define SNAP_META_HASH  0x200u   /* flags: 'hash' valid; low byte = kind  */
+
+typedef struct SnapMeta {
+    gint64  size;
+    gint64  mtime_us;
+    guint64 ino;
+    guint64 hash;
+    guint32 flags;
+    guint32 reserved;
+} SnapMeta;
+
+/* Live directory mtime in the same unit/precision the walker records. */
+static gboolean
+stat_dir_mtime(const char *path, gint64 *out_mtime_us)
+{
+#ifdef G_OS_UNIX
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) return FALSE;
+    *out_mtime_us = (gint64)st.st_mtim.tv_sec * G_USEC_PER_SEC + st.st_mtim.tv_nsec / 1000;
+#else
+    GStatBuf st;
+    if (g_stat(path, &st) != 0 || !(st.st_mode & S_IFDIR)) return FALSE;
+    *out_mtime_us = (gint64)st.st_mtime * G_USEC_PER_SEC;
+#endif
+    return TRUE;
+}
+
+/* Path relative to root ("" for the root itself). */
+static const char *
+rel_to_root(const UmiFileIndex *idx, const char *path)
+{
+    const gsize rl = strlen(idx->root);
+    if (strncmp(path, idx->root, rl) != 0) return NULL;
+    if (path[rl] == '\0') return "";
+    if (path[rl] != G_DIR_SEPARATOR) return NULL;
+    return path + rl + 1;
+}
+
+/*---------------------------------------------------------------------------
+ * Public: serialize 'idx' and write it atomically to 'snapshot_path'.
+ *-------------------------------------------------------------------------*/
+gboolean
+umi_index_save(const UmiFileIndex *idx, const char *snapshot_path, GError **err)
+{
+    if (!idx || !snapshot_path) return FALSE;
+
+    const guint32 n_dirs  = idx->dir_order->len;
+    const guint32 n_files = idx->order->len;
+    const gsize   root_sz = strlen(idx->root) + 1;
+
+    SnapHeader h;
+    memcpy(h.magic, SNAP_MAGIC, 4);
+    h.version     = SNAP_VERSION;
+    h.n_dirs      = n_dirs;
+    h.n_files     = n_files;
+    h.strings_len = idx->arena->len + (guint32)root_sz;
+    h.root_off    = idx->arena->len;
+
+    GByteArray *out = g_byte_array_sized_new((guint)(sizeof h + n_dirs * sizeof(SnapDir) +
+                                                     n_files * (sizeof(SnapFile) + sizeof(SnapMeta)) +
+                                                     h.strings_len));
+    g_byte_array_append(out, (const guint8 *)&h, sizeof h);
+
+    /* Ranks are dir_order positions, i.e. the snapshot's dir indices. */
+    for (guint i = 0; i < n_dirs; ++i) {
+        const IdxDir *d = DIR_AT(idx, g_array_index(idx->dir_order, guint32, i));
+        SnapDir sd = { d->parent == NO_ID ? NO_ID : DIR_AT(idx, d->parent)->rank,
+                       d->name_off, d->mtime_us, d->ign_stamp };
+        g_byte_array_append(out, (const guint8 *)&sd, sizeof sd);
+    }
+    for (guint i = 0; i < n_files; ++i) {
+        const IdxFile *f = FILE_AT(idx, g_array_index(idx->order, guint32, i));
+        SnapFile sf = { DIR_AT(idx, f->dir)->rank, f->name_off };
+        g_byte_array_append(out, (const guint8 *)&sf, sizeof sf);
+    }
+    for (guint i = 0; i < n_files; ++i) {
+        SnapMeta    sm = { 0 };
+        UmiFileStat st;
+        if (umi_file_meta_peek(idx->meta, g_array_index(idx->order, guint32, i), &st)) {
+            sm.size     = st.size;
+            sm.mtime_us = st.mtime_us;
+            sm.ino      = st.ino;
+            sm.hash     = st.has_hash ? st.hash : 0;
+            sm.flags    = SNAP_META_KNOWN | (st.has_hash ? SNAP_META_HASH : 0) | (guint32)st.kind;
+        }
+        g_byte_array_append(out, (const guint8 *)&sm, sizeof sm);
+    }
+    g_byte_array_append(out, idx->arena->data, idx->arena->len);
+    g_byte_array_append(out, (const guint8 *)idx->root, (guint)root_sz);
+
+    char *parent = g_path_get_dirname(snapshot_path);
+    g_mkdir_with_parents(parent, 0755);
+    g_free(parent);
+
+    const gboolean ok = umi_file_save_atomic(snapshot_path, (const char *)out->data, out->len, err);
+
+    g_byte_array_free(out, TRUE);
+    return ok;
+}
+
+/* Hand a snapshot metadata entry to the cache (to be verified on use). */
+static void
+restore_meta(UmiFileIndex *idx, guint32 file_id, const SnapMeta *sm)
+{
+    if (!(sm->flags & SNAP_META_KNOWN)) return;
+    UmiFileStat st;
+    st.size     = sm->size;
+    st.mtime_us = sm->mtime_us;
+    st.ino      = sm->ino;
+    st.kind     = (UmiFileKind)(sm->flags & 0xffu);
+    st.has_hash = (sm->flags & SNAP_META_HASH) != 0;
+    st.hash     = sm->hash;
+    if (st.kind > UMI_FILE_KIND_BINARY) st.kind = UMI_FILE_KIND_UNKNOWN;
+    umi_file_meta_restore(idx->meta, file_id, &st);
+}
+
+/* The recorded files of one snapshot directory (names sorted). */
+typedef struct SnapRange {
+    const SnapFile *files;
+    const SnapMeta *meta;
+    guint32         n;
+    const char     *strings;
+} SnapRange;
+
+static const SnapMeta *
+snap_range_find(const SnapRange *sr, const char *name)
+{
+    guint32 lo = 0, hi = sr->n;
+    while (lo < hi) {
+        const guint32 mid = lo + (hi - lo) / 2;
+        const int c = strcmp(sr->strings + sr->files[mid].name_off, name);
+        if (c == 0) return &sr->meta[mid];
+        if (c < 0) lo = mid + 1;
+        else       hi = mid;
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------
+ * Helper: re-read one directory whose mtime changed. Files are taken from
+ * the live listing (keeping the recorded metadata of names seen before);
+ * subdirectories unknown to the snapshot are new subtrees and get a full
+ * walk. Known subdirectories are reconciled on their own (the rules in
+ * effect here are unchanged, or the caller would have re-walked the whole
+ * subtree instead).
+ *-------------------------------------------------------------------------*/
+static void
+relist_dir(UmiFileIndex *idx, const char *dir, guint32 dir_id, GHashTable *snap_dirs,
+           const SnapRange *known)
+{
+    GDir *d = g_dir_open(dir, 0, NULL);
+    if (!d) return;
+    UmiIgnoreScope *scope = umi_ignore_scope_new(idx->ignore, dir);
+    for (const char *name = g_dir_read_name(d); name; name = g_dir_read_name(d)) {
+        if (name[0] == '.') continue;                   /* same rule as walk */
+        char *full = g_build_filename(dir, name, NULL);
+        const gboolean is_dir = g_file_test(full, G_FILE_TEST_IS_DIR);
+        if (umi_ignore_scope_match(scope, name, is_dir)) {
+            /* pruned, as in the walk */
+        } else if (!is_dir) {
+            const guint32   id = new_file(idx, dir_id, name);
+            const SnapMeta *sm = snap_range_find(known, name);
+            if (sm) restore_meta(idx, id, sm);
+        } else if (!g_file_test(full, G_FILE_TEST_IS_SYMLINK) &&
+                   !g_hash_table_contains(snap_dirs, full)) {
+            const guint32 sub = new_dir(idx, dir_id, name, -1);
+            (void)scan_tree(idx, full, sub);            /* brand-new subtree */
+        }
+        g_free(full);
+    }
+    umi_ignore_scope_free(scope);
+    g_dir_close(d);
+}
+
+/*---------------------------------------------------------------------------
+ * Helper: validate the mapping and reconcile it against the live tree.
+ * Returns FALSE when the snapshot is unusable (caller falls back to a scan).
+ *-------------------------------------------------------------------------*/
+static gboolean
+load_snapshot(UmiFileIndex *idx, const char *data, gsize len, gboolean *out_changed)
+{
+    if (len < sizeof(SnapHeader)) return FALSE;
+    SnapHeader h;
+    memcpy(&h, data, sizeof h);
+    if (memcmp(h.magic, SNAP_MAGIC, 4) != 0 || h.version != SNAP_VERSION) return FALSE;
+
+    const gsize need = sizeof h + (gsize)h.n_dirs * sizeof(SnapDir) +
+                       (gsize)h.n_files * (sizeof(SnapFile) + sizeof(SnapMeta)) + h.strings_len;
+    if (need != len || h.strings_len == 0 || h.n_dirs == 0) return FALSE;
+
+    const SnapDir  *sdirs   = (const SnapDir *)(const void *)(data + sizeof h);
+    const SnapFile *sfiles  = (const SnapFile *)(const void *)(sdirs + h.n_dirs);
+    const SnapMeta *smeta   = (const SnapMeta *)(const void *)(sfiles + h.n_files);
+    const char     *strings = (const char *)(smeta + h.n_files);
+    if (strings[h.strings_len - 1] != '\0' || h.root_off >= h.strings_len) return FALSE;
+    if (h.root_off == 0 || strings[h.root_off - 1] != '\0') return FALSE;
+    if (g_strcmp0(strings + h.root_off, idx->root) != 0) return FALSE;
+    if (sdirs[0].parent != NO_ID) return FALSE;
+    for (guint32 i = 0; i < h.n_dirs; ++i) {
+        if (sdirs[i].name_off >= h.root_off) return FALSE;
+        if (i > 0 && sdirs[i].parent >= i) return FALSE;  /* parents first */
+    }
+    for (guint32 i = 0; i < h.n_files; ++i) {
+        if (sfiles[i].dir_id >= h.n_dirs || sfiles[i].name_off >= h.root_off) return FALSE;
+        if (i > 0 && sfiles[i].dir_id < sfiles[i - 1].dir_id) return FALSE;
+    }
+
+    /* Adopt the arena as is: name offsets in the tables stay valid. */
+    reset_tables(idx);
+    g_byte_array_set_size(idx->arena, 0);
+    g_byte_array_append(idx->arena, (const guint8 *)strings, h.root_off);
+    names_rebuild(idx);
+    g_array_set_size(idx->dirs, 0);
+
+    /* Absolute path of every snapshot directory (parents come first). */
+    char      **full      = g_new0(char *, h.n_dirs);
+    GHashTable *snap_dirs = g_hash_table_new(g_str_hash, g_str_equal);
+    full[0] = g_strdup(idx->root);
+    for (guint32 i = 1; i < h.n_dirs; ++i)
+        full[i] = g_build_filename(full[sdirs[i].parent], strings + sdirs[i].name_off, NULL);
+    for (guint32 i = 0; i < h.n_dirs; ++i) g_hash_table_add(snap_dirs, full[i]);
+
+    guint32  *map     = g_new(guint32, h.n_dirs);      /* snapshot -> new id */
+    gboolean *covered = g_new0(gboolean, h.n_dirs);    /* inside a re-walk  */
+    idx->scan_dirs = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    gboolean changed = FALSE;
+    guint32  f = 0;                                     /* cursor in sfiles */
+    for (guint32 i = 0; i < h.n_dirs; ++i) {
+        const guint32 sp = sdirs[i].parent;
+        gint64        live = 0;
+        map[i] = NO_ID;
+
+        guint32 f_end = f;
+        while (f_end < h.n_files && sfiles[f_end].dir_id == i) ++f_end;
+
+        if (sp != NO_ID && covered[sp]) {
+            covered[i] = TRUE;                          /* already re-walked */
+        } else if ((sp != NO_ID && map[sp] == NO_ID) || !stat_dir_mtime(full[i], &live)) {
+            changed = TRUE;                             /* removed: drop it  */
+        } else {
+            /* Rules can only have changed if there were ignore files, or
+             * if the listing changed (one was created). */
+            gint64 stamp = sdirs[i].ign_stamp;
+            if (stamp != 0 || live != sdirs[i].mtime_us)
+                stamp = umi_ignore_stamp(idx->ignore, full[i]);
+
+            IdxDir d = { sp == NO_ID ? NO_ID : map[sp], sdirs[i].name_off, 0, 1, live, stamp };
+            g_array_append_val(idx->dirs, d);
+            map[i] = idx->dirs->len - 1;
+            scan_seed(idx, full[i], map[i]);
+            if (stamp != sdirs[i].ign_stamp) {          /* rules changed     */
+                (void)scan_tree(idx, full[i], map[i]);
+                covered[i] = TRUE;
+                changed = TRUE;
+            } else if (live == sdirs[i].mtime_us) {     /* unchanged: reuse  */
+                for (guint32 k = f; k < f_end; ++k) {
+                    IdxFile nf = { map[i], sfiles[k].name_off };
+                    g_array_append_val(idx->files, nf);
+                    restore_meta(idx, idx->files->len - 1, &smeta[k]);
+                }
+            } else {                                    /* mtime sampled     */
+                const SnapRange known = { sfiles + f, smeta + f, f_end - f, strings };
+                relist_dir(idx, full[i], map[i], snap_dirs, &known); /* BEFORE read */
+                changed = TRUE;
+            }
+        }
+        f = f_end;
+    }
+
+    g_clear_pointer(&idx->scan_dirs, g_hash_table_destroy);
+    g_free(covered);
+    g_free(map);
+    g_hash_table_destroy(snap_dirs);
+    for (guint32 i = 0; i < h.n_dirs; ++i) g_free(full[i]);
+    g_free(full);
+
+    if (idx->dirs->len == 0) return FALSE;              /* root vanished    */
+    rebuild_order(idx);
+    idx->arena_mark = idx->arena->len;
+    if (out_changed) *out_changed = changed;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------
+ * Public: open an index from a snapshot, reconciling with the disk.
+ *-------------------------------------------------------------------------*/
+UmiFileIndex *
+umi_index_open(const char *root, const char *snapshot_path)
+{
+    if (!root || !*root) return NULL;
+
+    UmiFileIndex *idx = index_new_empty(root);
+    gboolean loaded  = FALSE;
+    gboolean changed = TRUE;
+
+    GMappedFile *mf = snapshot_path ? g_mapped_file_new(snapshot_path, FALSE, NULL) : NULL;
+    if (mf) {
+        loaded = load_snapshot(idx, g_mapped_file_get_contents(mf),
+                               g_mapped_file_get_length(mf), &changed);
+        g_mapped_file_unref(mf);
+    }
+
+    if (!loaded) {
+        full_scan(idx);                                 /* discards partials */
+        changed = TRUE;
+    }
+
+    if (changed && snapshot_path) {
+        GError *err = NULL;
+        if (!umi_index_save(idx, snapshot_path, &err)) {
+            g_warning("file_index: cannot write snapshot '%s': %s",
+                      snapshot_path, err ? err->message : "unknown");
+            g_clear_error(&err);
+        }
+    }
+    return idx;
+}
+
+/*---------------------------------------------------------------------------
+ * Public: default per-root snapshot location in the user cache directory.
+ *-------------------------------------------------------------------------*/
+char *
+umi_index_snapshot_path_for(const char *root)
+{
+    if (!root || !*root) return NULL;
+    char *canon = g_canonicalize_filename(root, NULL);
+    char *key   = g_compute_checksum_for_string(G_CHECKSUM_SHA1, canon, -1);
+    char *leaf  = g_strconcat(key, ".idx", NULL);
+    char *path  = g_build_filename(g_get_user_cache_dir(), "umicom-studio-ide", "index", leaf, NULL);
+    g_free(leaf);
+    g_free(key);
+    g_free(canon);
+    return path;
 }
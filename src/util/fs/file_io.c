@@ -11,20 +11,32 @@
 #include <errno.h>                  /* errno for error reporting */
 #include <string.h>                 /* strerror for human-readable errno text */
 
-/* Atomic path write: "path.tmp" -> "path" via rename on success. */
-gboolean umi_file_save_atomic(const char *path, const char *data, gssize len, GError **err){
+/* Stage: write 'data' to the sibling "path.tmp", with the mode of 'path'. */
+gchar *umi_file_stage(const char *path, const char *data, gssize len, GError **err){
   if(!path)                                        /* Validate required arg. */
-    return FALSE;                                  /* No path => cannot save. */
+    return NULL;                                   /* No path => nothing to stage. */
 
   gchar *tmp = g_strconcat(path, ".tmp", NULL);    /* Create sibling temp path string. */
 
   /* Write file contents to temp path first. If len < 0, GLib will use strlen(data). */
-  gboolean ok = g_file_set_contents(tmp, data, len, err); /* On failure, 'err' set by GLib. */
-  if(!ok){                                         /* If write failed... */
-    g_free(tmp);                                   /* ...free temp path and bail. */
-    return FALSE;
+  if(!g_file_set_contents(tmp, data, len, err)){   /* On failure, 'err' set by GLib. */
+    (void)g_remove(tmp);                           /* Best-effort cleanup of a partial temp. */
+    g_free(tmp);
+    return NULL;
   }
 
+  /* Keep the permissions of the file being replaced (e.g. scripts stay executable). */
+  GStatBuf st;
+  if(g_stat(path, &st) == 0)                       /* No old file => GLib's default mode. */
+    (void)g_chmod(tmp, st.st_mode & 07777);
+  return tmp;                                      /* Caller commits or discards it. */
+}
+
+/* Commit: rename a staged temp over 'path'; the temp is gone either way. */
+gboolean umi_file_commit(const char *tmp, const char *path, GError **err){
+  if(!tmp || !path)                                /* Validate required args. */
+    return FALSE;
+
   /* Try to rename atomically into final destination. */
   if(g_rename(tmp, path) != 0){                    /* Non-zero -> rename failed. */
     int e = errno;                                 /* Snapshot errno ASAP. */
@@ -33,12 +45,18 @@ gboolean umi_file_save_atomic(const char *path, const char *data, gssize len, GE
       *err = g_error_new_literal(g_quark_from_string("umi.io"), e ? e : 1, msg);
       g_free(msg);
     }
-    /* Attempt to clean up dangling temp file. */
     (void)g_remove(tmp);                           /* Best-effort temp cleanup. */
-    g_free(tmp);                                   /* Free temp path string. */
     return FALSE;                                  /* Report failure. */
   }
-
-  g_free(tmp);                                     /* Free temp path on success as well. */
   return TRUE;                                     /* All good. */
 }
+
+/* Atomic path write: "path.tmp" -> "path" via rename on success. */
+gboolean umi_file_save_atomic(const char *path, const char *data, gssize len, GError **err){
+  gchar *tmp = umi_file_stage(path, data, len, err);   /* Temp written, 'path' untouched. */
+  if(!tmp)
+    return FALSE;
+  const gboolean ok = umi_file_commit(tmp, path, err); /* One rename makes it visible. */
+  g_free(tmp);
+  return ok;
+}
@@ -0,0 +1,429 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/util/fs/file_meta.c
+ *
+ * PURPOSE:
+ *   Metadata cache behind umi_index_meta(): one small record per file id
+ *   (stat fields, kind, content hash), filled by the index walk and lazily
+ *   completed by lookups.
+ *
+ * RECORD STATES:
+ *   EMPTY      : nothing known; the next lookup stat()s the file.
+ *   UNVERIFIED : restored from a snapshot; the next lookup stat()s it and
+ *                keeps kind/hash only if size, mtime and inode all match.
+ *   VALID      : stat fields are current (walk, lookup, no event since).
+ *   Every invalidation bumps the record's epoch. Lazy work (stat, sniff,
+ *   hash) runs outside the lock and is committed only if the epoch and the
+ *   stat fields it started from are still the same, so a result computed
+ *   against an older version of the file is never stored.
+ *
+ * HASH:
+ *   XXH64 (seed 0), a few GB/s per core over a mapped file; the exact
+ *   function matters only in that snapshots from older builds must not be
+ *   compared against it (the snapshot version covers that).
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include "include/file_meta.h"
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define SNIFF_LEN 8000u         /* same window as git's binary detection    */
+
+enum { META_EMPTY = 0, META_UNVERIFIED, META_VALID };
+
+typedef struct MetaRec {
+    gint64  size;
+    gint64  mtime_us;
+    guint64 ino;
+    guint64 hash;
+    guint32 epoch;       /* bumped by every invalidation                    */
+    guint8  state;       /* META_*                                          */
+    guint8  kind;        /* UmiFileKind                                     */
+    guint8  has_hash;
+} MetaRec;
+
+struct _UmiFileMeta {
+    const UmiFileIndex *idx;     /* owner; resolves ids to paths             */
+    GMutex              lock;
+    GArray             *recs;    /* MetaRec by file id, zero-filled on growth */
+};
+
+/*===========================================================================
+ * XXH64
+ *=========================================================================*/
+
+#define XXP1 11400714785074694791ULL
+#define XXP2 14029467366897019727ULL
+#define XXP3  1609587929392839161ULL
+#define XXP4  9650029242287828579ULL
+#define XXP5  2870177450012600261ULL
+
+static inline guint64 rotl64(guint64 x, int r) { return (x << r) | (x >> (64 - r)); }
+
+static inline guint64
+rd64(const guint8 *p)
+{
+    guint64 v;
+    memcpy(&v, p, 8);
+    return GUINT64_FROM_LE(v);
+}
+
+static inline guint32
+rd32(const guint8 *p)
+{
+    guint32 v;
+    memcpy(&v, p, 4);
+    return GUINT32_FROM_LE(v);
+}
+
+static inline guint64
+xx_round(guint64 acc, guint64 in)
+{
+    acc += in * XXP2;
+    return rotl64(acc, 31) * XXP1;
+}
+
+static inline guint64
+xx_merge(guint64 h, guint64 v)
+{
+    h ^= xx_round(0, v);
+    return h * XXP1 + XXP4;
+}
+
+guint64
+umi_file_meta_hash_bytes(const void *data, gsize len)
+{
+    const guint8 *p   = (const guint8 *)data;
+    const guint8 *end = p + len;
+    guint64 h;
+
+    if (len >= 32) {
+        const guint8 *limit = end - 32;
+        guint64 v1 = XXP1 + XXP2, v2 = XXP2, v3 = 0, v4 = 0 - XXP1;
+        do {
+            v1 = xx_round(v1, rd64(p));      p += 8;
+            v2 = xx_round(v2, rd64(p));      p += 8;
+            v3 = xx_round(v3, rd64(p));      p += 8;
+            v4 = xx_round(v4, rd64(p));      p += 8;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xx_merge(h, v1);
+        h = xx_merge(h, v2);
+        h = xx_merge(h, v3);
+        h = xx_merge(h, v4);
+    } else {
+        h = XXP5;
+    }
+    h += (guint64)len;
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= xx_round(0, rd64(p));
+        h  = rotl64(h, 27) * XXP1 + XXP4;
+    }
+    if (p + 4 <= end) {
+        h ^= (guint64)rd32(p) * XXP1;
+        h  = rotl64(h, 23) * XXP2 + XXP3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= (guint64)*p * XXP5;
+        h  = rotl64(h, 11) * XXP1;
+    }
+    h ^= h >> 33;
+    h *= XXP2;
+    h ^= h >> 29;
+    h *= XXP3;
+    h ^= h >> 32;
+    return h;
+}
+
+/*===========================================================================
+ * Records
+ *=========================================================================*/
+
+/* Record for 'id' (lock held); NULL past the end unless 'grow'. The pointer
+ * is only good until the array grows again. */
+static MetaRec *
+rec_at(UmiFileMeta *m, guint32 id, gboolean grow)
+{
+    if (id >= m->recs->len) {
+        if (!grow) return NULL;
+        g_array_set_size(m->recs, id + 1);
+    }
+    return &g_array_index(m->recs, MetaRec, id);
+}
+
+static gboolean
+same_stat(const MetaRec *r, gint64 size, gint64 mtime_us, guint64 ino)
+{
+    return r->size == size && r->mtime_us == mtime_us && r->ino == ino;
+}
+
+/* stat() following symlinks, in the units fs_walk reports. Regular files only. */
+static gboolean
+stat_file(const char *path, gint64 *size, gint64 *mtime_us, guint64 *ino)
+{
+#ifdef G_OS_UNIX
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) return FALSE;
+    *mtime_us = (gint64)st.st_mtim.tv_sec * G_USEC_PER_SEC + st.st_mtim.tv_nsec / 1000;
+#else
+    GStatBuf st;
+    if (g_stat(path, &st) != 0 || !(st.st_mode & S_IFREG)) return FALSE;
+    *mtime_us = (gint64)st.st_mtime * G_USEC_PER_SEC;
+#endif
+    *size = (gint64)st.st_size;
+    *ino  = (guint64)st.st_ino;
+    return TRUE;
+}
+
+static void
+rec_to_stat(const MetaRec *r, UmiFileStat *out)
+{
+    out->size     = r->size;
+    out->mtime_us = r->mtime_us;
+    out->ino      = r->ino;
+    out->kind     = (UmiFileKind)r->kind;
+    out->has_hash = r->has_hash;
+    out->hash     = r->hash;
+}
+
+/*---------------------------------------------------------------------------
+ * Make the record for 'id' VALID (one stat() outside the lock if needed)
+ * and copy it to 'out'. FALSE when the id is dead or the file is gone.
+ *-------------------------------------------------------------------------*/
+static gboolean
+ensure_valid(UmiFileMeta *m, guint32 id, MetaRec *out)
+{
+    g_mutex_lock(&m->lock);
+    MetaRec *r = rec_at(m, id, FALSE);
+    if (r && r->state == META_VALID) {
+        *out = *r;
+        g_mutex_unlock(&m->lock);
+        return TRUE;
+    }
+    const guint32 epoch = r ? r->epoch : 0;
+    g_mutex_unlock(&m->lock);
+
+    char *path = umi_index_file_path(m->idx, id);
+    gint64  size = 0, mtime_us = 0;
+    guint64 ino = 0;
+    const gboolean ok = path && stat_file(path, &size, &mtime_us, &ino);
+    g_free(path);
+    if (!ok) return FALSE;
+
+    g_mutex_lock(&m->lock);
+    r = rec_at(m, id, TRUE);
+    if (r->epoch == epoch && r->state != META_VALID) {
+        if (r->state != META_UNVERIFIED || !same_stat(r, size, mtime_us, ino)) {
+            r->kind     = UMI_FILE_KIND_UNKNOWN;
+            r->has_hash = FALSE;
+        }
+        r->size     = size;
+        r->mtime_us = mtime_us;
+        r->ino      = ino;
+        r->state    = META_VALID;
+    }
+    if (r->epoch == epoch && r->state == META_VALID && same_stat(r, size, mtime_us, ino)) {
+        *out = *r;
+    } else {                                  /* invalidated meanwhile */
+        memset(out, 0, sizeof *out);
+        out->size     = size;
+        out->mtime_us = mtime_us;
+        out->ino      = ino;
+        out->epoch    = G_MAXUINT32;          /* never commits */
+    }
+    g_mutex_unlock(&m->lock);
+    return TRUE;
+}
+
+/* Store lazily computed results if the record still describes the version
+ * of the file they were computed from. */
+static void
+commit(UmiFileMeta *m, guint32 id, const MetaRec *seen,
+       UmiFileKind kind, gboolean has_hash, guint64 hash)
+{
+    g_mutex_lock(&m->lock);
+    MetaRec *r = rec_at(m, id, FALSE);
+    if (r && r->state == META_VALID && r->epoch == seen->epoch &&
+        same_stat(r, seen->size, seen->mtime_us, seen->ino)) {
+        if (kind != UMI_FILE_KIND_UNKNOWN) r->kind = (guint8)kind;
+        if (has_hash) {
+            r->hash     = hash;
+            r->has_hash = TRUE;
+        }
+    }
+    g_mutex_unlock(&m->lock);
+}
+
+static UmiFileKind
+sniff(const char *data, gsize len)
+{
+    return memchr(data, '\0', MIN(len, (gsize)SNIFF_LEN)) ? UMI_FILE_KIND_BINARY
+                                                           : UMI_FILE_KIND_TEXT;
+}
+
+/*===========================================================================
+ * Lookups
+ *=========================================================================*/
+
+gboolean
+umi_file_meta_stat(UmiFileMeta *m, guint32 file_id, UmiFileStat *out)
+{
+    if (!m || !out) return FALSE;
+    MetaRec r;
+    if (!ensure_valid(m, file_id, &r)) return FALSE;
+    rec_to_stat(&r, out);
+    return TRUE;
+}
+
+UmiFileKind
+umi_file_meta_kind(UmiFileMeta *m, guint32 file_id)
+{
+    if (!m) return UMI_FILE_KIND_UNKNOWN;
+    MetaRec r;
+    if (!ensure_valid(m, file_id, &r)) return UMI_FILE_KIND_UNKNOWN;
+    if (r.kind != UMI_FILE_KIND_UNKNOWN) return (UmiFileKind)r.kind;
+
+    char *path = umi_index_file_path(m->idx, file_id);
+    FILE *fp   = path ? g_fopen(path, "rb") : NULL;
+    g_free(path);
+    if (!fp) return UMI_FILE_KIND_UNKNOWN;
+    char  buf[SNIFF_LEN];
+    const gsize n = fread(buf, 1, sizeof buf, fp);
+    fclose(fp);
+
+    const UmiFileKind kind = sniff(buf, n);
+    commit(m, file_id, &r, kind, FALSE, 0);
+    return kind;
+}
+
+gboolean
+umi_file_meta_hash(UmiFileMeta *m, guint32 file_id, guint64 *out_hash)
+{
+    if (!m) return FALSE;
+    MetaRec r;
+    if (!ensure_valid(m, file_id, &r)) return FALSE;
+    if (r.has_hash) {
+        if (out_hash) *out_hash = r.hash;
+        return TRUE;
+    }
+
+    char *path = umi_index_file_path(m->idx, file_id);
+    GMappedFile *mf = path ? g_mapped_file_new(path, FALSE, NULL) : NULL;
+    if (!mf) {
+        g_free(path);
+        return FALSE;
+    }
+    const char *data = g_mapped_file_get_contents(mf);
+    const gsize len  = g_mapped_file_get_length(mf);
+    const guint64 h  = umi_file_meta_hash_bytes(data, len);
+    const UmiFileKind kind = sniff(data ? data : "", len);
+    g_mapped_file_unref(mf);
+
+    /* Only remember it if the file did not move under us while reading. */
+    gint64  size = 0, mtime_us = 0;
+    guint64 ino = 0;
+    if (stat_file(path, &size, &mtime_us, &ino) && same_stat(&r, size, mtime_us, ino))
+        commit(m, file_id, &r, kind, TRUE, h);
+    g_free(path);
+
+    if (out_hash) *out_hash = h;
+    return TRUE;
+}
+
+/*===========================================================================
+ * Index hooks
+ *=========================================================================*/
+
+UmiFileMeta *
+umi_file_meta_new(const UmiFileIndex *idx)
+{
+    UmiFileMeta *m = g_new0(UmiFileMeta, 1);
+    m->idx  = idx;
+    m->recs = g_array_new(FALSE, TRUE, sizeof(MetaRec));
+    g_mutex_init(&m->lock);
+    return m;
+}
+
+void
+umi_file_meta_free(UmiFileMeta *m)
+{
+    if (!m) return;
+    g_array_free(m->recs, TRUE);
+    g_mutex_clear(&m->lock);
+    g_free(m);
+}
+
+void
+umi_file_meta_reset(UmiFileMeta *m)
+{
+    if (!m) return;
+    g_mutex_lock(&m->lock);
+    g_array_set_size(m->recs, 0);
+    g_mutex_unlock(&m->lock);
+}
+
+void
+umi_file_meta_record(UmiFileMeta *m, guint32 file_id,
+                     gint64 size, gint64 mtime_us, guint64 ino)
+{
+    if (!m) return;
+    g_mutex_lock(&m->lock);
+    MetaRec *r = rec_at(m, file_id, TRUE);
+    if (r->state == META_EMPTY || !same_stat(r, size, mtime_us, ino)) {
+        r->kind     = UMI_FILE_KIND_UNKNOWN;
+        r->has_hash = FALSE;
+    }
+    r->size     = size;
+    r->mtime_us = mtime_us;
+    r->ino      = ino;
+    r->state    = META_VALID;
+    g_mutex_unlock(&m->lock);
+}
+
+void
+umi_file_meta_restore(UmiFileMeta *m, guint32 file_id, const UmiFileStat *st)
+{
+    if (!m || !st) return;
+    g_mutex_lock(&m->lock);
+    MetaRec *r = rec_at(m, file_id, TRUE);
+    r->size     = st->size;
+    r->mtime_us = st->mtime_us;
+    r->ino      = st->ino;
+    r->kind     = (guint8)st->kind;
+    r->has_hash = st->has_hash ? 1 : 0;
+    r->hash     = st->has_hash ? st->hash : 0;
+    r->state    = META_UNVERIFIED;
+    g_mutex_unlock(&m->lock);
+}
+
+void
+umi_file_meta_invalidate(UmiFileMeta *m, guint32 file_id)
+{
+    if (!m) return;
+    g_mutex_lock(&m->lock);
+    MetaRec *r = rec_at(m, file_id, FALSE);
+    if (r) {
+        r->epoch++;
+        r->state    = META_EMPTY;
+        r->kind     = UMI_FILE_KIND_UNKNOWN;
+        r->has_hash = FALSE;
+    }
+    g_mutex_unlock(&m->lock);
+}
+
+gboolean
+umi_file_meta_peek(UmiFileMeta *m, guint32 file_id, UmiFileStat *out)
+{
+    if (!m || !out) return FALSE;
+    g_mutex_lock(&m->lock);
+    const MetaRec *r = rec_at(m, file_id, FALSE);
+    const gboolean known = r && r->state != META_EMPTY;
+    if (known) rec_to_stat(r, out);
+    g_mutex_unlock(&m->lock);
+    return known;
+}
@@ -1,108 +1,240 @@
-/*----------------------------------------------------------------------------- 
+/*-----------------------------------------------------------------------------
  * Umicom Studio IDE
  * File: src/util/fs/file_tree.c
  *
  * PURPOSE:
- *   Provide a tiny, self‑contained file tree widget based on GtkTreeView.
- *   This module exposes a very small API (see file_tree.h) so the rest of
- *   the IDE can display a navigable directory tree and react when users
- *   activate a row (double‑click/Enter).
+ *   Provide a tiny, self‑contained file tree widget based on GtkListView +
+ *   GtkTreeListModel. This module exposes a very small API (see file_tree.h)
+ *   so the rest of the IDE can display a navigable directory tree and react
+ *   when users activate a row (double‑click/Enter).
  *
  * SCOPE:
- *   - Build the model from a given root directory.
- *   - Rebuild on demand (refresh).
+ *   - Show a root directory, leaving out dot-files and anything matched by
+ *     .gitignore/.ignore rules (ignored folders are not even opened; see
+ *     ignore_rules.h).
+ *   - Refresh on demand, or per directory from filesystem events.
  *   - Notify caller via a callback when a row is activated.
+ *   - Optionally mark rows with their git status (git_status.h); only rows
+ *     that have widgets are updated when the status changes.
  *
  * IMPORTANT DESIGN NOTES:
- *   - We keep the implementation simple and synchronous. If the tree is
- *     pointed at a very large folder, callers should build it off the GTK
- *     main loop (e.g., in a worker thread) and then hand the model back.
- *   - GtkTreeView/GtkTreeStore are deprecated in favor of GtkListView and
- *     GtkTreeListModel in newer GTK. Migrating is planned, but for now we
- *     keep the existing UI and *silence deprecation warnings* for this file
- *     using GLib’s G_GNUC_BEGIN/END_IGNORE_DEPRECATIONS to keep builds clean.
+ *   - Lazy: a directory's children are enumerated the first time its row is
+ *     expanded, never before. Collapsing keeps the listing for next time.
+ *   - Asynchronous: listings come from g_file_enumerate_children_async() and
+ *     arrive in batches of UMI_TREE_BATCH entries, each merged into the
+ *     directory's GListStore in name order. The main loop never blocks on
+ *     a big folder; rows appear as batches land.
+ *   - Virtualized: GtkListView only creates widgets for visible rows, and
+ *     a node is one small GObject (UmiFileNode). Memory and build time follow
+ *     what has been expanded, not the size of the tree.
+ *   - Refresh is a patch, not a rebuild: directories that were listed are
+ *     re-listed on a worker thread, and the UI thread only splices in the
+ *     rows that appeared or vanished. Surviving rows are the same objects,
+ *     so expansion state and the selection are kept.
+ *   - Filesystem events only mark their directory dirty; dirty directories
+ *     are re-listed at most once per UMI_TREE_DEBOUNCE_MS, so a build
+ *     churning files turns into a few background listings, not a storm of
+ *     main-thread work.
  *   - No dependencies on IDE output panes or other UI modules—this remains
  *     a small, reusable utility.
  *
  * THREADING:
- *   - All functions are synchronous; not thread‑safe unless guarded by the
- *     caller. GTK widgets should only be touched on the main thread.
+ *   - Main thread only. GIO runs the first listing of a directory on its
+ *     worker threads; refresh listings run on the tree's own small
+ *     GThreadPool and post back with g_idle_add(). Nothing in the thread
+ *     touches GTK or the stores. A root change cancels all of it.
  *
  * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-12 | MIT
  *---------------------------------------------------------------------------*/
 #include "file_tree.h"     /* Public API: struct Opaque + callback typedefs       */
-#include <glib.h>          /* GDir/GPtrArray utilities                            */
-#include <glib/gstdio.h>   /* g_file_test utilities                               */
+#include "ignore_rules.h"  /* gitignore-style pruning                             */
+#include "git_status.h"    /* per-path work tree status                           */
+#include <gio/gio.h>       /* GFileEnumerator, GListStore                         */
 #include <string.h>        /* g_strcmp0                                            */
 
-/*------------------------------- Model columns ---------------------------------
- * We store three columns:
- *   COL_NAME  : leaf filename shown in the UI
- *   COL_PATH  : full, absolute path (used when the user activates a row)
- *   COL_IS_DIR: gboolean flag (directory or regular file)
+#define UMI_TREE_BATCH 128 /* GFileInfos per next_files_async() round             */
+#define UMI_TREE_DEBOUNCE_MS 150 /* event coalescing window                      */
+#define UMI_TREE_WORKERS 2 /* background re-listing threads                      */
+#define UMI_TREE_ATTRS G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+                       G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+                       G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK
+
+/*------------------------------ Tree nodes -------------------------------------
+ * One row of the tree (file or directory). Directories own the GListStore of
+ * their children, created empty when GtkTreeListModel first asks for it and
+ * filled once the row is expanded.
  *-----------------------------------------------------------------------------*/
-enum {
-  COL_NAME = 0,
-  COL_PATH,
-  COL_IS_DIR,
-  N_COLS
+typedef enum {
+  NODE_IDLE = 0,                     /* children never listed                    */
+  NODE_LOADING,                      /* enumeration in flight                    */
+  NODE_LOADED
+} NodeState;
+
+/* What a refresh request covers (ordered: a subtree includes the dir). */
+typedef enum {
+  DIRTY_NONE = 0,
+  DIRTY_DIR,                         /* re-list this directory                   */
+  DIRTY_TREE                         /* ... and every listed directory below     */
+} DirtyMode;
+
+#define UMI_TYPE_FILE_NODE (umi_file_node_get_type())
+G_DECLARE_FINAL_TYPE(UmiFileNode, umi_file_node, UMI, FILE_NODE, GObject)
+
+struct _UmiFileNode {
+  GObject     parent_instance;
+  gchar      *name;                  /* leaf filename shown in the UI            */
+  gchar      *path;                  /* full path, reported on activation        */
+  gboolean    is_dir;
+  gboolean    expandable;            /* directory and not a symlink (no loops)   */
+  GListStore *children;              /* UmiFileNode items, NULL until requested  */
+  NodeState   state;
+  gboolean    refreshing;            /* a background re-list is in flight        */
+  DirtyMode   pending;               /* refresh asked for while busy             */
 };
 
+G_DEFINE_TYPE(UmiFileNode, umi_file_node, G_TYPE_OBJECT)
+
+static void umi_file_node_finalize(GObject *o){
+  UmiFileNode *n = UMI_FILE_NODE(o);
+  g_free(n->name);
+  g_free(n->path);
+  g_clear_object(&n->children);
+  G_OBJECT_CLASS(umi_file_node_parent_class)->finalize(o);
+}
+
+static void umi_file_node_class_init(UmiFileNodeClass *klass){
+  G_OBJECT_CLASS(klass)->finalize = umi_file_node_finalize;
+}
+
+static void umi_file_node_init(UmiFileNode *n){ (void)n; }
+
+static UmiFileNode *node_new(const char *name, const char *path, gboolean is_dir, gboolean expandable){
+  UmiFileNode *n = g_object_new(UMI_TYPE_FILE_NODE, NULL);
+  n->name       = g_strdup(name);
+  n->path       = g_strdup(path);
+  n->is_dir     = is_dir;
+  n->expandable = expandable;
+  return n;
+}
+
+static GListStore *node_children(UmiFileNode *n){
+  if(!n->children) n->children = g_list_store_new(UMI_TYPE_FILE_NODE);
+  return n->children;
+}
+
+/* Name order, as the synchronous tree had (GCompareDataFunc for the store). */
+static gint cmp_nodes(gconstpointer a, gconstpointer b, gpointer user_data){
+  (void)user_data;                           /* unused */
+  return g_strcmp0(((const UmiFileNode *)a)->name, ((const UmiFileNode *)b)->name);
+}
+
+/* Same order for GPtrArray sorting (elements are passed by address). */
+static gint cmp_node_ptrs(gconstpointer a, gconstpointer b, gpointer user_data){
+  return cmp_nodes(*(UmiFileNode * const *)a, *(UmiFileNode * const *)b, user_data);
+}
+
+/* Row for one enumerated entry of 'dir', or NULL if it is hidden/ignored.
+ * Thread-safe: used by the async first listing and by refresh workers. */
+static UmiFileNode *node_from_info(const char *dir, GFileInfo *info, UmiIgnoreScope *scope){
+  const char *name = g_file_info_get_name(info);
+  if(!name || name[0]=='.') return NULL;    /* hide dot‑files in tree view */
+
+  const gboolean is_dir = g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY;
+  if(scope && umi_ignore_scope_match(scope, name, is_dir)) return NULL;
+
+  gchar *full = g_build_filename(dir, name, NULL);
+  UmiFileNode *n = node_new(name, full, is_dir, is_dir && !g_file_info_get_is_symlink(info));
+  g_free(full);
+  return n;
+}
+
 /*-------------------------- Internal object layout ----------------------------
  * The concrete struct is private to this translation unit. The public header
  * holds only an opaque pointer typedef (`typedef struct _UmiFileTree UmiFileTree;`).
  *-----------------------------------------------------------------------------*/
 struct _UmiFileTree {
-  GtkTreeStore      *store;          /* tree model (rows + columns)                 */
-  GtkTreeView       *view;           /* widget presented to callers                  */
-  gchar             *root;           /* g_strdup() of the current root directory     */
-  UmiFileActivateCb  on_activate;    /* activation callback provided by the caller   */
-  gpointer           user;           /* user data cookie echoed on callbacks         */
+  GtkWidget          *scroller;      /* widget presented to callers (owned ref)  */
+  GtkListView        *view;          /* child of 'scroller'                      */
+  GtkListItemFactory *factory;       /* borrowed; owned by the view              */
+  GtkTreeListModel   *model;         /* borrowed; owned by the selection model   */
+  GListStore         *top;           /* children of the root (our own ref)       */
+  UmiFileNode        *root_node;     /* the root itself; its children are 'top'  */
+  GCancellable       *cancel;        /* cancels every listing of this root       */
+  GThreadPool        *pool;          /* refresh listings (RefreshJob)            */
+  GHashTable         *dirty;         /* canonical dir path -> DirtyMode          */
+  guint               dirty_source;  /* pending debounce timeout, 0 if none      */
+  gchar              *root;          /* g_strdup() of the current root directory */
+  UmiIgnore          *ignore;        /* ignore rules under root (NULL w/o root)  */
+  UmiFileActivateCb   on_activate;   /* activation callback provided by the caller */
+  gpointer            user;          /* user data cookie echoed on callbacks     */
+  UmiGitStatusEngine *git;           /* borrowed, optional row decorations       */
+  guint               git_listener;
+  GHashTable         *bound;         /* GtkListItem set: rows with widgets       */
 };
 
+/* One asynchronous first listing of a directory. Jobs keep their own
+ * references and only touch 't' while their cancellable is not cancelled,
+ * so they can finish safely after a root change or umi_file_tree_free(). */
+typedef struct {
+  UmiFileTree     *t;
+  GCancellable    *cancel;
+  UmiFileNode     *node;             /* directory being listed                   */
+  GFileEnumerator *en;
+  UmiIgnoreScope  *scope;            /* rules in effect inside it (or NULL)      */
+} LoadJob;
+
+/* One background re-listing; 'fresh' is filled by the worker thread. */
+typedef struct {
+  UmiFileTree     *t;
+  GCancellable    *cancel;
+  UmiFileNode     *node;
+  UmiIgnoreScope  *scope;
+  DirtyMode        mode;
+  GPtrArray       *fresh;            /* UmiFileNode, name order; NULL on error   */
+} RefreshJob;
+
 /* Forward declarations of local helpers. */
-static void         clear_store (UmiFileTree *t);
-static void         add_dir     (UmiFileTree *t, GtkTreeIter *parent_iter, const char *dir);
+static void         start_load  (UmiFileTree *t, UmiFileNode *node);
+static void         start_refresh(UmiFileTree *t, UmiFileNode *node, DirtyMode mode);
+static void         refresh_worker(gpointer data, gpointer user);
+static gboolean     refresh_apply(gpointer data);
 static void         rebuild     (UmiFileTree *t);
-static void         on_row_activated(GtkTreeView *v, GtkTreePath *tp, GtkTreeViewColumn *col, gpointer user);
-
-/* Comparator wrapper matching GCompareDataFunc for strings. */
-static gint cmp_cstrings(gconstpointer a, gconstpointer b, gpointer user_data){
-  (void)user_data;                           /* unused */
-  const char *sa = (const char *)a;
-  const char *sb = (const char *)b;
-  return g_strcmp0(sa, sb);
-}
+static GListModel  *create_children(gpointer item, gpointer user);
+static void         on_setup    (GtkSignalListItemFactory *f, GtkListItem *li, gpointer user);
+static void         on_bind     (GtkSignalListItemFactory *f, GtkListItem *li, gpointer user);
+static void         on_unbind   (GtkSignalListItemFactory *f, GtkListItem *li, gpointer user);
+static void         on_activate_row(GtkListView *v, guint pos, gpointer user);
 
 /*------------------------------- Public API ----------------------------------*/
 UmiFileTree *umi_file_tree_new(UmiFileActivateCb on_activate, gpointer user)
 {
-  /* Silence deprecation warnings within this block – we keep the legacy
-   * TreeView/TreeStore for now to avoid churning the UI layer. */
-#if defined(G_GNUC_BEGIN_IGNORE_DEPRECATIONS)
-  G_GNUC_BEGIN_IGNORE_DEPRECATIONS
-#endif
   UmiFileTree *t = g_new0(UmiFileTree, 1);
+  t->top    = g_list_store_new(UMI_TYPE_FILE_NODE);
+  t->cancel = g_cancellable_new();
+  t->pool   = g_thread_pool_new(refresh_worker, NULL, UMI_TREE_WORKERS, FALSE, NULL);
+  t->dirty  = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  t->bound  = g_hash_table_new(g_direct_hash, g_direct_equal);
 
-  /* Create the model with our three columns. */
-  t->store = gtk_tree_store_new(N_COLS,
-                                G_TYPE_STRING,   /* COL_NAME  */
-                                G_TYPE_STRING,   /* COL_PATH  */
-                                G_TYPE_BOOLEAN); /* COL_IS_DIR*/
+  /* Rows are GtkTreeListRow wrappers; children models come from the nodes. */
+  t->model = gtk_tree_list_model_new(G_LIST_MODEL(g_object_ref(t->top)),
+                                     FALSE,    /* passthrough: we need the rows */
+                                     FALSE,    /* autoexpand                    */
+                                     create_children, t, NULL);
 
-  /* Bind a TreeView to the model. */
-  t->view  = GTK_TREE_VIEW(gtk_tree_view_new_with_model(GTK_TREE_MODEL(t->store)));
+  /* Each visible row: an expander (indent + arrow) around a label. */
+  t->factory = gtk_signal_list_item_factory_new();
+  g_signal_connect(t->factory, "setup",  G_CALLBACK(on_setup),  t);
+  g_signal_connect(t->factory, "bind",   G_CALLBACK(on_bind),   t);
+  g_signal_connect(t->factory, "unbind", G_CALLBACK(on_unbind), t);
 
-  /* Add a single text column: “Name”. */
-  GtkCellRenderer   *r = gtk_cell_renderer_text_new();
-  GtkTreeViewColumn *c = gtk_tree_view_column_new_with_attributes("Name", r, "text", COL_NAME, NULL);
-  gtk_tree_view_append_column(t->view, c);
+  GtkSingleSelection *sel = gtk_single_selection_new(G_LIST_MODEL(t->model));
+  t->view = GTK_LIST_VIEW(gtk_list_view_new(GTK_SELECTION_MODEL(sel), t->factory));
+  g_signal_connect(t->view, "activate", G_CALLBACK(on_activate_row), t);
 
-  /* Hook row‑activation to our trampoline. */
-  g_signal_connect(t->view, "row-activated", G_CALLBACK(on_row_activated), t);
-#if defined(G_GNUC_END_IGNORE_DEPRECATIONS)
-  G_GNUC_END_IGNORE_DEPRECATIONS
-#endif
+  /* The view only virtualizes inside a scrollable parent. */
+  t->scroller = gtk_scrolled_window_new();
+  gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(t->scroller), GTK_WIDGET(t->view));
+  g_object_ref_sink(t->scroller);
 
   /* Save callback + cookie. */
   t->on_activate = on_activate;
@@ -110,15 +242,9 @@ UmiFileTree *umi_file_tree_new(UmiFileActivateCb on_activate, gpointer user)
   return t;
 }
 
-/* Return the widget for packing. */
+/* Return the widget for packing (a scrolled window holding the list). */
 GtkWidget *umi_file_tree_widget(UmiFileTree *t){
-#if defined(G_GNUC_BEGIN_IGNORE_DEPRECATIONS)
-  G_GNUC_BEGIN_IGNORE_DEPRECATIONS
-#endif
-  return t ? GTK_WIDGET(t->view) : NULL;
-#if defined(G_GNUC_END_IGNORE_DEPRECATIONS)
-  G_GNUC_END_IGNORE_DEPRECATIONS
-#endif
+  return t ? t->scroller : NULL;
 }
 
 /* Replace root directory and rebuild. */
@@ -126,128 +252,448 @@ void umi_file_tree_set_root(UmiFileTree *t, const char *path){
   if(!t) return;
   g_free(t->root);
   t->root = path ? g_strdup(path) : NULL;
+  umi_ignore_free(t->ignore);
+  t->ignore = path ? umi_ignore_new(path) : NULL;
   rebuild(t);
 }
 
-/* Rebuild from current root. */
+/* Re-list everything shown so far in the background and patch the model
+ * (ignore files are re-read as well). */
 void umi_file_tree_refresh(UmiFileTree *t){
   if(!t) return;
-  rebuild(t);
+  umi_ignore_invalidate(t->ignore, NULL);
+  if(t->root_node) start_refresh(t, t->root_node, DIRTY_TREE);
+  else             rebuild(t);
+}
+
+/* Run the refreshes collected by umi_file_tree_notify(). */
+static UmiFileNode *find_node(UmiFileTree *t, const char *dir);
+static gboolean flush_dirty(gpointer user){
+  UmiFileTree *t = (UmiFileTree*)user;
+  t->dirty_source = 0;
+
+  GHashTableIter it;
+  gpointer key, val;
+  g_hash_table_iter_init(&it, t->dirty);
+  while(g_hash_table_iter_next(&it, &key, &val)){
+    UmiFileNode *n = find_node(t, (const char*)key);
+    if(n) start_refresh(t, n, (DirtyMode)GPOINTER_TO_INT(val));
+  }
+  g_hash_table_remove_all(t->dirty);
+  return G_SOURCE_REMOVE;
+}
+
+/* 'path' appeared, vanished, or is an ignore file that changed. */
+void umi_file_tree_notify(UmiFileTree *t, const char *path){
+  if(!t || !path || !*path || !t->root_node) return;
+
+  gchar *canon = g_canonicalize_filename(path, NULL);
+  gchar *dir   = g_path_get_dirname(canon);
+  gchar *leaf  = g_path_get_basename(canon);
+  DirtyMode mode = DIRTY_DIR;
+  if(umi_ignore_is_rule_file(leaf)){          /* rules apply to the subtree */
+    umi_ignore_invalidate(t->ignore, dir);
+    mode = DIRTY_TREE;
+  }
+  const DirtyMode had = (DirtyMode)GPOINTER_TO_INT(g_hash_table_lookup(t->dirty, dir));
+  if(mode > had) g_hash_table_replace(t->dirty, dir, GINT_TO_POINTER(mode));
+  else           g_free(dir);
+  g_free(leaf);
+  g_free(canon);
+
+  if(!t->dirty_source)
+    t->dirty_source = g_timeout_add(UMI_TREE_DEBOUNCE_MS, flush_dirty, t);
+}
+
+static void git_mark(UmiFileTree *t, GtkListItem *li);
+static void on_git_changed(UmiGitStatusEngine *s, gpointer user){
+  (void)s;
+  UmiFileTree *t = (UmiFileTree*)user;
+  GHashTableIter it;
+  gpointer li;
+  g_hash_table_iter_init(&it, t->bound);
+  while(g_hash_table_iter_next(&it, &li, NULL)) git_mark(t, GTK_LIST_ITEM(li));
+}
+
+/* Show git status markers from 'git' (NULL turns them off). */
+void umi_file_tree_set_git_status(UmiFileTree *t, UmiGitStatusEngine *git){
+  if(!t || t->git == git) return;
+  if(t->git) umi_git_status_remove_listener(t->git, t->git_listener);
+  t->git = git;
+  t->git_listener = git ? umi_git_status_add_listener(git, on_git_changed, t) : 0;
+  on_git_changed(git, t);
 }
 
 /* Destroy widget/model and free memory. */
 void umi_file_tree_free(UmiFileTree *t){
   if(!t) return;
-#if defined(G_GNUC_BEGIN_IGNORE_DEPRECATIONS)
-  G_GNUC_BEGIN_IGNORE_DEPRECATIONS
-#endif
-  if(t->store) g_object_unref(t->store);
-  if(t->view)  g_object_unref(t->view);
-#if defined(G_GNUC_END_IGNORE_DEPRECATIONS)
-  G_GNUC_END_IGNORE_DEPRECATIONS
-#endif
+  if(t->git) umi_git_status_remove_listener(t->git, t->git_listener);
+  g_cancellable_cancel(t->cancel);
+  if(t->dirty_source) g_source_remove(t->dirty_source);
+  g_thread_pool_free(t->pool, FALSE, TRUE);   /* cancelled jobs finish quickly */
+  /* Dropping the model unbinds every row (disconnecting their handlers)
+   * before our own handlers go, in case the caller still shows the widget. */
+  gtk_list_view_set_model(t->view, NULL);
+  g_signal_handlers_disconnect_by_data(t->factory, t);
+  g_signal_handlers_disconnect_by_data(t->view, t);
+  g_clear_object(&t->scroller);
+  g_clear_object(&t->root_node);
+  g_clear_object(&t->top);
+  g_hash_table_destroy(t->dirty);
+  g_hash_table_destroy(t->bound);
+  g_clear_object(&t->cancel);
+  g_clear_pointer(&t->ignore, umi_ignore_free);
   g_clear_pointer(&t->root, g_free);
   g_free(t);
 }
 
 /*------------------------------- Internals -----------------------------------*/
-/* Append a directory’s children (files + subdirs) under parent_iter (or root). */
-static void add_dir(UmiFileTree *t, GtkTreeIter *parent_iter, const char *dir){
-  if(!t || !dir) return;
+static void load_job_free(LoadJob *j){
+  if(!g_cancellable_is_cancelled(j->cancel)){
+    j->node->state = NODE_LOADED;
+    if(j->node->pending){                     /* events during the listing */
+      const DirtyMode mode = j->node->pending;
+      j->node->pending = DIRTY_NONE;
+      start_refresh(j->t, j->node, mode);
+    }
+  }
+  g_clear_object(&j->en);
+  g_clear_object(&j->node);
+  g_clear_object(&j->cancel);
+  umi_ignore_scope_free(j->scope);
+  g_free(j);
+}
 
-  GError *err = NULL;
-  GDir   *d   = g_dir_open(dir, 0, &err);
-  if(!d){
+/* Merge one batch of GFileInfos into the store, keeping name order. */
+static void on_next_files(GObject *src, GAsyncResult *res, gpointer user){
+  LoadJob *j = (LoadJob*)user;
+  GError  *err = NULL;
+  GList   *infos = g_file_enumerator_next_files_finish(G_FILE_ENUMERATOR(src), res, &err);
+  if(!infos){                                 /* done, failed or cancelled */
     g_clear_error(&err);
+    load_job_free(j);
     return;
   }
 
-  /* Read all names, sort for deterministic ordering, then emit rows. */
-  GPtrArray *names = g_ptr_array_new_with_free_func(g_free);
-  const gchar *name;
-  while((name = g_dir_read_name(d))){
-    if(name[0]=='.') continue;              /* hide dot‑files in tree view */
-    g_ptr_array_add(names, g_strdup(name)); /* keep a copy for sorting     */
+  GListStore *store = node_children(j->node);
+  for(GList *l = infos; l; l = l->next){
+    UmiFileNode *n = node_from_info(j->node->path, G_FILE_INFO(l->data), j->scope);
+    if(!n) continue;
+    g_list_store_insert_sorted(store, n, cmp_nodes, NULL);
+    g_object_unref(n);
   }
-  g_dir_close(d);
-
-  g_ptr_array_sort_with_data(names, cmp_cstrings, NULL);
-
-#if defined(G_GNUC_BEGIN_IGNORE_DEPRECATIONS)
-  G_GNUC_BEGIN_IGNORE_DEPRECATIONS
-#endif
-  for(guint i=0;i<names->len;i++){
-    const char *leaf = (const char*)names->pdata[i];
-    gchar *full      = g_build_filename(dir, leaf, NULL);
-    const gboolean is_dir = g_file_test(full, G_FILE_TEST_IS_DIR);
-
-    GtkTreeIter child;
-    gtk_tree_store_append(t->store, &child, parent_iter);
-    gtk_tree_store_set(t->store, &child,
-                       COL_NAME,   leaf,
-                       COL_PATH,   full,
-                       COL_IS_DIR, is_dir,
-                       -1);
-
-    if(is_dir){
-      /* Avoid naive symlink loops. */
-      if(!g_file_test(full, G_FILE_TEST_IS_SYMLINK))
-        add_dir(t, &child, full);
+  g_list_free_full(infos, g_object_unref);
+
+  g_file_enumerator_next_files_async(j->en, UMI_TREE_BATCH, G_PRIORITY_DEFAULT,
+                                     j->cancel, on_next_files, j);
+}
+
+static void on_enum_opened(GObject *src, GAsyncResult *res, gpointer user){
+  LoadJob *j = (LoadJob*)user;
+  GError  *err = NULL;
+  j->en = g_file_enumerate_children_finish(G_FILE(src), res, &err);
+  if(!j->en){                                 /* unreadable or cancelled */
+    g_clear_error(&err);
+    load_job_free(j);
+    return;
+  }
+  g_file_enumerator_next_files_async(j->en, UMI_TREE_BATCH, G_PRIORITY_DEFAULT,
+                                     j->cancel, on_next_files, j);
+}
+
+/* First listing of 'node' (its store is empty), in the background. */
+static void start_load(UmiFileTree *t, UmiFileNode *node){
+  LoadJob *j = g_new0(LoadJob, 1);
+  j->t      = t;
+  j->cancel = g_object_ref(t->cancel);
+  j->node   = g_object_ref(node);
+  j->scope  = t->ignore ? umi_ignore_scope_new(t->ignore, node->path) : NULL;
+  node->state = NODE_LOADING;
+
+  GFile *f = g_file_new_for_path(node->path);
+  g_file_enumerate_children_async(f, UMI_TREE_ATTRS, G_FILE_QUERY_INFO_NONE,
+                                  G_PRIORITY_DEFAULT, j->cancel, on_enum_opened, j);
+  g_object_unref(f);
+}
+
+/*--------------------------- Background refresh --------------------------------
+ * A refresh re-lists a directory that is already shown, on a pool thread,
+ * into fresh nodes sorted like the store. The UI thread then merges the two
+ * sorted sequences and splices only the differences, so untouched rows keep
+ * their identity (expansion, selection). A name whose kind changed (file
+ * became a directory) is replaced.
+ *-----------------------------------------------------------------------------*/
+static void refresh_job_free(RefreshJob *j){
+  if(j->fresh) g_ptr_array_free(j->fresh, TRUE);
+  umi_ignore_scope_free(j->scope);
+  g_clear_object(&j->node);
+  g_clear_object(&j->cancel);
+  g_free(j);
+}
+
+/* Worker thread: plain synchronous listing, no GTK and no stores. */
+static void refresh_worker(gpointer data, gpointer user){
+  (void)user;
+  RefreshJob *j = (RefreshJob*)data;
+  GFile *f = g_file_new_for_path(j->node->path);
+  GFileEnumerator *en = g_cancellable_is_cancelled(j->cancel) ? NULL :
+      g_file_enumerate_children(f, UMI_TREE_ATTRS, G_FILE_QUERY_INFO_NONE, j->cancel, NULL);
+  g_object_unref(f);
+
+  if(en){
+    j->fresh = g_ptr_array_new_with_free_func(g_object_unref);
+    GFileInfo *info;
+    while((info = g_file_enumerator_next_file(en, j->cancel, NULL))){
+      UmiFileNode *n = node_from_info(j->node->path, info, j->scope);
+      if(n) g_ptr_array_add(j->fresh, n);
+      g_object_unref(info);
     }
-    g_free(full);
+    g_object_unref(en);
+    g_ptr_array_sort_with_data(j->fresh, cmp_node_ptrs, NULL);
   }
-#if defined(G_GNUC_END_IGNORE_DEPRECATIONS)
-  G_GNUC_END_IGNORE_DEPRECATIONS
-#endif
-  g_ptr_array_free(names, TRUE);
+  g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, refresh_apply, j, NULL);
 }
 
-/* Clear the model completely. */
-static void clear_store(UmiFileTree *t){
-#if defined(G_GNUC_BEGIN_IGNORE_DEPRECATIONS)
-  G_GNUC_BEGIN_IGNORE_DEPRECATIONS
-#endif
-  gtk_tree_store_clear(t->store);
-#if defined(G_GNUC_END_IGNORE_DEPRECATIONS)
-  G_GNUC_END_IGNORE_DEPRECATIONS
-#endif
+/* Make 'store' (sorted) hold exactly 'fresh' (sorted), reusing the nodes of
+ * names that survived. Splices are computed on the old positions and
+ * applied back to front, so each one leaves the earlier positions valid. */
+typedef struct { guint at, n_del; GPtrArray *add; } Splice;
+
+static gboolean same_row(const UmiFileNode *a, const UmiFileNode *b){
+  return a->is_dir == b->is_dir && a->expandable == b->expandable;
 }
 
-/* Clear + rebuild the model from t->root (directories only for now). */
+static void patch_store(GListStore *store, GPtrArray *fresh){
+  const guint n_old = g_list_model_get_n_items(G_LIST_MODEL(store));
+  GPtrArray *old = g_ptr_array_new_full(n_old, g_object_unref);
+  for(guint i=0;i<n_old;i++) g_ptr_array_add(old, g_list_model_get_item(G_LIST_MODEL(store), i));
+
+  GArray *ops = g_array_new(FALSE, FALSE, sizeof(Splice));
+  guint i = 0, k = 0;
+  while(i < old->len || k < fresh->len){
+    const UmiFileNode *o = i < old->len   ? old->pdata[i]   : NULL;
+    const UmiFileNode *f = k < fresh->len ? fresh->pdata[k] : NULL;
+    if(o && f && g_strcmp0(o->name, f->name) == 0 && same_row(o, f)){ i++; k++; continue; }
+
+    Splice sp = { i, 0, g_ptr_array_new() };
+    while(i < old->len || k < fresh->len){
+      o = i < old->len   ? old->pdata[i]   : NULL;
+      f = k < fresh->len ? fresh->pdata[k] : NULL;
+      const int c = !o ? 1 : !f ? -1 : g_strcmp0(o->name, f->name);
+      if(c == 0 && same_row(o, f)) break;     /* end of the differing run */
+      if(c <= 0){ sp.n_del++; i++; }          /* gone (or kind changed)   */
+      if(c >= 0){ g_ptr_array_add(sp.add, fresh->pdata[k]); k++; }
+    }
+    g_array_append_val(ops, sp);
+  }
+
+  for(guint n = ops->len; n-- > 0; ){
+    Splice *sp = &g_array_index(ops, Splice, n);
+    g_list_store_splice(store, sp->at, sp->n_del, sp->add->pdata, sp->add->len);
+    g_ptr_array_free(sp->add, TRUE);
+  }
+  g_array_free(ops, TRUE);
+  g_ptr_array_free(old, TRUE);
+}
+
+/* Idle callback on the UI thread: apply a finished re-listing. */
+static gboolean refresh_apply(gpointer data){
+  RefreshJob *j = (RefreshJob*)data;
+  if(g_cancellable_is_cancelled(j->cancel)){  /* root changed / tree freed */
+    refresh_job_free(j);
+    return G_SOURCE_REMOVE;
+  }
+
+  UmiFileTree *t = j->t;
+  UmiFileNode *node = j->node;
+  node->refreshing = FALSE;
+  if(j->fresh) patch_store(node_children(node), j->fresh);
+
+  /* Rules changed or full refresh: descend into what is listed below. */
+  if(j->mode == DIRTY_TREE){
+    GListModel *m = G_LIST_MODEL(node_children(node));
+    const guint n = g_list_model_get_n_items(m);
+    for(guint i=0;i<n;i++){
+      UmiFileNode *c = UMI_FILE_NODE(g_list_model_get_item(m, i));
+      if(c->expandable && c->state == NODE_LOADED) start_refresh(t, c, DIRTY_TREE);
+      g_object_unref(c);
+    }
+  }
+  if(node->pending){                          /* asked again meanwhile */
+    const DirtyMode mode = node->pending;
+    node->pending = DIRTY_NONE;
+    start_refresh(t, node, mode);
+  }
+  refresh_job_free(j);
+  return G_SOURCE_REMOVE;
+}
+
+/* Queue a re-listing of 'node' (no-op for directories never listed). */
+static void start_refresh(UmiFileTree *t, UmiFileNode *node, DirtyMode mode){
+  if(node->state == NODE_IDLE) return;        /* nothing shown to patch */
+  if(node->state == NODE_LOADING || node->refreshing){
+    if(mode > node->pending) node->pending = mode;
+    return;
+  }
+  RefreshJob *j = g_new0(RefreshJob, 1);
+  j->t      = t;
+  j->cancel = g_object_ref(t->cancel);
+  j->node   = g_object_ref(node);
+  j->scope  = t->ignore ? umi_ignore_scope_new(t->ignore, node->path) : NULL;
+  j->mode   = mode;
+  node->refreshing = TRUE;
+  g_thread_pool_push(t->pool, j, NULL);
+}
+
+/* Listed node for canonical directory path 'dir', or NULL when that
+ * directory is not in the tree or was never listed (borrowed: the parent
+ * store keeps it alive). Binary search per level; stores are name-sorted. */
+static UmiFileNode *find_node(UmiFileTree *t, const char *dir){
+  if(!t->root_node) return NULL;
+  const char *root = t->root_node->path;
+  const gsize rl = strlen(root);
+  if(strncmp(dir, root, rl) != 0) return NULL;
+  if(dir[rl] == '\0') return t->root_node;
+  if(dir[rl] != G_DIR_SEPARATOR) return NULL;
+
+  UmiFileNode *node = t->root_node;
+  gchar **parts = g_strsplit(dir + rl + 1, G_DIR_SEPARATOR_S, -1);
+  for(guint p=0; parts[p] && node; p++){
+    if(node->state == NODE_IDLE || !node->children){ node = NULL; break; }
+    GListModel *m = G_LIST_MODEL(node->children);
+    guint lo = 0, hi = g_list_model_get_n_items(m);
+    UmiFileNode *hit = NULL;
+    while(lo < hi){
+      const guint mid = lo + (hi - lo) / 2;
+      UmiFileNode *c = UMI_FILE_NODE(g_list_model_get_item(m, mid));
+      const int cmp = g_strcmp0(c->name, parts[p]);
+      g_object_unref(c);                      /* the store still holds it */
+      if(cmp == 0){ hit = c; break; }
+      if(cmp < 0) lo = mid + 1; else hi = mid;
+    }
+    node = (hit && hit->expandable) ? hit : NULL;
+  }
+  g_strfreev(parts);
+  return node;
+}
+
+/* New root: cancel everything in flight, clear the model, list it again. */
 static void rebuild(UmiFileTree *t){
   if(!t) return;
-  clear_store(t);
+  g_cancellable_cancel(t->cancel);
+  g_object_unref(t->cancel);
+  t->cancel = g_cancellable_new();
+  if(t->dirty_source){ g_source_remove(t->dirty_source); t->dirty_source = 0; }
+  g_hash_table_remove_all(t->dirty);
+  g_clear_object(&t->root_node);
+  g_list_store_remove_all(t->top);
   if(!t->root || !*t->root) return;
   if(!g_file_test(t->root, G_FILE_TEST_IS_DIR)) return;
-  add_dir(t, NULL, t->root);
+
+  /* Canonical paths keep nodes comparable with watcher events and the
+   * ignore rules' root. */
+  gchar *canon = g_canonicalize_filename(t->root, NULL);
+  t->root_node = node_new("", canon, TRUE, TRUE);
+  t->root_node->children = g_object_ref(t->top);
+  g_free(canon);
+  start_load(t, t->root_node);
+}
+
+
+/* GtkTreeListModelCreateModelFunc. GTK also calls this just to learn whether
+ * a row is expandable, so it must stay cheap: hand out the (possibly still
+ * empty) children store; the listing starts on expansion (on_row_expanded). */
+static GListModel *create_children(gpointer item, gpointer user){
+  (void)user;
+  UmiFileNode *n = UMI_FILE_NODE(item);
+  if(!n->expandable) return NULL;
+  return G_LIST_MODEL(g_object_ref(node_children(n)));
+}
+
+static void on_row_expanded(GObject *obj, GParamSpec *pspec, gpointer user){
+  (void)pspec;
+  UmiFileTree    *t   = (UmiFileTree*)user;
+  GtkTreeListRow *row = GTK_TREE_LIST_ROW(obj);
+  if(!gtk_tree_list_row_get_expanded(row)) return;
+
+  UmiFileNode *n = UMI_FILE_NODE(gtk_tree_list_row_get_item(row));
+  if(n->expandable && n->state == NODE_IDLE)
+    start_load(t, n);
+  g_object_unref(n);
+}
+
+/* Row widgets: expander > box > [ name label | git marker label ]. */
+static void on_setup(GtkSignalListItemFactory *f, GtkListItem *li, gpointer user){
+  (void)f; (void)user;
+  GtkWidget *label = gtk_label_new(NULL);
+  gtk_label_set_xalign(GTK_LABEL(label), 0.0f);
+  gtk_widget_set_hexpand(label, TRUE);
+  GtkWidget *mark = gtk_label_new(NULL);
+  gtk_widget_set_margin_end(mark, 6);
+  GtkWidget *box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 6);
+  gtk_box_append(GTK_BOX(box), label);
+  gtk_box_append(GTK_BOX(box), mark);
+  GtkWidget *exp = gtk_tree_expander_new();
+  gtk_tree_expander_set_child(GTK_TREE_EXPANDER(exp), box);
+  gtk_list_item_set_child(li, exp);
 }
 
-/* Called when a row is double‑clicked or Enter is pressed. */
-static void on_row_activated(GtkTreeView *v, GtkTreePath *tp, GtkTreeViewColumn *col, gpointer user){
-  (void)col;                     /* column pointer not used */
+/* Refresh the git marker of a bound row (folders show what is below). */
+static void git_mark(UmiFileTree *t, GtkListItem *li){
+  GtkTreeListRow  *row = GTK_TREE_LIST_ROW(gtk_list_item_get_item(li));
+  GtkTreeExpander *exp = GTK_TREE_EXPANDER(gtk_list_item_get_child(li));
+  if(!row || !exp) return;
+  GtkWidget *mark = gtk_widget_get_last_child(gtk_tree_expander_get_child(exp));
+  UmiFileNode *n = UMI_FILE_NODE(gtk_tree_list_row_get_item(row));
+  const UmiGitFileStatus st = t->git ? umi_git_status_get(t->git, n->path) : UMI_GIT_CLEAN;
+  char text[2] = { umi_git_status_letter(st), '\0' };
+  if(n->is_dir && st != UMI_GIT_CLEAN) text[0] = '*';   /* something changed below */
+  gtk_label_set_text(GTK_LABEL(mark), st == UMI_GIT_CLEAN ? "" : text);
+  g_object_unref(n);
+}
+
+static void on_bind(GtkSignalListItemFactory *f, GtkListItem *li, gpointer user){
+  (void)f;
+  GtkTreeListRow  *row = GTK_TREE_LIST_ROW(gtk_list_item_get_item(li));
+  GtkTreeExpander *exp = GTK_TREE_EXPANDER(gtk_list_item_get_child(li));
+  gtk_tree_expander_set_list_row(exp, row);
+
+  UmiFileNode *n = UMI_FILE_NODE(gtk_tree_list_row_get_item(row));
+  GtkWidget *box = gtk_tree_expander_get_child(exp);
+  gtk_label_set_text(GTK_LABEL(gtk_widget_get_first_child(box)), n->name);
+  g_object_unref(n);
+
   UmiFileTree *t = (UmiFileTree*)user;
+  g_hash_table_add(t->bound, li);
+  git_mark(t, li);
 
-#if defined(G_GNUC_BEGIN_IGNORE_DEPRECATIONS)
-  G_GNUC_BEGIN_IGNORE_DEPRECATIONS
-#endif
-  GtkTreeModel *m = gtk_tree_view_get_model(v);
-  GtkTreeIter it;
-  if(!gtk_tree_model_get_iter(m, &it, tp))
-    return;
+  g_signal_connect(row, "notify::expanded", G_CALLBACK(on_row_expanded), user);
+}
+
+static void on_unbind(GtkSignalListItemFactory *f, GtkListItem *li, gpointer user){
+  (void)f;
+  GtkTreeListRow *row = GTK_TREE_LIST_ROW(gtk_list_item_get_item(li));
+  if(row) g_signal_handlers_disconnect_by_func(row, G_CALLBACK(on_row_expanded), user);
+  g_hash_table_remove(((UmiFileTree*)user)->bound, li);
+  gtk_tree_expander_set_list_row(GTK_TREE_EXPANDER(gtk_list_item_get_child(li)), NULL);
+}
+
+/* Called when a row is double‑clicked or Enter is pressed. Directories also
+ * toggle open/closed, as the expander arrow would. */
+static void on_activate_row(GtkListView *v, guint pos, gpointer user){
+  (void)v;                       /* the model is reachable through 't' */
+  UmiFileTree *t = (UmiFileTree*)user;
 
-  gchar *path = NULL;
-  gboolean is_dir = FALSE;
-  gtk_tree_model_get(m, &it,
-                     COL_PATH,   &path,
-                     COL_IS_DIR, &is_dir,
-                     -1);
-#if defined(G_GNUC_END_IGNORE_DEPRECATIONS)
-  G_GNUC_END_IGNORE_DEPRECATIONS
-#endif
+  GtkTreeListRow *row = gtk_tree_list_model_get_row(t->model, pos);
+  if(!row) return;
+  UmiFileNode *n = UMI_FILE_NODE(gtk_tree_list_row_get_item(row));
 
   if(t->on_activate)
-    t->on_activate(t->user, path, is_dir);
+    t->on_activate(t->user, n->path, n->is_dir);
+  if(n->expandable)
+    gtk_tree_list_row_set_expanded(row, !gtk_tree_list_row_get_expanded(row));
 
-  g_free(path);
+  g_object_unref(n);
+  g_object_unref(row);
 }
 /*--------------------------------- End of file -------------------------------*/
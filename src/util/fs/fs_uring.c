@@ -0,0 +1,231 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/util/fs/fs_uring.c
+ *
+ * PURPOSE:
+ *   Raw io_uring ring used for batched openat/statx (see fs_uring.h).
+ *
+ * DESIGN:
+ *   - Setup maps the SQ/CQ rings and the SQE array once; submission fills
+ *     SQEs at the SQ tail, io_uring_enter() submits and optionally waits,
+ *     completions are popped from the CQ head.
+ *   - Ring indices shared with the kernel are read with acquire and written
+ *     with release ordering; everything else is owned by the caller.
+ *   - 'in_flight' counts queued-but-unreaped requests so the CQ (twice the
+ *     SQ size) can never overflow.
+ *   - Opcode support is probed at setup (IORING_REGISTER_PROBE, 5.6+), so
+ *     a ring only exists when every request type we issue will work.
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include "include/fs_uring.h"
+
+#if UMI_HAVE_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#endif
+
+#if UMI_HAVE_URING && defined(IORING_FEAT_RW_CUR_POS)   /* 5.6+ UAPI header */
+
+struct UmiUring {
+    int                  fd;
+    guint                entries;
+    guint                in_flight;   /* queued, not yet reaped               */
+    guint                to_submit;   /* queued, not yet handed to the kernel */
+
+    void                *sq_map;
+    gsize                sq_map_len;
+    void                *cq_map;      /* == sq_map with IORING_FEAT_SINGLE_MMAP */
+    gsize                cq_map_len;
+    struct io_uring_sqe *sqes;
+    gsize                sqes_len;
+
+    unsigned            *sq_tail;
+    unsigned            *sq_mask;
+    unsigned            *sq_array;
+    unsigned            *cq_head;
+    unsigned            *cq_tail;
+    unsigned            *cq_mask;
+    struct io_uring_cqe *cqes;
+};
+
+static gboolean
+probe_ops(int fd)
+{
+    const gsize len = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *p = g_malloc0(len);
+    gboolean ok = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, p, 256) == 0 &&
+                  p->last_op >= IORING_OP_STATX &&
+                  (p->ops[IORING_OP_OPENAT].flags & IO_URING_OP_SUPPORTED) &&
+                  (p->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED);
+    g_free(p);
+    return ok;
+}
+
+UmiUring *
+umi_uring_new(guint entries)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof p);
+    const int fd = (int)syscall(__NR_io_uring_setup, MAX(entries, 1u), &p);
+    if (fd < 0) return NULL;
+    if (!probe_ops(fd)) { close(fd); return NULL; }
+
+    UmiUring *r = g_new0(UmiUring, 1);
+    r->fd      = fd;
+    r->entries = p.sq_entries;
+
+    r->sq_map_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_map_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    const gboolean single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) r->sq_map_len = r->cq_map_len = MAX(r->sq_map_len, r->cq_map_len);
+
+    r->sq_map = mmap(NULL, r->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     fd, IORING_OFF_SQ_RING);
+    if (r->sq_map == MAP_FAILED) { r->sq_map = NULL; umi_uring_free(r); return NULL; }
+    r->cq_map = single ? r->sq_map
+                       : mmap(NULL, r->cq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                              fd, IORING_OFF_CQ_RING);
+    if (r->cq_map == MAP_FAILED) { r->cq_map = NULL; umi_uring_free(r); return NULL; }
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) { r->sqes = NULL; umi_uring_free(r); return NULL; }
+
+    char *sq = r->sq_map, *cq = r->cq_map;
+    r->sq_tail  = (unsigned *)(void *)(sq + p.sq_off.tail);
+    r->sq_mask  = (unsigned *)(void *)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned *)(void *)(sq + p.sq_off.array);
+    r->cq_head  = (unsigned *)(void *)(cq + p.cq_off.head);
+    r->cq_tail  = (unsigned *)(void *)(cq + p.cq_off.tail);
+    r->cq_mask  = (unsigned *)(void *)(cq + p.cq_off.ring_mask);
+    r->cqes     = (struct io_uring_cqe *)(void *)(cq + p.cq_off.cqes);
+    return r;
+}
+
+void
+umi_uring_free(UmiUring *r)
+{
+    if (!r) return;
+    if (r->sqes) munmap(r->sqes, r->sqes_len);
+    if (r->cq_map && r->cq_map != r->sq_map) munmap(r->cq_map, r->cq_map_len);
+    if (r->sq_map) munmap(r->sq_map, r->sq_map_len);
+    close(r->fd);
+    g_free(r);
+}
+
+guint
+umi_uring_space(const UmiUring *r)
+{
+    return r ? r->entries - r->in_flight : 0;
+}
+
+/* Next free SQE (zeroed), or NULL when the ring is full. */
+static struct io_uring_sqe *
+get_sqe(UmiUring *r)
+{
+    if (r->in_flight >= r->entries) return NULL;
+    const unsigned tail = *r->sq_tail + r->to_submit;   /* only we write tail */
+    const unsigned slot = tail & *r->sq_mask;
+    struct io_uring_sqe *sqe = &r->sqes[slot];
+    memset(sqe, 0, sizeof *sqe);
+    r->sq_array[slot] = slot;
+    r->to_submit++;
+    r->in_flight++;
+    return sqe;
+}
+
+gboolean
+umi_uring_openat(UmiUring *r, int dfd, const char *path, int flags, guint64 tag)
+{
+    struct io_uring_sqe *sqe = r ? get_sqe(r) : NULL;
+    if (!sqe) return FALSE;
+    sqe->opcode     = IORING_OP_OPENAT;
+    sqe->fd         = dfd;
+    sqe->addr       = (guint64)(guintptr)path;
+    sqe->open_flags = (guint32)flags;
+    sqe->user_data  = tag;
+    return TRUE;
+}
+
+gboolean
+umi_uring_statx(UmiUring *r, int dfd, const char *path, int flags,
+                guint mask, struct statx *out, guint64 tag)
+{
+    struct io_uring_sqe *sqe = r ? get_sqe(r) : NULL;
+    if (!sqe) return FALSE;
+    sqe->opcode      = IORING_OP_STATX;
+    sqe->fd          = dfd;
+    sqe->addr        = (guint64)(guintptr)path;
+    sqe->len         = mask;
+    sqe->off         = (guint64)(guintptr)out;
+    sqe->statx_flags = (guint32)flags;
+    sqe->user_data   = tag;
+    return TRUE;
+}
+
+gboolean
+umi_uring_submit(UmiUring *r, guint wait_nr)
+{
+    if (!r) return FALSE;
+    if (r->to_submit) {                                /* publish the new tail */
+        __atomic_store_n(r->sq_tail, *r->sq_tail + r->to_submit, __ATOMIC_RELEASE);
+    }
+    wait_nr = MIN(wait_nr, r->in_flight);
+    while (r->to_submit || wait_nr) {
+        const long n = syscall(__NR_io_uring_enter, r->fd, r->to_submit, wait_nr,
+                               wait_nr ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return FALSE;
+        }
+        r->to_submit -= MIN((guint)n, r->to_submit);
+        if (!r->to_submit) break;                      /* waited as well      */
+    }
+    return TRUE;
+}
+
+gboolean
+umi_uring_reap(UmiUring *r, guint64 *tag, gint *res)
+{
+    if (!r) return FALSE;
+    const unsigned head = *r->cq_head;                 /* only we write head  */
+    if (head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) return FALSE;
+    const struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+    if (tag) *tag = cqe->user_data;
+    if (res) *res = cqe->res;
+    __atomic_store_n(r->cq_head, head + 1, __ATOMIC_RELEASE);
+    r->in_flight--;
+    return TRUE;
+}
+
+#else /* no io_uring: every ring is "unavailable" */
+
+UmiUring *umi_uring_new(guint entries)      { (void)entries; return NULL; }
+void      umi_uring_free(UmiUring *r)       { (void)r; }
+guint     umi_uring_space(const UmiUring *r) { (void)r; return 0; }
+
+gboolean
+umi_uring_openat(UmiUring *r, int dfd, const char *path, int flags, guint64 tag)
+{
+    (void)r; (void)dfd; (void)path; (void)flags; (void)tag;
+    return FALSE;
+}
+
+gboolean
+umi_uring_statx(UmiUring *r, int dfd, const char *path, int flags,
+                guint mask, struct statx *out, guint64 tag)
+{
+    (void)r; (void)dfd; (void)path; (void)flags; (void)mask; (void)out; (void)tag;
+    return FALSE;
+}
+
+gboolean umi_uring_submit(UmiUring *r, guint wait_nr)               { (void)r; (void)wait_nr; return FALSE; }
+gboolean umi_uring_reap(UmiUring *r, guint64 *tag, gint *res)       { (void)r; (void)tag; (void)res; return FALSE; }
+
+#endif
@@ -0,0 +1,471 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/util/fs/ignore_rules.c
+ *
+ * PURPOSE:
+ *   gitignore-style matcher (see ignore_rules.h for the rule semantics).
+ *
+ * DESIGN:
+ *   - Rules are compiled once when their file is read. Most real-world
+ *     patterns are plain names ("node_modules", "build/") or extensions
+ *     ("*.o"); those become a strcmp or a tail memcmp. Only the rest goes
+ *     through the glob matcher.
+ *   - Rule sets are cached per directory (root-relative, '/'-separated key).
+ *     Directories without ignore files are cached as NULL, so each
+ *     directory costs at most one failed open per source, once.
+ *   - Sets are reference counted: a scope keeps the sets it resolved even if
+ *     the cache entry is invalidated while a walk is still running.
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include "include/ignore_rules.h"
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+typedef enum {
+    RULE_LITERAL,        /* no wildcards: strcmp                             */
+    RULE_SUFFIX,         /* '*' + plain tail ("*.o"): compare the tail       */
+    RULE_GLOB            /* anything else: glob_match()                      */
+} RuleKind;
+
+typedef struct IgnRule {
+    char   *pat;         /* LITERAL: the name; SUFFIX: the tail; GLOB: all  */
+    gsize   len;
+    guint8  kind;
+    guint8  negate;      /* '!' prefix                                      */
+    guint8  dir_only;    /* trailing '/'                                    */
+    guint8  anchored;    /* matched against the path below the rule's dir   */
+} IgnRule;
+
+/* All rules of one directory, lowest precedence first. */
+typedef struct IgnSet {
+    gint     ref;
+    GArray  *rules;      /* IgnRule; the last matching rule wins            */
+    gint64   stamp;      /* see umi_ignore_stamp()                          */
+    gboolean anchored;   /* any anchored rule                               */
+} IgnSet;
+
+struct _UmiIgnore {
+    char       *root;    /* canonical                                       */
+    GMutex      lock;
+    GHashTable *sets;    /* rel dir ("" = root) -> IgnSet*, NULL = no files */
+};
+
+struct _UmiIgnoreScope {
+    guint     n;
+    IgnSet  **sets;      /* root first                                      */
+    gsize    *base;      /* offset in 'rel' of the path below sets[i]'s dir */
+    gboolean  anchored;
+    GString  *rel;       /* "<dir>/" (empty at the root), then the entry    */
+    gsize     rel_len;
+};
+
+/* Ignore files read for every directory, lowest precedence first. */
+static const char *const k_sources[] = { ".gitignore", ".ignore" };
+
+/*===========================================================================
+ * Rule sets
+ *=========================================================================*/
+
+static void
+set_unref(gpointer p)
+{
+    IgnSet *set = (IgnSet *)p;
+    if (!set || !g_atomic_int_dec_and_test(&set->ref)) return;
+    for (guint i = 0; i < set->rules->len; ++i)
+        g_free(g_array_index(set->rules, IgnRule, i).pat);
+    g_array_free(set->rules, TRUE);
+    g_free(set);
+}
+
+static IgnSet *
+set_ref(IgnSet *set)
+{
+    if (set) g_atomic_int_inc(&set->ref);
+    return set;
+}
+
+static gboolean
+has_wildcard(const char *s, gsize n)
+{
+    for (gsize i = 0; i < n; ++i)
+        if (s[i] == '*' || s[i] == '?' || s[i] == '[' || s[i] == '\\') return TRUE;
+    return FALSE;
+}
+
+/* Compile one line of an ignore file. */
+static void
+add_rule(IgnSet *set, const char *line, gsize n)
+{
+    if (n > 0 && line[n - 1] == '\r') --n;
+    while (n > 0 && line[n - 1] == ' ' && !(n >= 2 && line[n - 2] == '\\')) --n;
+    if (n == 0 || line[0] == '#') return;
+
+    IgnRule r;
+    memset(&r, 0, sizeof r);
+    if (line[0] == '!') { r.negate = 1; ++line; --n; }
+    if (n > 0 && line[n - 1] == '/') { r.dir_only = 1; --n; }
+    if (n > 0 && line[0] == '/') { r.anchored = 1; ++line; --n; }
+    if (n == 0) return;
+    if (memchr(line, '/', n)) r.anchored = 1;
+
+    if (!has_wildcard(line, n)) {
+        r.kind = RULE_LITERAL;
+        r.pat  = g_strndup(line, n);
+    } else if (!r.anchored && n > 1 && line[0] == '*' && !has_wildcard(line + 1, n - 1)) {
+        r.kind = RULE_SUFFIX;
+        r.pat  = g_strndup(line + 1, n - 1);
+    } else {
+        r.kind = RULE_GLOB;
+        r.pat  = g_strndup(line, n);
+    }
+    r.len = strlen(r.pat);
+    set->anchored |= r.anchored;
+    g_array_append_val(set->rules, r);
+}
+
+/* Append the rules in 'path'; returns its stamp contribution (0: absent). */
+static gint64
+read_rules(IgnSet *set, const char *path)
+{
+    char  *text = NULL;
+    gsize  len  = 0;
+    if (!g_file_get_contents(path, &text, &len, NULL)) return 0;
+
+    for (const char *p = text, *end = text + len; p < end; ) {
+        const char *nl = memchr(p, '\n', (gsize)(end - p));
+        const char *le = nl ? nl : end;
+        add_rule(set, p, (gsize)(le - p));
+        p = le + 1;
+    }
+    g_free(text);
+
+#ifdef G_OS_UNIX
+    struct stat st;
+    if (stat(path, &st) != 0) return 1;
+    return (gint64)st.st_mtim.tv_sec * G_USEC_PER_SEC + st.st_mtim.tv_nsec / 1000 +
+           (gint64)st.st_size + 1;
+#else
+    GStatBuf st;
+    if (g_stat(path, &st) != 0) return 1;
+    return (gint64)st.st_mtime * G_USEC_PER_SEC + (gint64)st.st_size + 1;
+#endif
+}
+
+/* Read the ignore files of root-relative directory 'rel'; NULL if none. */
+static IgnSet *
+load_set(const UmiIgnore *ig, const char *rel)
+{
+    IgnSet *set = g_new0(IgnSet, 1);
+    set->ref   = 1;
+    set->rules = g_array_new(FALSE, FALSE, sizeof(IgnRule));
+
+    char *dir = *rel ? g_build_filename(ig->root, rel, NULL) : g_strdup(ig->root);
+    if (!*rel) {
+        char *exclude = g_build_filename(dir, ".git", "info", "exclude", NULL);
+        set->stamp += read_rules(set, exclude);
+        g_free(exclude);
+    }
+    for (guint i = 0; i < G_N_ELEMENTS(k_sources); ++i) {
+        char *path = g_build_filename(dir, k_sources[i], NULL);
+        set->stamp += read_rules(set, path);
+        g_free(path);
+    }
+    g_free(dir);
+
+    if (set->stamp == 0) {
+        set_unref(set);
+        return NULL;
+    }
+    return set;
+}
+
+/* Cached set for 'rel' (new reference), loading it on first use. */
+static IgnSet *
+get_set(UmiIgnore *ig, const char *rel)
+{
+    gpointer hit = NULL;
+    g_mutex_lock(&ig->lock);
+    const gboolean found = g_hash_table_lookup_extended(ig->sets, rel, NULL, &hit);
+    IgnSet *set = found ? set_ref((IgnSet *)hit) : NULL;
+    g_mutex_unlock(&ig->lock);
+    if (found) return set;
+
+    set = load_set(ig, rel);                           /* I/O outside lock */
+
+    g_mutex_lock(&ig->lock);
+    if (g_hash_table_lookup_extended(ig->sets, rel, NULL, &hit)) {
+        set_unref(set);                                /* lost the race     */
+        set = set_ref((IgnSet *)hit);
+    } else {
+        g_hash_table_insert(ig->sets, g_strdup(rel), set_ref(set));
+    }
+    g_mutex_unlock(&ig->lock);
+    return set;
+}
+
+/*===========================================================================
+ * Matching
+ *=========================================================================*/
+
+/* Glob over a '/'-separated path. 'start' is the beginning of the pattern
+ * (a "**" is only special when it forms a whole component). */
+static gboolean
+glob_match(const char *start, const char *p, const char *s)
+{
+    for (;;) {
+        if (*p == '\0') return *s == '\0';
+
+        if (*p == '*') {
+            if (p[1] == '*' && (p == start || p[-1] == '/') && (p[2] == '/' || p[2] == '\0')) {
+                if (p[2] == '\0') return TRUE;         /* trailing: inside  */
+                for (const char *t = s; ; ++t) {       /* zero or more dirs */
+                    if (glob_match(start, p + 3, t)) return TRUE;
+                    t = strchr(t, '/');
+                    if (!t) return FALSE;
+                }
+            }
+            while (*p == '*') ++p;
+            if (*p == '\0') return strchr(s, '/') == NULL;
+            for (;; ++s) {
+                if (glob_match(start, p, s)) return TRUE;
+                if (*s == '\0' || *s == '/') return FALSE;
+            }
+        }
+
+        if (*p == '?') {
+            if (*s == '\0' || *s == '/') return FALSE;
+            ++p; ++s;
+            continue;
+        }
+
+        if (*p == '[') {
+            const char *q = p + 1;
+            const gboolean neg = (*q == '!' || *q == '^');
+            if (neg) ++q;
+            gboolean hit = FALSE;
+            for (gboolean first = TRUE; *q && (first || *q != ']'); first = FALSE) {
+                unsigned char lo = (unsigned char)*q;
+                if (lo == '\\' && q[1]) lo = (unsigned char)*++q;
+                ++q;
+                unsigned char hi = lo;
+                if (*q == '-' && q[1] && q[1] != ']') {
+                    ++q;
+                    hi = (unsigned char)*q;
+                    if (hi == '\\' && q[1]) hi = (unsigned char)*++q;
+                    ++q;
+                }
+                const unsigned char c = (unsigned char)*s;
+                if (c >= lo && c <= hi) hit = TRUE;
+            }
+            if (*q == ']') {                           /* well-formed class */
+                if (*s == '\0' || *s == '/' || hit == neg) return FALSE;
+                p = q + 1;
+                ++s;
+                continue;
+            }
+            /* Unterminated: a literal '[' (handled below). */
+        }
+
+        if (*p == '\\' && p[1]) ++p;
+        if (*p != *s) return FALSE;
+        ++p; ++s;
+    }
+}
+
+/* Verdict of one set: -1 no rule matches, 1 ignored, 0 re-included. */
+static int
+set_match(const IgnSet *set, const char *sub, const char *name, gsize name_len,
+          gboolean is_dir)
+{
+    for (guint i = set->rules->len; i-- > 0; ) {
+        const IgnRule *r = &g_array_index(set->rules, IgnRule, i);
+        if (r->dir_only && !is_dir) continue;
+
+        gboolean hit;
+        switch (r->kind) {
+        case RULE_LITERAL:
+            hit = strcmp(r->anchored ? sub : name, r->pat) == 0;
+            break;
+        case RULE_SUFFIX:
+            hit = name_len >= r->len && memcmp(name + name_len - r->len, r->pat, r->len) == 0;
+            break;
+        default:
+            hit = glob_match(r->pat, r->pat, r->anchored ? sub : name);
+            break;
+        }
+        if (hit) return r->negate ? 0 : 1;
+    }
+    return -1;
+}
+
+/* Root-relative, '/'-separated form of 'abs' ("" for the root), or NULL
+ * when 'abs' is outside the root. */
+static char *
+rel_path(const UmiIgnore *ig, const char *abs)
+{
+    gsize rl = strlen(ig->root);
+    if (rl > 0 && ig->root[rl - 1] == G_DIR_SEPARATOR) --rl;   /* "/" root */
+    if (strncmp(abs, ig->root, rl) != 0) return NULL;
+    if (abs[rl] == '\0') return g_strdup("");
+    if (abs[rl] != G_DIR_SEPARATOR) return NULL;
+    char *rel = g_strdup(abs + rl + 1);
+#ifdef G_OS_WIN32
+    g_strdelimit(rel, "\\", '/');
+#endif
+    return rel;
+}
+
+/*===========================================================================
+ * Public API
+ *=========================================================================*/
+
+UmiIgnore *
+umi_ignore_new(const char *root)
+{
+    if (!root || !*root) return NULL;
+    UmiIgnore *ig = g_new0(UmiIgnore, 1);
+    ig->root = g_canonicalize_filename(root, NULL);
+    g_mutex_init(&ig->lock);
+    ig->sets = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, set_unref);
+    return ig;
+}
+
+void
+umi_ignore_free(UmiIgnore *ig)
+{
+    if (!ig) return;
+    g_hash_table_destroy(ig->sets);
+    g_mutex_clear(&ig->lock);
+    g_free(ig->root);
+    g_free(ig);
+}
+
+void
+umi_ignore_invalidate(UmiIgnore *ig, const char *abs_dir)
+{
+    if (!ig) return;
+    char *rel = abs_dir ? rel_path(ig, abs_dir) : NULL;
+    if (abs_dir && !rel) return;
+    g_mutex_lock(&ig->lock);
+    if (rel) g_hash_table_remove(ig->sets, rel);
+    else     g_hash_table_remove_all(ig->sets);
+    g_mutex_unlock(&ig->lock);
+    g_free(rel);
+}
+
+gint64
+umi_ignore_stamp(UmiIgnore *ig, const char *abs_dir)
+{
+    if (!ig || !abs_dir) return 0;
+    char *rel = rel_path(ig, abs_dir);
+    if (!rel) return 0;
+    IgnSet *set = get_set(ig, rel);
+    const gint64 stamp = set ? set->stamp : 0;
+    set_unref(set);
+    g_free(rel);
+    return stamp;
+}
+
+gboolean
+umi_ignore_is_rule_file(const char *name)
+{
+    if (!name) return FALSE;
+    for (guint i = 0; i < G_N_ELEMENTS(k_sources); ++i)
+        if (strcmp(name, k_sources[i]) == 0) return TRUE;
+    return FALSE;
+}
+
+UmiIgnoreScope *
+umi_ignore_scope_new(UmiIgnore *ig, const char *abs_dir)
+{
+    UmiIgnoreScope *sc = g_new0(UmiIgnoreScope, 1);
+    sc->rel = g_string_new(NULL);
+    char *rel = (ig && abs_dir) ? rel_path(ig, abs_dir) : NULL;
+    if (!rel) return sc;                               /* no rules apply    */
+
+    /* One set per level: "", "a", "a/b", ... up to the directory itself. */
+    GPtrArray *sets = g_ptr_array_new();
+    GArray    *base = g_array_new(FALSE, FALSE, sizeof(gsize));
+    for (gsize cut = 0; ; ) {
+        char   *prefix = g_strndup(rel, cut);
+        IgnSet *set    = get_set(ig, prefix);
+        g_free(prefix);
+        if (set) {
+            const gsize off = cut ? cut + 1 : 0;
+            g_ptr_array_add(sets, set);
+            g_array_append_val(base, off);
+            sc->anchored |= set->anchored;
+        }
+        if (rel[cut] == '\0') break;
+        const char *slash = strchr(rel + cut + (cut ? 1 : 0), '/');
+        cut = slash ? (gsize)(slash - rel) : strlen(rel);
+    }
+
+    sc->n    = sets->len;
+    sc->sets = (IgnSet **)g_ptr_array_free(sets, FALSE);
+    sc->base = (gsize *)(void *)g_array_free(base, FALSE);
+    g_string_append(sc->rel, rel);
+    if (*rel) g_string_append_c(sc->rel, '/');
+    sc->rel_len = sc->rel->len;
+    g_free(rel);
+    return sc;
+}
+
+gboolean
+umi_ignore_scope_match(UmiIgnoreScope *sc, const char *name, gboolean is_dir)
+{
+    if (!sc || !name) return FALSE;
+    if (is_dir && strcmp(name, ".git") == 0) return TRUE;
+    if (sc->n == 0) return FALSE;
+
+    if (sc->anchored) {                                /* path below root   */
+        g_string_truncate(sc->rel, sc->rel_len);
+        g_string_append(sc->rel, name);
+    }
+    const gsize name_len = strlen(name);
+    for (guint i = sc->n; i-- > 0; ) {                 /* deepest first     */
+        const int v = set_match(sc->sets[i], sc->rel->str + sc->base[i], name, name_len, is_dir);
+        if (v >= 0) return v == 1;
+    }
+    return FALSE;
+}
+
+void
+umi_ignore_scope_free(UmiIgnoreScope *sc)
+{
+    if (!sc) return;
+    for (guint i = 0; i < sc->n; ++i) set_unref(sc->sets[i]);
+    g_free(sc->sets);
+    g_free(sc->base);
+    g_string_free(sc->rel, TRUE);
+    g_free(sc);
+}
+
+gboolean
+umi_ignore_is_ignored(UmiIgnore *ig, const char *abs_path, gboolean is_dir)
+{
+    if (!ig || !abs_path) return FALSE;
+    char *rel = rel_path(ig, abs_path);
+    if (!rel || !*rel) { g_free(rel); return FALSE; }
+
+    /* Each component against the rules of its parent, root downwards: an
+     * ignored ancestor wins over anything below it. */
+    gchar  **parts   = g_strsplit(rel, "/", -1);
+    GString *dir     = g_string_new(ig->root);
+    gboolean ignored = FALSE;
+    for (guint i = 0; parts[i] && !ignored; ++i) {
+        if (!*parts[i]) continue;
+        UmiIgnoreScope *sc = umi_ignore_scope_new(ig, dir->str);
+        ignored = umi_ignore_scope_match(sc, parts[i], parts[i + 1] ? TRUE : is_dir);
+        umi_ignore_scope_free(sc);
+        if (dir->len == 0 || dir->str[dir->len - 1] != G_DIR_SEPARATOR)
+            g_string_append_c(dir, G_DIR_SEPARATOR);
+        g_string_append(dir, parts[i]);
+    }
+    g_string_free(dir, TRUE);
+    g_strfreev(parts);
+    g_free(rel);
+    return ignored;
+}
@@ -4,8 +4,9 @@
  *
  * PURPOSE:
  *   Public API for a tiny in-memory file index used by panels that need fast
- *   access to "all files under a root directory". The index stores immutable
- *   (g_strdup'ed) absolute, canonicalized paths in a GLib GPtrArray.
+ *   access to "all files under a root directory". Paths are absolute and
+ *   canonicalized, but stored compactly: a directory table plus interned
+ *   leaf names in one arena. Full paths are rebuilt on demand.
  *
  *  API (stable):
  *    - UmiFileIndex *umi_index_build(const char *root);
@@ -15,14 +16,43 @@
  *    - void umi_index_refresh(UmiFileIndex *idx);
  *        Clear and re-scan the index's files from disk using the same root.
  *
+ *    - gboolean umi_index_apply(UmiFileIndex *idx, UmiIndexEvent kind,
+ *                               const char *path, const char *new_path);
+ *        Patch the index in place from one created/deleted/renamed event
+ *        (binary search; no rescan). guint64 umi_index_generation(idx)
+ *        changes whenever the file set changes, umi_index_epoch(idx)
+ *        only when file ids were renumbered.
+ *
  *    - void umi_index_free(UmiFileIndex *idx);
- *        Release all resources (the array and the strings inside).
+ *        Release all resources (the tables and the name arena).
+ *
+ *    - UmiIndexIter + umi_index_iter_init/next/path/clear
+ *        Zero-copy iteration in index order: leaf name and directory id
+ *        point into the index; the full path is assembled in a buffer that
+ *        is reused across steps (the directory prefix only on change).
+ *
+ *    - guint32 umi_index_lookup(idx, path) / UmiFileMeta *umi_index_meta(idx)
+ *        File id of a path, and the shared per-file metadata cache
+ *        (size, mtime, inode, text/binary, content hash; see file_meta.h).
+ *
+ *    - UmiFileIndex *umi_index_open(const char *root, const char *snapshot);
+ *        Like umi_index_build(), but starts from an on-disk snapshot and only
+ *        re-walks directories whose mtime changed since it was written.
+ *
+ *    - gboolean umi_index_save(const UmiFileIndex *idx, const char *snapshot,
+ *                              GError **err);
+ *        Write a compact, mmap-friendly snapshot (atomic temp + rename).
  *
  * NOTES:
  *   - The index contains only regular files (not directories). If you need both,
- *     adapt the callback in file_index.c (search for 'on_visit').
+ *     adapt the callback in file_index.c (search for 'on_batch').
+ *   - Hidden entries and anything matched by .gitignore/.ignore rules under
+ *     the root (ignore_rules.h) are left out; ignored directories are not
+ *     even opened.
  *   - No GTK dependencies; pure GLib.
  *   - Threading: synchronous; scanning large trees should be dispatched off the UI thread.
+ *     The index is not internally locked: apply events from the thread that
+ *     owns it (typically the GTK main thread, where watcher events arrive).
  *
  * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-12 | MIT
  *---------------------------------------------------------------------------*/
@@ -35,8 +65,8 @@ G_BEGIN_DECLS
 
 /*---------------------------------------------------------------------------
  * Forward-declared opaque handle.
- * Internals (root + GPtrArray of char*) live in the C file to keep the header
- * minimal and stable.
+ * Internals (root + dir/file tables + name arena) live in the C file to keep
+ * the header minimal and stable.
  *-------------------------------------------------------------------------*/
 typedef struct _UmiFileIndex UmiFileIndex;
 
@@ -55,15 +85,143 @@ UmiFileIndex *umi_index_build(const char *root);
  *-------------------------------------------------------------------------*/
 void          umi_index_refresh(UmiFileIndex *idx);
 
+/*---------------------------------------------------------------------------
+ * Incremental updates.
+ *  - UMI_INDEX_CREATED : 'path' appeared. A file is binary-inserted; a
+ *                        directory is walked and merged in one pass.
+ *  - UMI_INDEX_DELETED : 'path' vanished. A file, or a directory together
+ *                        with its whole subtree (one contiguous range).
+ *  - UMI_INDEX_RENAMED : 'path' moved to 'new_path' (delete + create).
+ *  - UMI_INDEX_CHANGED : contents of 'path' changed. The file set only
+ *                        moves for ignore files; for anything else the
+ *                        file's cached metadata is dropped.
+ * Hidden, ignored and out-of-root paths are skipped, like a full scan.
+ * When an ignore file itself appears, changes or goes away, the directory
+ * it governs is re-walked (the whole index for the root's).
+ *
+ * RETURNS: TRUE if the file set changed (and the generation was bumped).
+ *-------------------------------------------------------------------------*/
+typedef enum {
+    UMI_INDEX_CREATED,
+    UMI_INDEX_DELETED,
+    UMI_INDEX_RENAMED,
+    UMI_INDEX_CHANGED
+} UmiIndexEvent;
+
+gboolean      umi_index_apply(UmiFileIndex *idx, UmiIndexEvent kind,
+                              const char *path, const char *new_path);
+
+/*---------------------------------------------------------------------------
+ * Monotonic generation counter. Starts at 1 and increases on every change
+ * (apply/refresh). Consumers cache it and compare to detect staleness.
+ * Returns 0 for NULL.
+ *-------------------------------------------------------------------------*/
+guint64       umi_index_generation(const UmiFileIndex *idx);
+
+/*---------------------------------------------------------------------------
+ * Id epoch. Changes only when file ids are renumbered: refresh, and an
+ * apply that has to re-scan the whole tree (the root's ignore file
+ * appeared, changed or went away). Consumers that keep file ids across
+ * applies compare it; a new value means "match entries by path again".
+ * Returns 0 for NULL.
+ *-------------------------------------------------------------------------*/
+guint64       umi_index_epoch(const UmiFileIndex *idx);
+
 /*---------------------------------------------------------------------------
  * Release all resources of the index. Safe on NULL.
  *-------------------------------------------------------------------------*/
 void          umi_index_free   (UmiFileIndex *idx);
 
 /*---------------------------------------------------------------------------
- * Convenience: fetch read-only slice view of the internal GPtrArray so callers
- * can iterate without copying. This is non-owning; do not free/modify entries.
- * Provided as a helper for panels and tests.
+ * Open an index for 'root' from 'snapshot_path' (see umi_index_save()).
+ * - The snapshot is memory-mapped and reconciled against the disk: every
+ *   recorded directory is stat()'ed; unchanged ones reuse their recorded
+ *   files, changed ones are re-listed, new subdirectories are walked.
+ * - Missing, stale-format or foreign snapshots fall back to a full scan.
+ * - When anything changed, the refreshed snapshot is written back.
+ * - 'snapshot_path' may be NULL (behaves like umi_index_build()).
+ *
+ * RETURNS:
+ *   Newly-allocated UmiFileIndex* or NULL if 'root' is invalid.
+ *-------------------------------------------------------------------------*/
+UmiFileIndex *umi_index_open(const char *root, const char *snapshot_path);
+
+/*---------------------------------------------------------------------------
+ * Serialize 'idx' to 'snapshot_path' (parent directories are created).
+ * Per-directory mtimes are stored so umi_index_open() can skip unchanged
+ * directories, along with the metadata cache (file hashes survive restarts).
+ * Returns FALSE and sets 'err' on I/O failure.
+ *-------------------------------------------------------------------------*/
+gboolean      umi_index_save(const UmiFileIndex *idx, const char *snapshot_path, GError **err);
+
+/*---------------------------------------------------------------------------
+ * Default snapshot location for 'root':
+ *   <user cache dir>/umicom-studio-ide/index/<sha1 of canonical root>.idx
+ * Caller must g_free() the result. NULL if 'root' is empty.
+ *-------------------------------------------------------------------------*/
+char         *umi_index_snapshot_path_for(const char *root);
+
+/*---------------------------------------------------------------------------
+ * Zero-copy iteration.
+ *
+ *   UmiIndexIter it;
+ *   umi_index_iter_init(&it, idx);
+ *   while (umi_index_iter_next(&it)) {
+ *       use(it.id, it.dir, it.name);            // no allocation
+ *       const char *p = umi_index_iter_path(&it); // only when needed
+ *   }
+ *   umi_index_iter_clear(&it);
+ *
+ * Order: directories in path order, each directory's files by name before
+ * its subdirectories'. 'name' and the path buffer stay valid until the next
+ * step or until the index is modified. File ids stay valid while
+ * umi_index_epoch() does not change (deleted ids are never reused, a
+ * re-walked subdirectory gets fresh ones); refresh, and an apply that
+ * re-scans the whole tree, renumber them and change the epoch. The
+ * generation changes on every file set change and cannot tell the two
+ * apart.
+ *-------------------------------------------------------------------------*/
+typedef struct {
+    const UmiFileIndex *idx;
+    guint32     id;        /* file id of the current entry                  */
+    guint32     dir;       /* directory id of the current entry             */
+    const char *name;      /* leaf name, points into the index's arena      */
+    /*< private >*/
+    guint       pos;
+    GString    *path;
+    guint32     path_dir;
+    gsize       dir_len;
+} UmiIndexIter;
+
+void          umi_index_iter_init (UmiIndexIter *it, const UmiFileIndex *idx);
+gboolean      umi_index_iter_next (UmiIndexIter *it);
+const char   *umi_index_iter_path (UmiIndexIter *it);
+void          umi_index_iter_clear(UmiIndexIter *it);
+
+/* Number of live files. */
+guint         umi_index_count(const UmiFileIndex *idx);
+
+/* Canonical root the index was built for (owned by the index). */
+const char   *umi_index_root(const UmiFileIndex *idx);
+
+/* File id of the live file at 'path' (canonicalized; one binary search per
+ * level), or UMI_INDEX_NO_FILE when it is not indexed. */
+#define UMI_INDEX_NO_FILE G_MAXUINT32
+guint32       umi_index_lookup(const UmiFileIndex *idx, const char *path);
+
+/* Metadata cache for this index's files (owned by the index). */
+typedef struct _UmiFileMeta UmiFileMeta;
+UmiFileMeta  *umi_index_meta(const UmiFileIndex *idx);
+
+/* Random access by file id; NULL for deleted/unknown ids.
+ * _name is zero-copy; _path is newly allocated (g_free). */
+const char   *umi_index_file_name(const UmiFileIndex *idx, guint32 file_id);
+char         *umi_index_file_path(const UmiFileIndex *idx, guint32 file_id);
+
+/*---------------------------------------------------------------------------
+ * Convenience: read-only array of full paths for callers that want plain
+ * strings. Materialized on first use per generation and owned by the index
+ * (do not free/modify entries); prefer UmiIndexIter on large trees.
  *-------------------------------------------------------------------------*/
 static inline const char * const *umi_index_files(const UmiFileIndex *idx, guint *out_len)
 {
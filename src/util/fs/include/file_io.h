@@ -18,4 +18,14 @@
    NOTE: For maximum durability (fsync), a custom open/write/fsync/rename flow would be required. */
 gboolean umi_file_save_atomic(const char *path, const char *data, gssize len, GError **err);
 
+/* The two halves of umi_file_save_atomic(), for writing many files as one
+   batch: stage every file first, and commit only when all were staged.
+   - umi_file_stage() writes "path.tmp" (with the permissions of 'path' when
+     it exists) and returns that temp path (g_free), or NULL with 'err' set.
+     'path' itself is not touched.
+   - umi_file_commit() renames the temp over 'path'. The temp is removed on
+     failure; to drop a staged temp without committing, g_remove() it. */
+gchar   *umi_file_stage(const char *path, const char *data, gssize len, GError **err);
+gboolean umi_file_commit(const char *tmp, const char *path, GError **err);
+
 #endif /* UMICOM_FILE_IO_H */
@@ -0,0 +1,97 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/util/fs/include/file_meta.h
+ *
+ * PURPOSE:
+ *   Per-file metadata shared by every subsystem that looks at project files
+ *   (search, editor, LLM context builder): size, mtime, inode, a text or
+ *   binary classification and a fast 64-bit content hash, keyed by the file
+ *   ids of a UmiFileIndex so nobody has to stat or read a file just to learn
+ *   whether it is binary or unchanged.
+ *
+ * LIFECYCLE:
+ *   - Every UmiFileIndex owns one cache (umi_index_meta()). The index walk
+ *     fills size/mtime/inode as it lists each directory; kind and hash are
+ *     computed on first request and kept until the file changes.
+ *   - umi_index_apply(UMI_INDEX_CHANGED) drops what is known about a file,
+ *     so watcher events keep the cache honest. Without a watcher, entries
+ *     reflect the last walk.
+ *   - The index snapshot carries the cache across sessions. Restored entries
+ *     are verified with one stat() on first use: if size, mtime and inode
+ *     still match, kind and hash are reused without reading the file.
+ *
+ * THREADING:
+ *   - Lookups may come from any thread (search workers hash in parallel);
+ *     records are locked internally and file I/O happens outside the lock.
+ *   - Like any index read, lookups must not race umi_index_apply/refresh
+ *     (file ids are resolved to paths through the index).
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_FILE_META_H
+#define UMICOM_FILE_META_H
+
+#include <glib.h>
+#include "file_index.h"
+
+G_BEGIN_DECLS
+
+typedef enum {
+    UMI_FILE_KIND_UNKNOWN = 0,   /* not classified yet                       */
+    UMI_FILE_KIND_TEXT,
+    UMI_FILE_KIND_BINARY         /* a NUL byte in the first 8000 bytes (git) */
+} UmiFileKind;
+
+typedef struct {
+    gint64      size;            /* bytes                                    */
+    gint64      mtime_us;        /* microseconds since the epoch             */
+    guint64     ino;
+    UmiFileKind kind;            /* UNKNOWN unless already classified        */
+    gboolean    has_hash;
+    guint64     hash;            /* valid when has_hash                      */
+} UmiFileStat;
+
+/*---------------------------------------------------------------------------
+ * Lookups. All return FALSE / UNKNOWN for deleted ids and vanished files.
+ *-------------------------------------------------------------------------*/
+
+/* Size, mtime and inode (one stat() only if nothing trusted is cached);
+ * kind and hash are filled when already known, never computed here. */
+gboolean     umi_file_meta_stat(UmiFileMeta *m, guint32 file_id, UmiFileStat *out);
+
+/* Text or binary; reads at most the first 8000 bytes, once. */
+UmiFileKind  umi_file_meta_kind(UmiFileMeta *m, guint32 file_id);
+
+/* 64-bit content hash (XXH64, seed 0), computed once per file version. */
+gboolean     umi_file_meta_hash(UmiFileMeta *m, guint32 file_id, guint64 *out_hash);
+
+/* XXH64 of a buffer, for callers comparing in-memory text (editor buffers)
+ * against umi_file_meta_hash(). */
+guint64      umi_file_meta_hash_bytes(const void *data, gsize len);
+
+/*---------------------------------------------------------------------------
+ * Index hooks. Called by file_index.c on the thread that owns the index.
+ *-------------------------------------------------------------------------*/
+UmiFileMeta *umi_file_meta_new(const UmiFileIndex *idx);
+void         umi_file_meta_free(UmiFileMeta *m);
+
+/* Forget everything (file ids are about to be reassigned). */
+void         umi_file_meta_reset(UmiFileMeta *m);
+
+/* Trusted stat of a freshly walked file. */
+void         umi_file_meta_record(UmiFileMeta *m, guint32 file_id,
+                                  gint64 size, gint64 mtime_us, guint64 ino);
+
+/* Entry loaded from a snapshot: trusted only after a matching stat(). */
+void         umi_file_meta_restore(UmiFileMeta *m, guint32 file_id, const UmiFileStat *st);
+
+/* The file's contents changed (or it went away): drop stat, kind and hash. */
+void         umi_file_meta_invalidate(UmiFileMeta *m, guint32 file_id);
+
+/* What is cached, without any I/O (for the snapshot writer). FALSE when
+ * nothing is known about the file. */
+gboolean     umi_file_meta_peek(UmiFileMeta *m, guint32 file_id, UmiFileStat *out);
+
+G_END_DECLS
+
+#endif /* UMICOM_FILE_META_H */
@@ -1,17 +1,20 @@
 /*-----------------------------------------------------------------------------
  * Umicom Studio IDE
  * File: src/util/fs/include/file_tree.h
- * PURPOSE: Minimal GTK file tree widget wrapper
+ * PURPOSE: Minimal GTK file tree widget wrapper (lazy GtkListView +
+ *          GtkTreeListModel; directories are listed asynchronously on
+ *          first expansion)
  * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-01 | MIT
  *---------------------------------------------------------------------------*/
 
 #ifndef UMICOM_FILE_TREE_H
 #define UMICOM_FILE_TREE_H
 
-#include <gtk/gtk.h>     /* GtkTreeView, GtkTreeStore, etc. */
+#include <gtk/gtk.h>     /* GtkListView, GtkTreeListModel, etc. */
 #include <glib.h>        /* gchar, gboolean */
 
 typedef struct _UmiFileTree UmiFileTree;  /* Opaque handle. */
+typedef struct _UmiGitStatusEngine UmiGitStatusEngine;  /* git_status.h */
 
 /* Callback when a row (file/dir) is activated from the UI. */
 typedef void (*UmiFileActivateCb)(gpointer user, const char *path, gboolean is_dir);
@@ -21,15 +24,29 @@ typedef void (*UmiFileActivateCb)(gpointer user, const char *path, gboolean is_d
    - 'user' is passed back to the callback untouched. */
 UmiFileTree *umi_file_tree_new(UmiFileActivateCb on_activate, gpointer user);
 
-/* Get the GTK widget to pack into your UI. */
+/* Get the GTK widget to pack into your UI (a GtkScrolledWindow around the
+   list, so only visible rows get widgets). The tree keeps its own
+   reference until umi_file_tree_free(). */
 GtkWidget   *umi_file_tree_widget(UmiFileTree *t);
 
 /* Change the root directory displayed by the tree and reload. */
 void         umi_file_tree_set_root(UmiFileTree *t, const char *path);
 
-/* Re-scan current root and refresh the view. */
+/* Re-list every folder shown so far in the background and patch the view:
+   only rows that appeared or vanished change, so expanded folders and the
+   selection survive. Ignore files are re-read. */
 void         umi_file_tree_refresh(UmiFileTree *t);
 
+/* Filesystem event hook: 'path' was created, deleted or renamed (or is an
+   ignore file that changed). Its directory is re-listed the same way after
+   a short debounce, if the tree has listed it; otherwise nothing happens. */
+void         umi_file_tree_notify(UmiFileTree *t, const char *path);
+
+/* Mark rows with their git status ('M', '?', ...; folders get '*' when
+   something below changed) and follow status changes. 'git' is borrowed:
+   detach with NULL before freeing it. */
+void         umi_file_tree_set_git_status(UmiFileTree *t, UmiGitStatusEngine *git);
+
 /* Free all resources held by the tree (safe on NULL). */
 void         umi_file_tree_free(UmiFileTree *t);
 
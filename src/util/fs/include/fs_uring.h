@@ -0,0 +1,67 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/util/fs/include/fs_uring.h
+ *
+ * PURPOSE:
+ *   Minimal io_uring submission/completion ring for batched metadata I/O
+ *   (openat, statx). Used by the parallel walker to keep many requests in
+ *   flight per thread on cold or network-backed storage.
+ *
+ * NOTES:
+ *   - Talks to the kernel directly (io_uring_setup/enter/register); no
+ *     liburing dependency.
+ *   - Compiled in on Linux when the build sets USIDE_IO_URING (CMake option,
+ *     ON by default). At runtime umi_uring_new() probes the kernel and
+ *     returns NULL when io_uring or the needed opcodes are unavailable
+ *     (kernel < 5.6, seccomp, container policy); callers then take their
+ *     plain syscall path.
+ *   - getdents has no io_uring opcode; directory listing stays synchronous.
+ *
+ * THREADING:
+ *   - A ring is single-threaded: one per worker.
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_FS_URING_H
+#define UMICOM_FS_URING_H
+
+#include <glib.h>
+
+#if defined(__linux__) && defined(USIDE_IO_URING) && USIDE_IO_URING && defined(__has_include)
+#  if __has_include(<linux/io_uring.h>)
+#    define UMI_HAVE_URING 1
+#  endif
+#endif
+#ifndef UMI_HAVE_URING
+#  define UMI_HAVE_URING 0
+#endif
+
+G_BEGIN_DECLS
+
+typedef struct UmiUring UmiUring;
+struct statx;
+
+/* Ring with room for 'entries' requests in flight; NULL if unavailable. */
+UmiUring *umi_uring_new(guint entries);
+void      umi_uring_free(UmiUring *r);
+
+/* Requests that can still be queued before some must be reaped. */
+guint     umi_uring_space(const UmiUring *r);
+
+/* Queue a request ('tag' comes back with its result). 'path' and 'out'
+ * must stay valid until the completion is reaped. FALSE when full. */
+gboolean  umi_uring_openat(UmiUring *r, int dfd, const char *path, int flags, guint64 tag);
+gboolean  umi_uring_statx(UmiUring *r, int dfd, const char *path, int flags,
+                          guint mask, struct statx *out, guint64 tag);
+
+/* Submit everything queued and wait until at least 'wait_nr' completions
+ * are ready (0: do not wait). FALSE on a ring error. */
+gboolean  umi_uring_submit(UmiUring *r, guint wait_nr);
+
+/* Pop one ready completion: 'res' is the syscall result (-errno on
+ * failure). FALSE when none is ready. */
+gboolean  umi_uring_reap(UmiUring *r, guint64 *tag, gint *res);
+
+G_END_DECLS
+
+#endif /* UMICOM_FS_URING_H */
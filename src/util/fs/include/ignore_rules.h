@@ -0,0 +1,76 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/util/fs/include/ignore_rules.h
+ *
+ * PURPOSE:
+ *   Compiled .gitignore / .ignore matcher for everything that walks a
+ *   project tree (fs_walk, file_index, file_tree). Ignored directories are
+ *   rejected by name while their parent is being listed, so they are never
+ *   opened.
+ *
+ * SEMANTICS (gitignore(5)):
+ *   - Sources per directory, lowest precedence first: .git/info/exclude
+ *     (root only), .gitignore, .ignore. Rules apply to the directory they
+ *     live in and everything below it.
+ *   - Blank lines and '#' comments are skipped; "\#", "\!" and "\ " escape.
+ *   - '!' negates (re-includes). A trailing '/' matches directories only.
+ *   - A pattern containing a '/' (other than a trailing one) is anchored to
+ *     its directory; otherwise it matches the leaf name at any depth.
+ *   - '*' and '?' never match a '/'; classes '[a-z]' and '[!a-z]'. A "**"
+ *     that is a whole path component matches zero or more directories
+ *     (leading or in the middle) or everything inside (trailing).
+ *   - The deepest file with a matching rule decides; inside one file the
+ *     last matching rule wins. As in git, a file inside an ignored
+ *     directory cannot be re-included.
+ *   - A directory named ".git" is always ignored.
+ *
+ * THREADING:
+ *   - A UmiIgnore may be shared by any number of threads (the per-directory
+ *     rule cache is locked internally; files are read outside the lock).
+ *   - A UmiIgnoreScope belongs to the thread that created it.
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_IGNORE_RULES_H
+#define UMICOM_IGNORE_RULES_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _UmiIgnore      UmiIgnore;
+typedef struct _UmiIgnoreScope UmiIgnoreScope;
+
+/* Matcher for the tree under 'root'. Ignore files are read lazily, once per
+ * directory, the first time something below that directory is matched. */
+UmiIgnore      *umi_ignore_new(const char *root);
+void            umi_ignore_free(UmiIgnore *ig);
+
+/* Forget the cached rules of directory 'abs_dir' (NULL: every directory)
+ * after one of its ignore files was created, edited or removed. */
+void            umi_ignore_invalidate(UmiIgnore *ig, const char *abs_dir);
+
+/* TRUE when 'abs_path' or any of its ancestors below the root is ignored.
+ * For one-off checks (watcher events); walkers should use a scope. */
+gboolean        umi_ignore_is_ignored(UmiIgnore *ig, const char *abs_path, gboolean is_dir);
+
+/* Change stamp of the ignore files in 'abs_dir' (mtime and size folded
+ * together), 0 when the directory has none. */
+gint64          umi_ignore_stamp(UmiIgnore *ig, const char *abs_dir);
+
+/* TRUE for the leaf names this module reads (".gitignore", ".ignore"). */
+gboolean        umi_ignore_is_rule_file(const char *name);
+
+/*---------------------------------------------------------------------------
+ * Scopes: the rules in effect inside one directory, resolved once, then
+ * matched against each of its entries by leaf name. The caller must already
+ * know that 'abs_dir' itself is not ignored (walkers never descend into an
+ * ignored directory, so that holds by construction).
+ *-------------------------------------------------------------------------*/
+UmiIgnoreScope *umi_ignore_scope_new(UmiIgnore *ig, const char *abs_dir);
+gboolean        umi_ignore_scope_match(UmiIgnoreScope *sc, const char *name, gboolean is_dir);
+void            umi_ignore_scope_free(UmiIgnoreScope *sc);
+
+G_END_DECLS
+
+#endif /* UMICOM_IGNORE_RULES_H */
@@ -0,0 +1,534 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/util/git/git_blame.c
+ *
+ * PURPOSE:
+ *   Streaming, cached git blame (see git_blame.h).
+ *
+ * DESIGN:
+ *   - A request runs two steps: "git rev-parse HEAD:./<name>" for the blob
+ *     id (the cache key), then, on a miss in memory and on disk, "git blame
+ *     --incremental --porcelain HEAD -- <name>" read 64 KiB at a time. Both
+ *     run with the file's directory as working directory, so no path has
+ *     to be made relative to the work tree.
+ *   - The incremental format is line based: a header "<id> <orig> <final>
+ *     <count>", then "key value" lines (full commit details only the first
+ *     time an id appears) and always "filename <path>" last. Strings are
+ *     interned in a GStringChunk per result.
+ *   - The disk cache stores git's raw output behind a format line and is
+ *     replayed through the same parser; it is written asynchronously with
+ *     an atomic replace.
+ *   - Every step checks the request's cancellable (the caller's, plus the
+ *     cache's own on umi_blame_cache_free()) before touching anything.
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include "include/git_blame.h"
+#include "include/git_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define UMI_BLAME_READ_SIZE   (64 * 1024)
+#define UMI_BLAME_CACHE_MAGIC "umi-blame 1\n"
+
+struct _UmiBlame {
+    gint            ref;
+    GStringChunk   *strings;
+    GHashTable     *commits;    /* id -> UmiBlameCommit*                      */
+    GArray         *chunks;     /* UmiBlameChunk, arrival order               */
+    GArray         *by_line;    /* guint: chunk index + 1, 0 = not known yet  */
+    gboolean        complete;
+    /* Parser state. */
+    GString        *partial;    /* unterminated last line                     */
+    UmiBlameCommit *cur;        /* commit of the group being read             */
+    UmiBlameChunk   pending;
+    gboolean        in_group;
+};
+
+struct _UmiBlameCache {
+    char         *dir;
+    guint         max_mem;
+    GHashTable   *mem;          /* key -> UmiBlame* (ref)                     */
+    GQueue        lru;          /* keys (owned by 'mem'), most recent first   */
+    GHashTable   *reqs;         /* running BlameReq set                       */
+};
+
+typedef struct {
+    UmiBlameCache *cache;       /* NULL once the cache is gone                */
+    GCancellable  *user_cancel;
+    gulong         user_handler;
+    GCancellable  *cancel;      /* ours: every async step uses it             */
+    char          *dir, *name;
+    char          *path_key;    /* hash of the canonical path                 */
+    char          *key;
+    GSubprocess   *sp;
+    GInputStream  *out;
+    UmiBlame      *blame;
+    GString       *raw;         /* git's output, for the disk cache           */
+    UmiBlameCb     cb;
+    gpointer       user;
+} BlameReq;
+
+/*===========================================================================
+ * Results and the incremental parser
+ *=========================================================================*/
+
+static UmiBlame *
+blame_new(void)
+{
+    UmiBlame *b = g_new0(UmiBlame, 1);
+    b->ref     = 1;
+    b->strings = g_string_chunk_new(4096);
+    b->commits = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free);
+    b->chunks  = g_array_new(FALSE, FALSE, sizeof(UmiBlameChunk));
+    b->by_line = g_array_new(FALSE, TRUE, sizeof(guint));
+    b->partial = g_string_new(NULL);
+    return b;
+}
+
+UmiBlame *
+umi_blame_ref(UmiBlame *b)
+{
+    if (b) g_atomic_int_inc(&b->ref);
+    return b;
+}
+
+void
+umi_blame_unref(UmiBlame *b)
+{
+    if (!b || !g_atomic_int_dec_and_test(&b->ref)) return;
+    g_hash_table_destroy(b->commits);
+    g_string_chunk_free(b->strings);
+    g_array_free(b->chunks, TRUE);
+    g_array_free(b->by_line, TRUE);
+    g_string_free(b->partial, TRUE);
+    g_free(b);
+}
+
+static gboolean
+is_hex_id(const char *s, gsize n)
+{
+    if (n != 40 && n != 64) return FALSE;
+    for (gsize i = 0; i < n; ++i)
+        if (!g_ascii_isxdigit(s[i])) return FALSE;
+    return TRUE;
+}
+
+/* "<id> <orig> <final> <count>" starts a group. */
+static gboolean
+parse_header(UmiBlame *b, const char *line)
+{
+    const char *sp = strchr(line, ' ');
+    if (!sp || !is_hex_id(line, (gsize)(sp - line))) return FALSE;
+    char *end;
+    const guint64 orig  = g_ascii_strtoull(sp + 1, &end, 10);
+    if (*end != ' ') return FALSE;
+    const guint64 final = g_ascii_strtoull(end + 1, &end, 10);
+    if (*end != ' ') return FALSE;
+    const guint64 count = g_ascii_strtoull(end + 1, &end, 10);
+    if (*end || !orig || !final || !count || final + count > G_MAXUINT) return FALSE;
+
+    char *id = g_strndup(line, (gsize)(sp - line));
+    UmiBlameCommit *c = g_hash_table_lookup(b->commits, id);
+    if (!c) {
+        c = g_new0(UmiBlameCommit, 1);
+        c->id = g_string_chunk_insert_const(b->strings, id);
+        g_hash_table_insert(b->commits, (gpointer)c->id, c);
+    }
+    g_free(id);
+    b->cur      = c;
+    b->in_group = TRUE;
+    b->pending  = (UmiBlameChunk){ (guint)final - 1, (guint)count, (guint)orig - 1, c };
+    return TRUE;
+}
+
+static void
+parse_line(UmiBlame *b, const char *line)
+{
+    if (!b->in_group) {
+        parse_header(b, line);                          /* anything else: noise */
+        return;
+    }
+    const char *sp  = strchr(line, ' ');
+    const gsize klen = sp ? (gsize)(sp - line) : strlen(line);
+    const char *val = sp ? sp + 1 : "";
+    UmiBlameCommit *c = b->cur;
+#define KEY(k) (klen == sizeof(k) - 1 && !strncmp(line, k, klen))
+    if      (KEY("author"))      c->author      = g_string_chunk_insert_const(b->strings, val);
+    else if (KEY("author-mail")) c->author_mail = g_string_chunk_insert_const(b->strings, val);
+    else if (KEY("author-time")) c->author_time = g_ascii_strtoll(val, NULL, 10);
+    else if (KEY("author-tz"))   c->author_tz   = g_string_chunk_insert_const(b->strings, val);
+    else if (KEY("summary"))     c->summary     = g_string_chunk_insert_const(b->strings, val);
+    else if (KEY("boundary"))    c->boundary    = TRUE;
+    else if (KEY("filename")) {                         /* always ends a group */
+        if (!c->filename) c->filename = g_string_chunk_insert_const(b->strings, val);
+        const UmiBlameChunk *ch = &b->pending;
+        g_array_append_val(b->chunks, *ch);
+        const guint idx = b->chunks->len;               /* index + 1 */
+        if (b->by_line->len < ch->line + ch->n_lines) g_array_set_size(b->by_line, ch->line + ch->n_lines);
+        for (guint i = 0; i < ch->n_lines; ++i) g_array_index(b->by_line, guint, ch->line + i) = idx;
+        b->in_group = FALSE;
+        b->cur      = NULL;
+    }
+#undef KEY
+}
+
+/* Feed raw output; complete lines are parsed, the rest is kept. */
+static void
+blame_feed(UmiBlame *b, const char *data, gsize len)
+{
+    const char *p = data, *end = data + len;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (gsize)(end - p));
+        if (!nl) {
+            g_string_append_len(b->partial, p, end - p);
+            break;
+        }
+        if (b->partial->len) {
+            g_string_append_len(b->partial, p, nl - p);
+            parse_line(b, b->partial->str);
+            g_string_truncate(b->partial, 0);
+        } else {
+            char *line = g_strndup(p, (gsize)(nl - p));
+            parse_line(b, line);
+            g_free(line);
+        }
+        p = nl + 1;
+    }
+}
+
+gboolean
+umi_blame_is_complete(const UmiBlame *b)
+{
+    return b && b->complete;
+}
+
+guint
+umi_blame_n_chunks(const UmiBlame *b)
+{
+    return b ? b->chunks->len : 0;
+}
+
+const UmiBlameChunk *
+umi_blame_chunk(const UmiBlame *b, guint i)
+{
+    if (!b || i >= b->chunks->len) return NULL;
+    return &g_array_index(b->chunks, UmiBlameChunk, i);
+}
+
+const UmiBlameChunk *
+umi_blame_line(const UmiBlame *b, guint line)
+{
+    if (!b || line >= b->by_line->len) return NULL;
+    const guint idx = g_array_index(b->by_line, guint, line);
+    return idx ? &g_array_index(b->chunks, UmiBlameChunk, idx - 1) : NULL;
+}
+
+/*===========================================================================
+ * Cache
+ *=========================================================================*/
+
+static UmiBlame *
+mem_get(UmiBlameCache *c, const char *key)
+{
+    gpointer k, v;
+    if (!g_hash_table_lookup_extended(c->mem, key, &k, &v)) return NULL;
+    GList *l = g_queue_find(&c->lru, k);                /* move to the front */
+    g_queue_unlink(&c->lru, l);
+    g_queue_push_head_link(&c->lru, l);
+    return v;
+}
+
+static void
+mem_put(UmiBlameCache *c, const char *key, UmiBlame *b)
+{
+    if (!c->max_mem || g_hash_table_contains(c->mem, key)) return;
+    char *k = g_strdup(key);
+    g_hash_table_insert(c->mem, k, umi_blame_ref(b));
+    g_queue_push_head(&c->lru, k);
+    while (c->lru.length > c->max_mem) g_hash_table_remove(c->mem, g_queue_pop_tail(&c->lru));
+}
+
+static char *
+disk_path(const UmiBlameCache *c, const char *key)
+{
+    return g_build_filename(c->dir, key, NULL);
+}
+
+UmiBlameCache *
+umi_blame_cache_new(const char *dir, guint max_mem)
+{
+    UmiBlameCache *c = g_new0(UmiBlameCache, 1);
+    c->dir     = dir ? g_strdup(dir)
+                     : g_build_filename(g_get_user_cache_dir(), "umicom-studio-ide", "blame", NULL);
+    c->max_mem = max_mem;
+    c->mem     = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)umi_blame_unref);
+    c->reqs    = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_queue_init(&c->lru);
+    return c;
+}
+
+void
+umi_blame_cache_free(UmiBlameCache *c)
+{
+    if (!c) return;
+    GHashTableIter it;
+    gpointer key;
+    g_hash_table_iter_init(&it, c->reqs);
+    while (g_hash_table_iter_next(&it, &key, NULL)) {
+        BlameReq *r = key;
+        r->cache = NULL;                                /* pending callbacks clean up alone */
+        g_cancellable_cancel(r->cancel);
+    }
+    g_hash_table_destroy(c->reqs);
+    g_queue_clear(&c->lru);
+    g_hash_table_destroy(c->mem);
+    g_free(c->dir);
+    g_free(c);
+}
+
+/*===========================================================================
+ * Requests
+ *=========================================================================*/
+
+static void
+on_user_cancel(GCancellable *user_cancel, gpointer data)
+{
+    (void)user_cancel;
+    g_cancellable_cancel(G_CANCELLABLE(data));
+}
+
+static void
+req_free(BlameReq *r)
+{
+    if (r->cache) g_hash_table_remove(r->cache->reqs, r);
+    if (r->sp) g_subprocess_force_exit(r->sp);         /* no-op once git exited */
+    if (r->user_cancel) {
+        g_cancellable_disconnect(r->user_cancel, r->user_handler);
+        g_object_unref(r->user_cancel);
+    }
+    g_clear_object(&r->out);
+    g_clear_object(&r->sp);
+    g_object_unref(r->cancel);
+    if (r->blame) umi_blame_unref(r->blame);
+    if (r->raw) g_string_free(r->raw, TRUE);
+    g_free(r->dir);
+    g_free(r->name);
+    g_free(r->path_key);
+    g_free(r->key);
+    g_free(r);
+}
+
+/* Deliver the end of a request and free it. */
+static void
+req_finish(BlameReq *r)
+{
+    if (!r->blame) r->blame = blame_new();             /* nothing to blame */
+    r->cb(r->blame, 0, r->blame->chunks->len, TRUE, r->user);
+    req_free(r);
+}
+
+/* Same, from an idle: umi_blame_cache_get() never calls back before it
+ * returns. */
+static gboolean
+finish_idle(gpointer data)
+{
+    BlameReq *r = data;
+    if (g_cancellable_is_cancelled(r->cancel)) req_free(r);
+    else req_finish(r);
+    return G_SOURCE_REMOVE;
+}
+
+static GSubprocess *
+spawn_git(const char *dir, const char * const *argv, GError **err)
+{
+    GSubprocessLauncher *launcher = g_subprocess_launcher_new(
+        G_SUBPROCESS_FLAGS_STDOUT_PIPE | G_SUBPROCESS_FLAGS_STDERR_SILENCE);
+    g_subprocess_launcher_set_cwd(launcher, dir);
+    GSubprocess *sp = g_subprocess_launcher_spawnv(launcher, argv, err);
+    g_object_unref(launcher);
+    return sp;
+}
+
+static void
+on_cache_written(GObject *src, GAsyncResult *res, gpointer data)
+{
+    (void)data;
+    g_file_replace_contents_finish(G_FILE(src), res, NULL, NULL);   /* best effort */
+}
+
+static void
+write_disk(BlameReq *r)
+{
+    if (g_mkdir_with_parents(r->cache->dir, 0700) != 0) return;
+    char *path = disk_path(r->cache, r->key);
+    GFile *f = g_file_new_for_path(path);
+    g_string_prepend(r->raw, UMI_BLAME_CACHE_MAGIC);
+    GBytes *bytes = g_string_free_to_bytes(r->raw);
+    r->raw = NULL;
+    g_file_replace_contents_bytes_async(f, bytes, NULL, FALSE, G_FILE_CREATE_PRIVATE, NULL,
+                                        on_cache_written, NULL);
+    g_bytes_unref(bytes);
+    g_object_unref(f);
+    g_free(path);
+}
+
+static void
+on_blame_exit(GObject *src, GAsyncResult *res, gpointer data)
+{
+    BlameReq *r = data;
+    const gboolean ok = g_subprocess_wait_finish(G_SUBPROCESS(src), res, NULL)
+                        && g_subprocess_get_successful(G_SUBPROCESS(src));
+    if (g_cancellable_is_cancelled(r->cancel)) { req_free(r); return; }
+    if (ok) {
+        r->blame->complete = TRUE;
+        mem_put(r->cache, r->key, r->blame);
+        write_disk(r);
+    }
+    req_finish(r);
+}
+
+static void
+on_blame_read(GObject *src, GAsyncResult *res, gpointer data)
+{
+    BlameReq *r = data;
+    GBytes *bytes = g_input_stream_read_bytes_finish(G_INPUT_STREAM(src), res, NULL);
+    if (g_cancellable_is_cancelled(r->cancel)) {
+        if (bytes) g_bytes_unref(bytes);
+        req_free(r);
+        return;
+    }
+    gsize len = 0;
+    const char *data_p = bytes ? g_bytes_get_data(bytes, &len) : NULL;
+    if (!len) {                                         /* EOF or read error */
+        if (bytes) g_bytes_unref(bytes);
+        g_subprocess_wait_async(r->sp, r->cancel, on_blame_exit, r);
+        return;
+    }
+    const guint before = r->blame->chunks->len;
+    blame_feed(r->blame, data_p, len);
+    g_string_append_len(r->raw, data_p, (gssize)len);
+    g_bytes_unref(bytes);
+    if (r->blame->chunks->len > before)
+        r->cb(r->blame, before, r->blame->chunks->len - before, FALSE, r->user);
+    g_input_stream_read_bytes_async(r->out, UMI_BLAME_READ_SIZE, G_PRIORITY_DEFAULT, r->cancel,
+                                    on_blame_read, r);
+}
+
+static void
+run_blame(BlameReq *r)
+{
+    const char *argv[] = { "git", "blame", "--incremental", "--porcelain", "HEAD", "--", r->name, NULL };
+    r->sp = spawn_git(r->dir, argv, NULL);
+    if (!r->sp) { req_finish(r); return; }
+    r->out   = g_object_ref(g_subprocess_get_stdout_pipe(r->sp));
+    r->blame = blame_new();
+    r->raw   = g_string_new(NULL);
+    g_input_stream_read_bytes_async(r->out, UMI_BLAME_READ_SIZE, G_PRIORITY_DEFAULT, r->cancel,
+                                    on_blame_read, r);
+}
+
+/* Cached output replayed through the parser; NULL if absent or stale format. */
+static UmiBlame *
+blame_from_disk(const char *data, gsize len)
+{
+    const gsize ml = strlen(UMI_BLAME_CACHE_MAGIC);
+    if (len < ml || memcmp(data, UMI_BLAME_CACHE_MAGIC, ml) != 0) return NULL;
+    UmiBlame *b = blame_new();
+    blame_feed(b, data + ml, len - ml);
+    b->complete = TRUE;
+    return b;
+}
+
+static void
+on_disk_loaded(GObject *src, GAsyncResult *res, gpointer data)
+{
+    BlameReq *r = data;
+    char *contents = NULL;
+    gsize len = 0;
+    const gboolean ok = g_file_load_contents_finish(G_FILE(src), res, &contents, &len, NULL, NULL);
+    if (g_cancellable_is_cancelled(r->cancel)) {
+        g_free(contents);
+        req_free(r);
+        return;
+    }
+    UmiBlame *b = ok ? blame_from_disk(contents, len) : NULL;
+    g_free(contents);
+    if (!b) { run_blame(r); return; }
+    mem_put(r->cache, r->key, b);
+    r->blame = b;
+    req_finish(r);
+}
+
+static void
+on_blob_id(GObject *src, GAsyncResult *res, gpointer data)
+{
+    BlameReq *r = data;
+    GBytes *out = NULL;
+    const gboolean ok = g_subprocess_communicate_finish(G_SUBPROCESS(src), res, &out, NULL, NULL)
+                        && g_subprocess_get_successful(G_SUBPROCESS(src));
+    g_clear_object(&r->sp);
+    if (g_cancellable_is_cancelled(r->cancel)) {
+        if (out) g_bytes_unref(out);
+        req_free(r);
+        return;
+    }
+    gsize len = 0;
+    const char *id = (ok && out) ? g_bytes_get_data(out, &len) : NULL;
+    while (id && len && g_ascii_isspace(id[len - 1])) --len;
+    if (!id || !is_hex_id(id, len)) {                   /* not in HEAD */
+        if (out) g_bytes_unref(out);
+        req_finish(r);
+        return;
+    }
+    r->key = g_strdup_printf("%.*s-%s", (int)len, id, r->path_key);
+    g_bytes_unref(out);
+
+    UmiBlame *hit = mem_get(r->cache, r->key);
+    if (hit) {
+        r->blame = umi_blame_ref(hit);
+        req_finish(r);
+        return;
+    }
+    char *path = disk_path(r->cache, r->key);
+    GFile *f = g_file_new_for_path(path);
+    g_file_load_contents_async(f, r->cancel, on_disk_loaded, r);
+    g_object_unref(f);
+    g_free(path);
+}
+
+void
+umi_blame_cache_get(UmiBlameCache *c, const char *path, GCancellable *cancel,
+                    UmiBlameCb cb, gpointer user)
+{
+    g_return_if_fail(c && path && cb);
+    BlameReq *r = g_new0(BlameReq, 1);
+    r->cache  = c;
+    r->cancel = g_cancellable_new();
+    r->cb     = cb;
+    r->user   = user;
+    if (cancel) {
+        r->user_cancel  = g_object_ref(cancel);
+        r->user_handler = g_cancellable_connect(cancel, G_CALLBACK(on_user_cancel),
+                                                g_object_ref(r->cancel), g_object_unref);
+    }
+    g_hash_table_add(c->reqs, r);
+
+    char *canon = g_canonicalize_filename(path, NULL);
+    r->dir      = g_path_get_dirname(canon);
+    r->name     = g_path_get_basename(canon);
+    r->path_key = g_compute_checksum_for_string(G_CHECKSUM_SHA1, canon, -1);
+    r->path_key[16] = '\0';
+    g_free(canon);
+
+    if (g_cancellable_is_cancelled(r->cancel)) { req_free(r); return; }
+    if (!umi_git_find_repo(r->dir, NULL, NULL)) { g_idle_add(finish_idle, r); return; }
+
+    /* "HEAD:./name" resolves against the working directory. */
+    char *spec = g_strconcat("HEAD:./", r->name, NULL);
+    const char *argv[] = { "git", "rev-parse", "--verify", "--quiet", spec, NULL };
+    r->sp = spawn_git(r->dir, argv, NULL);
+    g_free(spec);
+    if (!r->sp) { g_idle_add(finish_idle, r); return; }
+    g_subprocess_communicate_async(r->sp, NULL, r->cancel, on_blob_id, r);
+}
@@ -0,0 +1,778 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/util/git/git_status.c
+ *
+ * PURPOSE:
+ *   Work tree status engine (see git_status.h).
+ *
+ * DESIGN:
+ *   - State lives on the main thread: the loaded UmiGitIndex, a table of
+ *     every non-clean path (work tree relative, '/'-separated as in the
+ *     index) and per-directory counters of the statuses below each dir.
+ *   - Work is done by jobs on a one-thread pool. A full job re-reads the
+ *     index and checks all entries with umi_parallel_for(); a partial job
+ *     checks the queued paths against the current index. Results come back
+ *     through g_idle_add() and are applied in one go, then listeners run.
+ *     Only one job is in flight; paths queued meanwhile wait for the next.
+ *   - A queued path that turns out to be a directory (created, deleted or
+ *     renamed as a whole) escalates to a full check, which is simpler than
+ *     working out every path below it and just as fast on a warm cache.
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include "include/git_status.h"
+#include "include/git_index.h"
+#include "parallel_for.h"
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define UMI_GIT_STATUS_DEBOUNCE_MS 200
+
+typedef struct {
+    guint                 id;
+    UmiGitStatusChangedCb cb;
+    gpointer              user;
+} Listener;
+
+struct _UmiGitStatusEngine {
+    char         *worktree;     /* canonical work tree root                  */
+    char         *gitdir;
+    UmiFileIndex *files;        /* borrowed, optional (untracked files)      */
+    UmiGitIndex  *gi;           /* index of the last full check              */
+    gint64        index_mtime_s, index_mtime_ns;   /* racy-git reference      */
+    GHashTable   *status;       /* rel path -> UmiGitFileStatus, non-clean   */
+    GHashTable   *dirs;         /* rel dir ("" = root) -> guint[N_STATUS]    */
+    guint         counts[UMI_GIT_N_STATUS];
+    char         *branch;
+    guint64       generation;
+
+    GHashTable   *queued;       /* rel paths waiting for a re-check          */
+    gboolean      full_queued;
+    guint         debounce_id;
+    gboolean      busy;         /* a job is in flight                        */
+    GThreadPool  *pool;
+    GCancellable *cancel;
+    GFileMonitor *git_mon;      /* the git dir: index / HEAD rewrites        */
+
+    GArray       *listeners;    /* Listener                                  */
+    guint         next_listener;
+};
+
+/* One unit of background work. Inputs are copies or stay untouched on the
+ * main thread while the job runs (only one job is ever in flight). */
+typedef struct {
+    UmiGitStatusEngine *s;
+    GCancellable       *cancel;
+    gboolean            full;
+    char               *worktree, *gitdir;
+    UmiGitIndex        *gi;          /* full: read here; partial: s->gi       */
+    gint64              index_mtime_s, index_mtime_ns;
+    gboolean            filemode;
+    GPtrArray          *paths;       /* partial: rel paths to check           */
+    /* Results. */
+    GHashTable         *result;      /* rel -> status + 1 (see apply_job)     */
+    gboolean            escalate;    /* a partial job met a directory         */
+    char               *branch;
+} StatusJob;
+
+/* Worst-first order for directories. */
+static const guint status_rank[UMI_GIT_N_STATUS] = {
+    [UMI_GIT_CLEAN] = 0, [UMI_GIT_UNTRACKED] = 1, [UMI_GIT_ADDED] = 2,
+    [UMI_GIT_DELETED] = 3, [UMI_GIT_MODIFIED] = 4, [UMI_GIT_CONFLICTED] = 5,
+};
+
+static void schedule(UmiGitStatusEngine *s);
+
+/*===========================================================================
+ * Checking one entry (worker threads)
+ *=========================================================================*/
+
+static char *
+abs_path(const char *worktree, const char *rel)
+{
+    char *p = g_build_filename(worktree, rel, NULL);
+    if (G_DIR_SEPARATOR != '/') g_strdelimit(p, "/", G_DIR_SEPARATOR);
+    return p;
+}
+
+typedef struct {
+    gboolean exists, is_reg, is_link, is_exec;
+    gint64   size;
+    gint64   mtime_s, mtime_ns, ctime_s, ctime_ns;
+    guint64  ino;
+} WtStat;
+
+static gboolean
+wt_lstat(const char *path, WtStat *w)
+{
+    memset(w, 0, sizeof *w);
+#ifdef G_OS_UNIX
+    struct stat st;
+    if (lstat(path, &st) != 0) return FALSE;
+    w->is_link  = S_ISLNK(st.st_mode);
+    w->is_exec  = (st.st_mode & S_IXUSR) != 0;
+    w->mtime_ns = st.st_mtim.tv_nsec;
+    w->ctime_ns = st.st_ctim.tv_nsec;
+#else
+    GStatBuf st;
+    if (g_lstat(path, &st) != 0) return FALSE;
+#endif
+    w->exists  = TRUE;
+    w->is_reg  = (st.st_mode & S_IFMT) == S_IFREG;
+    w->size    = (gint64)st.st_size;
+    w->mtime_s = (gint64)st.st_mtime;
+    w->ctime_s = (gint64)st.st_ctime;
+    w->ino     = (guint64)st.st_ino;
+    return TRUE;
+}
+
+/* Blob id of a work tree file: hash("blob <size>\0" + content), or of the
+ * link target for a symlink. */
+static gboolean
+blob_oid(const char *path, gboolean is_link, guint oid_len, guint8 *out)
+{
+    GChecksum *ck = g_checksum_new(oid_len == 32 ? G_CHECKSUM_SHA256 : G_CHECKSUM_SHA1);
+    gboolean ok = FALSE;
+    if (is_link) {
+        char *target = g_file_read_link(path, NULL);
+        if (target) {
+            char hdr[32];
+            const int hl = g_snprintf(hdr, sizeof hdr, "blob %zu", strlen(target));
+            g_checksum_update(ck, (const guchar *)hdr, hl + 1);     /* with NUL */
+            g_checksum_update(ck, (const guchar *)target, (gssize)strlen(target));
+            g_free(target);
+            ok = TRUE;
+        }
+    } else {
+        GMappedFile *mf = g_mapped_file_new(path, FALSE, NULL);
+        if (mf) {
+            const gsize len = g_mapped_file_get_length(mf);
+            char hdr[48];
+            const int hl = g_snprintf(hdr, sizeof hdr, "blob %" G_GSIZE_FORMAT, len);
+            g_checksum_update(ck, (const guchar *)hdr, hl + 1);
+            if (len) g_checksum_update(ck, (const guchar *)g_mapped_file_get_contents(mf), (gssize)len);
+            g_mapped_file_unref(mf);
+            ok = TRUE;
+        }
+    }
+    if (ok) {
+        gsize n = oid_len;
+        g_checksum_get_digest(ck, out, &n);
+        ok = (n == oid_len);
+    }
+    g_checksum_free(ck);
+    return ok;
+}
+
+/* Compare one stage-0 entry with the work tree (git's ie_match_stat() plus
+ * the content check git status does for entries whose stat data moved). */
+static UmiGitFileStatus
+check_entry(const StatusJob *j, const UmiGitIndexEntry *e)
+{
+    if (e->stage) return UMI_GIT_CONFLICTED;
+    if (e->flags & (UMI_GIT_ENTRY_ASSUME_VALID | UMI_GIT_ENTRY_SKIP_WORKTREE)) return UMI_GIT_CLEAN;
+    if (e->mode == UMI_GIT_MODE_GITLINK || e->mode == UMI_GIT_MODE_DIR) return UMI_GIT_CLEAN;
+
+    char *path = abs_path(j->worktree, e->path);
+    WtStat w;
+    UmiGitFileStatus st = UMI_GIT_CLEAN;
+    if (!wt_lstat(path, &w)) {
+        st = UMI_GIT_DELETED;
+    } else if (e->flags & UMI_GIT_ENTRY_INTENT_TO_ADD) {
+        st = UMI_GIT_ADDED;
+    } else if ((e->mode == UMI_GIT_MODE_SYMLINK) != w.is_link || (!w.is_link && !w.is_reg)) {
+        st = UMI_GIT_MODIFIED;                          /* type changed      */
+    } else if (j->filemode && w.is_reg && (e->mode == UMI_GIT_MODE_EXEC) != w.is_exec) {
+        st = UMI_GIT_MODIFIED;
+    } else if (e->size != (guint32)w.size && e->size != 0) {
+        st = UMI_GIT_MODIFIED;  /* size 0 may be a racily-clean entry git smudged */
+    } else {
+        /* Nanoseconds are only compared when git recorded them. */
+        const gboolean same =
+            e->size == (guint32)w.size &&
+            e->mtime_s == (guint32)w.mtime_s && (!e->mtime_ns || e->mtime_ns == (guint32)w.mtime_ns) &&
+            e->ctime_s == (guint32)w.ctime_s && (!e->ctime_ns || e->ctime_ns == (guint32)w.ctime_ns) &&
+            (!e->ino || e->ino == (guint32)w.ino);
+        /* Written in the same tick as the index: a later edit within that
+         * tick would leave identical stat data, so the content decides. */
+        const gboolean racy =
+            (gint64)e->mtime_s > j->index_mtime_s ||
+            ((gint64)e->mtime_s == j->index_mtime_s && (gint64)e->mtime_ns >= j->index_mtime_ns);
+        if (!same || racy) {
+            guint8 oid[UMI_GIT_OID_MAX];
+            const guint oid_len = umi_git_index_oid_len(j->gi);
+            if (!blob_oid(path, w.is_link, oid_len, oid) || memcmp(oid, e->oid, oid_len) != 0)
+                st = UMI_GIT_MODIFIED;
+        }
+    }
+    g_free(path);
+    return st;
+}
+
+typedef struct {
+    const StatusJob *job;
+    guint8          *out;           /* UmiGitFileStatus per entry            */
+} CheckRange;
+
+static void
+check_range(guint begin, guint end, guint worker, gpointer user)
+{
+    (void)worker;
+    CheckRange *cr = user;
+    for (guint i = begin; i < end; ++i) {
+        if (g_cancellable_is_cancelled(cr->job->cancel)) return;
+        cr->out[i] = (guint8)check_entry(cr->job, umi_git_index_entry(cr->job->gi, i));
+    }
+}
+
+/* "main" for "ref: refs/heads/main", the abbreviated id when detached. */
+static char *
+read_branch(const char *gitdir)
+{
+    char *head = g_build_filename(gitdir, "HEAD", NULL);
+    char *text = NULL;
+    char *branch = NULL;
+    if (g_file_get_contents(head, &text, NULL, NULL)) {
+        g_strstrip(text);
+        if (g_str_has_prefix(text, "ref:")) {
+            const char *ref = text + 4;
+            while (*ref == ' ') ++ref;
+            branch = g_strdup(g_str_has_prefix(ref, "refs/heads/") ? ref + 11 : ref);
+        } else if (*text) {
+            branch = g_strndup(text, 7);
+        }
+    }
+    g_free(text);
+    g_free(head);
+    return branch;
+}
+
+static void
+index_mtime(const char *gitdir, gint64 *s_out, gint64 *ns_out)
+{
+    char *path = g_build_filename(gitdir, "index", NULL);
+    WtStat w;
+    *s_out = *ns_out = 0;
+    if (wt_lstat(path, &w)) { *s_out = w.mtime_s; *ns_out = w.mtime_ns; }
+    g_free(path);
+}
+
+/* True when the index has entries strictly below directory 'rel'. */
+static gboolean
+has_entries_below(const UmiGitIndex *gi, const char *rel)
+{
+    const gsize rl = strlen(rel);
+    const guint n = umi_git_index_count(gi);
+    guint lo = 0, hi = n;
+    while (lo < hi) {                                   /* first > rel        */
+        const guint mid = lo + (hi - lo) / 2;
+        if (strcmp(umi_git_index_entry(gi, mid)->path, rel) <= 0) lo = mid + 1;
+        else hi = mid;
+    }
+    /* "rel/..." sorts after "rel" but may follow "rel-x", "rel.c", ... */
+    for (guint i = lo; i < n; ++i) {
+        const char *p = umi_git_index_entry(gi, i)->path;
+        const int c = strncmp(p, rel, rl);
+        if (c != 0) return FALSE;
+        if (p[rl] == '/') return TRUE;
+        if ((guchar)p[rl] > '/') return FALSE;
+    }
+    return FALSE;
+}
+
+static void
+run_job(StatusJob *j)
+{
+    j->result = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    j->branch = read_branch(j->gitdir);
+
+    if (j->full) {
+        j->filemode = umi_git_config_bool(j->gitdir, "core", "filemode", TRUE);
+        index_mtime(j->gitdir, &j->index_mtime_s, &j->index_mtime_ns);
+        j->gi = umi_git_index_read(j->gitdir, NULL);
+        if (!j->gi) return;
+        const guint n = umi_git_index_count(j->gi);
+        CheckRange cr = { j, g_new0(guint8, MAX(n, 1)) };
+        umi_parallel_for(n, 64, check_range, &cr);
+        for (guint i = 0; i < n; ++i) {
+            const char *p = umi_git_index_entry(j->gi, i)->path;
+            if (cr.out[i] != UMI_GIT_CLEAN && !g_hash_table_contains(j->result, p))
+                g_hash_table_insert(j->result, g_strdup(p), GUINT_TO_POINTER(cr.out[i] + 1));
+        }
+        g_free(cr.out);
+        return;
+    }
+
+    for (guint k = 0; k < j->paths->len && !j->escalate; ++k) {
+        const char *rel = g_ptr_array_index(j->paths, k);
+        const gint pos = j->gi ? umi_git_index_find(j->gi, rel) : -1;
+        UmiGitFileStatus st;
+        if (pos >= 0) {
+            st = check_entry(j, umi_git_index_entry(j->gi, (guint)pos));
+        } else {
+            char *path = abs_path(j->worktree, rel);
+            const gboolean is_dir = g_file_test(path, G_FILE_TEST_IS_DIR) &&
+                                    !g_file_test(path, G_FILE_TEST_IS_SYMLINK);
+            g_free(path);
+            if (is_dir || (j->gi && has_entries_below(j->gi, rel))) { j->escalate = TRUE; break; }
+            st = UMI_GIT_UNTRACKED;                     /* if the file index has it */
+        }
+        g_hash_table_insert(j->result, g_strdup(rel), GUINT_TO_POINTER(st + 1));
+    }
+}
+
+/*===========================================================================
+ * Main thread state
+ *=========================================================================*/
+
+/* Work tree relative, '/'-separated form of 'path'; NULL when it lies
+ * outside the work tree or inside the git dir. */
+static char *
+rel_of(const UmiGitStatusEngine *s, const char *path)
+{
+    if (!path || !*path) return NULL;
+    char *canon = g_canonicalize_filename(path, NULL);
+    const gsize gl = strlen(s->gitdir);
+    if (strncmp(canon, s->gitdir, gl) == 0 && (canon[gl] == '\0' || canon[gl] == G_DIR_SEPARATOR)) {
+        g_free(canon);
+        return NULL;
+    }
+    const gsize wl = strlen(s->worktree);
+    char *rel = NULL;
+    if (strncmp(canon, s->worktree, wl) == 0 && (canon[wl] == '\0' || canon[wl] == G_DIR_SEPARATOR)) {
+        rel = g_strdup(canon[wl] ? canon + wl + 1 : "");
+        if (G_DIR_SEPARATOR != '/') g_strdelimit(rel, G_DIR_SEPARATOR_S, '/');
+    }
+    g_free(canon);
+    return rel;
+}
+
+/* Move 'rel' to status 'st', keeping the totals and the per-directory
+ * counters of every ancestor in step. TRUE if anything changed. */
+static gboolean
+set_status(UmiGitStatusEngine *s, const char *rel, UmiGitFileStatus st)
+{
+    const UmiGitFileStatus old = (UmiGitFileStatus)GPOINTER_TO_UINT(g_hash_table_lookup(s->status, rel));
+    if (old == st) return FALSE;
+    if (st == UMI_GIT_CLEAN) g_hash_table_remove(s->status, rel);
+    else g_hash_table_replace(s->status, g_strdup(rel), GUINT_TO_POINTER(st));
+    if (old != UMI_GIT_CLEAN) s->counts[old]--;
+    if (st  != UMI_GIT_CLEAN) s->counts[st]++;
+
+    char *dir = g_strdup(rel);
+    for (;;) {
+        char *slash = strrchr(dir, '/');
+        if (slash) *slash = '\0'; else dir[0] = '\0';
+        guint *c = g_hash_table_lookup(s->dirs, dir);
+        if (!c) {
+            c = g_new0(guint, UMI_GIT_N_STATUS);
+            g_hash_table_insert(s->dirs, g_strdup(dir), c);
+        }
+        if (old != UMI_GIT_CLEAN) c[old]--;
+        if (st  != UMI_GIT_CLEAN) c[st]++;
+        gboolean empty = TRUE;
+        for (guint i = 1; i < UMI_GIT_N_STATUS && empty; ++i) empty = (c[i] == 0);
+        if (empty) g_hash_table_remove(s->dirs, dir);
+        if (!dir[0]) break;
+    }
+    g_free(dir);
+    return TRUE;
+}
+
+static void
+emit_changed(UmiGitStatusEngine *s)
+{
+    s->generation++;
+    /* Copy: a listener may add or remove listeners. */
+    GArray *ls = g_array_copy(s->listeners);
+    for (guint i = 0; i < ls->len; ++i) {
+        const Listener *l = &g_array_index(ls, Listener, i);
+        l->cb(s, l->user);
+    }
+    g_array_free(ls, TRUE);
+}
+
+/* Untracked files come from the file index: everything it lists that the
+ * git index does not track. */
+static gboolean
+collect_untracked(UmiGitStatusEngine *s)
+{
+    if (!s->files || !s->gi) return FALSE;
+    gboolean changed = FALSE;
+    UmiIndexIter it;
+    umi_index_iter_init(&it, s->files);
+    while (umi_index_iter_next(&it)) {
+        char *rel = rel_of(s, umi_index_iter_path(&it));
+        if (rel && umi_git_index_find(s->gi, rel) < 0) changed |= set_status(s, rel, UMI_GIT_UNTRACKED);
+        g_free(rel);
+    }
+    umi_index_iter_clear(&it);
+    return changed;
+}
+
+static void
+job_free(StatusJob *j)
+{
+    if (j->full && j->gi) umi_git_index_free(j->gi);
+    if (j->paths) g_ptr_array_free(j->paths, TRUE);
+    if (j->result) g_hash_table_destroy(j->result);
+    g_clear_object(&j->cancel);
+    g_free(j->worktree);
+    g_free(j->gitdir);
+    g_free(j->branch);
+    g_free(j);
+}
+
+static void
+apply_job(UmiGitStatusEngine *s, StatusJob *j)
+{
+    gboolean changed = FALSE;
+    if (g_strcmp0(s->branch, j->branch) != 0) {
+        g_free(s->branch);
+        s->branch = g_steal_pointer(&j->branch);
+        changed = TRUE;
+    }
+    if (j->full) {
+        /* Rebuild from scratch, but only report a change if something moved. */
+        GHashTable *old = s->status;
+        s->status = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+        g_hash_table_remove_all(s->dirs);
+        memset(s->counts, 0, sizeof s->counts);
+        if (s->gi) umi_git_index_free(s->gi);
+        s->gi = g_steal_pointer(&j->gi);
+        s->index_mtime_s  = j->index_mtime_s;
+        s->index_mtime_ns = j->index_mtime_ns;
+
+        GHashTableIter it;
+        gpointer key, val;
+        g_hash_table_iter_init(&it, j->result);
+        while (g_hash_table_iter_next(&it, &key, &val))
+            set_status(s, key, (UmiGitFileStatus)(GPOINTER_TO_UINT(val) - 1));
+        collect_untracked(s);
+
+        if (g_hash_table_size(old) != g_hash_table_size(s->status)) {
+            changed = TRUE;
+        } else {
+            g_hash_table_iter_init(&it, old);
+            while (!changed && g_hash_table_iter_next(&it, &key, &val))
+                changed = g_hash_table_lookup(s->status, key) != val;
+        }
+        g_hash_table_destroy(old);
+    } else if (j->escalate) {
+        s->full_queued = TRUE;
+    } else {
+        GHashTableIter it;
+        gpointer key, val;
+        g_hash_table_iter_init(&it, j->result);
+        while (g_hash_table_iter_next(&it, &key, &val)) {
+            UmiGitFileStatus st = (UmiGitFileStatus)(GPOINTER_TO_UINT(val) - 1);
+            if (st == UMI_GIT_UNTRACKED) {
+                /* Untracked only if the file index lists it (not ignored,
+                 * not hidden, still there). */
+                char *path = abs_path(s->worktree, key);
+                if (!s->files || umi_index_lookup(s->files, path) == UMI_INDEX_NO_FILE) st = UMI_GIT_CLEAN;
+                g_free(path);
+            }
+            changed |= set_status(s, key, st);
+        }
+    }
+    if (changed) emit_changed(s);
+}
+
+/*---------------------------------------------------------------------------
+ * Job plumbing
+ *-------------------------------------------------------------------------*/
+
+static StatusJob *
+take_job(UmiGitStatusEngine *s)
+{
+    if (!s->full_queued && g_hash_table_size(s->queued) == 0) return NULL;
+    StatusJob *j = g_new0(StatusJob, 1);
+    j->s        = s;
+    j->cancel   = g_object_ref(s->cancel);
+    j->worktree = g_strdup(s->worktree);
+    j->gitdir   = g_strdup(s->gitdir);
+    j->full     = s->full_queued || !s->gi;
+    if (!j->full) {
+        j->gi             = s->gi;
+        j->index_mtime_s  = s->index_mtime_s;
+        j->index_mtime_ns = s->index_mtime_ns;
+        j->filemode       = umi_git_config_bool(s->gitdir, "core", "filemode", TRUE);
+        j->paths          = g_ptr_array_new_with_free_func(g_free);
+        GHashTableIter it;
+        gpointer key;
+        g_hash_table_iter_init(&it, s->queued);
+        while (g_hash_table_iter_next(&it, &key, NULL)) {
+            g_ptr_array_add(j->paths, key);
+            g_hash_table_iter_steal(&it);
+        }
+    } else {
+        g_hash_table_remove_all(s->queued);             /* covered by a full check */
+    }
+    s->full_queued = FALSE;
+    return j;
+}
+
+static gboolean
+job_done(gpointer data)
+{
+    StatusJob *j = data;
+    if (g_cancellable_is_cancelled(j->cancel)) {        /* engine freed      */
+        job_free(j);
+        return G_SOURCE_REMOVE;
+    }
+    UmiGitStatusEngine *s = j->s;
+    s->busy = FALSE;
+    apply_job(s, j);
+    job_free(j);
+    if (s->full_queued || g_hash_table_size(s->queued)) schedule(s);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+job_worker(gpointer data, gpointer user)
+{
+    (void)user;
+    StatusJob *j = data;
+    if (!g_cancellable_is_cancelled(j->cancel)) run_job(j);
+    g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, job_done, j, NULL);
+}
+
+static gboolean
+on_debounce(gpointer user)
+{
+    UmiGitStatusEngine *s = user;
+    s->debounce_id = 0;
+    if (s->busy) return G_SOURCE_REMOVE;                /* job_done reschedules */
+    StatusJob *j = take_job(s);
+    if (j) {
+        s->busy = TRUE;
+        g_thread_pool_push(s->pool, j, NULL);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static void
+schedule(UmiGitStatusEngine *s)
+{
+    if (!s->debounce_id)
+        s->debounce_id = g_timeout_add(UMI_GIT_STATUS_DEBOUNCE_MS, on_debounce, s);
+}
+
+/* Run whatever is queued inline. */
+static gboolean
+run_inline(UmiGitStatusEngine *s)
+{
+    if (s->busy) return FALSE;
+    StatusJob *j;
+    while ((j = take_job(s))) {                         /* escalation requeues */
+        run_job(j);
+        apply_job(s, j);
+        job_free(j);
+    }
+    return TRUE;
+}
+
+static void
+on_git_dir_changed(GFileMonitor *mon, GFile *file, GFile *other, GFileMonitorEvent evt, gpointer user)
+{
+    (void)mon;
+    (void)evt;
+    UmiGitStatusEngine *s = user;
+    /* git writes "index.lock" / "HEAD.lock" and renames them into place. */
+    GFile *files[2] = { file, other };
+    for (guint i = 0; i < 2; ++i) {
+        if (!files[i]) continue;
+        char *name = g_file_get_basename(files[i]);
+        const gboolean hit = name && (!strcmp(name, "index") || !strcmp(name, "HEAD"));
+        g_free(name);
+        if (hit) {
+            s->full_queued = TRUE;
+            schedule(s);
+            return;
+        }
+    }
+}
+
+/*===========================================================================
+ * Public API
+ *=========================================================================*/
+
+UmiGitStatusEngine *
+umi_git_status_new(const char *path)
+{
+    char *worktree = NULL, *gitdir = NULL;
+    if (!umi_git_find_repo(path, &worktree, &gitdir)) return NULL;
+
+    UmiGitStatusEngine *s = g_new0(UmiGitStatusEngine, 1);
+    s->worktree  = worktree;
+    s->gitdir    = gitdir;
+    s->status    = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    s->dirs      = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    s->queued    = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    s->pool      = g_thread_pool_new(job_worker, NULL, 1, FALSE, NULL);
+    s->cancel    = g_cancellable_new();
+    s->listeners = g_array_new(FALSE, FALSE, sizeof(Listener));
+
+    GFile *dir = g_file_new_for_path(gitdir);
+    s->git_mon = g_file_monitor_directory(dir, G_FILE_MONITOR_WATCH_MOVES, NULL, NULL);
+    g_object_unref(dir);
+    if (s->git_mon) g_signal_connect(s->git_mon, "changed", G_CALLBACK(on_git_dir_changed), s);
+    return s;
+}
+
+void
+umi_git_status_free(UmiGitStatusEngine *s)
+{
+    if (!s) return;
+    g_cancellable_cancel(s->cancel);                    /* pending job_done frees its job */
+    if (s->debounce_id) g_source_remove(s->debounce_id);
+    if (s->git_mon) {
+        g_signal_handlers_disconnect_by_data(s->git_mon, s);
+        g_file_monitor_cancel(s->git_mon);
+        g_object_unref(s->git_mon);
+    }
+    g_thread_pool_free(s->pool, FALSE, TRUE);
+    g_object_unref(s->cancel);
+    if (s->gi) umi_git_index_free(s->gi);
+    g_hash_table_destroy(s->status);
+    g_hash_table_destroy(s->dirs);
+    g_hash_table_destroy(s->queued);
+    g_array_free(s->listeners, TRUE);
+    g_free(s->branch);
+    g_free(s->worktree);
+    g_free(s->gitdir);
+    g_free(s);
+}
+
+const char *
+umi_git_status_worktree(const UmiGitStatusEngine *s)
+{
+    return s ? s->worktree : NULL;
+}
+
+const char *
+umi_git_status_gitdir(const UmiGitStatusEngine *s)
+{
+    return s ? s->gitdir : NULL;
+}
+
+void
+umi_git_status_set_files(UmiGitStatusEngine *s, UmiFileIndex *files)
+{
+    if (!s || s->files == files) return;
+    s->files = files;
+    /* The untracked set is derived from it: recompute on the next check. */
+    s->full_queued = TRUE;
+}
+
+guint
+umi_git_status_add_listener(UmiGitStatusEngine *s, UmiGitStatusChangedCb cb, gpointer user)
+{
+    if (!s || !cb) return 0;
+    Listener l = { ++s->next_listener, cb, user };
+    g_array_append_val(s->listeners, l);
+    return l.id;
+}
+
+void
+umi_git_status_remove_listener(UmiGitStatusEngine *s, guint id)
+{
+    if (!s || !id) return;
+    for (guint i = 0; i < s->listeners->len; ++i) {
+        if (g_array_index(s->listeners, Listener, i).id == id) {
+            g_array_remove_index(s->listeners, i);
+            return;
+        }
+    }
+}
+
+void
+umi_git_status_refresh(UmiGitStatusEngine *s)
+{
+    if (!s) return;
+    s->full_queued = TRUE;
+    schedule(s);
+}
+
+gboolean
+umi_git_status_scan(UmiGitStatusEngine *s)
+{
+    if (!s) return FALSE;
+    s->full_queued = TRUE;
+    return run_inline(s);
+}
+
+void
+umi_git_status_notify(UmiGitStatusEngine *s, const char *path)
+{
+    if (!s) return;
+    char *rel = rel_of(s, path);
+    if (!rel) return;
+    if (!*rel) {
+        s->full_queued = TRUE;                          /* the root itself   */
+        g_free(rel);
+    } else if (g_hash_table_contains(s->dirs, rel)) {
+        s->full_queued = TRUE;                          /* a dir with changes below */
+        g_free(rel);
+    } else {
+        g_hash_table_add(s->queued, rel);
+    }
+    schedule(s);
+}
+
+gboolean
+umi_git_status_flush(UmiGitStatusEngine *s)
+{
+    return s ? run_inline(s) : FALSE;
+}
+
+UmiGitFileStatus
+umi_git_status_get(const UmiGitStatusEngine *s, const char *path)
+{
+    if (!s) return UMI_GIT_CLEAN;
+    char *rel = rel_of(s, path);
+    if (!rel) return UMI_GIT_CLEAN;
+    UmiGitFileStatus st = (UmiGitFileStatus)GPOINTER_TO_UINT(g_hash_table_lookup(s->status, rel));
+    if (st == UMI_GIT_CLEAN) {
+        const guint *c = g_hash_table_lookup(s->dirs, rel);
+        for (guint i = 1; c && i < UMI_GIT_N_STATUS; ++i)
+            if (c[i] && status_rank[i] > status_rank[st]) st = (UmiGitFileStatus)i;
+    }
+    g_free(rel);
+    return st;
+}
+
+guint
+umi_git_status_count(const UmiGitStatusEngine *s, UmiGitFileStatus st)
+{
+    if (!s || st <= UMI_GIT_CLEAN || st >= UMI_GIT_N_STATUS) return 0;
+    return s->counts[st];
+}
+
+const char *
+umi_git_status_branch(const UmiGitStatusEngine *s)
+{
+    return s ? s->branch : NULL;
+}
+
+guint64
+umi_git_status_generation(const UmiGitStatusEngine *s)
+{
+    return s ? s->generation : 0;
+}
+
+char
+umi_git_status_letter(UmiGitFileStatus st)
+{
+    switch (st) {
+    case UMI_GIT_MODIFIED:   return 'M';
+    case UMI_GIT_DELETED:    return 'D';
+    case UMI_GIT_ADDED:      return 'A';
+    case UMI_GIT_UNTRACKED:  return '?';
+    case UMI_GIT_CONFLICTED: return 'U';
+    default:                 return ' ';
+    }
+}
@@ -0,0 +1,89 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/util/git/include/git_blame.h
+ *
+ * PURPOSE:
+ *   Line annotations (commit, author, date) for a file as of HEAD, streamed
+ *   from "git blame --incremental --porcelain" and cached per blob id.
+ *
+ * DESIGN:
+ *   - git blame emits a group per run of lines as soon as it has assigned
+ *     them, in no particular order. Groups are parsed as stdout arrives and
+ *     handed to the caller in batches, so the first annotations show up
+ *     long before blame of a large, old file finishes.
+ *   - A blame result only depends on the file's content in HEAD and the
+ *     history behind it, so it is keyed by the blob id (git rev-parse
+ *     HEAD:<path>, cheap) plus the path. Results are kept in memory (LRU)
+ *     and on disk in the user cache directory: switching back to a file or
+ *     restarting the IDE does not re-run blame.
+ *   - Everything runs on the main loop with async GIO; nothing blocks.
+ *
+ * LIMITS:
+ *   - Lines are numbered as in HEAD. Lines edited in the work tree or the
+ *     editor are not known to blame; map them with the diff gutter.
+ *
+ * THREADING:
+ *   - Main thread only.
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_GIT_BLAME_H
+#define UMICOM_GIT_BLAME_H
+
+#include <glib.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct {
+    const char *id;             /* commit id, hex                            */
+    const char *author;
+    const char *author_mail;    /* "<name@host>"                             */
+    gint64      author_time;    /* seconds since the epoch                   */
+    const char *author_tz;      /* "+0100"                                   */
+    const char *summary;        /* first line of the message                 */
+    const char *filename;       /* path in that commit (follows renames)     */
+    gboolean    boundary;       /* history was cut here (shallow, --since)   */
+} UmiBlameCommit;
+
+/* Lines [line, line + n_lines) of HEAD (0-based) come from 'commit', where
+ * they start at 'orig_line'. */
+typedef struct {
+    guint                 line, n_lines;
+    guint                 orig_line;
+    const UmiBlameCommit *commit;
+} UmiBlameChunk;
+
+typedef struct _UmiBlame      UmiBlame;
+typedef struct _UmiBlameCache UmiBlameCache;
+
+/* New chunks [first, first + n) arrived; 'done' once blame finished (then
+ * umi_blame_is_complete() says whether it succeeded). 'b' is borrowed. */
+typedef void (*UmiBlameCb)(UmiBlame *b, guint first, guint n, gboolean done, gpointer user);
+
+UmiBlame             *umi_blame_ref(UmiBlame *b);
+void                  umi_blame_unref(UmiBlame *b);
+gboolean              umi_blame_is_complete(const UmiBlame *b);
+guint                 umi_blame_n_chunks(const UmiBlame *b);
+const UmiBlameChunk  *umi_blame_chunk(const UmiBlame *b, guint i);
+
+/* Chunk covering HEAD line 'line', or NULL if not known (yet). */
+const UmiBlameChunk  *umi_blame_line(const UmiBlame *b, guint line);
+
+/* Cache of finished results: 'max_mem' kept in memory, all on disk under
+ * 'dir' (NULL: the user cache directory). */
+UmiBlameCache        *umi_blame_cache_new(const char *dir, guint max_mem);
+
+/* Cancels every running request (their callbacks are not called again). */
+void                  umi_blame_cache_free(UmiBlameCache *c);
+
+/* Blame 'path' as of HEAD. Cached results arrive in one callback with
+ * done = TRUE. Cancelling 'cancel' (e.g. when the user leaves the file)
+ * kills git and silences the callback. Files outside git or not in HEAD
+ * get a single done callback with no chunks. */
+void                  umi_blame_cache_get(UmiBlameCache *c, const char *path, GCancellable *cancel,
+                                          UmiBlameCb cb, gpointer user);
+
+G_END_DECLS
+
+#endif /* UMICOM_GIT_BLAME_H */
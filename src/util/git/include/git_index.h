@@ -0,0 +1,90 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/util/git/include/git_index.h
+ *
+ * PURPOSE:
+ *   Native reader for git's index file ($GIT_DIR/index): the list of tracked
+ *   paths with their cached stat data and blob ids, read in one sequential
+ *   pass without spawning git.
+ *
+ * FORMAT:
+ *   - Index versions 2, 3 (extended flags) and 4 (path prefix compression).
+ *   - SHA-1 and SHA-256 repositories (extensions.objectformat).
+ *   - Extensions (cache tree, untracked cache, ...) are skipped; sparse
+ *     directory entries are reported as they are (mode 040000, trailing
+ *     '/', skip-worktree set).
+ *   - The trailing checksum is not verified: git rewrites the file by
+ *     atomic rename, so a torn read cannot happen.
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_GIT_INDEX_H
+#define UMICOM_GIT_INDEX_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define UMI_GIT_OID_MAX 32
+
+typedef enum {
+    UMI_GIT_ENTRY_ASSUME_VALID  = 1 << 0,
+    UMI_GIT_ENTRY_SKIP_WORKTREE = 1 << 1,   /* not checked out (sparse)      */
+    UMI_GIT_ENTRY_INTENT_TO_ADD = 1 << 2    /* "git add -N"                  */
+} UmiGitEntryFlags;
+
+/* Object modes as stored in the index. */
+#define UMI_GIT_MODE_FILE     0100644u
+#define UMI_GIT_MODE_EXEC     0100755u
+#define UMI_GIT_MODE_SYMLINK  0120000u
+#define UMI_GIT_MODE_GITLINK  0160000u      /* submodule                     */
+#define UMI_GIT_MODE_DIR      0040000u      /* sparse-index directory        */
+
+typedef struct {
+    const char *path;                  /* repo-relative, '/'-separated      */
+    guint32     ctime_s, ctime_ns;
+    guint32     mtime_s, mtime_ns;
+    guint32     dev, ino;              /* truncated to 32 bits by git       */
+    guint32     mode;
+    guint32     uid, gid;
+    guint32     size;                  /* truncated to 32 bits by git       */
+    guint8      oid[UMI_GIT_OID_MAX];  /* first oid_len bytes are valid     */
+    guint8      stage;                 /* 0, or 1..3 while a merge conflicts */
+    guint8      flags;                 /* UmiGitEntryFlags                  */
+} UmiGitIndexEntry;
+
+typedef struct _UmiGitIndex UmiGitIndex;
+
+/* Find the work tree containing 'path' (walking up). On success returns
+ * the canonical work tree root and git dir (following a ".git" file, as
+ * used by linked worktrees and submodules); free both with g_free(). */
+gboolean     umi_git_find_repo(const char *path, char **out_worktree, char **out_gitdir);
+
+/* Value of 'section.key' in the repository config (the common dir's for a
+ * linked worktree), last occurrence winning; NULL if unset. Only plain
+ * "[section]" headers are matched, not "[section \"sub\"]". g_free(). */
+char        *umi_git_config_get(const char *gitdir, const char *section, const char *key);
+gboolean     umi_git_config_bool(const char *gitdir, const char *section, const char *key,
+                                 gboolean dflt);
+
+/* Read '<gitdir>/index'. NULL with 'err' set if missing or malformed. */
+UmiGitIndex *umi_git_index_read(const char *gitdir, GError **err);
+
+/* Parse an index image; 'oid_len' is 20 (SHA-1) or 32 (SHA-256). */
+UmiGitIndex *umi_git_index_parse(const guint8 *data, gsize len, guint oid_len, GError **err);
+
+void         umi_git_index_free(UmiGitIndex *gi);
+
+guint        umi_git_index_version(const UmiGitIndex *gi);
+guint        umi_git_index_oid_len(const UmiGitIndex *gi);
+
+/* Entries in index order: sorted by path bytes, then by stage. */
+guint                   umi_git_index_count(const UmiGitIndex *gi);
+const UmiGitIndexEntry *umi_git_index_entry(const UmiGitIndex *gi, guint i);
+
+/* Position of the first entry for 'path' (any stage), or -1. */
+gint         umi_git_index_find(const UmiGitIndex *gi, const char *path);
+
+G_END_DECLS
+
+#endif /* UMICOM_GIT_INDEX_H */
@@ -0,0 +1,112 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/util/git/include/git_status.h
+ *
+ * PURPOSE:
+ *   Native "git status" for the work tree: which tracked files are modified,
+ *   deleted, intent-to-add or conflicted, and which files are untracked,
+ *   kept up to date from filesystem events without spawning git.
+ *
+ * DESIGN:
+ *   - Tracked files are checked the way git does it: the stat data cached in
+ *     .git/index (mtime, ctime, size, inode, mode) is compared with lstat().
+ *     A file is hashed (blob id) only when that comparison is ambiguous:
+ *     stat data changed but the size did not, or the entry is "racily
+ *     clean" (modified in the same tick the index was written).
+ *   - A full check fans out over the worker pool (parallel_for.h) on a
+ *     background thread; results are applied on the main loop.
+ *   - Untracked = present in an attached UmiFileIndex (so hidden and ignored
+ *     files are already excluded) but absent from the git index.
+ *   - umi_git_status_notify() queues one path; queued paths are re-checked
+ *     together after a short debounce. Changes to .git/index or HEAD (a
+ *     commit, checkout, "git add", ...) are picked up through a monitor on
+ *     the git dir and trigger a full check.
+ *   - Directories report the most significant status below them, so a file
+ *     tree can mark collapsed folders.
+ *
+ * LIMITS:
+ *   - Work tree against index only: staged changes (index against HEAD)
+ *     would need the object database and are not reported.
+ *   - Clean/smudge filters and autocrlf are not applied before hashing; a
+ *     file that differs only by such a conversion shows as modified.
+ *   - Submodules are not inspected.
+ *
+ * THREADING:
+ *   - Main thread only (the engine schedules its own background work).
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_GIT_STATUS_H
+#define UMICOM_GIT_STATUS_H
+
+#include <glib.h>
+#include "file_index.h"
+
+G_BEGIN_DECLS
+
+typedef enum {
+    UMI_GIT_CLEAN = 0,
+    UMI_GIT_MODIFIED,      /* work tree differs from the index              */
+    UMI_GIT_DELETED,       /* tracked, missing from the work tree           */
+    UMI_GIT_ADDED,         /* intent-to-add ("git add -N")                  */
+    UMI_GIT_UNTRACKED,     /* in the file index, not in the git index       */
+    UMI_GIT_CONFLICTED,    /* unmerged index stages                         */
+    UMI_GIT_N_STATUS
+} UmiGitFileStatus;
+
+typedef struct _UmiGitStatusEngine UmiGitStatusEngine;
+
+typedef void (*UmiGitStatusChangedCb)(UmiGitStatusEngine *s, gpointer user);
+
+/* Engine for the work tree containing 'path', or NULL outside git. Starts
+ * with nothing known; call umi_git_status_refresh() or _scan(). */
+UmiGitStatusEngine *umi_git_status_new(const char *path);
+void                umi_git_status_free(UmiGitStatusEngine *s);
+
+const char *umi_git_status_worktree(const UmiGitStatusEngine *s);
+const char *umi_git_status_gitdir(const UmiGitStatusEngine *s);
+
+/* Source of untracked files (borrowed; detach with NULL before freeing it).
+ * Without one, nothing is reported as untracked. */
+void        umi_git_status_set_files(UmiGitStatusEngine *s, UmiFileIndex *files);
+
+/* Listeners run on the main loop after statuses changed. */
+guint       umi_git_status_add_listener(UmiGitStatusEngine *s, UmiGitStatusChangedCb cb, gpointer user);
+void        umi_git_status_remove_listener(UmiGitStatusEngine *s, guint id);
+
+/* Re-read the git index and check every tracked file in the background. */
+void        umi_git_status_refresh(UmiGitStatusEngine *s);
+
+/* Same, synchronously on the caller (plus whatever was queued). For tools
+ * and tests without a main loop; FALSE while a background check runs. */
+gboolean    umi_git_status_scan(UmiGitStatusEngine *s);
+
+/* Filesystem event for 'path' (absolute): re-check it after the debounce.
+ * Paths outside the work tree or inside the git dir are ignored. */
+void        umi_git_status_notify(UmiGitStatusEngine *s, const char *path);
+
+/* Run queued re-checks now, synchronously. FALSE while a background check
+ * runs (the queue is then handled when it finishes). */
+gboolean    umi_git_status_flush(UmiGitStatusEngine *s);
+
+/* Status of a file, or for a directory the most significant status below it
+ * (conflicted > modified > deleted > added > untracked). */
+UmiGitFileStatus umi_git_status_get(const UmiGitStatusEngine *s, const char *path);
+
+/* Files currently in state 'st' (st != UMI_GIT_CLEAN). */
+guint       umi_git_status_count(const UmiGitStatusEngine *s, UmiGitFileStatus st);
+
+/* Checked-out branch ("main"), an abbreviated commit id when detached, or
+ * NULL before the first check. */
+const char *umi_git_status_branch(const UmiGitStatusEngine *s);
+
+/* Bumped whenever any status or the branch changes. */
+guint64     umi_git_status_generation(const UmiGitStatusEngine *s);
+
+/* One-letter marker as in "git status --short": 'M', 'D', 'A', '?'
+ * (untracked), 'U' (conflicted) or ' '. */
+char        umi_git_status_letter(UmiGitFileStatus st);
+
+G_END_DECLS
+
+#endif /* UMICOM_GIT_STATUS_H */
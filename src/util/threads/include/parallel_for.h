@@ -0,0 +1,48 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/util/threads/include/parallel_for.h
+ *
+ * PURPOSE:
+ *   Split an index range [0, n) across the CPU cores and block until every
+ *   piece has been processed. Meant for CPU-bound loops over large tables
+ *   (fuzzy matching, index scans) where one call must finish quickly.
+ *
+ * API:
+ *   guint umi_parallel_workers(void);
+ *   void  umi_parallel_for(guint n, guint grain, UmiRangeFn fn, gpointer user);
+ *
+ * DESIGN:
+ *   - One process-wide GThreadPool (created on first use, ncpu-1 threads).
+ *   - The calling thread always participates as worker 0, so progress never
+ *     depends on a free pool thread (nested/concurrent calls cannot stall).
+ *   - Chunks of 'grain' items are claimed dynamically (atomic cursor), which
+ *     balances uneven per-item cost.
+ *   - 'worker' passed to the callback is in [0, umi_parallel_workers()) and
+ *     unique among concurrently running callbacks of one call: index
+ *     per-worker scratch state with it (no locking needed).
+ *
+ * THREADING:
+ *   - Callbacks run on pool threads; never touch GTK from them.
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#ifndef UMICOM_PARALLEL_FOR_H
+#define UMICOM_PARALLEL_FOR_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Process items [begin, end) as 'worker'. */
+typedef void (*UmiRangeFn)(guint begin, guint end, guint worker, gpointer user);
+
+/* Upper bound for the 'worker' argument (>= 1). Size per-worker state with it. */
+guint umi_parallel_workers(void);
+
+/* Run 'fn' over [0, n) in chunks of 'grain' (0 = pick one). Returns when all
+ * chunks are done. Small ranges run inline on the caller. n <= G_MAXINT / 2. */
+void  umi_parallel_for(guint n, guint grain, UmiRangeFn fn, gpointer user);
+
+G_END_DECLS
+
+#endif /* UMICOM_PARALLEL_FOR_H */
@@ -0,0 +1,142 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: src/util/threads/parallel_for.c
+ *
+ * PURPOSE:
+ *   Implementation of umi_parallel_for(): a blocking, chunked parallel loop
+ *   on a shared GThreadPool. See parallel_for.h for the contract.
+ *
+ * DESIGN:
+ *   - Each call allocates a small refcounted ParJob. Helpers are pushed to
+ *     the pool; the caller works too, then waits only for helpers that have
+ *     actually started. A helper that starts after the range is exhausted
+ *     returns immediately, so a busy pool only costs parallelism.
+ *   - The job is refcounted because late helpers may still touch it after
+ *     the caller has returned.
+ *
+ * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include "include/parallel_for.h"
+
+#define PAR_MAX_WORKERS 32
+
+typedef struct ParJob {
+    gint        ref;        /* caller + queued helpers                       */
+    gint        next;       /* next unclaimed index (atomic)                 */
+    gint        next_slot;  /* worker ids handed to helpers (atomic)         */
+    gint        active;     /* helpers currently working (under 'lock')      */
+    guint       n;
+    guint       grain;
+    UmiRangeFn  fn;
+    gpointer    user;
+    GMutex      lock;
+    GCond       done;
+} ParJob;
+
+static GThreadPool *par_pool;
+static guint        par_workers;
+
+static void
+job_unref(ParJob *j)
+{
+    if (!g_atomic_int_dec_and_test(&j->ref)) return;
+    g_mutex_clear(&j->lock);
+    g_cond_clear(&j->done);
+    g_free(j);
+}
+
+static void
+run_chunks(ParJob *j, guint worker)
+{
+    for (;;) {
+        const gint b = g_atomic_int_add(&j->next, (gint)j->grain);
+        if (b < 0 || (guint)b >= j->n) break;
+        const guint e = MIN((guint)b + j->grain, j->n);
+        j->fn((guint)b, e, worker, j->user);
+    }
+}
+
+static void
+helper_main(gpointer data, gpointer pool_user)
+{
+    (void)pool_user;
+    ParJob *j = (ParJob *)data;
+
+    g_mutex_lock(&j->lock);
+    const gboolean late = (guint)g_atomic_int_get(&j->next) >= j->n;
+    if (!late) j->active++;
+    g_mutex_unlock(&j->lock);
+
+    if (!late) {
+        run_chunks(j, (guint)g_atomic_int_add(&j->next_slot, 1));
+        g_mutex_lock(&j->lock);
+        if (--j->active == 0) g_cond_signal(&j->done);
+        g_mutex_unlock(&j->lock);
+    }
+    job_unref(j);
+}
+
+static gpointer
+pool_init(gpointer unused)
+{
+    (void)unused;
+    par_workers = CLAMP(g_get_num_processors(), 1u, (guint)PAR_MAX_WORKERS);
+    if (par_workers > 1) {
+        GError *err = NULL;
+        par_pool = g_thread_pool_new(helper_main, NULL, (gint)par_workers - 1, FALSE, &err);
+        if (!par_pool) {
+            g_warning("parallel_for: %s", err ? err->message : "unknown");
+            g_clear_error(&err);
+            par_workers = 1;
+        }
+    }
+    return NULL;
+}
+
+guint
+umi_parallel_workers(void)
+{
+    static GOnce once = G_ONCE_INIT;
+    g_once(&once, pool_init, NULL);
+    return par_workers;
+}
+
+void
+umi_parallel_for(guint n, guint grain, UmiRangeFn fn, gpointer user)
+{
+    if (!fn || n == 0) return;
+    g_return_if_fail(n <= (guint)(G_MAXINT / 2));
+
+    const guint workers = umi_parallel_workers();
+    if (grain == 0) grain = MAX(1u, n / (workers * 8));
+    if (workers == 1 || n <= grain) {
+        fn(0, n, 0, user);
+        return;
+    }
+
+    const guint helpers = MIN(workers - 1, (n + grain - 1) / grain - 1);
+    ParJob *j = g_new0(ParJob, 1);
+    j->ref       = (gint)helpers + 1;
+    j->next_slot = 1;
+    j->n         = n;
+    j->grain     = grain;
+    j->fn        = fn;
+    j->user      = user;
+    g_mutex_init(&j->lock);
+    g_cond_init(&j->done);
+
+    for (guint i = 0; i < helpers; ++i) {
+        GError *err = NULL;
+        if (!g_thread_pool_push(par_pool, j, &err)) {
+            g_clear_error(&err);
+            job_unref(j);                 /* caller picks up the work        */
+        }
+    }
+
+    run_chunks(j, 0);
+
+    g_mutex_lock(&j->lock);
+    while (j->active > 0) g_cond_wait(&j->done, &j->lock);
+    g_mutex_unlock(&j->lock);
+    job_unref(j);
+}
@@ -4,13 +4,26 @@
  *
  * PURPOSE:
  *   Glue between the recursive watcher and UI/workspace components.
- *   On any FS event, we refresh the FileTree; workspace state is optional.
+ *   Entries that appear or vanish are reported to the FileTree, which
+ *   re-lists just their directory (debounced, off the UI thread);
+ *   workspace state is optional.
  *
  * API:
  *   typedef struct _UmiWatcherIntegration UmiWatcherIntegration;
  *   UmiWatcherIntegration *umi_watch_integ_new(FileTree *tree, WorkspaceState *ws);
  *   gboolean               umi_watch_integ_add(UmiWatcherIntegration *wi, const UmiPathWatch *req);
  *   void                   umi_watch_integ_free(UmiWatcherIntegration *wi);
+ *   void                   umi_watch_integ_set_index(UmiWatcherIntegration *wi, UmiFileIndex *idx);
+ *   void                   umi_watch_integ_set_trigram(UmiWatcherIntegration *wi, UmiTrigramIndex *t);
+ *   void                   umi_watch_integ_set_symbols(UmiWatcherIntegration *wi, UmiSymbolIndex *s);
+ *   void                   umi_watch_integ_set_idents(UmiWatcherIntegration *wi, UmiIdentIndex *x);
+ *   void                   umi_watch_integ_set_git_status(UmiWatcherIntegration *wi, UmiGitStatusEngine *g);
+ *
+ *   When an index is attached, created/deleted/renamed events patch it in
+ *   place (umi_index_apply) instead of requiring a full rescan. A trigram,
+ *   symbol or identifier index is told which files changed and re-reads
+ *   them on its next sync.
+ *   A git status engine re-checks every path an event touches.
  *
  * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
  *---------------------------------------------------------------------------*/
@@ -19,14 +32,29 @@
 
 #include <glib.h>
 #include "watcher_recursive.h"
+#include "file_index.h"
 
 typedef struct _FileTree       FileTree;
 typedef struct _WorkspaceState WorkspaceState;
+typedef struct _UmiTrigramIndex UmiTrigramIndex;
+typedef struct _UmiSymbolIndex UmiSymbolIndex;
+typedef struct _UmiIdentIndex  UmiIdentIndex;
+typedef struct _UmiGitStatusEngine UmiGitStatusEngine;
 
 typedef struct _UmiWatcherIntegration UmiWatcherIntegration;
 
 UmiWatcherIntegration *umi_watch_integ_new(FileTree *tree, WorkspaceState *ws);
 gboolean umi_watch_integ_add(UmiWatcherIntegration *wi, const UmiPathWatch *req);
 void     umi_watch_integ_free(UmiWatcherIntegration *wi);
+/* Borrowed; must outlive the integration or be detached with NULL. */
+void     umi_watch_integ_set_index(UmiWatcherIntegration *wi, UmiFileIndex *idx);
+/* Same ownership rule as the index. */
+void     umi_watch_integ_set_trigram(UmiWatcherIntegration *wi, UmiTrigramIndex *t);
+/* Same ownership rule as the index. */
+void     umi_watch_integ_set_symbols(UmiWatcherIntegration *wi, UmiSymbolIndex *s);
+/* Same ownership rule as the index. */
+void     umi_watch_integ_set_idents(UmiWatcherIntegration *wi, UmiIdentIndex *x);
+/* Same ownership rule as the index. */
+void     umi_watch_integ_set_git_status(UmiWatcherIntegration *wi, UmiGitStatusEngine *g);
 
 #endif /* UMICOM_WATCHER_INTEGRATION_H */
@@ -19,6 +19,13 @@
  *   gboolean       umi_watchrec_add (UmiWatcherRec *w, const char *path_or_dir);
  *   void           umi_watchrec_rescan(UmiWatcherRec *w);
  *   void           umi_watchrec_free  (UmiWatcherRec *w);
+ *   void           umi_watchrec_set_event_cb(UmiWatcherRec *w, UmiWatchEventCb cb, gpointer user);
+ *
+ * TYPED EVENTS:
+ *   The plain callback only says "something changed here". Consumers that
+ *   maintain derived state (e.g. UmiFileIndex) can additionally register a
+ *   typed callback that classifies each event as created / deleted / renamed
+ *   / changed, with the destination path for renames and moves.
  *
  * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
  *---------------------------------------------------------------------------*/
@@ -33,9 +40,22 @@
 typedef void (*UmiWatchCb)(gpointer user, const char *path);
 typedef struct _UmiWatcherRec UmiWatcherRec;
 
+typedef enum {
+    UMI_WATCH_CHANGED,   /* contents/attributes changed                     */
+    UMI_WATCH_CREATED,   /* path appeared (created or moved in)             */
+    UMI_WATCH_DELETED,   /* path vanished (deleted or moved out)            */
+    UMI_WATCH_RENAMED    /* path moved to other_path (both inside the tree) */
+} UmiWatchEvent;
+
+typedef void (*UmiWatchEventCb)(gpointer user, UmiWatchEvent evt,
+                                const char *path, const char *other_path);
+
 UmiWatcherRec *umi_watchrec_new(const char *root, UmiWatchCb cb, gpointer user);
 gboolean       umi_watchrec_add(UmiWatcherRec *w, const char *path_or_dir);
 void           umi_watchrec_rescan(UmiWatcherRec *w);
 void           umi_watchrec_free(UmiWatcherRec *w);
 
+/* Optional typed callback, invoked before the plain one. NULL clears it. */
+void           umi_watchrec_set_event_cb(UmiWatcherRec *w, UmiWatchEventCb cb, gpointer user);
+
 #endif /* UMICOM_WATCHER_RECURSIVE_H */
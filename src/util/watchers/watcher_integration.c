@@ -8,32 +8,92 @@
  *
  * DESIGN:
  *   - Very thin by design; keep work minimal in callback.
- *   - Future: debounce/throttle refresh via g_timeout_add if needed.
+ *   - Typed events are forwarded to an attached UmiFileIndex so it is
+ *     patched in place (binary search) rather than rebuilt.
+ *   - An attached UmiTrigramIndex, UmiSymbolIndex or UmiIdentIndex is only
+ *     told which files to re-read; the work happens on its next sync.
+ *   - An attached git status engine queues the touched paths and re-checks
+ *     them after its own debounce.
+ *   - The FileTree only hears about entries that appeared or vanished (and
+ *     ignore-file edits); it debounces and re-lists the affected directory
+ *     in the background. Plain content changes never touch it.
  *
  * Created by: Umicom Foundation | Developer: Sammy Hegab | Date: 2025-10-13 | MIT
  *---------------------------------------------------------------------------*/
 
 #include "watcher_integration.h"
+#include "ignore_rules.h"
 #include <gio/gio.h>
 #include <glib.h>
+#include <string.h>
 
-/* Forward declare UI refresh to avoid heavy includes. */
-void umi_file_tree_refresh(struct _FileTree *tree);
+/* Forward declare UI notification to avoid heavy includes. */
+void umi_file_tree_notify(struct _FileTree *tree, const char *path);
+void umi_trigram_index_mark_dirty(struct _UmiTrigramIndex *t, const char *path);
+void umi_symbol_index_mark_dirty(struct _UmiSymbolIndex *s, const char *path);
+void umi_ident_index_mark_dirty(struct _UmiIdentIndex *x, const char *path);
+void umi_git_status_notify(struct _UmiGitStatusEngine *s, const char *path);
 
 struct _UmiWatcherIntegration {
     FileTree       *tree;   /* borrowed */
     WorkspaceState *ws;     /* borrowed (unused for now) */
     UmiWatcherRec  *rec;    /* owned */
+    UmiFileIndex   *index;  /* borrowed, optional */
+    UmiTrigramIndex *trigram; /* borrowed, optional */
+    UmiSymbolIndex  *symbols; /* borrowed, optional */
+    UmiIdentIndex   *idents;  /* borrowed, optional */
+    UmiGitStatusEngine *git;  /* borrowed, optional */
 };
 
-static void on_evt(gpointer u, const char *path)
+static void on_typed_evt(gpointer u, UmiWatchEvent evt,
+                         const char *path, const char *other_path)
 {
-    (void)path; /* refresh whole tree; future: selective refresh */
     UmiWatcherIntegration *g = (UmiWatcherIntegration*)u;
-    if (!g || !g->tree) return;
+    if (!g) return;
+
+    if (g->tree && path) {
+        const char *leaf = strrchr(path, G_DIR_SEPARATOR);
+        if (evt != UMI_WATCH_CHANGED || umi_ignore_is_rule_file(leaf ? leaf + 1 : path)) {
+            umi_file_tree_notify(g->tree, path);
+            if (other_path) umi_file_tree_notify(g->tree, other_path);
+        }
+    }
+    if (g->trigram) {
+        /* Content may differ; the index re-reads it on its next sync.
+         * Deletions need nothing: the file simply leaves the file index. */
+        if (evt == UMI_WATCH_CHANGED || evt == UMI_WATCH_CREATED) umi_trigram_index_mark_dirty(g->trigram, path);
+        else if (evt == UMI_WATCH_RENAMED && other_path) umi_trigram_index_mark_dirty(g->trigram, other_path);
+    }
+    if (g->symbols) {
+        /* Same rule: re-parse on the next sync (lookups sync first). */
+        if (evt == UMI_WATCH_CHANGED || evt == UMI_WATCH_CREATED) umi_symbol_index_mark_dirty(g->symbols, path);
+        else if (evt == UMI_WATCH_RENAMED && other_path) umi_symbol_index_mark_dirty(g->symbols, other_path);
+    }
+    if (g->idents) {
+        if (evt == UMI_WATCH_CHANGED || evt == UMI_WATCH_CREATED) umi_ident_index_mark_dirty(g->idents, path);
+        else if (evt == UMI_WATCH_RENAMED && other_path) umi_ident_index_mark_dirty(g->idents, other_path);
+    }
+    if (g->git) {
+        /* Edits, creations, deletions: every touched path may change status. */
+        if (path) umi_git_status_notify(g->git, path);
+        if (other_path) umi_git_status_notify(g->git, other_path);
+    }
+    if (!g->index) return;
+
+    switch (evt) {
+    case UMI_WATCH_CREATED: umi_index_apply(g->index, UMI_INDEX_CREATED, path, NULL);       break;
+    case UMI_WATCH_DELETED: umi_index_apply(g->index, UMI_INDEX_DELETED, path, NULL);       break;
+    case UMI_WATCH_RENAMED: umi_index_apply(g->index, UMI_INDEX_RENAMED, path, other_path); break;
+    case UMI_WATCH_CHANGED: umi_index_apply(g->index, UMI_INDEX_CHANGED, path, NULL);       break; /* metadata, ignore files */
+    }
+}
 
-    /* If you must marshal to GTK main thread explicitly, use g_idle_add(). */
-    umi_file_tree_refresh(g->tree);
+static void on_evt(gpointer u, const char *path)
+{
+    /* Untyped events include raw CHANGED bursts (every write during a
+     * build); on_typed_evt already routes what matters to the tree. */
+    (void)u;
+    (void)path;
 }
 
 UmiWatcherIntegration *umi_watch_integ_new(FileTree *tree, WorkspaceState *ws)
@@ -52,6 +112,7 @@ gboolean umi_watch_integ_add(UmiWatcherIntegration *wi, const UmiPathWatch *req)
     if (!wi->rec) {
         wi->rec = umi_watchrec_new(req->path, on_evt, wi);
         if (!wi->rec) return FALSE;
+        umi_watchrec_set_event_cb(wi->rec, on_typed_evt, wi);
     } else {
         if (!umi_watchrec_add(wi->rec, req->path)) return FALSE;
     }
@@ -59,6 +120,36 @@ gboolean umi_watch_integ_add(UmiWatcherIntegration *wi, const UmiPathWatch *req)
     return TRUE;
 }
 
+void umi_watch_integ_set_index(UmiWatcherIntegration *wi, UmiFileIndex *idx)
+{
+    if (!wi) return;
+    wi->index = idx;
+}
+
+void umi_watch_integ_set_trigram(UmiWatcherIntegration *wi, UmiTrigramIndex *t)
+{
+    if (!wi) return;
+    wi->trigram = t;
+}
+
+void umi_watch_integ_set_symbols(UmiWatcherIntegration *wi, UmiSymbolIndex *s)
+{
+    if (!wi) return;
+    wi->symbols = s;
+}
+
+void umi_watch_integ_set_idents(UmiWatcherIntegration *wi, UmiIdentIndex *x)
+{
+    if (!wi) return;
+    wi->idents = x;
+}
+
+void umi_watch_integ_set_git_status(UmiWatcherIntegration *wi, UmiGitStatusEngine *g)
+{
+    if (!wi) return;
+    wi->git = g;
+}
+
 void umi_watch_integ_free(UmiWatcherIntegration *wi)
 {
     if (!wi) return;
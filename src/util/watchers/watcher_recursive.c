@@ -8,9 +8,15 @@
  *   best-effort UTF-8 path. Pure C; no UI/cross-module headers.
  *
  * DESIGN:
- *   - Track monitors (GFileMonitor*) and root directories we manage.
+ *   - Track monitors (GFileMonitor*, keyed by directory path) and root
+ *     directories we manage. A directory is monitored once however often
+ *     it is scanned (e.g. "mkdir -p a/b" reports b while a is being
+ *     scanned), so no event is delivered twice.
  *   - Convert file paths to UTF-8 using GLib; avoid following symlink loops.
  *   - WATCH_MOVES to classify renames on backends that support it.
+ *   - Directories created after the initial scan get monitors of their own,
+ *     so new subtrees keep reporting events; the monitors of a directory
+ *     that is deleted or moved away are dropped with its whole subtree.
  *
  * SECURITY/ROBUSTNESS:
  *   - Skip symlinked directories to avoid cycles.
@@ -27,12 +33,17 @@
 
 /* Private structure */
 struct _UmiWatcherRec {
-    GPtrArray  *monitors;  /* Array<GFileMonitor*>; owned here                */
+    GHashTable *monitors;  /* dir path (char*) -> GFileMonitor*; owned here   */
     GPtrArray  *roots;     /* Array<char*> of directory roots we manage       */
     UmiWatchCb  cb;        /* User callback                                   */
     gpointer    user;      /* Opaque pointer passed back                      */
+    UmiWatchEventCb evt_cb;   /* Optional typed callback                      */
+    gpointer        evt_user; /* Opaque pointer for evt_cb                    */
 };
 
+static void scan_dir(UmiWatcherRec *w, const char *root);
+static void drop_subtree(UmiWatcherRec *w, GFile *dir);
+
 /* Normalize to a displayable UTF-8 path or URI. */
 static char *normalize_path(GFile *f)
 {
@@ -51,11 +62,45 @@ static void mon_changed(GFileMonitor *mon,
                         GFileMonitorEvent evt,
                         gpointer       u)
 {
-    (void)mon; (void)other_file; (void)evt;
+    (void)mon;
     UmiWatcherRec *w = (UmiWatcherRec*)u;
     if (!w || !w->cb) return;
 
     g_autofree char *path = normalize_path(file);
+
+    UmiWatchEvent kind;
+    gboolean      typed = TRUE;
+    switch (evt) {
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_MOVED_IN:  kind = UMI_WATCH_CREATED; break;
+    case G_FILE_MONITOR_EVENT_DELETED:
+    case G_FILE_MONITOR_EVENT_MOVED_OUT: kind = UMI_WATCH_DELETED; break;
+    case G_FILE_MONITOR_EVENT_RENAMED:
+    case G_FILE_MONITOR_EVENT_MOVED:     kind = UMI_WATCH_RENAMED; break;
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+    case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED: kind = UMI_WATCH_CHANGED; break;
+    default: kind = UMI_WATCH_CHANGED; typed = FALSE; break; /* CHANGED etc. */
+    }
+
+    /* Renames without a destination degrade to a plain delete. */
+    g_autofree char *other = NULL;
+    if (kind == UMI_WATCH_RENAMED) {
+        if (other_file) other = normalize_path(other_file);
+        else            kind  = UMI_WATCH_DELETED;
+    }
+
+    /* A new directory needs its own monitor(s) to report further events. */
+    const char *appeared = (kind == UMI_WATCH_CREATED) ? path
+                         : (kind == UMI_WATCH_RENAMED) ? other : NULL;
+    if (appeared && g_file_test(appeared, G_FILE_TEST_IS_DIR) &&
+        !g_file_test(appeared, G_FILE_TEST_IS_SYMLINK)) {
+        scan_dir(w, appeared);
+    }
+    /* A directory that went away takes its monitors with it. */
+    if (kind == UMI_WATCH_DELETED || kind == UMI_WATCH_RENAMED) drop_subtree(w, file);
+
+    /* Raw CHANGED bursts are noisy; CHANGES_DONE_HINT reports the same edit. */
+    if (w->evt_cb && typed) w->evt_cb(w->evt_user, kind, path, other);
     w->cb(w->user, path ? path : "(unknown)");
 }
 
@@ -63,6 +108,7 @@ static void mon_changed(GFileMonitor *mon,
 static gboolean add_dir_monitor(UmiWatcherRec *w, const char *dir_path)
 {
     if (!w || !dir_path || !*dir_path) return FALSE;
+    if (g_hash_table_contains(w->monitors, dir_path)) return TRUE; /* already watched */
 
     g_autoptr(GFile) dir = g_file_new_for_path(dir_path);
     GError *err = NULL;
@@ -78,10 +124,37 @@ static gboolean add_dir_monitor(UmiWatcherRec *w, const char *dir_path)
     }
 
     g_signal_connect(m, "changed", G_CALLBACK(mon_changed), w);
-    g_ptr_array_add(w->monitors, m); /* owned by array free func */
+    g_hash_table_insert(w->monitors, g_strdup(dir_path), m); /* owned by the table */
     return TRUE;
 }
 
+/* Value destroy func of the monitor table: stop delivery, then release. */
+static void monitor_release(gpointer p)
+{
+    GFileMonitor *m = p;
+    g_signal_handlers_disconnect_matched(m, G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
+                                         (gpointer)mon_changed, NULL);
+    g_file_monitor_cancel(m);
+    g_object_unref(m);
+}
+
+/* Forget the monitors of 'dir' and everything below it. Only directories
+ * carry monitors, so anything else returns after one lookup. */
+static void drop_subtree(UmiWatcherRec *w, GFile *dir)
+{
+    g_autofree char *p = dir ? g_file_get_path(dir) : NULL;
+    if (!p || !g_hash_table_remove(w->monitors, p)) return;
+
+    const size_t n = strlen(p);
+    GHashTableIter it;
+    gpointer key;
+    g_hash_table_iter_init(&it, w->monitors);
+    while (g_hash_table_iter_next(&it, &key, NULL)) {
+        const char *k = key;
+        if (strncmp(k, p, n) == 0 && G_IS_DIR_SEPARATOR(k[n])) g_hash_table_iter_remove(&it);
+    }
+}
+
 /* Depth-first scan with symlink-guard. */
 static void scan_dir(UmiWatcherRec *w, const char *root)
 {
@@ -131,13 +204,7 @@ static char *dir_for_any_path(const char *path)
 static void clear_monitors(UmiWatcherRec *w)
 {
     if (!w || !w->monitors) return;
-    for (guint i = 0; i < w->monitors->len; ++i) {
-        GFileMonitor *m = g_ptr_array_index(w->monitors, i);
-        if (!m) continue;
-        g_signal_handlers_disconnect_by_data(m, w);
-        /* array free func will unref in unref below */
-    }
-    g_ptr_array_set_size(w->monitors, 0);
+    g_hash_table_remove_all(w->monitors); /* monitor_release() per entry */
 }
 
 UmiWatcherRec *umi_watchrec_new(const char *root, UmiWatchCb cb, gpointer user)
@@ -145,7 +212,7 @@ UmiWatcherRec *umi_watchrec_new(const char *root, UmiWatchCb cb, gpointer user)
     if (!root || !*root || !cb) return NULL;
 
     UmiWatcherRec *w = g_new0(UmiWatcherRec, 1);
-    w->monitors = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+    w->monitors = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, monitor_release);
     w->roots    = g_ptr_array_new_with_free_func(g_free);
     w->cb       = cb;
     w->user     = user;
@@ -186,7 +253,14 @@ void umi_watchrec_free(UmiWatcherRec *w)
 {
     if (!w) return;
     clear_monitors(w);
-    g_clear_pointer(&w->monitors, g_ptr_array_unref);
+    g_clear_pointer(&w->monitors, g_hash_table_unref);
     g_clear_pointer(&w->roots,    g_ptr_array_unref);
     g_free(w);
 }
+
+void umi_watchrec_set_event_cb(UmiWatcherRec *w, UmiWatchEventCb cb, gpointer user)
+{
+    if (!w) return;
+    w->evt_cb   = cb;
+    w->evt_user = cb ? user : NULL;
+}
@@ -0,0 +1,180 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: tests/test_diff_gutter.c
+ * PURPOSE: Diff gutter: Myers hunks for inserts, deletes and modifications
+ *          at the file edges, line splitting, marks, and minimal edit
+ *          scripts on generated inputs
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+#include "test_scaffold.h"
+
+/* The diff runs on the gutter's worker; test it from inside. */
+#include "../src/editor/diff_gutter.c"
+
+/* Hunks of 'base' -> 'text' over whole files, as "base_start,base_len>line_start,line_len"
+ * joined by ' ' ("" when equal). */
+static char *hunks_of(const char *base, const char *text)
+{
+    GArray *a = split_lines(base, strlen(base), G_MAXUINT);
+    GArray *b = split_lines(text, strlen(text), G_MAXUINT);
+    Myers m = { base, (const Line *)(void *)a->data, text, (const Line *)(void *)b->data,
+                g_array_new(FALSE, FALSE, sizeof(UmiDiffHunk)) };
+    diff_range(&m, 0, a->len, 0, b->len);
+    GString *s = g_string_new(NULL);
+    for (guint i = 0; i < m.out->len; ++i) {
+        const UmiDiffHunk *h = &g_array_index(m.out, UmiDiffHunk, i);
+        g_string_append_printf(s, "%s%u,%u>%u,%u", i ? " " : "", h->base_start, h->base_len,
+                               h->line_start, h->line_len);
+    }
+    g_array_free(m.out, TRUE);
+    g_array_free(a, TRUE);
+    g_array_free(b, TRUE);
+    return g_string_free(s, FALSE);
+}
+
+static gboolean hunks_are(const char *base, const char *text, const char *want)
+{
+    char *got = hunks_of(base, text);
+    const gboolean ok = strcmp(got, want) == 0;
+    if (!ok) g_printerr("  '%s' -> '%s': '%s', want '%s'\n", base, text, got, want);
+    g_free(got);
+    return ok;
+}
+
+/*---------------------------------------------------------------------------
+ * Tests
+ *-------------------------------------------------------------------------*/
+
+static gboolean test_split_lines(void)
+{
+    GArray *l = split_lines("a\r\nbb\rc\n", 8, G_MAXUINT);  /* as GtkTextBuffer counts */
+    gboolean ok = l->len == 4 &&
+                  g_array_index(l, Line, 0).off == 0 && g_array_index(l, Line, 0).len == 1 &&
+                  g_array_index(l, Line, 1).off == 3 && g_array_index(l, Line, 1).len == 2 &&
+                  g_array_index(l, Line, 2).off == 6 && g_array_index(l, Line, 3).len == 0;
+    g_array_free(l, TRUE);
+    l  = split_lines("", 0, G_MAXUINT);
+    ok = ok && l->len == 1;
+    g_array_free(l, TRUE);
+    l  = split_lines("a\nb\nc\nd", 7, 2);
+    ok = ok && l->len == 2;
+    g_array_free(l, TRUE);
+    return ok;
+}
+
+static gboolean test_edges(void)
+{
+    return hunks_are("a\nb\nc", "a\nb\nc", "") &&
+           hunks_are("b\nc", "a\nb\nc", "0,0>0,1") &&            /* insert at the top    */
+           hunks_are("a\nb", "a\nb\nc", "2,0>2,1") &&            /* ... at the end       */
+           hunks_are("a\nb\nc", "b\nc", "0,1>0,0") &&            /* delete the first     */
+           hunks_are("a\nb\nc", "a\nb", "2,1>2,0") &&            /* ... the last         */
+           hunks_are("a\nb\nc", "x\nb\nc", "0,1>0,1") &&         /* modify the first     */
+           hunks_are("a\nb\nc", "a\nb\nx", "2,1>2,1") &&         /* ... the last         */
+           hunks_are("a\nb\nc", "x\nb\ny", "0,1>0,1 2,1>2,1") && /* both edges           */
+           hunks_are("a\nb\n", "a\nb\nc\n", "2,0>2,1") &&        /* trailing newline     */
+           hunks_are("a\nb", "a\nb\n", "2,0>2,1") &&             /* newline added at EOF */
+           hunks_are("", "a\nb", "0,1>0,2") &&                   /* from an empty file   */
+           hunks_are("a\nb", "", "0,2>0,1") &&                   /* ... to an empty one  */
+           hunks_are("a\r\nb\r\nc", "a\nb\nc", "");              /* line ends not compared */
+}
+
+static gboolean test_middle(void)
+{
+    return hunks_are("a\nb\nc\nd\ne\nf\ng", "a\nB\nc\nd\ne\nF\nF2\ng", "1,1>1,1 5,1>5,2") &&
+           hunks_are("a\nb\nc\nd", "a\nd", "1,2>1,0") &&
+           hunks_are("a\nb\nb\nb\nc", "a\nb\nc", "2,2>2,0") &&       /* repeats: one hunk */
+           hunks_are("x\ny", "y\nx", "0,1>0,0 2,0>1,1");
+}
+
+static gboolean test_marks(void)
+{
+    const UmiDiffHunk top = { 0, 2, 0, 0 }, end = { 5, 1, 4, 0 }, mod = { 1, 1, 1, 1 }, add = { 2, 0, 2, 3 };
+    return hunk_mark(&top, 0) == UMI_GUTTER_DELETED && hunk_mark(&top, 1) == UMI_GUTTER_NONE &&
+           hunk_mark(&end, 3) == UMI_GUTTER_DELETED && hunk_mark(&end, 4) == UMI_GUTTER_NONE &&
+           hunk_mark(&mod, 1) == UMI_GUTTER_MODIFIED && hunk_mark(&mod, 2) == UMI_GUTTER_NONE &&
+           hunk_mark(&add, 2) == UMI_GUTTER_ADDED && hunk_mark(&add, 4) == UMI_GUTTER_ADDED &&
+           hunk_mark(&add, 5) == UMI_GUTTER_NONE;
+}
+
+/* Length of the longest common subsequence of 'a' and 'b' (one char per line). */
+static guint lcs(const char *a, guint n, const char *b, guint m)
+{
+    guint *row = g_new0(guint, m + 1);
+    for (guint i = 1; i <= n; ++i) {
+        guint diag = 0;
+        for (guint j = 1; j <= m; ++j) {
+            const guint up = row[j];
+            row[j] = a[i - 1] == b[j - 1] ? diag + 1 : MAX(row[j], row[j - 1]);
+            diag = up;
+        }
+    }
+    const guint r = row[m];
+    g_free(row);
+    return r;
+}
+
+/* Hunks applied to the base give the text back, and they change no more
+ * lines than a shortest edit script must. */
+static gboolean test_generated(void)
+{
+    GRand *rnd = g_rand_new_with_seed(14);
+    gboolean ok = TRUE;
+    for (guint round = 0; round < 400 && ok; ++round) {
+        const guint n = (guint)g_rand_int_range(rnd, 1, 40), m = (guint)g_rand_int_range(rnd, 1, 40);
+        const gint alpha = g_rand_int_range(rnd, 2, 6);
+        char a[40], b[40];
+        for (guint i = 0; i < n; ++i) a[i] = (char)('a' + g_rand_int_range(rnd, 0, alpha));
+        for (guint i = 0; i < m; ++i) b[i] = (char)('a' + g_rand_int_range(rnd, 0, alpha));
+
+        GString *at = g_string_new(NULL), *bt = g_string_new(NULL);
+        for (guint i = 0; i < n; ++i) g_string_append_printf(at, "%s%c", i ? "\n" : "", a[i]);
+        for (guint i = 0; i < m; ++i) g_string_append_printf(bt, "%s%c", i ? "\n" : "", b[i]);
+        GArray *la = split_lines(at->str, at->len, G_MAXUINT), *lb = split_lines(bt->str, bt->len, G_MAXUINT);
+        Myers my = { at->str, (const Line *)(void *)la->data, bt->str, (const Line *)(void *)lb->data,
+                     g_array_new(FALSE, FALSE, sizeof(UmiDiffHunk)) };
+        diff_range(&my, 0, n, 0, m);
+
+        GString *rebuilt = g_string_new(NULL);
+        guint ai = 0, cost = 0;
+        for (guint i = 0; i < my.out->len && ok; ++i) {
+            const UmiDiffHunk *h = &g_array_index(my.out, UmiDiffHunk, i);
+            ok = h->base_start >= ai && h->line_start == rebuilt->len + (h->base_start - ai);
+            g_string_append_len(rebuilt, a + ai, h->base_start - ai);
+            g_string_append_len(rebuilt, b + h->line_start, h->line_len);
+            ai = h->base_start + h->base_len;
+            cost += h->base_len + h->line_len;
+        }
+        g_string_append_len(rebuilt, a + ai, n - ai);
+        ok = ok && rebuilt->len == m && memcmp(rebuilt->str, b, m) == 0 &&
+             cost == n + m - 2 * lcs(a, n, b, m);
+        if (!ok) g_printerr("  round %u: '%.*s' -> '%.*s'\n", round, (int)n, a, (int)m, b);
+
+        g_string_free(rebuilt, TRUE);
+        g_array_free(my.out, TRUE);
+        g_array_free(la, TRUE);
+        g_array_free(lb, TRUE);
+        g_string_free(at, TRUE);
+        g_string_free(bt, TRUE);
+    }
+    g_rand_free(rnd);
+    return ok;
+}
+
+int main(void)
+{
+    UmiTests *t = umi_tests_new();
+    umi_tests_add(t, "diff gutter line splitting", test_split_lines);
+    umi_tests_add(t, "diff gutter hunks at the file edges", test_edges);
+    umi_tests_add(t, "diff gutter hunks in the middle", test_middle);
+    umi_tests_add(t, "diff gutter marks", test_marks);
+    umi_tests_add(t, "diff gutter minimal edit scripts", test_generated);
+    const int fails = umi_tests_run(t);
+    umi_tests_free(t);
+    puts(fails ? "fail" : "ok");
+    return fails ? 1 : 0;
+}
+/*  END OF FILE */
@@ -0,0 +1,260 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: tests/test_git_index.c
+ * PURPOSE: .git/index parser: versions 2-4, v4 prefix compression, SHA-256
+ *          object ids, and malformed or truncated images
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+#include "git_index.h"
+#include "test_scaffold.h"
+
+#define X_SKIP_WORKTREE 0x4000u
+#define X_INTENT_TO_ADD 0x2000u
+
+/*------------------------------ Image builder --------------------------------*/
+static void put16(GByteArray *b, guint16 v){
+  const guint8 x[2] = { (guint8)(v >> 8), (guint8)v };
+  g_byte_array_append(b, x, 2);
+}
+
+static void put32(GByteArray *b, guint32 v){
+  const guint8 x[4] = { (guint8)(v >> 24), (guint8)(v >> 16), (guint8)(v >> 8), (guint8)v };
+  g_byte_array_append(b, x, 4);
+}
+
+/* git's offset varint (varint.c: encode_varint). */
+static void put_varint(GByteArray *b, guint64 v){
+  guint8 tmp[16];
+  guint pos = sizeof tmp - 1;
+  tmp[pos] = v & 127;
+  while (v >>= 7) tmp[--pos] = (guint8)(128 | (--v & 127));
+  g_byte_array_append(b, tmp + pos, sizeof tmp - pos);
+}
+
+static GByteArray *image_new(guint version, guint32 n){
+  GByteArray *b = g_byte_array_new();
+  g_byte_array_append(b, (const guint8 *)"DIRC", 4);
+  put32(b, version);
+  put32(b, n);
+  return b;
+}
+
+/* Append an entry for 'path'; 'prev' is the path before it (v4 strips the
+ * shared prefix). Stat fields are derived from 'seed'; the oid is 'seed'
+ * repeated. 'xflags' (v3+) are written when non-zero. */
+static void put_entry(GByteArray *b, guint version, guint oid_len, const char *prev,
+                      const char *path, guint stage, guint16 xflags, guint32 seed){
+  const gsize start = b->len;
+  for (guint i = 0; i < 6; i++) put32(b, seed + i);   /* ctime, mtime, dev, ino */
+  put32(b, 0100644u);
+  put32(b, 1000); put32(b, 1000);
+  put32(b, seed * 10);
+  for (guint i = 0; i < oid_len; i++) g_byte_array_append(b, (const guint8 *)&seed, 1);
+  const gsize plen = strlen(path);
+  put16(b, (guint16)((xflags ? 0x4000u : 0) | (stage << 12) | MIN(plen, 0xFFFu)));
+  if (xflags) put16(b, xflags);
+  if (version == 4) {
+    gsize common = 0;
+    while (prev[common] && prev[common] == path[common]) common++;
+    put_varint(b, strlen(prev) - common);
+    g_byte_array_append(b, (const guint8 *)path + common, (guint)(plen - common + 1));
+  } else {
+    g_byte_array_append(b, (const guint8 *)path, (guint)plen);
+    const gsize elen = (b->len - start + 8) & ~(gsize)7;
+    const guint8 zero[8] = { 0 };
+    g_byte_array_append(b, zero, (guint)(elen - (b->len - start)));
+  }
+}
+
+/* The trailing checksum; the parser does not verify it. */
+static void put_trailer(GByteArray *b, guint oid_len){
+  for (guint i = 0; i < oid_len; i++) { const guint8 z = 0xAB; g_byte_array_append(b, &z, 1); }
+}
+
+static const char *const PATHS[] = {
+  "Makefile", "a", "abcdefg", "abcdefgh", "src/main.c", "src/main.h", "src/util/x.c", NULL
+};
+
+static GByteArray *image_of(guint version, guint oid_len, const char *const *paths){
+  guint32 n = 0;
+  while (paths[n]) n++;
+  GByteArray *b = image_new(version, n);
+  for (guint32 i = 0; i < n; i++)
+    put_entry(b, version, oid_len, i ? paths[i - 1] : "", paths[i], 0, 0, i + 1);
+  return b;
+}
+
+/* Parse from an exact-size copy, so reading past 'len' is caught. */
+static UmiGitIndex *parse(const GByteArray *b, gsize len, guint oid_len){
+  guint8 *copy = g_memdup2(b->data, len);
+  UmiGitIndex *gi = umi_git_index_parse(copy, len, oid_len, NULL);
+  g_free(copy);
+  return gi;
+}
+
+static gboolean entries_match(const UmiGitIndex *gi, const char *const *paths, guint oid_len){
+  guint n = 0;
+  while (paths[n]) n++;
+  if (umi_git_index_count(gi) != n) return FALSE;
+  for (guint i = 0; i < n; i++) {
+    const UmiGitIndexEntry *e = umi_git_index_entry(gi, i);
+    if (strcmp(e->path, paths[i]) != 0) return FALSE;
+    if (e->ctime_s != i + 1 || e->ino != i + 6 || e->size != (i + 1) * 10) return FALSE;
+    if (e->mode != UMI_GIT_MODE_FILE || e->uid != 1000 || e->stage != 0 || e->flags != 0) return FALSE;
+    if (e->oid[0] != (guint8)(i + 1) || e->oid[oid_len - 1] != (guint8)(i + 1)) return FALSE;
+    if (umi_git_index_find(gi, paths[i]) != (gint)i) return FALSE;
+  }
+  return umi_git_index_find(gi, "src/missing.c") == -1;
+}
+
+/*------------------------------ Tests ----------------------------------------*/
+static gboolean test_versions(void){
+  for (guint v = 2; v <= 4; v++) {
+    GByteArray *b = image_of(v, 20, PATHS);
+    put_trailer(b, 20);
+    UmiGitIndex *gi = parse(b, b->len, 20);
+    const gboolean ok = gi && umi_git_index_version(gi) == v && umi_git_index_oid_len(gi) == 20 &&
+                        entries_match(gi, PATHS, 20);
+    umi_git_index_free(gi);
+    g_byte_array_free(b, TRUE);
+    if (!ok) return FALSE;
+  }
+  return TRUE;
+}
+
+static gboolean test_sha256(void){
+  GByteArray *b = image_of(2, 32, PATHS);
+  put_trailer(b, 32);
+  UmiGitIndex *gi = parse(b, b->len, 32);
+  const gboolean ok = gi && umi_git_index_oid_len(gi) == 32 && entries_match(gi, PATHS, 32);
+  umi_git_index_free(gi);
+  g_byte_array_free(b, TRUE);
+  return ok && !umi_git_index_parse((const guint8 *)"DIRC", 4, 24, NULL);
+}
+
+/* Strips of 0, of a whole path, and of 128+ bytes (a two-byte varint). */
+static gboolean test_v4_prefix(void){
+  GString *deep = g_string_new("d/");
+  while (deep->len < 300) g_string_append(deep, "nested/");
+  g_string_append(deep, "leaf.c");
+  const char *const paths[] = { "a/b/c.c", "a/b/c.h", "a/b/cd/e.c", "a/bz", deep->str, "e", "e/f", NULL };
+  GByteArray *b = image_of(4, 20, paths);
+  UmiGitIndex *gi = parse(b, b->len, 20);
+  const gboolean ok = gi && entries_match(gi, paths, 20);
+  umi_git_index_free(gi);
+  g_byte_array_free(b, TRUE);
+  g_string_free(deep, TRUE);
+  return ok;
+}
+
+static gboolean test_flags_and_stages(void){
+  GByteArray *b = image_new(3, 5);
+  put_entry(b, 3, 20, "", "conflict.c", 1, 0, 1);
+  put_entry(b, 3, 20, "", "conflict.c", 2, 0, 2);
+  put_entry(b, 3, 20, "", "conflict.c", 3, 0, 3);
+  put_entry(b, 3, 20, "", "new.c", 0, X_INTENT_TO_ADD, 4);
+  put_entry(b, 3, 20, "", "sparse/x.c", 0, X_SKIP_WORKTREE, 5);
+  UmiGitIndex *gi = parse(b, b->len, 20);
+  gboolean ok = gi && umi_git_index_count(gi) == 5;
+  for (guint i = 0; ok && i < 3; i++) ok = umi_git_index_entry(gi, i)->stage == i + 1;
+  ok = ok && umi_git_index_find(gi, "conflict.c") == 0 &&
+       umi_git_index_entry(gi, 3)->flags == UMI_GIT_ENTRY_INTENT_TO_ADD &&
+       umi_git_index_entry(gi, 4)->flags == UMI_GIT_ENTRY_SKIP_WORKTREE;
+  umi_git_index_free(gi);
+  g_byte_array_free(b, TRUE);
+
+  /* Extended flags do not exist in version 2. */
+  b = image_new(2, 1);
+  put_entry(b, 2, 20, "", "x.c", 0, X_SKIP_WORKTREE, 1);
+  ok = ok && !parse(b, b->len, 20);
+  g_byte_array_free(b, TRUE);
+  return ok;
+}
+
+/* Every prefix that cuts into the entries is rejected, without reading
+ * past its end; once all entries are there, the rest is not needed. */
+static gboolean test_truncated(void){
+  for (guint v = 2; v <= 4; v++) {
+    GByteArray *b = image_of(v, 20, PATHS);
+    const gsize entries_end = b->len;
+    put_trailer(b, 20);
+    for (gsize len = 0; len <= b->len; len++) {
+      UmiGitIndex *gi = parse(b, len, 20);
+      const gboolean want = len >= entries_end;
+      const gboolean ok = want ? (gi && entries_match(gi, PATHS, 20)) : gi == NULL;
+      umi_git_index_free(gi);
+      if (!ok) { g_byte_array_free(b, TRUE); return FALSE; }
+    }
+    g_byte_array_free(b, TRUE);
+  }
+  return TRUE;
+}
+
+static gboolean test_malformed(void){
+  gboolean ok = TRUE;
+  GError *err = NULL;
+
+  GByteArray *b = image_of(2, 20, PATHS);
+  b->data[0] = 'X';                                       /* signature */
+  ok = ok && !umi_git_index_parse(b->data, b->len, 20, &err) && err;
+  g_clear_error(&err);
+  b->data[0] = 'D';
+  b->data[7] = 5;                                         /* version 5 */
+  ok = ok && !parse(b, b->len, 20);
+  b->data[7] = 1;
+  ok = ok && !parse(b, b->len, 20);
+  g_byte_array_free(b, TRUE);
+
+  /* More entries announced than present. */
+  b = image_of(2, 20, PATHS);
+  b->data[11] = 200;
+  ok = ok && !parse(b, b->len, 20);
+  g_byte_array_free(b, TRUE);
+
+  /* Name length in the flags disagrees with the path. */
+  b = image_new(2, 1);
+  put_entry(b, 2, 20, "", "abc", 0, 0, 1);
+  b->data[12 + 40 + 20 + 1] = 4;
+  ok = ok && !parse(b, b->len, 20);
+  g_byte_array_free(b, TRUE);
+
+  /* v4: a strip longer than the previous path. */
+  b = image_new(4, 2);
+  put_entry(b, 4, 20, "", "ab", 0, 0, 1);
+  put_entry(b, 4, 20, "", "cd", 0, 0, 2);
+  b->data[b->len - 4] = 3;                                /* "drop 3 of 'ab'" */
+  ok = ok && !parse(b, b->len, 20);
+  g_byte_array_free(b, TRUE);
+
+  /* v4: a path without its NUL at the end of the data. */
+  b = image_new(4, 1);
+  put_entry(b, 4, 20, "", "abc", 0, 0, 1);
+  ok = ok && !parse(b, b->len - 1, 20);
+  g_byte_array_free(b, TRUE);
+
+  /* v4: a varint that never ends. */
+  b = image_new(4, 1);
+  put_entry(b, 4, 20, "", "", 0, 0, 1);
+  b->len -= 2;                                            /* drop varint and NUL */
+  for (guint i = 0; i < 12; i++) { const guint8 c = 0xFF; g_byte_array_append(b, &c, 1); }
+  ok = ok && !parse(b, b->len, 20);
+  g_byte_array_free(b, TRUE);
+  return ok;
+}
+
+int main(void){
+  UmiTests *t = umi_tests_new();
+  umi_tests_add(t, "git index v2, v3, v4", test_versions);
+  umi_tests_add(t, "git index sha256 ids", test_sha256);
+  umi_tests_add(t, "git index v4 prefix compression", test_v4_prefix);
+  umi_tests_add(t, "git index stages and extended flags", test_flags_and_stages);
+  umi_tests_add(t, "git index truncated images", test_truncated);
+  umi_tests_add(t, "git index malformed images", test_malformed);
+  const int fails = umi_tests_run(t);
+  umi_tests_free(t);
+  puts(fails ? "fail" : "ok");
+  return fails ? 1 : 0;
+}
@@ -0,0 +1,195 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: tests/test_multi_search.c
+ * PURPOSE: Aho-Corasick multi-pattern scan: overlapping and nested matches,
+ *          caseless and whole-word modes, pattern lists, and generated
+ *          inputs checked against a naive scan
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+#include "multi_search.h"
+#include "test_scaffold.h"
+
+/*------------------------------ Helpers --------------------------------------*/
+typedef struct {
+  GString *s;
+  guint    stop_after;                /* 0: never stop                        */
+  guint    n;
+} Collect;
+
+static gboolean collect(guint pattern, gsize start, gsize end, gpointer user){
+  Collect *c = user;
+  g_string_append_printf(c->s, "%s%u@%" G_GSIZE_FORMAT "-%" G_GSIZE_FORMAT,
+                         c->s->len ? " " : "", pattern, start, end);
+  return !c->stop_after || ++c->n < c->stop_after;
+}
+
+/* Matches of 'mp' in 'text' as "pattern@start-end" joined by ' '. */
+static char *scan_of(const UmiMultiPattern *mp, const char *text, gsize len, guint stop_after){
+  Collect c = { g_string_new(NULL), stop_after, 0 };
+  umi_multi_pattern_scan(mp, text, len, collect, &c);
+  return g_string_free(c.s, FALSE);
+}
+
+static gboolean scan_is(const UmiMultiPattern *mp, const char *text, const char *want){
+  char *got = scan_of(mp, text, strlen(text), 0);
+  const gboolean ok = strcmp(got, want) == 0;
+  if (!ok) g_printerr("  '%s': '%s', want '%s'\n", text, got, want);
+  g_free(got);
+  return ok;
+}
+
+static UmiMultiPattern *pattern_of(const char *const *pats, UmiMultiPatternFlags flags){
+  return umi_multi_pattern_new(pats, g_strv_length((gchar **)pats), flags);
+}
+
+/*------------------------------ Tests ----------------------------------------*/
+
+/* The textbook set: matches end in order, the longer first at one end. */
+static gboolean test_overlapping(void){
+  const char *const pats[] = { "he", "she", "his", "hers", NULL };
+  UmiMultiPattern *mp = pattern_of(pats, 0);
+  const gboolean ok = mp && umi_multi_pattern_count(mp) == 4 &&
+                      scan_is(mp, "ushers", "1@1-4 0@2-4 3@2-6") &&
+                      scan_is(mp, "ahishers", "2@1-4 1@3-6 0@4-6 3@4-8") &&
+                      scan_is(mp, "HERS", "") &&
+                      scan_is(mp, "", "");
+  umi_multi_pattern_unref(mp);
+  return ok;
+}
+
+static gboolean test_nested(void){
+  const char *const pats[] = { "aa", "a", "aaa", "b", NULL };
+  UmiMultiPattern *mp = pattern_of(pats, 0);
+  const gboolean ok = scan_is(mp, "aaaa", "1@0-1 0@0-2 1@1-2 2@0-3 0@1-3 1@2-3 2@1-4 0@2-4 1@3-4") &&
+                      scan_is(mp, "aba", "1@0-1 3@1-2 1@2-3");
+  umi_multi_pattern_unref(mp);
+  return ok;
+}
+
+static gboolean test_caseless(void){
+  const char *const pats[] = { "Foo", "BAR", "foo", "x_1", "", NULL };
+  UmiMultiPattern *mp = pattern_of(pats, UMI_MULTI_PATTERN_CASELESS);
+  gboolean ok = mp && umi_multi_pattern_count(mp) == 3 &&       /* "foo" repeats "Foo" */
+                strcmp(umi_multi_pattern_get(mp, 0), "Foo") == 0 &&
+                strcmp(umi_multi_pattern_get(mp, 2), "x_1") == 0 &&
+                umi_multi_pattern_get(mp, 3) == NULL &&
+                scan_is(mp, "foo FOO fOoBaR X_1 x-1", "0@0-3 0@4-7 0@8-11 1@11-14 2@15-18");
+  umi_multi_pattern_unref(mp);
+
+  /* Case matters without the flag, and only ASCII letters fold. */
+  mp = pattern_of(pats, 0);
+  ok = ok && umi_multi_pattern_count(mp) == 4 && scan_is(mp, "foo FOO Foo bar", "2@0-3 0@8-11");
+  umi_multi_pattern_unref(mp);
+  const char *const utf8[] = { "\xc3\xa9t\xc3\xa9", NULL };             /* "été" */
+  mp = pattern_of(utf8, UMI_MULTI_PATTERN_CASELESS);
+  ok = ok && scan_is(mp, "\xc3\xa9T\xc3\xa9 \xc3\x89t\xc3\xa9", "0@0-5");
+  umi_multi_pattern_unref(mp);
+  return ok;
+}
+
+static gboolean test_word(void){
+  const char *const pats[] = { "int", "->", "a.b", NULL };
+  UmiMultiPattern *mp = pattern_of(pats, UMI_MULTI_PATTERN_WORD);
+  const gboolean ok = scan_is(mp, "int x; print(int_t) (int)", "0@0-3 0@21-24") &&
+                      scan_is(mp, "p->q x->->y", "1@1-3 1@6-8 1@8-10") &&    /* edges not word bytes */
+                      scan_is(mp, "xa.b a.b a.bc", "2@5-8") &&
+                      scan_is(mp, "int", "0@0-3");
+  umi_multi_pattern_unref(mp);
+  return ok;
+}
+
+static gboolean test_stop(void){
+  const char *const pats[] = { "a", NULL };
+  UmiMultiPattern *mp = pattern_of(pats, 0);
+  char *got = scan_of(mp, "aaaa", 4, 2);
+  const gboolean ok = strcmp(got, "0@0-1 0@1-2") == 0;
+  g_free(got);
+  umi_multi_pattern_unref(mp);
+  return ok;
+}
+
+static gboolean test_from_text(void){
+  UmiMultiPattern *mp = umi_multi_pattern_new_from_text("alpha\r\n\nbeta\nalpha\n", 0);
+  gboolean ok = mp && umi_multi_pattern_count(mp) == 2 &&
+                strcmp(umi_multi_pattern_get(mp, 1), "beta") == 0 &&
+                scan_is(mp, "beta\ralpha", "1@0-4 0@5-10");
+  umi_multi_pattern_unref(mp);
+  ok = ok && !umi_multi_pattern_new_from_text("\n\r\n", 0) && !umi_multi_pattern_new(NULL, 0, 0);
+
+  GError *err = NULL;
+  ok = ok && !umi_multi_pattern_new_from_file("/nonexistent/patterns.txt", 0, &err) && err;
+  g_clear_error(&err);
+  return ok;
+}
+
+/* Every match, by end and then longest first, like the automaton reports
+ * them; 'pats' are distinct under the flags. */
+static char *naive_scan(GPtrArray *pats, gboolean caseless, const char *text, gsize len){
+  GString *s = g_string_new(NULL);
+  for (gsize end = 1; end <= len; ++end)
+    for (gsize plen = end; plen > 0; --plen)
+      for (guint p = 0; p < pats->len; ++p) {
+        const char *pat = g_ptr_array_index(pats, p);
+        if (strlen(pat) != plen) continue;
+        const gboolean hit = caseless ? g_ascii_strncasecmp(text + end - plen, pat, plen) == 0
+                                      : memcmp(text + end - plen, pat, plen) == 0;
+        if (hit) g_string_append_printf(s, "%s%u@%" G_GSIZE_FORMAT "-%" G_GSIZE_FORMAT,
+                                        s->len ? " " : "", p, end - plen, end);
+      }
+  return g_string_free(s, FALSE);
+}
+
+static gboolean test_generated(void){
+  static const char ALPHA[] = "abAB\xe9";
+  GRand *rnd = g_rand_new_with_seed(24);
+  gboolean ok = TRUE;
+  for (guint round = 0; round < 300 && ok; ++round) {
+    const gboolean caseless = round & 1;
+    const gint n_alpha = g_rand_int_range(rnd, 2, (gint)strlen(ALPHA) + 1);
+    GPtrArray *pats = g_ptr_array_new_with_free_func(g_free);
+    for (gint i = g_rand_int_range(rnd, 1, 12); i > 0; --i) {
+      char p[7] = { 0 };
+      for (gint k = g_rand_int_range(rnd, 1, 7), j = 0; j < k; ++j)
+        p[j] = ALPHA[g_rand_int_range(rnd, 0, n_alpha)];
+      gboolean dup = FALSE;
+      for (guint q = 0; q < pats->len && !dup; ++q)
+        dup = caseless ? g_ascii_strcasecmp(p, g_ptr_array_index(pats, q)) == 0
+                       : strcmp(p, g_ptr_array_index(pats, q)) == 0;
+      if (!dup) g_ptr_array_add(pats, g_strdup(p));
+    }
+    char text[200];
+    const gsize len = (gsize)g_rand_int_range(rnd, 0, sizeof text);
+    for (gsize i = 0; i < len; ++i) text[i] = ALPHA[g_rand_int_range(rnd, 0, n_alpha)];
+
+    UmiMultiPattern *mp = umi_multi_pattern_new((const char * const *)pats->pdata, pats->len,
+                                                caseless ? UMI_MULTI_PATTERN_CASELESS : 0);
+    char *got  = scan_of(mp, text, len, 0);
+    char *want = naive_scan(pats, caseless, text, len);
+    ok = umi_multi_pattern_count(mp) == pats->len && strcmp(got, want) == 0;
+    if (!ok) g_printerr("  round %u: '%s', want '%s'\n", round, got, want);
+    g_free(got);
+    g_free(want);
+    umi_multi_pattern_unref(mp);
+    g_ptr_array_free(pats, TRUE);
+  }
+  g_rand_free(rnd);
+  return ok;
+}
+
+int main(void){
+  UmiTests *t = umi_tests_new();
+  umi_tests_add(t, "multi pattern overlapping matches", test_overlapping);
+  umi_tests_add(t, "multi pattern nested matches", test_nested);
+  umi_tests_add(t, "multi pattern caseless", test_caseless);
+  umi_tests_add(t, "multi pattern whole words", test_word);
+  umi_tests_add(t, "multi pattern scan stops", test_stop);
+  umi_tests_add(t, "multi pattern lists", test_from_text);
+  umi_tests_add(t, "multi pattern against a naive scan", test_generated);
+  const int fails = umi_tests_run(t);
+  umi_tests_free(t);
+  puts(fails ? "fail" : "ok");
+  return fails ? 1 : 0;
+}
@@ -0,0 +1,251 @@
+/*-----------------------------------------------------------------------------
+ * Umicom Studio IDE
+ * File: tests/test_trigram_index.c
+ * PURPOSE: Trigram index: varint posting lists, literal runs of regexes,
+ *          and candidates / matches / snapshots over a small tree
+ * Created by: Umicom Foundation | Author: Sammy Hegab | Date: 2025-10-13 | MIT
+ *---------------------------------------------------------------------------*/
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include "test_scaffold.h"
+
+/* The posting list codec is private to the index; test it from inside. */
+#include "../src/search/trigram_index.c"
+
+/*------------------------------ Posting lists --------------------------------*/
+static const guint32 EDGES[] = {
+  0, 1, 127, 128, 16383, 16384, (1u << 21) - 1, 1u << 21, (1u << 28) - 1, 1u << 28, G_MAXUINT32
+};
+
+static gboolean test_varint_edges(void){
+  GByteArray *b = g_byte_array_new();
+  for (guint i = 0; i < G_N_ELEMENTS(EDGES); i++) put_varint(b, EDGES[i]);
+  const guint8 *p = b->data, *end = b->data + b->len;
+  gboolean ok = b->len == 1 + 1 + 1 + 2 + 2 + 3 + 3 + 4 + 4 + 5 + 5;
+  for (guint i = 0; ok && i < G_N_ELEMENTS(EDGES); i++) {
+    guint32 v = 0;
+    ok = (p = get_varint(p, end, &v)) != NULL && v == EDGES[i];
+  }
+  ok = ok && p == end;
+
+  /* Cut inside the last value, or no terminating byte within 5: NULL. */
+  guint32 v;
+  ok = ok && !get_varint(b->data + b->len - 5, end - 1, &v);
+  const guint8 endless[6] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x01 };
+  ok = ok && !get_varint(endless, endless + sizeof endless, &v);
+  g_byte_array_free(b, TRUE);
+  return ok;
+}
+
+static TgPost *post_of(const guint32 *docs, guint n){
+  TgPost *pl = g_new0(TgPost, 1);
+  pl->data = g_byte_array_new();
+  for (guint i = 0; i < n; i++) post_append(pl, docs[i]);
+  return pl;
+}
+
+/* Gaps of every varint width, starting at 0 and at a large first id. */
+static gboolean test_postings_roundtrip(void){
+  const guint32 a[] = { 0, 1, 128, 256, 16640, 33024, 2130176, 270565632, G_MAXUINT32 };
+  const guint32 b[] = { 300000, 300001, 300129 };
+  const guint32 *lists[] = { a, b };
+  const guint    lens[]  = { G_N_ELEMENTS(a), G_N_ELEMENTS(b) };
+  for (guint k = 0; k < 2; k++) {
+    TgPost *pl  = post_of(lists[k], lens[k]);
+    GArray *out = g_array_new(FALSE, FALSE, sizeof(guint32));
+    post_decode(pl, out);
+    const gboolean ok = out->len == lens[k] && !memcmp(out->data, lists[k], lens[k] * sizeof(guint32));
+    g_array_free(out, TRUE);
+    post_free(pl);
+    if (!ok) return FALSE;
+  }
+  return TRUE;
+}
+
+static gboolean intersect_is(const TgPost *pl, const guint32 *acc, guint n,
+                             const guint32 *want, guint wn){
+  GArray *a = g_array_new(FALSE, FALSE, sizeof(guint32));
+  g_array_append_vals(a, acc, n);
+  post_intersect(pl, a);
+  const gboolean ok = a->len == wn && (!wn || !memcmp(a->data, want, wn * sizeof(guint32)));
+  g_array_free(a, TRUE);
+  return ok;
+}
+
+static gboolean test_postings_intersect(void){
+  const guint32 docs[] = { 3, 200, 201, 40000, 40001, 5000000 };
+  TgPost *pl = post_of(docs, G_N_ELEMENTS(docs));
+  const guint32 mixed[]  = { 0, 3, 199, 201, 40000, 5000000, 5000001 };
+  const guint32 hits[]   = { 3, 201, 40000, 5000000 };
+  const guint32 none[]   = { 1, 2, 202, 39999 };
+  const guint32 past[]   = { 6000000, 7000000 };
+  const guint32 head[]   = { 3 };
+  const gboolean ok =
+    intersect_is(pl, mixed, G_N_ELEMENTS(mixed), hits, G_N_ELEMENTS(hits)) &&
+    intersect_is(pl, none, G_N_ELEMENTS(none), NULL, 0) &&
+    intersect_is(pl, past, G_N_ELEMENTS(past), NULL, 0) &&
+    intersect_is(pl, head, 1, head, 1) &&
+    intersect_is(pl, docs, G_N_ELEMENTS(docs), docs, G_N_ELEMENTS(docs)) &&
+    intersect_is(pl, NULL, 0, NULL, 0);
+  post_free(pl);
+  return ok;
+}
+
+/*------------------------------ Literal runs ---------------------------------*/
+typedef struct { const char *pattern; UmiTrigramFlags flags; const char *runs; } RunCase;
+
+/* 'runs': the expected runs joined by '|' ("" for none). */
+static const RunCase RUNS[] = {
+  { "hello",           0,                 "hello" },
+  { "a.b",             0,                 "a.b" },       /* literal: taken whole */
+  { "ab",              UMI_TRIGRAM_REGEX, "" },          /* under 3 bytes        */
+  { "foo\\d{3}bar",    UMI_TRIGRAM_REGEX, "foo|bar" },
+  { "a\\.bcd",         UMI_TRIGRAM_REGEX, "a.bcd" },
+  { "\\tabc",          UMI_TRIGRAM_REGEX, "\tabc" },
+  { "\\bword\\b",      UMI_TRIGRAM_REGEX, "word" },
+  { "\\x41BCdef",      UMI_TRIGRAM_REGEX, "BCdef" },     /* escape args skipped  */
+  { "abc\\x{263a}def", UMI_TRIGRAM_REGEX, "abc|def" },
+  { "\\Qa.b\\Ecde",    UMI_TRIGRAM_REGEX, "cde" },
+  { "ab?cde",          UMI_TRIGRAM_REGEX, "cde" },       /* optional atom out    */
+  { "abc*def",         UMI_TRIGRAM_REGEX, "def" },
+  { "x{0,3}abcd",      UMI_TRIGRAM_REGEX, "abcd" },
+  { "abc+def",         UMI_TRIGRAM_REGEX, "abc|def" },   /* repeat ends the run  */
+  { "a{2}bcd",         UMI_TRIGRAM_REGEX, "bcd" },
+  { "abc.*?xyz",       UMI_TRIGRAM_REGEX, "abc|xyz" },
+  { "[abc]defg",       UMI_TRIGRAM_REGEX, "defg" },
+  { "wxyz(abc)defg",   UMI_TRIGRAM_REGEX, "wxyz|defg" },
+  { "a[|]bcd(e|f)ghi", UMI_TRIGRAM_REGEX, "bcd|ghi" },   /* '|' not top-level    */
+  { "foo|bar",         UMI_TRIGRAM_REGEX, "" },          /* alternation: give up */
+  { "(?i)hello",       UMI_TRIGRAM_REGEX, "" },
+};
+
+static gboolean test_literal_runs(void){
+  gboolean ok = TRUE;
+  for (guint i = 0; i < G_N_ELEMENTS(RUNS); i++) {
+    GPtrArray *runs = g_ptr_array_new_with_free_func(g_free);
+    umi_trigram_literal_runs(RUNS[i].pattern, RUNS[i].flags, runs);
+    g_ptr_array_add(runs, NULL);
+    char *got = g_strjoinv("|", (char **)runs->pdata);
+    if (strcmp(got, RUNS[i].runs) != 0) {
+      g_printerr("  runs of '%s': '%s', want '%s'\n", RUNS[i].pattern, got, RUNS[i].runs);
+      ok = FALSE;
+    }
+    g_free(got);
+    g_ptr_array_free(runs, TRUE);
+  }
+  return ok;
+}
+
+/*------------------------------ Index over a tree ----------------------------*/
+static char *tree;
+
+static void write_data(const char *rel, const char *data, gssize len){
+  char *path = g_build_filename(tree, rel, NULL);
+  char *dir  = g_path_get_dirname(path);
+  g_mkdir_with_parents(dir, 0755);
+  g_file_set_contents(path, data, len, NULL);
+  g_free(dir);
+  g_free(path);
+}
+
+static void write_file(const char *rel, const char *text){
+  write_data(rel, text, -1);
+}
+
+static void remove_tree(const char *dir){
+  GDir *d = g_dir_open(dir, 0, NULL);
+  for (const char *name; d && (name = g_dir_read_name(d)); ) {
+    char *path = g_build_filename(dir, name, NULL);
+    if (g_file_test(path, G_FILE_TEST_IS_DIR)) remove_tree(path);
+    else g_remove(path);
+    g_free(path);
+  }
+  if (d) g_dir_close(d);
+  g_rmdir(dir);
+}
+
+static char *candidates(UmiTrigramIndex *t, const char *pattern, UmiTrigramFlags flags){
+  GPtrArray *c = g_ptr_array_new_with_free_func(g_free);
+  if (!umi_trigram_index_candidates(t, pattern, flags, c)) {
+    g_ptr_array_free(c, TRUE);
+    return g_strdup("*");
+  }
+  g_ptr_array_add(c, NULL);
+  char *s = g_strjoinv(" ", (char **)c->pdata);
+  g_ptr_array_free(c, TRUE);
+  return s;
+}
+
+static gboolean candidates_are(UmiTrigramIndex *t, const char *pattern, UmiTrigramFlags flags,
+                               const char *want){
+  char *got = candidates(t, pattern, flags);
+  const gboolean ok = strcmp(got, want) == 0;
+  if (!ok) g_printerr("  candidates of '%s': '%s', want '%s'\n", pattern, got, want);
+  g_free(got);
+  return ok;
+}
+
+static guint count(UmiTrigramIndex *t, const char *pattern, UmiTrigramFlags flags){
+  GArray *hits = umi_trigram_hits_new();
+  const guint n = umi_trigram_index_search(t, pattern, flags, 100, hits, NULL);
+  g_array_free(hits, TRUE);
+  return n;
+}
+
+static gboolean test_index_tree(void){
+  tree = g_dir_make_tmp("umi-trigram-XXXXXX", NULL);
+  write_file("a.c", "int hello_world(void);\n");
+  write_file("b.txt", "Hello\nworld\n");
+  write_file("sub/c.h", "#define CAFE 1\n");
+  write_file("sub/u.txt", "caf\xc3\xa9 cr\xc3\xa8me\n");   /* bytes >= 0x80 */
+  write_data("bin.dat", "hello\0world", 11);
+
+  UmiFileIndex    *idx = umi_index_build(tree);
+  UmiTrigramIndex *t   = umi_trigram_index_new(idx);
+  gboolean ok =
+    candidates_are(t, "hello", 0, "a.c b.txt") &&         /* grams are case-folded */
+    candidates_are(t, "hello", UMI_TRIGRAM_CASELESS, "a.c b.txt") &&
+    candidates_are(t, "cr\xc3\xa8me", 0, "sub/u.txt") &&
+    candidates_are(t, "lo_wor", UMI_TRIGRAM_REGEX, "a.c") &&
+    candidates_are(t, "wor.d", UMI_TRIGRAM_REGEX, "a.c b.txt") &&   /* runs are not lines */
+    candidates_are(t, "nowhere", 0, "") &&
+    candidates_are(t, "a.c", UMI_TRIGRAM_REGEX, "*") &&
+    count(t, "hello", 0) == 1 && count(t, "hello", UMI_TRIGRAM_CASELESS) == 2 &&
+    count(t, "wor.d", UMI_TRIGRAM_REGEX) == 2 && umi_trigram_index_n_docs(t) == 5;
+
+  /* A snapshot reopens to the same answers; an edit is seen after marking. */
+  char *snap = g_build_filename(tree, "index.tri", NULL);
+  ok = ok && umi_trigram_index_save(t, snap, NULL);
+  umi_trigram_index_free(t);
+  t  = umi_trigram_index_open(idx, snap);
+  ok = ok && candidates_are(t, "hello", UMI_TRIGRAM_CASELESS, "a.c b.txt");
+
+  write_file("b.txt", "goodbye\n");
+  char *b = g_build_filename(tree, "b.txt", NULL);
+  umi_trigram_index_mark_dirty(t, b);
+  ok = ok && candidates_are(t, "hello", UMI_TRIGRAM_CASELESS, "a.c") &&
+       candidates_are(t, "goodbye", 0, "b.txt");
+
+  g_free(b);
+  g_free(snap);
+  umi_trigram_index_free(t);
+  umi_index_free(idx);
+  remove_tree(tree);
+  g_free(tree);
+  return ok;
+}
+
+int main(void){
+  UmiTests *t = umi_tests_new();
+  umi_tests_add(t, "trigram varint edges", test_varint_edges);
+  umi_tests_add(t, "trigram posting list round trip", test_postings_roundtrip);
+  umi_tests_add(t, "trigram posting list intersection", test_postings_intersect);
+  umi_tests_add(t, "trigram literal runs", test_literal_runs);
+  umi_tests_add(t, "trigram index over a tree", test_index_tree);
+  const int fails = umi_tests_run(t);
+  umi_tests_free(t);
+  puts(fails ? "fail" : "ok");
+  return fails ? 1 : 0;
+}